@@ -1,9 +1,11 @@
 #version 300 es
 precision lowp float;
 
-uniform mat4 ViewMatrix;
-uniform mat4 ProjectionMatrix;
-uniform mat4 ModelMatrix;
+layout(std140) uniform Camera
+{
+	mat4 ViewMatrix;
+	mat4 ProjectionMatrix;
+};
 
 uniform sampler2D Albedo;
 uniform sampler2D Detail;
@@ -1,15 +1,22 @@
 #version 300 es
 precision lowp float;
 
-uniform mat4 ViewMatrix;
-uniform mat4 ProjectionMatrix;
-uniform mat4 ModelMatrix;
+layout(std140) uniform Camera
+{
+	mat4 ViewMatrix;
+	mat4 ProjectionMatrix;
+};
+
+uniform bool PackedVertices;
+uniform vec3 QuantizationOffset;
+uniform vec3 QuantizationScale;
 
-in vec3 Position;
-in vec3 Normal;
+in vec4 Position;
+in vec4 Normal;
 in vec4 Tangent;
 in vec3 Color;
 in vec2 UV;
+in mat4 InstanceMatrix;
 
 out vec3 VertPosition;
 out mat3 VertTBN;
@@ -26,15 +33,30 @@ vec4 snap(vec4 position)
 	return snapped;
 }
 
+vec3 OctahedralDecode(vec2 encoded)
+{
+	vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float t = max(-n.z, 0.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+}
+
 void main()
 {
-	vec3 normal = normalize((ModelMatrix * vec4(Normal, 0.0)).xyz);
-	vec3 tangent = normalize((ModelMatrix * vec4(Tangent.xyz, 0.0)).xyz);
-	vec3 bitangent = normalize((ModelMatrix * vec4((cross(Normal, Tangent.xyz) * Tangent.w), 0.0)).xyz);
+	mat4 ModelMatrix = InstanceMatrix;
+
+	// Float vertices use an identity quantization, packed ones carry handedness in position.w
+	vec3 position = Position.xyz * QuantizationScale + QuantizationOffset;
+	vec3 local_normal = PackedVertices ? OctahedralDecode(Normal.xy) : Normal.xyz;
+	vec4 local_tangent = PackedVertices ? vec4(OctahedralDecode(Tangent.xy), Position.w * 2.0 - 1.0) : Tangent;
+
+	vec3 normal = normalize((ModelMatrix * vec4(local_normal, 0.0)).xyz);
+	vec3 tangent = normalize((ModelMatrix * vec4(local_tangent.xyz, 0.0)).xyz);
+	vec3 bitangent = normalize((ModelMatrix * vec4((cross(local_normal, local_tangent.xyz) * local_tangent.w), 0.0)).xyz);
 
-	VertPosition = (ViewMatrix * ModelMatrix * vec4(Position, 1.0)).xyz;
+	VertPosition = (ViewMatrix * ModelMatrix * vec4(position, 1.0)).xyz;
 	VertTBN = mat3(tangent, bitangent, normal);
 	VertColor = vec4(Color, 1.0);
 	VertUV = vec2(UV.x, UV.y);
-	gl_Position = ProjectionMatrix * ViewMatrix * ModelMatrix * vec4(Position, 1.0);
+	gl_Position = ProjectionMatrix * ViewMatrix * ModelMatrix * vec4(position, 1.0);
 }
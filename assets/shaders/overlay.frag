@@ -0,0 +1,11 @@
+#version 300 es
+precision lowp float;
+
+in vec4 VertColor;
+
+out vec4 FragColor;
+
+void main()
+{
+	FragColor = VertColor;
+}
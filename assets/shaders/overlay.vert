@@ -0,0 +1,14 @@
+#version 300 es
+precision lowp float;
+
+// Positions are already in clip space, the overlay is drawn flat over the frame
+in vec4 Position;
+in vec4 Color;
+
+out vec4 VertColor;
+
+void main()
+{
+	VertColor = Color;
+	gl_Position = vec4(Position.xy, 0.0, 1.0);
+}
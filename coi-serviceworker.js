@@ -0,0 +1,49 @@
+// Pthreads need SharedArrayBuffer, which browsers only expose to cross-origin isolated pages.
+// GitHub Pages can't send the headers that isolate a page, so this worker adds them to every
+// response instead. Loaded as a page script it registers itself and reloads once it's in control.
+if (typeof window === 'undefined') {
+	self.addEventListener('install', () => self.skipWaiting());
+	self.addEventListener('activate', (event) => event.waitUntil(self.clients.claim()));
+
+	self.addEventListener('fetch', (event) => {
+		const request = event.request;
+
+		// Only-if-cached requests fail outside of same-origin mode, let the browser handle them
+		if (request.cache === 'only-if-cached' && request.mode !== 'same-origin') {
+			return;
+		}
+
+		event.respondWith(fetch(request).then((response) => {
+			// Opaque responses can't be rewritten
+			if (response.status === 0) {
+				return response;
+			}
+
+			const headers = new Headers(response.headers);
+			headers.set('Cross-Origin-Embedder-Policy', 'require-corp');
+			headers.set('Cross-Origin-Opener-Policy', 'same-origin');
+			headers.set('Cross-Origin-Resource-Policy', 'cross-origin');
+
+			return new Response(response.body, { status: response.status, statusText: response.statusText, headers: headers });
+		}));
+	});
+} else if (!window.crossOriginIsolated && window.isSecureContext && 'serviceWorker' in navigator) {
+	// A page the worker already controls but that still isn't isolated would otherwise reload forever
+	const reloaded = window.sessionStorage.getItem('coiReloaded');
+	window.sessionStorage.removeItem('coiReloaded');
+
+	if (!reloaded) {
+		navigator.serviceWorker.register(document.currentScript.src).then((registration) => {
+			const reload = () => {
+				window.sessionStorage.setItem('coiReloaded', '1');
+				window.location.reload();
+			};
+
+			if (navigator.serviceWorker.controller) {
+				reload();
+			} else {
+				navigator.serviceWorker.addEventListener('controllerchange', reload);
+			}
+		}, (error) => console.error('Could not register the cross-origin isolation worker:', error));
+	}
+}
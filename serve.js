@@ -0,0 +1,13 @@
+// Serves the page cross-origin isolated, as pthreads need, without caching so rebuilds show up right away
+const httpServer = require('http-server');
+
+const port = 8080;
+const server = httpServer.createServer({
+	cache: -1,
+	headers: {
+		'Cross-Origin-Embedder-Policy': 'require-corp',
+		'Cross-Origin-Opener-Policy': 'same-origin',
+	},
+});
+
+server.listen(port, () => console.log('Serving on http://localhost:' + port));
@@ -1,10 +1,15 @@
 #include "Camera.h"
 
+#ifndef ENGINE_HEADLESS
+#include "Render/UniformBuffer.h"
+
 #include <SDL_opengl.h>
+#endif
 
 CCamera::CCamera()
 	: m_ViewIsUptodate(false)
 	, m_ProjIsUptodate(false)
+	, m_FrustumIsUptodate(false)
 {
 	m_ViewMatrix.setIdentity();
 
@@ -23,6 +28,7 @@ CCamera& CCamera::operator=(const CCamera& other)
 {
 	m_ViewIsUptodate = false;
 	m_ProjIsUptodate = false;
+	m_FrustumIsUptodate = false;
 
 	m_VpX = other.m_VpX;
 	m_VpY = other.m_VpY;
@@ -72,6 +78,11 @@ void CCamera::setFovY(float value)
 	m_ProjIsUptodate = false;
 }
 
+float CCamera::pixelSize(float distance) const
+{
+	return 2.0f * distance * tan(m_FovY * 0.5f) / float(m_VpHeight ? m_VpHeight : 1);
+}
+
 CVector3f CCamera::direction(void) const
 {
 	return -(orientation() * CVector3f::UnitZ());
@@ -157,6 +168,7 @@ void CCamera::updateViewMatrix(void) const
 		m_ViewMatrix.linear() = q.toRotationMatrix();
 		m_ViewMatrix.translation() = -(m_ViewMatrix.linear() * position());
 		m_ViewIsUptodate = true;
+		m_FrustumIsUptodate = false;
 	}
 }
 
@@ -184,6 +196,7 @@ void CCamera::updateProjectionMatrix(void) const
 		m_ProjectionMatrix(3, 3) = 0;
 
 		m_ProjIsUptodate = true;
+		m_FrustumIsUptodate = false;
 	}
 }
 
@@ -193,13 +206,27 @@ const CMatrix4f& CCamera::projectionMatrix(void) const
 	return m_ProjectionMatrix;
 }
 
-void CCamera::activateGL(void)
+const CFrustum& CCamera::frustum(void) const
+{
+	updateViewMatrix();
+	updateProjectionMatrix();
+
+	if (!m_FrustumIsUptodate)
+	{
+		m_Frustum = CFrustum(m_ProjectionMatrix.matrix() * m_ViewMatrix.matrix());
+		m_FrustumIsUptodate = true;
+	}
+
+	return m_Frustum;
+}
+
+#ifndef ENGINE_HEADLESS
+void CCamera::activateGL(NRender::CUniformBuffer& uniforms)
 {
 	glViewport(vpX(), vpY(), vpWidth(), vpHeight());
 
-	GLint program;
-	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
-	glUniformMatrix4fv(glGetUniformLocation(program, "ViewMatrix"), 1, GL_FALSE, viewMatrix().data());
-	glUniformMatrix4fv(glGetUniformLocation(program, "ProjectionMatrix"), 1, GL_FALSE, projectionMatrix().data());
+	const SUniforms data = { viewMatrix().matrix(), projectionMatrix().matrix() };
+	uniforms.Update(&data, sizeof(data));
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
+#endif
@@ -8,14 +8,20 @@
 // with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
 #pragma once
 
+#include "Frustum.h"
 #include "Math.h"
 #include <stdint.h>
 
+namespace NRender
+{
+class CUniformBuffer;
+}
+
 class CFrame
 {
 public:
 	inline CFrame(const CVector3f& pos = CVector3f::Zero(),
-				  const CQuaternion& o = CQuaternion())
+				  const CQuaternion& o = CQuaternion::Identity())
 		: orientation(o)
 		, position(pos)
 	{
@@ -50,6 +56,9 @@ public:
 	inline float fovY(void) const { return m_FovY; }
 	void setFovY(float value);
 
+	// World space height covered by one pixel at the given view depth
+	float pixelSize(float distance) const;
+
 	void setPosition(const CVector3f& pos);
 	inline const CVector3f& position(void) const { return m_Frame.position; }
 
@@ -70,13 +79,23 @@ public:
 
 	const CTransform& viewMatrix(void) const;
 	const CMatrix4f& projectionMatrix(void) const;
+	const CFrustum& frustum(void) const;
 
 	void localRotate(const CQuaternion& q);
 	void zoom(float d);
 
 	void localTranslate(const CVector3f& t);
 
-	void activateGL(void);
+#ifndef ENGINE_HEADLESS
+	// Layout of the std140 Camera uniform block
+	struct SUniforms
+	{
+		Eigen::Matrix4f m_ViewMatrix;
+		Eigen::Matrix4f m_ProjectionMatrix;
+	};
+
+	void activateGL(NRender::CUniformBuffer& uniforms);
+#endif
 
 protected:
 	void updateViewMatrix(void) const;
@@ -90,9 +109,11 @@ protected:
 
 	mutable CTransform m_ViewMatrix;
 	mutable CMatrix4f m_ProjectionMatrix;
+	mutable CFrustum m_Frustum;
 
 	mutable bool m_ViewIsUptodate;
 	mutable bool m_ProjIsUptodate;
+	mutable bool m_FrustumIsUptodate;
 
 	CVector3f m_Target;
 
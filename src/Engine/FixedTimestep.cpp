@@ -0,0 +1,29 @@
+#include "FixedTimestep.h"
+
+#include <algorithm>
+
+CFixedTimestep::CFixedTimestep(double tick, size_t max_ticks)
+	: m_Tick(tick)
+	, m_MaxTicks(std::max<size_t>(max_ticks, 1))
+{
+}
+
+size_t CFixedTimestep::Advance(double elapsed)
+{
+	m_Accumulator += std::max(elapsed, 0.0);
+
+	size_t ticks = size_t(m_Accumulator / m_Tick);
+	m_Accumulator -= ticks * m_Tick;
+
+	// Rounding can leave the remainder a hair outside of a tick
+	m_Accumulator = std::min(std::max(m_Accumulator, 0.0), m_Tick);
+
+	if (ticks > m_MaxTicks)
+	{
+		m_DroppedTicks += ticks - m_MaxTicks;
+		ticks = m_MaxTicks;
+	}
+
+	m_Ticks += ticks;
+	return ticks;
+}
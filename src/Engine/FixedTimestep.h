@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stddef.h>
+
+/**
+ * Splits variable frame times into fixed simulation ticks. Advance adds the time
+ * a frame took and returns how many ticks to simulate, whatever is less than a
+ * tick carries over to the next frame, and Alpha is how far rendering is between
+ * the last two simulated states.
+ *
+ * A frame never runs more than the tick limit. When a client can't keep up, or
+ * the page was in the background, the time beyond the limit is dropped and the
+ * simulation falls behind the clock instead of spending every following frame
+ * catching up on ticks that make it later still.
+ **/
+class CFixedTimestep
+{
+public:
+	explicit CFixedTimestep(double tick = 1.0 / 60.0, size_t max_ticks = 4);
+
+	size_t Advance(double elapsed);
+
+	// Between 0 for the previous state and 1 for the last one simulated
+	float Alpha() const { return float(m_Accumulator / m_Tick); }
+
+	double Tick() const { return m_Tick; }
+	size_t Ticks() const { return m_Ticks; }
+	size_t DroppedTicks() const { return m_DroppedTicks; }
+
+private:
+	double m_Tick;
+	size_t m_MaxTicks;
+	double m_Accumulator = 0.0;
+	size_t m_Ticks = 0;
+	size_t m_DroppedTicks = 0;
+};
@@ -0,0 +1,133 @@
+#include "Frustum.h"
+
+#include <algorithm>
+#include <cmath>
+
+CFrustum::CFrustum()
+{
+	// Every plane starts out passing everything
+	for (size_t plane = 0; plane < PLANE_STRIDE; ++plane)
+	{
+		m_X[plane] = m_Y[plane] = m_Z[plane] = 0.0f;
+		m_W[plane] = 1.0f;
+	}
+}
+
+CFrustum::CFrustum(const Eigen::Matrix4f& view_projection)
+	: CFrustum()
+{
+	// Gribb & Hartmann, planes are combinations of the clip matrix rows with normals pointing inwards
+	const CVector4f x = view_projection.row(0);
+	const CVector4f y = view_projection.row(1);
+	const CVector4f z = view_projection.row(2);
+	const CVector4f w = view_projection.row(3);
+
+	SetPlane(Left, w + x);
+	SetPlane(Right, w - x);
+	SetPlane(Bottom, w + y);
+	SetPlane(Top, w - y);
+	SetPlane(Near, w + z);
+	SetPlane(Far, w - z);
+}
+
+CFrustum CFrustum::Transformed(const CTransform& transform) const
+{
+	// Planes transform by the transpose, left unnormalized as box tests are scale invariant
+	const Eigen::Matrix4f& m = transform.matrix();
+	CFrustum frustum;
+
+	for (size_t plane = 0; plane < PLANE_STRIDE; ++plane)
+	{
+		frustum.m_X[plane] = m(0, 0) * m_X[plane] + m(1, 0) * m_Y[plane] + m(2, 0) * m_Z[plane] + m(3, 0) * m_W[plane];
+		frustum.m_Y[plane] = m(0, 1) * m_X[plane] + m(1, 1) * m_Y[plane] + m(2, 1) * m_Z[plane] + m(3, 1) * m_W[plane];
+		frustum.m_Z[plane] = m(0, 2) * m_X[plane] + m(1, 2) * m_Y[plane] + m(2, 2) * m_Z[plane] + m(3, 2) * m_W[plane];
+		frustum.m_W[plane] = m(0, 3) * m_X[plane] + m(1, 3) * m_Y[plane] + m(2, 3) * m_Z[plane] + m(3, 3) * m_W[plane];
+	}
+
+	return frustum;
+}
+
+void CFrustum::SetPlane(size_t plane, const CVector4f& value)
+{
+	// Normalized so sphere tests can compare distances directly
+	const float length = value.head<3>().norm();
+	const CVector4f normalized = length > 0.0f ? CVector4f(value / length) : value;
+
+	m_X[plane] = normalized.x();
+	m_Y[plane] = normalized.y();
+	m_Z[plane] = normalized.z();
+	m_W[plane] = normalized.w();
+}
+
+bool CFrustum::TestSphere(const CVector3f& center, float radius) const
+{
+	bool visible = true;
+
+	for (size_t plane = 0; plane < PLANE_STRIDE; ++plane)
+	{
+		visible &= m_X[plane] * center.x() + m_Y[plane] * center.y() + m_Z[plane] * center.z() + m_W[plane] >= -radius;
+	}
+
+	return visible;
+}
+
+bool CFrustum::TestBox(const CVector3f& min, const CVector3f& max) const
+{
+	const CVector3f center = (min + max) * 0.5f;
+	const CVector3f extent = (max - min) * 0.5f;
+	bool visible = true;
+
+	// A box is outside once its most positive corner along the plane normal is behind it
+	for (size_t plane = 0; plane < PLANE_STRIDE; ++plane)
+	{
+		const float distance = m_X[plane] * center.x() + m_Y[plane] * center.y() + m_Z[plane] * center.z() + m_W[plane];
+		const float radius = std::abs(m_X[plane]) * extent.x() + std::abs(m_Y[plane]) * extent.y() + std::abs(m_Z[plane]) * extent.z();
+		visible &= distance >= -radius;
+	}
+
+	return visible;
+}
+
+size_t CFrustum::CullSpheres(const float* x, const float* y, const float* z, const float* radius, size_t count, uint8_t* visible) const
+{
+	size_t visible_count = 0;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		uint8_t inside = 1;
+
+		for (size_t plane = 0; plane < Count; ++plane)
+		{
+			inside &= m_X[plane] * x[i] + m_Y[plane] * y[i] + m_Z[plane] * z[i] + m_W[plane] >= -radius[i];
+		}
+
+		visible[i] = inside;
+		visible_count += inside;
+	}
+
+	return visible_count;
+}
+
+size_t CFrustum::CullBoxes(const float* center_x, const float* center_y, const float* center_z,
+						   const float* extent_x, const float* extent_y, const float* extent_z,
+						   size_t count, uint8_t* visible) const
+{
+	size_t visible_count = 0;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		uint8_t inside = 1;
+
+		for (size_t plane = 0; plane < Count; ++plane)
+		{
+			const float distance = m_X[plane] * center_x[i] + m_Y[plane] * center_y[i] + m_Z[plane] * center_z[i] + m_W[plane];
+			const float radius = std::abs(m_X[plane]) * extent_x[i] + std::abs(m_Y[plane]) * extent_y[i] + std::abs(m_Z[plane]) * extent_z[i];
+			inside &= distance >= -radius;
+		}
+
+		visible[i] = inside;
+		visible_count += inside;
+	}
+
+	return visible_count;
+}
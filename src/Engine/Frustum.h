@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Math.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Planes are stored as structure of arrays and padded to eight, the padding planes
+ * always pass so every test is a fixed width loop.
+ **/
+class CFrustum
+{
+public:
+	enum EPlane
+	{
+		Left,
+		Right,
+		Bottom,
+		Top,
+		Near,
+		Far,
+		Count
+	};
+
+	CFrustum();
+	explicit CFrustum(const Eigen::Matrix4f& view_projection);
+
+	// Moves the frustum into the space of the given transform, so local boxes can be tested directly.
+	// The planes aren't renormalized, so sphere tests are only meaningful on untransformed frustums.
+	CFrustum Transformed(const CTransform& transform) const;
+
+	CVector4f Plane(EPlane plane) const { return CVector4f(m_X[plane], m_Y[plane], m_Z[plane], m_W[plane]); }
+
+	bool TestSphere(const CVector3f& center, float radius) const;
+	bool TestBox(const CVector3f& min, const CVector3f& max) const;
+
+	// Batched tests over structure of array inputs, visible receives 0 or 1 per element
+	size_t CullSpheres(const float* x, const float* y, const float* z, const float* radius, size_t count, uint8_t* visible) const;
+	size_t CullBoxes(const float* center_x, const float* center_y, const float* center_z,
+					 const float* extent_x, const float* extent_y, const float* extent_z,
+					 size_t count, uint8_t* visible) const;
+
+private:
+	static constexpr size_t PLANE_STRIDE = 8;
+
+	void SetPlane(size_t plane, const CVector4f& value);
+
+	alignas(32) float m_X[PLANE_STRIDE];
+	alignas(32) float m_Y[PLANE_STRIDE];
+	alignas(32) float m_Z[PLANE_STRIDE];
+	alignas(32) float m_W[PLANE_STRIDE];
+};
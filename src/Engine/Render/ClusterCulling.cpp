@@ -0,0 +1,108 @@
+#include "ClusterCulling.h"
+
+#include <algorithm>
+
+namespace NRender
+{
+namespace
+{
+constexpr size_t CULL_BLOCK = 64;
+
+// Smaller submeshes are drawn whole, so they batch with every other instance drawing them
+constexpr size_t MIN_CULLED_MESHLETS = 8;
+constexpr float MIN_CULLED_SCREEN_SIZE = 0.5f;
+
+void AppendRun(const SMesh& mesh, size_t start, size_t end, uint32_t base_vertex, std::vector<uint32_t>& indices)
+{
+	const size_t offset = indices.size();
+	indices.insert(indices.end(), mesh.m_Indices.begin() + start, mesh.m_Indices.begin() + end);
+
+	for (size_t i = offset; i < indices.size(); ++i)
+	{
+		indices[i] += base_vertex;
+	}
+}
+}  // namespace
+
+size_t CullMeshlets(const SMesh& mesh, const SMesh::SSubMesh& sub_mesh, const CFrustum& frustum, const CVector3f& eye, float scale, bool cull_backfaces, uint32_t base_vertex, std::vector<uint32_t>& indices)
+{
+	const SMesh::SMeshlets& meshlets = mesh.m_Meshlets;
+	CVector4f planes[CFrustum::Count];
+
+	for (size_t plane = 0; plane < CFrustum::Count; ++plane)
+	{
+		planes[plane] = frustum.Plane(CFrustum::EPlane(plane));
+	}
+
+	size_t visible_count = 0;
+	size_t run_start = 0;
+	size_t run_end = 0;
+
+	for (size_t first = sub_mesh.m_FirstMeshlet; first < sub_mesh.m_FirstMeshlet + sub_mesh.m_MeshletCount; first += CULL_BLOCK)
+	{
+		const size_t count = std::min(CULL_BLOCK, sub_mesh.m_FirstMeshlet + sub_mesh.m_MeshletCount - first);
+		const float* x = &meshlets.m_CenterX[first];
+		const float* y = &meshlets.m_CenterY[first];
+		const float* z = &meshlets.m_CenterZ[first];
+		const float* radius = &meshlets.m_Radius[first];
+		uint8_t visible[CULL_BLOCK];
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			visible[i] = 1;
+		}
+
+		for (const CVector4f& plane : planes)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				visible[i] &= plane.x() * x[i] + plane.y() * y[i] + plane.z() * z[i] + plane.w() >= -radius[i] * scale;
+			}
+		}
+
+		// dot(center - eye, axis) - radius >= cutoff * |center - eye| compared squared, so there's no square root in the loop
+		if (cull_backfaces)
+		{
+			const float* axis_x = &meshlets.m_AxisX[first];
+			const float* axis_y = &meshlets.m_AxisY[first];
+			const float* axis_z = &meshlets.m_AxisZ[first];
+			const float* cutoff = &meshlets.m_Cutoff[first];
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				const float dx = x[i] - eye.x(), dy = y[i] - eye.y(), dz = z[i] - eye.z();
+				const float facing = dx * axis_x[i] + dy * axis_y[i] + dz * axis_z[i] - radius[i];
+				const float distance = dx * dx + dy * dy + dz * dz;
+				visible[i] &= !(facing >= 0.0f && facing * facing >= cutoff[i] * cutoff[i] * distance);
+			}
+		}
+
+		// Neighbouring clusters are neighbouring index ranges, so runs of them are copied at once
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (!visible[i])
+			{
+				continue;
+			}
+
+			const size_t offset = meshlets.m_IndexOffset[first + i];
+
+			if (offset != run_end)
+			{
+				AppendRun(mesh, run_start, run_end, base_vertex, indices);
+				run_start = offset;
+			}
+
+			run_end = offset + meshlets.m_IndexCount[first + i];
+			++visible_count;
+		}
+	}
+
+	AppendRun(mesh, run_start, run_end, base_vertex, indices);
+	return visible_count;
+}
+bool ShouldCullMeshlets(const SMesh::SSubMesh& sub_mesh, float screen_size)
+{
+	return sub_mesh.m_MeshletCount >= MIN_CULLED_MESHLETS && screen_size >= MIN_CULLED_SCREEN_SIZE;
+}
+}  // namespace NRender
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include <Engine/Frustum.h>
+#include <Engine/Math.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace NRender
+{
+/**
+ * Appends the indices of the submesh's clusters that may be visible and returns
+ * how many clusters that is. Clusters are tested in fixed size blocks, plane by
+ * plane and then against their normal cones, each test a pass over the block's
+ * arrays that only writes a visibility mask.
+ *
+ * The frustum and eye are in mesh space, the frustum as CFrustum::Transformed
+ * leaves it, and scale is the transform's largest axis scale, which turns mesh
+ * space radii into the world space distances its planes measure. Normal cones
+ * only hold under uniform scale, pass cull_backfaces false for anything else.
+ * Appended indices are offset by base_vertex, where the mesh's vertices start in
+ * the vertex buffer they're drawn from.
+ **/
+size_t CullMeshlets(const SMesh& mesh, const SMesh::SSubMesh& sub_mesh, const CFrustum& frustum, const CVector3f& eye, float scale, bool cull_backfaces, uint32_t base_vertex, std::vector<uint32_t>& indices);
+
+// Culled clusters are copied on the CPU and drawn apart from any instanced batch, which only pays off for submeshes
+// with enough clusters that span a good part of the view. Screen size is the bounding sphere's diameter over the
+// height of the view at its nearest point.
+bool ShouldCullMeshlets(const SMesh::SSubMesh& sub_mesh, float screen_size);
+}  // namespace NRender
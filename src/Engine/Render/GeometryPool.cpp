@@ -0,0 +1,206 @@
+#include "GeometryPool.h"
+
+#include "RenderStats.h"
+#include "StateCache.h"
+
+#include <Engine/ShaderProgram.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace NRender
+{
+namespace
+{
+// Room for a few meshes before the first copy
+constexpr size_t MIN_VERTICES = 1 << 16;
+constexpr size_t MIN_INDICES = 1 << 18;
+
+size_t VertexSize(EVertexFormat format)
+{
+	return format == EVertexFormat::Packed ? sizeof(SMesh::SPackedVertexData) : sizeof(SMesh::SVertexData);
+}
+}  // namespace
+
+CGeometryPool::~CGeometryPool()
+{
+	for (SPool& pool : m_Pools)
+	{
+		CStateCache::Instance().DeleteVertexArrays(pool.m_VertexArrays.size(), pool.m_VertexArrays.data());
+		CStateCache::Instance().DeleteBuffers(1, &pool.m_VertexBuffer);
+	}
+
+	CStateCache::Instance().DeleteBuffers(1, &m_IndexBuffer);
+}
+
+SGeometryRange CGeometryPool::Allocate(const SMesh& mesh)
+{
+	CStateCache& state = CStateCache::Instance();
+	SFrameStats& stats = CRenderStats::Instance().Current();
+
+	SGeometryRange range;
+	range.m_Format = mesh.m_VertexFormat;
+	range.m_VertexCount = mesh.m_VertexFormat == EVertexFormat::Packed ? mesh.m_PackedVertices.size() : mesh.m_Vertices.size();
+	range.m_IndexCount = mesh.m_Indices.size();
+
+	SPool& pool = m_Pools[size_t(range.m_Format)];
+	const size_t vertex_size = VertexSize(range.m_Format);
+	const void* vertices = mesh.m_VertexFormat == EVertexFormat::Packed ? (const void*)mesh.m_PackedVertices.data() : (const void*)mesh.m_Vertices.data();
+
+	// Index buffers bind into the current vertex array, so none is bound while they're touched
+	state.BindVertexArray(0);
+
+	const GLuint vertex_buffer = pool.m_VertexBuffer;
+	const GLuint index_buffer = m_IndexBuffer;
+	range.m_FirstVertex = Allocate(pool.m_Vertices, pool.m_VertexBuffer, GL_ARRAY_BUFFER, vertex_size, range.m_VertexCount);
+	range.m_FirstIndex = Allocate(m_Indices, m_IndexBuffer, GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t), range.m_IndexCount);
+
+	if (range.m_VertexCount > 0)
+	{
+		state.BindBuffer(GL_ARRAY_BUFFER, pool.m_VertexBuffer);
+		glBufferSubData(GL_ARRAY_BUFFER, range.m_FirstVertex * vertex_size, range.m_VertexCount * vertex_size, vertices);
+		stats.m_BytesUploaded += range.m_VertexCount * vertex_size;
+	}
+
+	if (range.m_IndexCount > 0)
+	{
+		// Stands in for the base vertex draws GLES3 doesn't have
+		std::vector<uint32_t> indices(mesh.m_Indices);
+
+		for (uint32_t& index : indices)
+		{
+			index += uint32_t(range.m_FirstVertex);
+		}
+
+		state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer);
+		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, range.m_FirstIndex * sizeof(uint32_t), indices.size() * sizeof(uint32_t), indices.data());
+		stats.m_BytesUploaded += indices.size() * sizeof(uint32_t);
+	}
+
+	// Grown buffers have new names, which every vertex array referring to them has to pick up
+	if (pool.m_VertexBuffer != vertex_buffer || m_IndexBuffer != index_buffer)
+	{
+		SetupVertexArrays(EVertexFormat::Float);
+		SetupVertexArrays(EVertexFormat::Packed);
+	}
+
+	return range;
+}
+
+void CGeometryPool::Free(const SGeometryRange& range)
+{
+	m_Pools[size_t(range.m_Format)].m_Vertices.Free(range.m_FirstVertex, range.m_VertexCount);
+	m_Indices.Free(range.m_FirstIndex, range.m_IndexCount);
+}
+
+size_t CGeometryPool::Allocate(NUtils::CRangeAllocator& allocator, GLuint& buffer, GLenum target, size_t element_size, size_t count)
+{
+	const size_t offset = allocator.Allocate(count);
+
+	if (offset != NUtils::CRangeAllocator::Invalid)
+	{
+		return offset;
+	}
+
+	CStateCache& state = CStateCache::Instance();
+	const size_t previous = allocator.Capacity();
+	const size_t minimum = target == GL_ELEMENT_ARRAY_BUFFER ? MIN_INDICES : MIN_VERTICES;
+	const size_t capacity = std::max({ previous * 2, previous + count, minimum });
+
+	GLuint grown = 0;
+	glGenBuffers(1, &grown);
+	state.BindBuffer(target, grown);
+	glBufferData(target, capacity * element_size, nullptr, GL_STATIC_DRAW);
+
+	if (buffer != 0)
+	{
+		state.BindBuffer(GL_COPY_READ_BUFFER, buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, target, 0, 0, previous * element_size);
+		state.DeleteBuffers(1, &buffer);
+	}
+
+	buffer = grown;
+	allocator.Grow(capacity);
+	return allocator.Allocate(count);
+}
+
+void CGeometryPool::SetupVertexArrays(EVertexFormat format)
+{
+	SPool& pool = m_Pools[size_t(format)];
+
+	if (pool.m_VertexBuffer == 0)
+	{
+		return;
+	}
+
+	if (pool.m_VertexArrays[0] == 0)
+	{
+		glGenVertexArrays(pool.m_VertexArrays.size(), pool.m_VertexArrays.data());
+	}
+
+	// Both vertex arrays read the same vertices, only the first one owns the indices
+	for (GLuint vertex_array : pool.m_VertexArrays)
+	{
+		CStateCache::Instance().BindVertexArray(vertex_array);
+		CStateCache::Instance().BindBuffer(GL_ARRAY_BUFFER, pool.m_VertexBuffer);
+
+		// Setup vertices
+#define OFFSET(TYPE, MEMBER) ((void*)&((TYPE*)0)->MEMBER)
+		if (format == EVertexFormat::Packed)
+		{
+			using SPackedVertexData = NRender::SMesh::SPackedVertexData;
+
+			glEnableVertexAttribArray(CShaderProgram::Position);  // Position, tangent handedness in w
+			glVertexAttribPointer(CShaderProgram::Position, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(SPackedVertexData), OFFSET(SPackedVertexData, m_Position));
+
+			glEnableVertexAttribArray(CShaderProgram::Normal);  // Normal, octahedral
+			glVertexAttribPointer(CShaderProgram::Normal, 2, GL_SHORT, GL_TRUE, sizeof(SPackedVertexData), OFFSET(SPackedVertexData, m_Normal));
+
+			glEnableVertexAttribArray(CShaderProgram::Tangent);  // Tangent, octahedral
+			glVertexAttribPointer(CShaderProgram::Tangent, 2, GL_SHORT, GL_TRUE, sizeof(SPackedVertexData), OFFSET(SPackedVertexData, m_Tangent));
+
+			glEnableVertexAttribArray(CShaderProgram::Color);  // Color
+			glVertexAttribPointer(CShaderProgram::Color, 3, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SPackedVertexData), OFFSET(SPackedVertexData, m_Color));
+
+			glEnableVertexAttribArray(CShaderProgram::UV);  // UV
+			glVertexAttribPointer(CShaderProgram::UV, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(SPackedVertexData), OFFSET(SPackedVertexData, m_UV));
+		}
+		else
+		{
+			using SVertexData = NRender::SMesh::SVertexData;
+
+			glEnableVertexAttribArray(CShaderProgram::Position);  // Position
+			glVertexAttribPointer(CShaderProgram::Position, 3, GL_FLOAT, GL_FALSE, sizeof(SVertexData), OFFSET(SVertexData, m_Position));
+
+			glEnableVertexAttribArray(CShaderProgram::Normal);  // Normal
+			glVertexAttribPointer(CShaderProgram::Normal, 3, GL_FLOAT, GL_TRUE, sizeof(SVertexData), OFFSET(SVertexData, m_Normal));
+
+			glEnableVertexAttribArray(CShaderProgram::Tangent);  // Tangent
+			glVertexAttribPointer(CShaderProgram::Tangent, 4, GL_FLOAT, GL_FALSE, sizeof(SVertexData), OFFSET(SVertexData, m_Tangent));
+
+			glEnableVertexAttribArray(CShaderProgram::Color);  // Color
+			glVertexAttribPointer(CShaderProgram::Color, 3, GL_FLOAT, GL_FALSE, sizeof(SVertexData), OFFSET(SVertexData, m_Color));
+
+			glEnableVertexAttribArray(CShaderProgram::UV);  // UV
+			glVertexAttribPointer(CShaderProgram::UV, 2, GL_FLOAT, GL_FALSE, sizeof(SVertexData), OFFSET(SVertexData, m_UV));
+		}
+#undef OFFSET
+
+		if (vertex_array == pool.m_VertexArrays[0])
+		{
+			CStateCache::Instance().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer);
+		}
+
+		// Per instance matrices, one column per location. The render queue points these at its
+		// instance buffer before each draw, as GLES3 has no base instance to offset them with
+		for (GLuint column = 0; column < 4; ++column)
+		{
+			glEnableVertexAttribArray(CShaderProgram::InstanceMatrix + column);
+			glVertexAttribDivisor(CShaderProgram::InstanceMatrix + column, 1);
+		}
+	}
+
+	// Unbind VAO, so later element array binds can't end up in it
+	CStateCache::Instance().BindVertexArray(0);
+}
+}  // namespace NRender
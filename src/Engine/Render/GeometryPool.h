@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include "Utils/BufferAllocator.h"
+#include "Utils/Singleton.h"
+
+#include <SDL_opengl.h>
+
+#include <stddef.h>
+
+#include <array>
+
+namespace NRender
+{
+// Where a mesh's vertices and indices live in the shared buffers of its vertex format
+struct SGeometryRange
+{
+	EVertexFormat m_Format = EVertexFormat::Float;
+	size_t m_FirstVertex = 0;
+	size_t m_VertexCount = 0;
+	size_t m_FirstIndex = 0;
+	size_t m_IndexCount = 0;
+};
+
+/**
+ * Shared vertex and index buffers every mesh is sub-allocated from, one vertex
+ * buffer and vertex array per vertex format and a single index buffer. Meshes
+ * of a format are drawn through the same vertex array, so switching between
+ * them binds nothing. GLES3 has no base vertex draws, so indices are rebased
+ * onto the mesh's first vertex as they are uploaded instead, and culled cluster
+ * indices are rebased the same way. Buffers grow by copying on the GPU.
+ **/
+class CGeometryPool : public TSingleton<CGeometryPool>
+{
+public:
+	~CGeometryPool();
+
+	SGeometryRange Allocate(const SMesh& mesh);
+	void Free(const SGeometryRange& range);
+
+	// Draws from the shared index buffer
+	GLuint VertexArray(EVertexFormat format) const { return m_Pools[size_t(format)].m_VertexArrays[0]; }
+
+	// Same vertices without indices, the render queue attaches its cluster indices
+	GLuint ClusterVertexArray(EVertexFormat format) const { return m_Pools[size_t(format)].m_VertexArrays[1]; }
+
+private:
+	struct SPool
+	{
+		std::array<GLuint, 2> m_VertexArrays = {};
+		GLuint m_VertexBuffer = 0;
+		NUtils::CRangeAllocator m_Vertices;
+	};
+
+	// Allocates, growing the buffer when nothing fits. Buffers are copied over to a larger one.
+	static size_t Allocate(NUtils::CRangeAllocator& allocator, GLuint& buffer, GLenum target, size_t element_size, size_t count);
+
+	void SetupVertexArrays(EVertexFormat format);
+
+	std::array<SPool, 2> m_Pools;
+	GLuint m_IndexBuffer = 0;
+	NUtils::CRangeAllocator m_Indices;
+};
+}  // namespace NRender
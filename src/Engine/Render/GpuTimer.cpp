@@ -0,0 +1,114 @@
+#include "GpuTimer.h"
+
+#include <emscripten/html5.h>
+
+#include <stdio.h>
+
+#ifndef GL_TIME_ELAPSED_EXT
+#define GL_TIME_ELAPSED_EXT 0x88BF
+#endif
+
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+namespace NRender
+{
+CGpuTimer::~CGpuTimer()
+{
+	for (const SQuery& query : m_Pending)
+	{
+		glDeleteQueries(1, &query.m_Query);
+	}
+
+	if (!m_Free.empty())
+	{
+		glDeleteQueries(GLsizei(m_Free.size()), m_Free.data());
+	}
+}
+
+bool CGpuTimer::Initialize()
+{
+	// Browsers may leave the extension out, or expose it with coarsened timings
+	m_Supported = emscripten_webgl_enable_extension(emscripten_webgl_get_current_context(), "EXT_disjoint_timer_query_webgl2");
+
+	if (!m_Supported)
+	{
+		printf("GPU timer queries aren't supported, GPU times won't be profiled\n");
+	}
+
+	return m_Supported;
+}
+
+void CGpuTimer::BeginFrame()
+{
+	if (!m_Supported || m_Pending.empty())
+	{
+		return;
+	}
+
+	// A disjoint operation, like a clock change, invalidates every query in flight
+	GLint disjoint = 0;
+	glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+	while (!m_Pending.empty())
+	{
+		const SQuery& query = m_Pending.front();
+
+		if (!disjoint)
+		{
+			GLuint available = 0;
+			glGetQueryObjectuiv(query.m_Query, GL_QUERY_RESULT_AVAILABLE, &available);
+
+			// Queries finish in order, so nothing after this one is ready either
+			if (!available)
+			{
+				break;
+			}
+
+			GLuint nanoseconds = 0;
+			glGetQueryObjectuiv(query.m_Query, GL_QUERY_RESULT, &nanoseconds);
+			NUtils::CProfiler::Instance().AddGpuZone(query.m_Frame, query.m_Name, query.m_Start, nanoseconds * 1e-6);
+		}
+
+		m_Free.push_back(query.m_Query);
+		m_Pending.pop_front();
+	}
+}
+
+void CGpuTimer::Begin(const char* name)
+{
+	if (m_Depth++ > 0 || !m_Supported || !NUtils::CProfiler::IsEnabled())
+	{
+		return;
+	}
+
+	if (m_Free.empty())
+	{
+		m_Free.push_back(0);
+		glGenQueries(1, &m_Free.back());
+	}
+
+	SQuery query;
+	query.m_Query = m_Free.back();
+	query.m_Name = name;
+	query.m_Frame = NUtils::CProfiler::Instance().FrameIndex();
+	query.m_Start = NUtils::CProfiler::Now();
+	m_Free.pop_back();
+
+	glBeginQuery(GL_TIME_ELAPSED_EXT, query.m_Query);
+	m_Pending.push_back(query);
+	m_Active = true;
+}
+
+void CGpuTimer::End()
+{
+	if (--m_Depth > 0 || !m_Active)
+	{
+		return;
+	}
+
+	glEndQuery(GL_TIME_ELAPSED_EXT);
+	m_Active = false;
+}
+}  // namespace NRender
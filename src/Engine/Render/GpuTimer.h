@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Utils/Profiler.h"
+#include "Utils/Singleton.h"
+
+#include <SDL_opengl.h>
+
+#include <stdint.h>
+
+#include <deque>
+#include <vector>
+
+namespace NRender
+{
+/**
+ * Times GPU work with EXT_disjoint_timer_query_webgl2 and hands the results to
+ * the profiler, a few frames after the work was issued. Elapsed time queries
+ * can't nest, so zones opened inside another one are folded into it. Without
+ * the extension, or with the profiler disabled, every call does nothing.
+ **/
+class CGpuTimer : public TSingleton<CGpuTimer>
+{
+public:
+	~CGpuTimer();
+
+	bool Initialize();
+	bool IsSupported() const { return m_Supported; }
+
+	// Collects the results that are ready, call once per frame after the profiler's BeginFrame
+	void BeginFrame();
+
+	void Begin(const char* name);
+	void End();
+
+private:
+	struct SQuery
+	{
+		GLuint m_Query;
+		const char* m_Name;
+		uint64_t m_Frame;
+		uint64_t m_Start;
+	};
+
+	bool m_Supported = false;
+	size_t m_Depth = 0;
+	bool m_Active = false;
+
+	std::vector<GLuint> m_Free;
+	std::deque<SQuery> m_Pending;
+};
+
+class CGpuZone
+{
+public:
+	explicit CGpuZone(const char* name) { CGpuTimer::Instance().Begin(name); }
+	~CGpuZone() { CGpuTimer::Instance().End(); }
+
+	CGpuZone(const CGpuZone&) = delete;
+	CGpuZone& operator=(const CGpuZone&) = delete;
+};
+}  // namespace NRender
+
+// Times the GPU work issued in the rest of the enclosing scope, names have to be literals
+#define PROFILE_GPU_ZONE(name) NRender::CGpuZone PROFILE_CONCAT(profile_gpu_zone_, __LINE__)(name)
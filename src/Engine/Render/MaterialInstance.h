@@ -2,6 +2,8 @@
 
 #include <SDL_opengl.h>
 
+#include <stdint.h>
+
 #include <memory>
 #include <array>
 
@@ -10,25 +12,25 @@ namespace NRender
 struct SMaterial;
 using HMaterial = std::shared_ptr<SMaterial>;
 
-struct STexture;
-using HTexture = std::shared_ptr<STexture>;
+class CTextureResource;
+using HTextureResource = std::shared_ptr<CTextureResource>;
 
 class CMaterialInstance
 {
 public:
 	CMaterialInstance(HMaterial material);
-	~CMaterialInstance();
 
 	void Reload();
 	void Bind();
-	void Unbind();
+
+	// Small id unique to the instance, used to group draws in the render queue
+	uint16_t SortID() const { return m_SortID; }
 
 private:
-	void CreateTexture(size_t index, HTexture texture);
 	void CreateTextures();
-	void DestroyTextures();
 
 	HMaterial m_Material;
-	std::array<GLuint, 2> m_Textures;
+	std::array<HTextureResource, 2> m_Textures;
+	uint16_t m_SortID;
 };
 }  // namespace NRender
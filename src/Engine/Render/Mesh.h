@@ -12,6 +12,12 @@ namespace NRender
 struct SMaterial;
 using HMaterial = std::shared_ptr<SMaterial>;
 
+enum class EVertexFormat : uint8_t
+{
+	Float,
+	Packed,
+};
+
 struct SMesh
 {
 	struct SVector2
@@ -44,6 +50,101 @@ struct SMesh
 		SVector2 m_UV;
 	};
 
+	// Positions are unorm within the submesh bounds with the tangent handedness in w,
+	// normals and tangents are octahedral snorm, color is unorm and UVs are half floats
+	struct SPackedVertexData
+	{
+		uint16_t m_Position[4] = {};
+		int16_t m_Normal[2] = {};
+		int16_t m_Tangent[2] = {};
+		uint8_t m_Color[4] = { 255, 255, 255, 255 };
+		uint16_t m_UV[2] = {};
+	};
+
+	// Axis aligned box and the bounding sphere around its center, in mesh space
+	struct SBounds
+	{
+		SVector3 m_Min;
+		SVector3 m_Max;
+		SVector3 m_Center;
+		float m_Radius = 0.0f;
+	};
+
+	// Coarser index range over the same vertices, error is the surface deviation in mesh units
+	struct SLod
+	{
+		size_t m_IndexOffset = 0;
+		size_t m_IndexCount = 0;
+		float m_Error = 0.0f;
+	};
+
+	/**
+	 * Clusters of full detail triangles, each a contiguous run of its submesh's index
+	 * range, with a bounding sphere and a cone bounding the triangle normals. Kept as
+	 * structure of arrays so the clusters of a submesh cull as a single batch. A
+	 * cluster faces away from any eye where dot(center - eye, axis) >= cutoff *
+	 * |center - eye| + radius, a cutoff of 1 never does.
+	 **/
+	struct SMeshlets
+	{
+		std::vector<uint32_t> m_IndexOffset;
+		std::vector<uint32_t> m_IndexCount;
+		std::vector<float> m_CenterX, m_CenterY, m_CenterZ, m_Radius;
+		std::vector<float> m_AxisX, m_AxisY, m_AxisZ, m_Cutoff;
+
+		size_t Size() const { return m_IndexOffset.size(); }
+
+		void Resize(size_t size)
+		{
+			for (std::vector<uint32_t>* values : { &m_IndexOffset, &m_IndexCount })
+			{
+				values->resize(size);
+			}
+
+			for (std::vector<float>* values : { &m_CenterX, &m_CenterY, &m_CenterZ, &m_Radius, &m_AxisX, &m_AxisY, &m_AxisZ, &m_Cutoff })
+			{
+				values->resize(size);
+			}
+		}
+	};
+
+	/**
+	 * Bounding volume hierarchy over the full detail triangles of every submesh, for
+	 * ray queries on the CPU. Inner nodes have no count and their children next to
+	 * each other at m_First, a leaf's count triangles fill the blocks from m_First.
+	 * Blocks hold four triangles side by side, as a corner and the edges to the
+	 * other two, already dequantized, so leaves are intersected four at a time.
+	 * Lanes past a leaf's last triangle have no edges and are never hit.
+	 **/
+	struct SBvh
+	{
+		static constexpr uint32_t NoTriangle = ~0u;
+
+		// Raycasts keep a fixed size stack, so no leaf sits deeper than this below the root
+		static constexpr size_t MaxDepth = 60;
+
+		struct SNode
+		{
+			float m_Min[3];
+			uint32_t m_First;
+			float m_Max[3];
+			uint32_t m_Count;
+		};
+
+		struct STriangleBlock
+		{
+			float m_X[4], m_Y[4], m_Z[4];
+			float m_Edge1X[4], m_Edge1Y[4], m_Edge1Z[4];
+			float m_Edge2X[4], m_Edge2Y[4], m_Edge2Z[4];
+
+			// Where each triangle's indices start in m_Indices, NoTriangle for empty lanes
+			uint32_t m_Index[4];
+		};
+
+		std::vector<SNode> m_Nodes;
+		std::vector<STriangleBlock> m_Blocks;
+	};
+
 	struct SSubMesh
 	{
 		std::string m_Name;
@@ -52,11 +153,48 @@ struct SMesh
 		size_t m_IndexOffset = 0;
 		size_t m_IndexCount = 0;
 		size_t m_Material = 0;
+		SBounds m_Bounds;
+
+		// Packed positions dequantize as position * scale + offset
+		SVector3 m_QuantizationOffset;
+		SVector3 m_QuantizationScale = { 1.0f, 1.0f, 1.0f };
+
+		// Level 0 is the range above, the rest are m_Lods ordered by increasing error
+		std::vector<SLod> m_Lods;
+
+		// Clusters of the full detail range in SMesh::m_Meshlets, none unless built at cook time
+		size_t m_FirstMeshlet = 0;
+		size_t m_MeshletCount = 0;
+
+		size_t LodCount() const { return m_Lods.size() + 1; }
+		size_t LodIndexOffset(size_t lod) const { return lod ? m_Lods[lod - 1].m_IndexOffset : m_IndexOffset; }
+		size_t LodIndexCount(size_t lod) const { return lod ? m_Lods[lod - 1].m_IndexCount : m_IndexCount; }
+
+		// Coarsest level whose error stays within max_error, in mesh units
+		size_t SelectLod(float max_error) const
+		{
+			size_t lod = 0;
+
+			while (lod < m_Lods.size() && m_Lods[lod].m_Error <= max_error)
+			{
+				++lod;
+			}
+
+			return lod;
+		}
 	};
 
+	// Only the vector matching m_VertexFormat is populated
+	EVertexFormat m_VertexFormat = EVertexFormat::Float;
 	std::vector<SVertexData> m_Vertices;
+	std::vector<SPackedVertexData> m_PackedVertices;
 	std::vector<uint32_t> m_Indices;
 	std::vector<HMaterial> m_Materials;
 	std::vector<SSubMesh> m_SubMeshes;
+	SMeshlets m_Meshlets;
+
+	// Empty unless built at cook or load time
+	SBvh m_Bvh;
+	SBounds m_Bounds;
 };
 }  // namespace NRender
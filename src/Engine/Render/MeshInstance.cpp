@@ -1,134 +1,176 @@
 #include "MeshInstance.h"
 
+#include "ClusterCulling.h"
 #include "Mesh.h"
 #include "MaterialInstance.h"
+#include "MeshResource.h"
+#include "OcclusionBuffer.h"
+#include "Raycast.h"
+#include "RenderQueue.h"
+#include "RenderStats.h"
 
-#include <SDL_opengl.h>
-#include <SDL_image.h>
+#include <Engine/Camera.h>
+#include <Engine/SceneBvh.h>
+
+#include <math.h>
+
+#include <algorithm>
 
 namespace NRender
 {
-CMeshInstance::CMeshInstance(std::shared_ptr<SMesh> mesh)
-	: m_Mesh(mesh)
-{
-	m_Transform.setIdentity();
-	CreateBuffers();
-}
+// Coarser levels are drawn while their error stays below this many pixels on screen
+constexpr float LOD_PIXEL_ERROR = 1.0f;
 
-CMeshInstance::~CMeshInstance()
+CMeshInstance::CMeshInstance(HMeshResource resource, CTransformHierarchy& transforms, uint32_t parent)
+	: m_Resource(resource)
+	, m_Transforms(&transforms)
+	, m_Node(transforms.Add(parent))
 {
-	DestroyBuffers();
 }
 
-void CMeshInstance::CreateBuffers()
+void CMeshInstance::Submit(CRenderQueue& queue, const CCamera& camera, const COcclusionBuffer* occlusion)
 {
-	// Clean up old buffers
-	DestroyBuffers();
+	SFrameStats& stats = CRenderStats::Instance().Current();
+	const SMesh& mesh = m_Resource->Mesh();
+	const CTransform& transform = m_Transforms->World(m_Node);
 
-	// Load materials
-	m_Materials.reserve(m_Mesh->m_Materials.size());
-	for (const NRender::HMaterial& material : m_Mesh->m_Materials)
+	// Cull in model space so the mesh and submesh boxes never need transforming
+	const CFrustum frustum = camera.frustum().Transformed(transform);
+
+	if (!frustum.TestBox(CVector3f(&mesh.m_Bounds.m_Min.m_X), CVector3f(&mesh.m_Bounds.m_Max.m_X)))
 	{
-		HMaterialInstance material_instance = std::make_shared<CMaterialInstance>(material);
-		m_Materials.push_back(material_instance);
+		++stats.m_CulledInstances;
+		stats.m_CulledSubMeshes += mesh.m_SubMeshes.size();
+		return;
 	}
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	// Generate and bind VAO
-	glGenVertexArrays(m_VAO.size(), m_VAO.data());
-	glBindVertexArray(m_VAO[0]);
-
-	// Generate buffer objects
-	glGenBuffers(m_VBO.size(), m_VBO.data());
 
-	// Setup vertices
-#define OFFSET(TYPE, MEMBER) ((void*)&((TYPE*)0)->MEMBER)
-	using SVertexData = NRender::SMesh::SVertexData;
-
-	printf("Vertices, vertex size, buffer size: %lu, %lu, %lu\n",
-		   m_Mesh->m_Vertices.size(),
-		   sizeof(SVertexData),
-		   m_Mesh->m_Vertices.size() * sizeof(SVertexData));
-
-	glBindBuffer(GL_ARRAY_BUFFER, m_VBO[0]);
-	glBufferData(GL_ARRAY_BUFFER, m_Mesh->m_Vertices.size() * sizeof(SVertexData), m_Mesh->m_Vertices.data(), GL_STATIC_DRAW);
-
-	glEnableVertexAttribArray(0);  // Position
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(SVertexData), OFFSET(SVertexData, m_Position));
-
-	glEnableVertexAttribArray(1);  // Normal
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_TRUE, sizeof(SVertexData), OFFSET(SVertexData, m_Normal));
+	if (occlusion && occlusion->IsOccluded(CVector3f(&mesh.m_Bounds.m_Min.m_X), CVector3f(&mesh.m_Bounds.m_Max.m_X), transform))
+	{
+		++stats.m_OccludedInstances;
+		stats.m_OccludedSubMeshes += mesh.m_SubMeshes.size();
+		return;
+	}
 
-	glEnableVertexAttribArray(2);  // Tangent
-	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(SVertexData), OFFSET(SVertexData, m_Tangent));
+	++stats.m_VisibleInstances;
 
-	glEnableVertexAttribArray(3);  // Color
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(SVertexData), OFFSET(SVertexData, m_Color));
+	const CTransform model_view = camera.viewMatrix() * transform;
 
-	glEnableVertexAttribArray(4);  // UV
-	glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, sizeof(SVertexData), OFFSET(SVertexData, m_UV));
-#undef OFFSET
+	// Errors are in mesh units, the largest axis scale bounds how much the transform enlarges them
+	const CVector3f axis_scales = transform.linear().colwise().norm();
+	const float scale = axis_scales.maxCoeff();
 
-	printf("Indices, indices size, buffer size: %lu, %lu, %lu\n",
-		   m_Mesh->m_Indices.size(),
-		   sizeof(size_t),
-		   m_Mesh->m_Indices.size() * sizeof(size_t));
+	// Clusters are culled in mesh space too, their normal cones only survive uniform scale
+	const CVector3f eye = transform.inverse() * camera.position();
+	const bool cull_backfaces = axis_scales.minCoeff() >= scale * 0.999f;
 
-	// Setup indices
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_VBO[1]);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_Mesh->m_Indices.size() * sizeof(m_Mesh->m_Indices[0]), m_Mesh->m_Indices.data(), GL_STATIC_DRAW);
+	SDrawPacket packet;
+	packet.m_PackedVertices = mesh.m_VertexFormat == EVertexFormat::Packed;
+	packet.m_Transform = &transform;
+	packet.m_FirstIndex = uint32_t(m_Resource->FirstIndex());
 
-	// Unbind VAO
-	glBindVertexArray(0);
+	for (size_t i = 0; i < mesh.m_SubMeshes.size(); ++i)
+	{
+		const SMesh::SSubMesh& sub_mesh = mesh.m_SubMeshes[i];
+
+		if (!frustum.TestBox(CVector3f(&sub_mesh.m_Bounds.m_Min.m_X), CVector3f(&sub_mesh.m_Bounds.m_Max.m_X)))
+		{
+			++stats.m_CulledSubMeshes;
+			continue;
+		}
+
+		// A single submesh has the bounds of the whole mesh, which were just tested
+		if (occlusion && mesh.m_SubMeshes.size() > 1 && occlusion->IsOccluded(CVector3f(&sub_mesh.m_Bounds.m_Min.m_X), CVector3f(&sub_mesh.m_Bounds.m_Max.m_X), transform))
+		{
+			++stats.m_OccludedSubMeshes;
+			continue;
+		}
+
+		++stats.m_VisibleSubMeshes;
+
+		// The camera looks down -z, so the depth is the negated view space z of the submesh center
+		const CVector3f center = model_view * CVector3f(&sub_mesh.m_Bounds.m_Center.m_X);
+		const float depth = -center.z();
+
+		// The nearest point of the bounding sphere sees the largest error, errors are judged there
+		const float distance = std::max(center.norm() - sub_mesh.m_Bounds.m_Radius * scale, 0.0f);
+		const float pixel_size = camera.pixelSize(distance);
+		const uint32_t lod = scale > 0.0f ? sub_mesh.SelectLod(pixel_size * LOD_PIXEL_ERROR / scale) : 0;
+
+		stats.m_FullDetailTriangles += sub_mesh.m_IndexCount / 3;
+
+		packet.m_VertexArray = m_Resource->VertexArray();
+		packet.m_ClusterIndexOffset = 0;
+		packet.m_ClusterIndexCount = 0;
+
+		// Full detail draws only what survives cluster culling once the submesh is big enough on screen, coarser
+		// levels and small submeshes are cheaper drawn whole and instanced
+		const float view_height = pixel_size * camera.vpHeight();
+		const float screen_size = view_height > 0.0f ? 2.0f * sub_mesh.m_Bounds.m_Radius * scale / view_height : INFINITY;
+
+		if (lod == 0 && ShouldCullMeshlets(sub_mesh, screen_size))
+		{
+			std::vector<uint32_t>& indices = queue.ClusterIndices();
+			const size_t offset = indices.size();
+			const size_t visible = CullMeshlets(mesh, sub_mesh, frustum, eye, scale, cull_backfaces, uint32_t(m_Resource->FirstVertex()), indices);
+
+			stats.m_VisibleMeshlets += visible;
+			stats.m_CulledMeshlets += sub_mesh.m_MeshletCount - visible;
+
+			if (visible == 0)
+			{
+				continue;
+			}
+
+			packet.m_VertexArray = m_Resource->ClusterVertexArray();
+			packet.m_ClusterIndexOffset = uint32_t(offset);
+			packet.m_ClusterIndexCount = uint32_t(indices.size() - offset);
+		}
+
+		stats.m_Triangles += packet.m_ClusterIndexCount ? packet.m_ClusterIndexCount / 3 : sub_mesh.LodIndexCount(lod) / 3;
+
+		packet.m_Material = m_Resource->Material(sub_mesh.m_Material);
+		packet.m_SubMesh = &sub_mesh;
+		packet.m_Lod = lod;
+		packet.m_Key = CRenderQueue::MakeSortKey(0, packet.m_Material->SortID(), packet.m_VertexArray, i, lod, depth);
+		queue.Push(packet);
+	}
 }
 
-void CMeshInstance::DestroyBuffers()
+void CMeshInstance::AddOccluder(COcclusionBuffer& occlusion) const
 {
-	glDeleteBuffers(m_VBO.size(), m_VBO.data());
-	m_VBO.fill(0);
-
-	glDeleteVertexArrays(m_VAO.size(), m_VAO.data());
-	m_VAO.fill(0);
+	occlusion.AddOccluder(m_Resource->Mesh(), m_Transforms->World(m_Node));
 }
 
-void CMeshInstance::Draw()
+void CMeshInstance::WorldBounds(CVector3f& min, CVector3f& max) const
 {
-	GLint program;
-	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
-	glUniformMatrix4fv(glGetUniformLocation(program, "ModelMatrix"), 1, GL_FALSE, m_Transform.data());
+	const SMesh::SBounds& bounds = m_Resource->Mesh().m_Bounds;
+	CSceneBvh::TransformBounds(m_Transforms->World(m_Node), CVector3f(&bounds.m_Min.m_X), CVector3f(&bounds.m_Max.m_X), min, max);
+}
 
-	glBindVertexArray(m_VAO[0]);
-	for (const auto& sub_mesh : m_Mesh->m_SubMeshes)
-	{
-		m_Materials[sub_mesh.m_Material]->Bind();
-		glDrawElements(GL_TRIANGLES, sub_mesh.m_IndexCount, GL_UNSIGNED_INT, (void*)(sub_mesh.m_IndexOffset * sizeof(size_t)));
-		m_Materials[sub_mesh.m_Material]->Unbind();
-	}
-	glBindVertexArray(0);
+bool CMeshInstance::Raycast(const CVector3f& origin, const CVector3f& direction, float max_distance, SRayHit& hit) const
+{
+	// The direction is brought in unnormalized, so the mesh space distance is the world space one
+	const CTransform inverse = m_Transforms->World(m_Node).inverse();
+	return RaycastClosest(m_Resource->Mesh(), inverse * origin, inverse.linear() * direction, max_distance, hit);
 }
 
 void CMeshInstance::Scale(const float scale)
 {
-	m_Transform.scale(scale);
+	m_Transforms->Scale(m_Node, scale);
 }
 
 void CMeshInstance::Rotate(const CMatrix3f& rotation)
 {
-	m_Transform.rotate(rotation);
+	m_Transforms->Rotate(m_Node, CQuaternion(rotation));
 }
 
-void CMeshInstance::SetPosition(const CVector3f& position)
+void CMeshInstance::SetRotation(const CQuaternion& rotation)
 {
-	m_Transform.translation() = position;
+	m_Transforms->SetRotation(m_Node, rotation);
 }
 
-void CMeshInstance::Reload()
+void CMeshInstance::SetPosition(const CVector3f& position)
 {
-	CreateBuffers();
-
-	for (HMaterialInstance& material : m_Materials)
-	{
-		material->Reload();
-	}
+	m_Transforms->SetPosition(m_Node, position);
 }
 };	// namespace NRender
@@ -1,45 +1,54 @@
 #pragma once
 
-#include <Engine/Math.h>
-
-#include <SDL_opengl.h>
+#include "MeshResource.h"
 
-#include <array>
-#include <memory>
-#include <vector>
+#include <Engine/Math.h>
+#include <Engine/TransformHierarchy.h>
 
-struct SDL_Surface;
-struct SDL_Texture;
+class CCamera;
 
 namespace NRender
 {
-struct SMesh;
-using HMesh = std::shared_ptr<SMesh>;
-
-class CMaterialInstance;
-using HMaterialInstance = std::shared_ptr<CMaterialInstance>;
+class COcclusionBuffer;
+class CRenderQueue;
+struct SRayHit;
 
+// Placement of a shared mesh resource, instances of a resource are batched into instanced draws.
+// The placement is a node of a transform hierarchy, which has to be updated before submitting.
 class CMeshInstance
 {
 public:
-	CMeshInstance(std::shared_ptr<SMesh> mesh);
-	~CMeshInstance();
+	CMeshInstance(HMeshResource resource, CTransformHierarchy& transforms, uint32_t parent = CTransformHierarchy::NoParent);
+
+	// Queues a packet per submesh, skipping the instance and any submeshes outside the camera's frustum
+	// or, given a finished occlusion buffer, hidden behind its occluders
+	void Submit(CRenderQueue& queue, const CCamera& camera, const COcclusionBuffer* occlusion = nullptr);
+
+	// Occluders are drawn into the occlusion buffer, large solid meshes make good ones
+	void SetOccluder(bool occluder) { m_Occluder = occluder; }
+	bool IsOccluder() const { return m_Occluder; }
+	void AddOccluder(COcclusionBuffer& occlusion) const;
 
-	void Draw();
 	void Scale(const float scale);
 	void Rotate(const CMatrix3f& rotation);
+	void SetRotation(const CQuaternion& rotation);
 	void SetPosition(const CVector3f& position);
 	void SetPosition(float x, float y, float z) { SetPosition(CVector3f(x, y, z)); };
-	void Reload();
+
+	// Other nodes can be parented to the instance's
+	uint32_t Node() const { return m_Node; }
+
+	// World space box around the mesh, and whether it changed with the last hierarchy update
+	void WorldBounds(CVector3f& min, CVector3f& max) const;
+	bool Moved() const { return m_Transforms->Updated(m_Node); }
+
+	// Closest triangle along a world space ray, distances stay in lengths of direction
+	bool Raycast(const CVector3f& origin, const CVector3f& direction, float max_distance, SRayHit& hit) const;
 
 private:
-	void CreateBuffers();
-	void DestroyBuffers();
-
-	HMesh m_Mesh;
-	CMatrix4f m_Transform;
-	std::array<GLuint, 1> m_VAO = {};
-	std::array<GLuint, 2> m_VBO = {};
-	std::vector<HMaterialInstance> m_Materials;
+	HMeshResource m_Resource;
+	CTransformHierarchy* m_Transforms;
+	uint32_t m_Node;
+	bool m_Occluder = false;
 };
 };	// namespace NRender
@@ -0,0 +1,64 @@
+#include "MeshResource.h"
+
+#include "Mesh.h"
+#include "MaterialInstance.h"
+#include "ResourceCache.h"
+
+namespace NRender
+{
+CMeshResource::CMeshResource(HMesh mesh)
+	: m_Mesh(mesh)
+{
+	CreateBuffers();
+}
+
+CMeshResource::~CMeshResource()
+{
+	DestroyBuffers();
+}
+
+void CMeshResource::Reload()
+{
+	CreateBuffers();
+
+	for (HMaterialInstance& material : m_Materials)
+	{
+		material->Reload();
+	}
+}
+
+size_t CMeshResource::Size() const
+{
+	const size_t vertex_size = m_Mesh->m_VertexFormat == EVertexFormat::Packed ? sizeof(SMesh::SPackedVertexData) : sizeof(SMesh::SVertexData);
+	const size_t vertex_count = m_Mesh->m_VertexFormat == EVertexFormat::Packed ? m_Mesh->m_PackedVertices.size() : m_Mesh->m_Vertices.size();
+
+	return vertex_count * vertex_size + m_Mesh->m_Indices.size() * sizeof(m_Mesh->m_Indices[0]);
+}
+
+void CMeshResource::CreateBuffers()
+{
+	// Clean up old buffers
+	DestroyBuffers();
+
+	// Load materials, shared with any other mesh using them
+	m_Materials.clear();
+	m_Materials.reserve(m_Mesh->m_Materials.size());
+	for (const NRender::HMaterial& material : m_Mesh->m_Materials)
+	{
+		m_Materials.push_back(CResourceCache::Instance().GetMaterial(material));
+	}
+
+	// Vertices and indices go to a range of the buffers every mesh shares
+	m_Range = CGeometryPool::Instance().Allocate(*m_Mesh);
+	m_Allocated = true;
+}
+
+void CMeshResource::DestroyBuffers()
+{
+	if (m_Allocated)
+	{
+		CGeometryPool::Instance().Free(m_Range);
+		m_Allocated = false;
+	}
+}
+}  // namespace NRender
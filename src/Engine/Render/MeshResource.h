@@ -0,0 +1,51 @@
+#pragma once
+
+#include "GeometryPool.h"
+
+#include <SDL_opengl.h>
+
+#include <memory>
+#include <vector>
+
+namespace NRender
+{
+struct SMesh;
+using HMesh = std::shared_ptr<SMesh>;
+
+class CMaterialInstance;
+using HMaterialInstance = std::shared_ptr<CMaterialInstance>;
+
+// GPU side of a mesh, its range of the shared buffers and its materials are used by every instance drawing it
+class CMeshResource
+{
+public:
+	CMeshResource(HMesh mesh);
+	~CMeshResource();
+
+	// Uploads the buffers and the textures of every material again
+	void Reload();
+
+	const SMesh& Mesh() const { return *m_Mesh; }
+	size_t Size() const;
+	GLuint VertexArray() const { return CGeometryPool::Instance().VertexArray(m_Range.m_Format); }
+
+	// Same vertices without an index buffer, the render queue attaches its cluster indices
+	GLuint ClusterVertexArray() const { return CGeometryPool::Instance().ClusterVertexArray(m_Range.m_Format); }
+
+	// The mesh's indices start here in the shared index buffer, rebased onto its first vertex
+	size_t FirstIndex() const { return m_Range.m_FirstIndex; }
+	size_t FirstVertex() const { return m_Range.m_FirstVertex; }
+	CMaterialInstance* Material(size_t index) const { return m_Materials[index].get(); }
+
+private:
+	void CreateBuffers();
+	void DestroyBuffers();
+
+	HMesh m_Mesh;
+	SGeometryRange m_Range;
+	bool m_Allocated = false;
+	std::vector<HMaterialInstance> m_Materials;
+};
+
+using HMeshResource = std::shared_ptr<CMeshResource>;
+}  // namespace NRender
@@ -0,0 +1,320 @@
+#include "OcclusionBuffer.h"
+
+#include <Engine/Camera.h>
+#include <Utils/MeshQuantizer.h>
+#include <Utils/Profiler.h>
+
+#include <math.h>
+
+#include <algorithm>
+
+namespace NRender
+{
+namespace
+{
+// Occludee rects grow by a texel for occluders sampled at pixel centers
+constexpr int32_t OCCLUDEE_MARGIN = 1;
+
+// Occluders use the coarsest level whose error stays within this fraction of a texel
+constexpr float OCCLUDER_TEXEL_ERROR = 0.25f;
+
+uint16_t RoundUpToPowerOfTwo(uint16_t value)
+{
+	uint16_t rounded = 1;
+
+	while (rounded < value && rounded < 0x8000)
+	{
+		rounded <<= 1;
+	}
+
+	return rounded;
+}
+
+double Milliseconds(uint64_t start)
+{
+	return double(NUtils::CProfiler::Now() - start) * 1e-6;
+}
+}  // namespace
+
+COcclusionBuffer::COcclusionBuffer(uint16_t width, uint16_t height)
+	: m_Width(RoundUpToPowerOfTwo(width))
+	, m_Height(RoundUpToPowerOfTwo(height))
+{
+	for (size_t level = 0;; ++level)
+	{
+		const size_t level_width = std::max(m_Width >> level, 1);
+		const size_t level_height = std::max(m_Height >> level, 1);
+		m_Levels.emplace_back(level_width * level_height, 1.0f);
+
+		if (level_width == 1 && level_height == 1)
+		{
+			break;
+		}
+	}
+}
+
+void COcclusionBuffer::Begin(const CCamera& camera)
+{
+	std::fill(m_Levels[0].begin(), m_Levels[0].end(), 1.0f);
+
+	m_ViewProjection = camera.projectionMatrix().matrix() * camera.viewMatrix().matrix();
+	m_Frustum = camera.frustum();
+	m_Eye = camera.position();
+	m_TexelScale = 2.0f * tanf(camera.fovY() * 0.5f) / m_Height;
+	m_Ready = false;
+	m_Stats = SOcclusionStats();
+}
+
+void COcclusionBuffer::AddOccluder(const SMesh& mesh, const CTransform& transform)
+{
+	const uint64_t start = NUtils::CProfiler::Now();
+	++m_Stats.m_Occluders;
+
+	const CFrustum frustum = m_Frustum.Transformed(transform);
+
+	if (!frustum.TestBox(CVector3f(&mesh.m_Bounds.m_Min.m_X), CVector3f(&mesh.m_Bounds.m_Max.m_X)))
+	{
+		m_Stats.m_BuildMs += Milliseconds(start);
+		return;
+	}
+
+	const Eigen::Matrix4f model_view_projection = m_ViewProjection * transform.matrix();
+	const float scale = transform.linear().colwise().norm().maxCoeff();
+	m_Positions.resize(mesh.m_VertexFormat == EVertexFormat::Packed ? mesh.m_PackedVertices.size() : mesh.m_Vertices.size());
+
+	for (const SMesh::SSubMesh& sub_mesh : mesh.m_SubMeshes)
+	{
+		if (!frustum.TestBox(CVector3f(&sub_mesh.m_Bounds.m_Min.m_X), CVector3f(&sub_mesh.m_Bounds.m_Max.m_X)))
+		{
+			continue;
+		}
+
+		// Errors are judged at the nearest point of the bounding sphere, like draws judge theirs
+		const CVector3f center = transform * CVector3f(&sub_mesh.m_Bounds.m_Center.m_X);
+		const float distance = std::max((center - m_Eye).norm() - sub_mesh.m_Bounds.m_Radius * scale, 0.0f);
+		const size_t lod = scale > 0.0f ? sub_mesh.SelectLod(distance * m_TexelScale * OCCLUDER_TEXEL_ERROR / scale) : 0;
+
+		for (size_t v = sub_mesh.m_VertexOffset; v < sub_mesh.m_VertexOffset + sub_mesh.m_VertexCount; ++v)
+		{
+			m_Positions[v] = model_view_projection * NUtils::GetVertexPosition(mesh, sub_mesh, v).homogeneous();
+		}
+
+		const size_t first = sub_mesh.LodIndexOffset(lod);
+		const size_t last = first + sub_mesh.LodIndexCount(lod);
+
+		for (size_t i = first; i + 2 < last; i += 3)
+		{
+			const CVector4f* triangle[3] = { &m_Positions[mesh.m_Indices[i]], &m_Positions[mesh.m_Indices[i + 1]], &m_Positions[mesh.m_Indices[i + 2]] };
+			float near[3];
+			size_t inside = 0;
+
+			for (size_t k = 0; k < 3; ++k)
+			{
+				near[k] = triangle[k]->z() + triangle[k]->w();
+				inside += near[k] >= 0.0f;
+			}
+
+			++m_Stats.m_Triangles;
+
+			if (inside == 3)
+			{
+				RasterizeTriangle(*triangle[0], *triangle[1], *triangle[2]);
+				continue;
+			}
+
+			// Cut at the near plane, which leaves a triangle or a quad
+			CVector4f polygon[4];
+			size_t count = 0;
+
+			for (size_t k = 0; k < 3 && inside > 0; ++k)
+			{
+				const size_t next = (k + 1) % 3;
+
+				if (near[k] >= 0.0f)
+				{
+					polygon[count++] = *triangle[k];
+				}
+
+				if ((near[k] >= 0.0f) != (near[next] >= 0.0f))
+				{
+					polygon[count++] = *triangle[k] + (*triangle[next] - *triangle[k]) * (near[k] / (near[k] - near[next]));
+				}
+			}
+
+			for (size_t k = 1; k + 1 < count; ++k)
+			{
+				RasterizeTriangle(polygon[0], polygon[k], polygon[k + 1]);
+			}
+		}
+	}
+
+	m_Stats.m_BuildMs += Milliseconds(start);
+}
+
+void COcclusionBuffer::Finish()
+{
+	const uint64_t start = NUtils::CProfiler::Now();
+
+	for (size_t level = 1; level < m_Levels.size(); ++level)
+	{
+		const std::vector<float>& source = m_Levels[level - 1];
+		std::vector<float>& target = m_Levels[level];
+		const size_t source_width = std::max(m_Width >> (level - 1), 1);
+		const size_t source_height = std::max(m_Height >> (level - 1), 1);
+		const size_t width = std::max(m_Width >> level, 1);
+		const size_t height = std::max(m_Height >> level, 1);
+
+		for (size_t y = 0; y < height; ++y)
+		{
+			const float* bottom = &source[std::min(y * 2, source_height - 1) * source_width];
+			const float* top = &source[std::min(y * 2 + 1, source_height - 1) * source_width];
+			float* row = &target[y * width];
+
+			for (size_t x = 0; x < width; ++x)
+			{
+				const size_t left = x * 2;
+				const size_t right = std::min(x * 2 + 1, source_width - 1);
+				row[x] = std::max(std::max(bottom[left], bottom[right]), std::max(top[left], top[right]));
+			}
+		}
+	}
+
+	m_Ready = m_Stats.m_RasterizedTriangles > 0;
+	m_Stats.m_BuildMs += Milliseconds(start);
+}
+
+bool COcclusionBuffer::IsOccluded(const CVector3f& min, const CVector3f& max, const CTransform& transform) const
+{
+	if (!m_Ready)
+	{
+		return false;
+	}
+
+	const Eigen::Matrix4f model_view_projection = m_ViewProjection * transform.matrix();
+	CVector3f lowest = CVector3f::Constant(INFINITY);
+	CVector3f highest = CVector3f::Constant(-INFINITY);
+
+	for (int corner = 0; corner < 8; ++corner)
+	{
+		const CVector4f position = model_view_projection * CVector4f(corner & 1 ? max.x() : min.x(), corner & 2 ? max.y() : min.y(), corner & 4 ? max.z() : min.z(), 1.0f);
+
+		// Boxes reaching past the near plane are as close as anything gets
+		if (position.z() < -position.w() || position.w() <= 0.0f)
+		{
+			return false;
+		}
+
+		const CVector3f projected = position.head<3>() / position.w();
+		lowest = lowest.cwiseMin(projected);
+		highest = highest.cwiseMax(projected);
+	}
+
+	int32_t x0 = int32_t(floorf((lowest.x() * 0.5f + 0.5f) * m_Width)) - OCCLUDEE_MARGIN;
+	int32_t y0 = int32_t(floorf((lowest.y() * 0.5f + 0.5f) * m_Height)) - OCCLUDEE_MARGIN;
+	int32_t x1 = int32_t(floorf((highest.x() * 0.5f + 0.5f) * m_Width)) + OCCLUDEE_MARGIN;
+	int32_t y1 = int32_t(floorf((highest.y() * 0.5f + 0.5f) * m_Height)) + OCCLUDEE_MARGIN;
+
+	// Off screen is for the frustum to decide
+	if (x1 < 0 || y1 < 0 || x0 >= m_Width || y0 >= m_Height)
+	{
+		return false;
+	}
+
+	x0 = std::max(x0, 0);
+	y0 = std::max(y0, 0);
+	x1 = std::min<int32_t>(x1, m_Width - 1);
+	y1 = std::min<int32_t>(y1, m_Height - 1);
+
+	// The finest level where the rect touches at most two texels either way
+	size_t level = 0;
+
+	while ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)
+	{
+		++level;
+	}
+
+	const std::vector<float>& depth = m_Levels[level];
+	const int32_t width = std::max(m_Width >> level, 1);
+	float farthest = 0.0f;
+
+	for (int32_t y = y0 >> level; y <= y1 >> level; ++y)
+	{
+		for (int32_t x = x0 >> level; x <= x1 >> level; ++x)
+		{
+			farthest = std::max(farthest, depth[size_t(y) * width + x]);
+		}
+	}
+
+	return lowest.z() * 0.5f + 0.5f > farthest;
+}
+
+void COcclusionBuffer::RasterizeTriangle(const CVector4f& a, const CVector4f& b, const CVector4f& c)
+{
+	const CVector4f* vertices[3] = { &a, &b, &c };
+	float x[3], y[3], z[3];
+
+	for (size_t k = 0; k < 3; ++k)
+	{
+		const float inv_w = 1.0f / vertices[k]->w();
+		x[k] = (vertices[k]->x() * inv_w * 0.5f + 0.5f) * m_Width;
+		y[k] = (vertices[k]->y() * inv_w * 0.5f + 0.5f) * m_Height;
+		z[k] = vertices[k]->z() * inv_w * 0.5f + 0.5f;
+	}
+
+	// Counter clockwise is front facing, back faces are culled the way GL culls them
+	const float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+
+	if (!(area > 0.0f))
+	{
+		return;
+	}
+
+	const int32_t min_x = std::max(int32_t(ceilf(std::min({ x[0], x[1], x[2] }) - 0.5f)), 0);
+	const int32_t min_y = std::max(int32_t(ceilf(std::min({ y[0], y[1], y[2] }) - 0.5f)), 0);
+	const int32_t max_x = std::min(int32_t(floorf(std::max({ x[0], x[1], x[2] }) - 0.5f)), m_Width - 1);
+	const int32_t max_y = std::min(int32_t(floorf(std::max({ y[0], y[1], y[2] }) - 0.5f)), m_Height - 1);
+
+	if (min_x > max_x || min_y > max_y)
+	{
+		return;
+	}
+
+	++m_Stats.m_RasterizedTriangles;
+
+	// Edge functions and depth as planes over pixel centers, edge e is opposite vertex e
+	float edge_x[3], edge_y[3], edge_c[3];
+
+	for (int e = 0; e < 3; ++e)
+	{
+		const int from = (e + 1) % 3;
+		const int to = (e + 2) % 3;
+		edge_x[e] = y[from] - y[to];
+		edge_y[e] = x[to] - x[from];
+		edge_c[e] = -(edge_x[e] * x[from] + edge_y[e] * y[from]);
+	}
+
+	const float depth_x = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+	const float depth_y = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+	const float depth_c = z[0] - depth_x * x[0] - depth_y * y[0];
+
+	std::vector<float>& depth = m_Levels[0];
+
+	for (int32_t py = min_y; py <= max_y; ++py)
+	{
+		const float cy = float(py) + 0.5f;
+		const float e0 = edge_y[0] * cy + edge_c[0];
+		const float e1 = edge_y[1] * cy + edge_c[1];
+		const float e2 = edge_y[2] * cy + edge_c[2];
+		const float row_depth = depth_y * cy + depth_c;
+		float* row = &depth[size_t(py) * m_Width];
+
+		for (int32_t px = min_x; px <= max_x; ++px)
+		{
+			const float cx = float(px) + 0.5f;
+			const bool inside = (edge_x[0] * cx + e0 >= 0.0f) & (edge_x[1] * cx + e1 >= 0.0f) & (edge_x[2] * cx + e2 >= 0.0f);
+			const float z_value = row_depth + depth_x * cx;
+			row[px] = inside ? std::min(row[px], z_value) : row[px];
+		}
+	}
+}
+}  // namespace NRender
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include <Engine/Frustum.h>
+#include <Engine/Math.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+class CCamera;
+
+namespace NRender
+{
+struct SOcclusionStats
+{
+	size_t m_Occluders = 0;
+
+	// Occluder triangles submitted, and those left after frustum and back face culling
+	size_t m_Triangles = 0;
+	size_t m_RasterizedTriangles = 0;
+
+	// Rasterizing occluders and building the pyramid
+	double m_BuildMs = 0.0;
+};
+
+/**
+ * Low resolution depth of designated occluders, rasterized on the CPU each frame
+ * and reduced into a pyramid where each texel keeps the farthest depth of the
+ * four below it. Occludees are tested by their bounds: the box's screen rect
+ * picks the level where it spans at most 2x2 texels, and it is hidden if its
+ * nearest point lies behind all of them.
+ *
+ * Occluders are drawn at pixel centers, back faces culled like GL culls them, at
+ * the coarsest level of detail whose error stays well under a texel. Occludee
+ * rects grow by a texel covering the pixel center sampling, so only boxes hidden
+ * in the real frame are rejected. Every pixel of a row evaluates its edges and
+ * keeps the nearer depth through a select, so a row is a single straight pass.
+ **/
+class COcclusionBuffer
+{
+public:
+	// Rounded up to powers of two, so every level halves cleanly
+	explicit COcclusionBuffer(uint16_t width = 256, uint16_t height = 128);
+
+	// Clears depth and takes the camera's matrices, call before adding occluders
+	void Begin(const CCamera& camera);
+	void AddOccluder(const SMesh& mesh, const CTransform& transform);
+
+	// Builds the pyramid, occludees can be tested after this
+	void Finish();
+
+	// Box in the space of transform, true only if it's certainly hidden
+	bool IsOccluded(const CVector3f& min, const CVector3f& max, const CTransform& transform) const;
+
+	uint16_t Width() const { return m_Width; }
+	uint16_t Height() const { return m_Height; }
+	size_t Levels() const { return m_Levels.size(); }
+
+	// Window space depth, row by row from the bottom, each level half the size of the one before
+	const std::vector<float>& Level(size_t level) const { return m_Levels[level]; }
+
+	const SOcclusionStats& Stats() const { return m_Stats; }
+
+private:
+	// Triangles in clip space, in front of the near plane
+	void RasterizeTriangle(const CVector4f& a, const CVector4f& b, const CVector4f& c);
+
+	uint16_t m_Width;
+	uint16_t m_Height;
+	std::vector<std::vector<float>> m_Levels;
+
+	Eigen::Matrix4f m_ViewProjection;
+	CFrustum m_Frustum;
+	CVector3f m_Eye;
+
+	// World space size of a texel at unit distance
+	float m_TexelScale = 0.0f;
+
+	// Nothing is occluded until an occluder made it into the pyramid
+	bool m_Ready = false;
+
+	std::vector<CVector4f> m_Positions;
+	SOcclusionStats m_Stats;
+};
+}  // namespace NRender
@@ -0,0 +1,128 @@
+#include "ProfilerOverlay.h"
+
+#include "StateCache.h"
+
+#include <Engine/ShaderProgram.h>
+#include <Utils/Profiler.h>
+
+#include <algorithm>
+
+namespace NRender
+{
+// Pixels per frame column and per millisecond, 33.3 ms fill the graph
+static const float s_ColumnWidth = 3.0f;
+static const float s_PixelsPerMs = 4.0f;
+static const float s_GraphHeight = 33.3f * s_PixelsPerMs;
+static const float s_Margin = 8.0f;
+
+CProfilerOverlay::~CProfilerOverlay()
+{
+	if (m_Buffer)
+	{
+		CStateCache::Instance().DeleteBuffers(1, &m_Buffer);
+		CStateCache::Instance().DeleteVertexArrays(1, &m_VertexArray);
+	}
+
+	delete m_Shader;
+}
+
+bool CProfilerOverlay::Initialize()
+{
+	m_Shader = new CShaderProgram("assets/shaders/overlay");
+
+	if (!m_Shader->Handle())
+	{
+		return false;
+	}
+
+	glGenVertexArrays(1, &m_VertexArray);
+	CStateCache::Instance().BindVertexArray(m_VertexArray);
+
+	glGenBuffers(1, &m_Buffer);
+	CStateCache::Instance().BindBuffer(GL_ARRAY_BUFFER, m_Buffer);
+
+#define OFFSET(TYPE, MEMBER) ((void*)&((TYPE*)0)->MEMBER)
+	glEnableVertexAttribArray(CShaderProgram::Position);
+	glVertexAttribPointer(CShaderProgram::Position, 2, GL_FLOAT, GL_FALSE, sizeof(SVertex), OFFSET(SVertex, m_X));
+
+	glEnableVertexAttribArray(CShaderProgram::Color);
+	glVertexAttribPointer(CShaderProgram::Color, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SVertex), OFFSET(SVertex, m_Color));
+#undef OFFSET
+
+	return true;
+}
+
+void CProfilerOverlay::AddRect(float x, float y, float width, float height, uint32_t color)
+{
+	// Pixels from the bottom left corner to clip space, wound counter clockwise
+	const float x0 = x / m_Width * 2.0f - 1.0f;
+	const float y0 = y / m_Height * 2.0f - 1.0f;
+	const float x1 = (x + width) / m_Width * 2.0f - 1.0f;
+	const float y1 = (y + height) / m_Height * 2.0f - 1.0f;
+
+	SVertex vertex = { 0.0f, 0.0f, { uint8_t(color >> 24), uint8_t(color >> 16), uint8_t(color >> 8), uint8_t(color) } };
+	const float corners[6][2] = { { x0, y0 }, { x1, y0 }, { x1, y1 }, { x0, y0 }, { x1, y1 }, { x0, y1 } };
+
+	for (const float(&corner)[2] : corners)
+	{
+		vertex.m_X = corner[0];
+		vertex.m_Y = corner[1];
+		m_Vertices.push_back(vertex);
+	}
+}
+
+void CProfilerOverlay::Draw(int width, int height)
+{
+	if (!m_Visible || width <= 0 || height <= 0)
+	{
+		return;
+	}
+
+	if (!m_Shader && !Initialize())
+	{
+		m_Visible = false;
+		return;
+	}
+
+	m_Width = width;
+	m_Height = height;
+	m_Vertices.clear();
+
+	const std::vector<NUtils::SProfileFrame> frames = NUtils::CProfiler::Instance().Frames();
+	const float graph_width = NUtils::CProfiler::FrameHistory * s_ColumnWidth;
+
+	AddRect(s_Margin, s_Margin, graph_width, s_GraphHeight, 0x00000080);
+
+	for (size_t i = 0; i < frames.size(); ++i)
+	{
+		const NUtils::SProfileFrame& frame = frames[i];
+		const float x = s_Margin + (NUtils::CProfiler::FrameHistory - frames.size() + i) * s_ColumnWidth;
+		const uint32_t cpu_color = frame.m_CpuMs < 16.7 ? 0x40E040FF : frame.m_CpuMs < 33.3 ? 0xE0E040FF : 0xE04040FF;
+
+		AddRect(x, s_Margin, s_ColumnWidth - 1.0f, std::min<float>(frame.FrameMs() * s_PixelsPerMs, s_GraphHeight), 0x80808080);
+		AddRect(x, s_Margin, 1.0f, std::min<float>(frame.m_CpuMs * s_PixelsPerMs, s_GraphHeight), cpu_color);
+
+		if (frame.m_GpuMs >= 0.0)
+		{
+			AddRect(x + 1.0f, s_Margin, 1.0f, std::min<float>(frame.m_GpuMs * s_PixelsPerMs, s_GraphHeight), 0x4080FFFF);
+		}
+	}
+
+	AddRect(s_Margin, s_Margin + 16.7f * s_PixelsPerMs, graph_width, 1.0f, 0xFFFFFF80);
+	AddRect(s_Margin, s_Margin + 33.3f * s_PixelsPerMs, graph_width, 1.0f, 0xFFFFFF80);
+
+	m_Shader->Use();
+	CStateCache::Instance().BindVertexArray(m_VertexArray);
+	CStateCache::Instance().BindBuffer(GL_ARRAY_BUFFER, m_Buffer);
+
+	// Orphan the buffer each frame, the driver can keep drawing from the last one
+	const size_t size = m_Vertices.size() * sizeof(SVertex);
+	m_Capacity = std::max(m_Capacity, size);
+	glBufferData(GL_ARRAY_BUFFER, m_Capacity, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, size, m_Vertices.data());
+
+	glDisable(GL_DEPTH_TEST);
+	glDrawArrays(GL_TRIANGLES, 0, GLsizei(m_Vertices.size()));
+	glEnable(GL_DEPTH_TEST);
+}
+}  // namespace NRender
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Utils/Singleton.h"
+
+#include <SDL_opengl.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+class CShaderProgram;
+
+namespace NRender
+{
+/**
+ * Frame time graph in the bottom left corner, one column per profiled frame.
+ * The grey bar is the whole frame, the coloured one the CPU work of the main
+ * thread, green under 60 Hz, yellow under 30 Hz and red above. GPU time is the
+ * blue bar beside them. Lines mark 16.7 and 33.3 ms.
+ **/
+class CProfilerOverlay : public TSingleton<CProfilerOverlay>
+{
+public:
+	~CProfilerOverlay();
+
+	bool IsVisible() const { return m_Visible; }
+	void SetVisible(bool visible) { m_Visible = visible; }
+
+	// Draws over whatever was rendered, call right before presenting
+	void Draw(int width, int height);
+
+private:
+	struct SVertex
+	{
+		float m_X;
+		float m_Y;
+		uint8_t m_Color[4];
+	};
+
+	bool Initialize();
+	void AddRect(float x, float y, float width, float height, uint32_t color);
+
+	bool m_Visible = false;
+	int m_Width = 0;
+	int m_Height = 0;
+
+	CShaderProgram* m_Shader = nullptr;
+	GLuint m_VertexArray = 0;
+	GLuint m_Buffer = 0;
+	size_t m_Capacity = 0;
+	std::vector<SVertex> m_Vertices;
+};
+}  // namespace NRender
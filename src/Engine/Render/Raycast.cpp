@@ -0,0 +1,212 @@
+#include "Raycast.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+namespace NRender
+{
+namespace
+{
+using SBvh = SMesh::SBvh;
+
+// Splitting a node pops it and pushes its two children, so the stack never holds more than a node per level and one
+constexpr size_t STACK_SIZE = SBvh::MaxDepth + 1;
+
+float Slab(const CVector3f& origin, const CVector3f& inverse, const float* min, const float* max, float limit)
+{
+	float enter = 0.0f;
+	float leave = limit;
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		const float t0 = (min[axis] - origin[axis]) * inverse[axis];
+		const float t1 = (max[axis] - origin[axis]) * inverse[axis];
+		enter = std::max(enter, std::min(t0, t1));
+		leave = std::min(leave, std::max(t0, t1));
+	}
+
+	return enter <= leave ? enter : INFINITY;
+}
+
+// Möller-Trumbore on all four lanes, returns the lane of the nearest hit before limit or -1. The lanes are
+// tested without branches, so the loop vectorizes
+int IntersectBlock(const SBvh::STriangleBlock& block, const CVector3f& origin, const CVector3f& direction, float limit, float& distance, float& u_out, float& v_out)
+{
+	float t[4], u[4], v[4];
+
+	for (size_t lane = 0; lane < 4; ++lane)
+	{
+		// p = direction x edge2
+		const float px = direction.y() * block.m_Edge2Z[lane] - direction.z() * block.m_Edge2Y[lane];
+		const float py = direction.z() * block.m_Edge2X[lane] - direction.x() * block.m_Edge2Z[lane];
+		const float pz = direction.x() * block.m_Edge2Y[lane] - direction.y() * block.m_Edge2X[lane];
+		const float det = block.m_Edge1X[lane] * px + block.m_Edge1Y[lane] * py + block.m_Edge1Z[lane] * pz;
+		const float inverse = 1.0f / det;
+
+		const float sx = origin.x() - block.m_X[lane];
+		const float sy = origin.y() - block.m_Y[lane];
+		const float sz = origin.z() - block.m_Z[lane];
+
+		// q = s x edge1
+		const float qx = sy * block.m_Edge1Z[lane] - sz * block.m_Edge1Y[lane];
+		const float qy = sz * block.m_Edge1X[lane] - sx * block.m_Edge1Z[lane];
+		const float qz = sx * block.m_Edge1Y[lane] - sy * block.m_Edge1X[lane];
+
+		const float lane_u = (sx * px + sy * py + sz * pz) * inverse;
+		const float lane_v = (direction.x() * qx + direction.y() * qy + direction.z() * qz) * inverse;
+		const float lane_t = (block.m_Edge2X[lane] * qx + block.m_Edge2Y[lane] * qy + block.m_Edge2Z[lane] * qz) * inverse;
+
+		// Empty lanes have no edges, so their determinant is zero
+		const bool hit = (det != 0.0f) & (lane_u >= 0.0f) & (lane_v >= 0.0f) & (lane_u + lane_v <= 1.0f) & (lane_t >= 0.0f) & (lane_t < limit);
+
+		// Misses are pushed out to infinity, which leaves the nearest hit as the smallest distance
+		t[lane] = hit ? lane_t : INFINITY;
+		u[lane] = lane_u;
+		v[lane] = lane_v;
+	}
+
+	int nearest = 0;
+
+	for (int lane = 1; lane < 4; ++lane)
+	{
+		nearest = t[lane] < t[nearest] ? lane : nearest;
+	}
+
+	if (t[nearest] == INFINITY)
+	{
+		return -1;
+	}
+
+	distance = t[nearest];
+	u_out = u[nearest];
+	v_out = v[nearest];
+	return nearest;
+}
+
+void Resolve(const SMesh& mesh, uint32_t index, SRayHit& hit)
+{
+	for (size_t s = 0; s < mesh.m_SubMeshes.size(); ++s)
+	{
+		const SMesh::SSubMesh& sub_mesh = mesh.m_SubMeshes[s];
+
+		if (index >= sub_mesh.m_IndexOffset && index < sub_mesh.m_IndexOffset + sub_mesh.m_IndexCount)
+		{
+			hit.m_SubMesh = s;
+			hit.m_Triangle = (index - sub_mesh.m_IndexOffset) / 3;
+			return;
+		}
+	}
+}
+
+template <bool Any>
+bool Raycast(const SMesh& mesh, const CVector3f& origin, const CVector3f& direction, float max_distance, SRayHit& hit)
+{
+	const SBvh& bvh = mesh.m_Bvh;
+
+	if (bvh.m_Nodes.empty())
+	{
+		return false;
+	}
+
+	const CVector3f inverse = direction.cwiseInverse();
+
+	struct SEntry
+	{
+		uint32_t m_Node;
+		float m_Distance;
+	};
+
+	SEntry stack[STACK_SIZE];
+	size_t size = 0;
+	const float root = Slab(origin, inverse, bvh.m_Nodes[0].m_Min, bvh.m_Nodes[0].m_Max, max_distance);
+
+	if (root != INFINITY)
+	{
+		stack[size++] = { 0, root };
+	}
+
+	float closest = max_distance;
+	uint32_t closest_index = SBvh::NoTriangle;
+
+	while (size > 0)
+	{
+		const SEntry entry = stack[--size];
+
+		if (entry.m_Distance > closest)
+		{
+			continue;
+		}
+
+		const SBvh::SNode& node = bvh.m_Nodes[entry.m_Node];
+
+		if (node.m_Count == 0)
+		{
+			const uint32_t near = node.m_First, far = node.m_First + 1;
+			float near_distance = Slab(origin, inverse, bvh.m_Nodes[near].m_Min, bvh.m_Nodes[near].m_Max, closest);
+			float far_distance = Slab(origin, inverse, bvh.m_Nodes[far].m_Min, bvh.m_Nodes[far].m_Max, closest);
+			const bool swap = far_distance < near_distance;
+
+			if (swap)
+			{
+				std::swap(near_distance, far_distance);
+			}
+
+			if (far_distance != INFINITY)
+			{
+				stack[size++] = { swap ? near : far, far_distance };
+			}
+
+			if (near_distance != INFINITY)
+			{
+				stack[size++] = { swap ? far : near, near_distance };
+			}
+
+			continue;
+		}
+
+		for (uint32_t b = node.m_First; b < node.m_First + (node.m_Count + 3) / 4; ++b)
+		{
+			const SBvh::STriangleBlock& block = bvh.m_Blocks[b];
+			float distance, u, v;
+			const int lane = IntersectBlock(block, origin, direction, closest, distance, u, v);
+
+			if (lane < 0)
+			{
+				continue;
+			}
+
+			closest = distance;
+			closest_index = block.m_Index[lane];
+			hit.m_Distance = distance;
+			hit.m_U = u;
+			hit.m_V = v;
+
+			if (Any)
+			{
+				Resolve(mesh, closest_index, hit);
+				return true;
+			}
+		}
+	}
+
+	if (closest_index == SBvh::NoTriangle)
+	{
+		return false;
+	}
+
+	Resolve(mesh, closest_index, hit);
+	return true;
+}
+}  // namespace
+
+bool RaycastClosest(const SMesh& mesh, const CVector3f& origin, const CVector3f& direction, float max_distance, SRayHit& hit)
+{
+	return Raycast<false>(mesh, origin, direction, max_distance, hit);
+}
+
+bool RaycastAny(const SMesh& mesh, const CVector3f& origin, const CVector3f& direction, float max_distance, SRayHit& hit)
+{
+	return Raycast<true>(mesh, origin, direction, max_distance, hit);
+}
+}  // namespace NRender
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include <Engine/Math.h>
+
+#include <stddef.h>
+
+namespace NRender
+{
+struct SRayHit
+{
+	size_t m_SubMesh = 0;
+
+	// Within the submesh's full detail range, so its indices start at m_IndexOffset + 3 * m_Triangle
+	size_t m_Triangle = 0;
+	float m_Distance = 0.0f;
+
+	// Barycentrics of the second and third corner, the hit is at a + u * (b - a) + v * (c - a)
+	float m_U = 0.0f;
+	float m_V = 0.0f;
+};
+
+/**
+ * Ray queries against the triangles of a mesh through its SMesh::SBvh, both
+ * false for meshes built without one. The ray is in mesh space and distances are
+ * in lengths of direction, which doesn't have to be normalized, so a world space
+ * ray brought in by the inverse transform keeps measuring world space distances.
+ * Triangles are hit from either side.
+ *
+ * Traversal visits the nearer child first and skips nodes entered beyond the
+ * closest hit so far, leaves intersect all four triangles of a block at once,
+ * one lane each, combining the hit tests into a mask before picking the nearest.
+ **/
+bool RaycastClosest(const SMesh& mesh, const CVector3f& origin, const CVector3f& direction, float max_distance, SRayHit& hit);
+
+// Stops at the first triangle hit within max_distance, not necessarily the closest, for visibility tests
+bool RaycastAny(const SMesh& mesh, const CVector3f& origin, const CVector3f& direction, float max_distance, SRayHit& hit);
+}  // namespace NRender
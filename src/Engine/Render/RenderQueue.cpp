@@ -0,0 +1,210 @@
+#include "RenderQueue.h"
+
+#ifndef ENGINE_HEADLESS
+#include "MaterialInstance.h"
+#include "RenderStats.h"
+#include "StateCache.h"
+
+#include <SDL_opengl.h>
+#endif
+
+#include <string.h>
+
+#include <algorithm>
+
+namespace NRender
+{
+uint64_t CRenderQueue::MakeSortKey(uint32_t shader, uint32_t material, uint32_t vertex_array, uint32_t sub_mesh, uint32_t lod, float depth)
+{
+	// Non-negative floats order the same as their bit patterns, so the top bits are a cheap depth bucket
+	uint32_t depth_bits;
+	depth = std::max(depth, 0.0f);
+	memcpy(&depth_bits, &depth, sizeof(depth_bits));
+
+	return (uint64_t(shader & 0xFF) << 56) |
+		   (uint64_t(material & 0xFFFF) << 40) |
+		   (uint64_t(vertex_array & 0xFFFF) << 24) |
+		   (uint64_t(sub_mesh & 0xFF) << 16) |
+		   (uint64_t(lod & 0x7) << 13) |
+		   uint64_t(depth_bits >> 19);
+}
+
+void CRenderQueue::Clear()
+{
+	m_Packets.clear();
+	m_Items.clear();
+	m_Batches.clear();
+	m_InstanceTransforms.clear();
+	m_ClusterIndices.clear();
+}
+
+void CRenderQueue::Push(const SDrawPacket& packet)
+{
+	m_Items.push_back({ packet.m_Key, uint32_t(m_Packets.size()) });
+	m_Packets.push_back(packet);
+}
+
+void CRenderQueue::Sort()
+{
+	const size_t count = m_Items.size();
+	if (count < 2)
+	{
+		return;
+	}
+
+	m_Scratch.resize(count);
+
+	// Histogram all eight digits in a single pass
+	size_t histograms[8][256] = {};
+	for (const SSortItem& item : m_Items)
+	{
+		for (int digit = 0; digit < 8; ++digit)
+		{
+			++histograms[digit][(item.m_Key >> (digit * 8)) & 0xFF];
+		}
+	}
+
+	for (int digit = 0; digit < 8; ++digit)
+	{
+		size_t* histogram = histograms[digit];
+
+		if (histogram[(m_Items[0].m_Key >> (digit * 8)) & 0xFF] == count)
+		{
+			continue;
+		}
+
+		size_t offset = 0;
+		for (size_t i = 0; i < 256; ++i)
+		{
+			const size_t bucket = histogram[i];
+			histogram[i] = offset;
+			offset += bucket;
+		}
+
+		for (const SSortItem& item : m_Items)
+		{
+			m_Scratch[histogram[(item.m_Key >> (digit * 8)) & 0xFF]++] = item;
+		}
+
+		m_Items.swap(m_Scratch);
+	}
+}
+
+void CRenderQueue::Batch()
+{
+	m_Batches.clear();
+	m_InstanceTransforms.resize(m_Items.size());
+
+	for (size_t i = 0; i < m_Items.size(); ++i)
+	{
+		const SDrawPacket& packet = Sorted(i);
+		m_InstanceTransforms[i] = packet.m_Transform != nullptr ? packet.m_Transform->matrix() : Eigen::Matrix4f::Identity();
+
+		// Keys can collide once ids wrap, so batches are split on the actual state as well
+		if (!m_Batches.empty())
+		{
+			const SDrawPacket& first = Sorted(m_Batches.back().m_First);
+
+			if ((first.m_Key >> 13) == (packet.m_Key >> 13) && packet.m_ClusterIndexCount == 0 && first.m_ClusterIndexCount == 0 &&
+				first.m_SubMesh == packet.m_SubMesh && first.m_Lod == packet.m_Lod && first.m_Material == packet.m_Material && first.m_VertexArray == packet.m_VertexArray)
+			{
+				++m_Batches.back().m_Count;
+				continue;
+			}
+		}
+
+		m_Batches.push_back({ uint32_t(i), 1 });
+	}
+}
+
+#ifndef ENGINE_HEADLESS
+void CRenderQueue::Submit(const CShaderProgram& program)
+{
+	SFrameStats& stats = CRenderStats::Instance().Current();
+	CStateCache& state = CStateCache::Instance();
+
+	if (m_Uniforms.m_Program != &program)
+	{
+		m_Uniforms.m_Program = &program;
+		m_Uniforms.m_PackedVertices = program.Uniform<bool>("PackedVertices");
+		m_Uniforms.m_QuantizationOffset = program.Uniform<CVector3f>("QuantizationOffset");
+		m_Uniforms.m_QuantizationScale = program.Uniform<CVector3f>("QuantizationScale");
+	}
+
+	program.Use();
+	Batch();
+
+	if (m_Batches.empty())
+	{
+		return;
+	}
+
+	// The frame's transforms and cluster indices go to ranges of ring buffers the GPU is done reading
+	const size_t instance_offset = m_InstanceBuffer.Upload(m_InstanceTransforms.data(), m_InstanceTransforms.size() * sizeof(Eigen::Matrix4f));
+	size_t cluster_offset = 0;
+
+	// With no vertex array bound, so the upload can't rebind one's indices
+	if (!m_ClusterIndices.empty())
+	{
+		state.BindVertexArray(0);
+		cluster_offset = m_ClusterIndexBuffer.Upload(m_ClusterIndices.data(), m_ClusterIndices.size() * sizeof(uint32_t));
+	}
+
+	// Start from values no packet can have, so the first batch binds everything
+	CMaterialInstance* material = nullptr;
+	uint32_t vertex_array = 0;
+	int packed = -1;
+
+	for (const SBatch& batch : m_Batches)
+	{
+		const SDrawPacket& packet = Sorted(batch.m_First);
+		const SMesh::SSubMesh& sub_mesh = *packet.m_SubMesh;
+
+		if (packet.m_VertexArray != vertex_array)
+		{
+			state.BindVertexArray(packet.m_VertexArray);
+			vertex_array = packet.m_VertexArray;
+			++stats.m_VertexArrayBinds;
+		}
+
+		if (packet.m_Material != material)
+		{
+			packet.m_Material->Bind();
+			material = packet.m_Material;
+			++stats.m_MaterialBinds;
+		}
+
+		if (int(packet.m_PackedVertices) != packed)
+		{
+			SetUniform(m_Uniforms.m_PackedVertices, packet.m_PackedVertices);
+			packed = packet.m_PackedVertices;
+		}
+
+		SetUniform(m_Uniforms.m_QuantizationOffset, CVector3f(&sub_mesh.m_QuantizationOffset.m_X));
+		SetUniform(m_Uniforms.m_QuantizationScale, CVector3f(&sub_mesh.m_QuantizationScale.m_X));
+
+		// Without base instance the matrix attributes are pointed at the batch's first transform instead
+		const size_t offset = instance_offset + batch.m_First * sizeof(Eigen::Matrix4f);
+		for (GLuint column = 0; column < 4; ++column)
+		{
+			glVertexAttribPointer(CShaderProgram::InstanceMatrix + column, 4, GL_FLOAT, GL_FALSE, sizeof(Eigen::Matrix4f), (void*)(offset + column * sizeof(Eigen::Vector4f)));
+		}
+
+		// Cluster vertex arrays have no indices of their own, binding the cluster buffer attaches it to them
+		if (packet.m_ClusterIndexCount > 0)
+		{
+			state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ClusterIndexBuffer.Buffer());
+			glDrawElementsInstanced(GL_TRIANGLES, packet.m_ClusterIndexCount, GL_UNSIGNED_INT, (void*)(cluster_offset + packet.m_ClusterIndexOffset * sizeof(uint32_t)), batch.m_Count);
+		}
+		else
+		{
+			glDrawElementsInstanced(GL_TRIANGLES, sub_mesh.LodIndexCount(packet.m_Lod), GL_UNSIGNED_INT, (void*)((packet.m_FirstIndex + sub_mesh.LodIndexOffset(packet.m_Lod)) * sizeof(uint32_t)), batch.m_Count);
+		}
+		++stats.m_DrawCalls;
+	}
+
+	m_InstanceBuffer.EndFrame();
+	m_ClusterIndexBuffer.EndFrame();
+}
+#endif
+}  // namespace NRender
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include <Engine/Math.h>
+
+#ifndef ENGINE_HEADLESS
+#include "StreamBuffer.h"
+
+#include <Engine/ShaderProgram.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace NRender
+{
+class CMaterialInstance;
+
+// Everything needed to draw one instance of a submesh, the pointers must outlive the frame
+struct SDrawPacket
+{
+	uint64_t m_Key = 0;
+	uint32_t m_VertexArray = 0;
+	bool m_PackedVertices = false;
+	CMaterialInstance* m_Material = nullptr;
+	const CMatrix4f* m_Transform = nullptr;
+	const SMesh::SSubMesh* m_SubMesh = nullptr;
+
+	// Where the mesh's indices start in the index buffer of the vertex array
+	uint32_t m_FirstIndex = 0;
+
+	// Level of detail of the submesh, 0 is full detail
+	uint32_t m_Lod = 0;
+
+	// Culled clusters are drawn from the queue's cluster indices instead of the submesh's range
+	uint32_t m_ClusterIndexOffset = 0;
+	uint32_t m_ClusterIndexCount = 0;
+};
+
+/**
+ * Collects draw packets for a frame and submits them ordered by their key, so
+ * packets sharing a shader, material or vertex array end up next to each other
+ * and only the state that actually changes between two draws is rebound. Runs of
+ * packets drawing the same submesh become a single instanced draw, except those
+ * drawing culled clusters, whose indices are the instance's own.
+ *
+ * Key layout, most significant first: shader (8), material (16), vertex array (16), submesh (8), lod (3), depth (13)
+ **/
+class CRenderQueue
+{
+public:
+	struct SSortItem
+	{
+		uint64_t m_Key;
+		uint32_t m_Packet;
+	};
+
+	// Consecutive packets of the same submesh and material drawn with a single call
+	struct SBatch
+	{
+		uint32_t m_First;
+		uint32_t m_Count;
+	};
+
+	// Depth is the view space distance, opaque packets sharing state draw front to back
+	static uint64_t MakeSortKey(uint32_t shader, uint32_t material, uint32_t vertex_array, uint32_t sub_mesh, uint32_t lod, float depth);
+
+	void Clear();
+	void Push(const SDrawPacket& packet);
+
+	// Indices of culled clusters for this frame, packets refer to ranges of it
+	std::vector<uint32_t>& ClusterIndices() { return m_ClusterIndices; }
+
+	// Stable radix sort on the keys, passes where every key has the same digit are skipped
+	void Sort();
+
+	// Groups the sorted packets into batches and gathers their transforms in draw order
+	void Batch();
+
+	size_t Size() const { return m_Packets.size(); }
+	const SDrawPacket& Sorted(size_t index) const { return m_Packets[m_Items[index].m_Packet]; }
+	const std::vector<SBatch>& Batches() const { return m_Batches; }
+
+#ifndef ENGINE_HEADLESS
+	// Batches and issues the sorted packets with the given program
+	void Submit(const CShaderProgram& program);
+#endif
+
+private:
+#ifndef ENGINE_HEADLESS
+	// Handles are fetched again only when a different program is submitted with
+	struct SUniforms
+	{
+		const CShaderProgram* m_Program = nullptr;
+		TUniform<bool> m_PackedVertices;
+		TUniform<CVector3f> m_QuantizationOffset;
+		TUniform<CVector3f> m_QuantizationScale;
+	} m_Uniforms;
+
+	// Both are written every frame, the initial sizes grow to whatever a frame needs
+	CStreamBuffer m_InstanceBuffer{ GL_ARRAY_BUFFER, 1 << 20 };
+	CStreamBuffer m_ClusterIndexBuffer{ GL_ELEMENT_ARRAY_BUFFER, 4 << 20 };
+#endif
+
+	std::vector<SDrawPacket> m_Packets;
+	std::vector<SSortItem> m_Items;
+	std::vector<SSortItem> m_Scratch;
+	std::vector<SBatch> m_Batches;
+	std::vector<Eigen::Matrix4f> m_InstanceTransforms;
+	std::vector<uint32_t> m_ClusterIndices;
+};
+}  // namespace NRender
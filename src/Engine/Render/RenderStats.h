@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Utils/Singleton.h"
+
+#include <stddef.h>
+
+namespace NRender
+{
+struct SFrameStats
+{
+	// World matrices the transform hierarchy recomputed
+	size_t m_UpdatedTransforms = 0;
+
+	size_t m_VisibleInstances = 0;
+	size_t m_CulledInstances = 0;
+	size_t m_VisibleSubMeshes = 0;
+	size_t m_CulledSubMeshes = 0;
+
+	// Instances and submeshes inside the frustum but hidden behind occluders, and what hiding them cost
+	size_t m_OccludedInstances = 0;
+	size_t m_OccludedSubMeshes = 0;
+	size_t m_OccluderTriangles = 0;
+	double m_OcclusionMs = 0.0;
+
+	// Triangles queued after level of detail selection, and what full detail would have been
+	size_t m_Triangles = 0;
+	size_t m_FullDetailTriangles = 0;
+
+	// Clusters of full detail submeshes kept and rejected by cluster culling
+	size_t m_VisibleMeshlets = 0;
+	size_t m_CulledMeshlets = 0;
+	size_t m_DrawCalls = 0;
+	size_t m_MaterialBinds = 0;
+	size_t m_VertexArrayBinds = 0;
+
+	// Bytes copied to GPU buffers, and stream buffers orphaned because every range was still in flight
+	size_t m_BytesUploaded = 0;
+	size_t m_BufferOrphans = 0;
+
+	// Binds that reached GL and binds the state cache dropped as redundant
+	size_t m_GLCallsIssued = 0;
+	size_t m_GLCallsElided = 0;
+};
+
+// Counters for the frame being recorded, the last completed frame is kept for display
+class CRenderStats : public TSingleton<CRenderStats>
+{
+public:
+	void BeginFrame()
+	{
+		m_Previous = m_Current;
+		m_Current = {};
+	}
+
+	SFrameStats& Current() { return m_Current; }
+	const SFrameStats& Previous() const { return m_Previous; }
+
+private:
+	SFrameStats m_Current;
+	SFrameStats m_Previous;
+};
+}  // namespace NRender
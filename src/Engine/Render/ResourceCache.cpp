@@ -0,0 +1,101 @@
+#include "ResourceCache.h"
+
+#include "Mesh.h"
+
+namespace NRender
+{
+template<typename TResource, typename TAsset>
+std::shared_ptr<TResource> CResourceCache::Get(std::unordered_map<const TAsset*, std::weak_ptr<TResource>>& entries, const std::shared_ptr<TAsset>& asset)
+{
+	if (asset == nullptr)
+	{
+		return nullptr;
+	}
+
+	// Resources keep their asset alive, or are purged along with their released texture before any lookup, so a live
+	// entry can never point at a reused address
+	std::weak_ptr<TResource>& entry = entries[asset.get()];
+	std::shared_ptr<TResource> resource = entry.lock();
+
+	if (resource != nullptr)
+	{
+		++m_Hits;
+		return resource;
+	}
+
+	++m_Misses;
+	resource = std::make_shared<TResource>(asset);
+	entry = resource;
+	return resource;
+}
+
+template<typename TResource, typename TAsset>
+void CResourceCache::Purge(std::unordered_map<const TAsset*, std::weak_ptr<TResource>>& entries)
+{
+	for (auto it = entries.begin(); it != entries.end();)
+	{
+		it = it->second.expired() ? entries.erase(it) : std::next(it);
+	}
+}
+
+void CResourceCache::PurgeReleased()
+{
+	// Only ever runs on the GL thread, wherever the last reference to the texture went away
+	for (auto it = m_Released.begin(); it != m_Released.end();)
+	{
+		it = it->second.m_Source.expired() ? m_Released.erase(it) : std::next(it);
+	}
+}
+
+HMeshResource CResourceCache::GetMesh(const HMesh& mesh)
+{
+	return Get(m_Meshes, mesh);
+}
+
+HMaterialInstance CResourceCache::GetMaterial(const HMaterial& material)
+{
+	return Get(m_Materials, material);
+}
+
+HTextureResource CResourceCache::GetTexture(const HTexture& texture)
+{
+	PurgeReleased();
+
+	HTextureResource resource = Get(m_Textures, texture);
+
+	// A texture without its pixels could never be uploaded again once every material let go of it
+	if (resource != nullptr && resource->Released())
+	{
+		m_Released.emplace(texture.get(), SReleasedTexture{ texture, resource });
+	}
+
+	return resource;
+}
+
+SResourceCacheStats CResourceCache::Stats()
+{
+	PurgeReleased();
+	Purge(m_Meshes);
+	Purge(m_Materials);
+	Purge(m_Textures);
+
+	SResourceCacheStats stats;
+	stats.m_Hits = m_Hits;
+	stats.m_Misses = m_Misses;
+	stats.m_Meshes = m_Meshes.size();
+	stats.m_Materials = m_Materials.size();
+	stats.m_Textures = m_Textures.size();
+
+	for (const auto& entry : m_Meshes)
+	{
+		stats.m_BufferBytes += entry.second.lock()->Size();
+	}
+
+	for (const auto& entry : m_Textures)
+	{
+		stats.m_TextureBytes += entry.second.lock()->Size();
+	}
+
+	return stats;
+}
+}  // namespace NRender
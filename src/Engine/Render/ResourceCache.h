@@ -0,0 +1,68 @@
+#pragma once
+
+#include "MaterialInstance.h"
+#include "MeshResource.h"
+#include "TextureResource.h"
+
+#include "Utils/Singleton.h"
+
+#include <stddef.h>
+
+#include <memory>
+#include <unordered_map>
+
+namespace NRender
+{
+struct SResourceCacheStats
+{
+	size_t m_Hits = 0;
+	size_t m_Misses = 0;
+	size_t m_Meshes = 0;
+	size_t m_Materials = 0;
+	size_t m_Textures = 0;
+	size_t m_BufferBytes = 0;
+	size_t m_TextureBytes = 0;
+};
+
+/**
+ * GPU resources keyed by the identity of the CPU asset they were created from, so
+ * an asset placed any number of times is uploaded once. The cache only holds weak
+ * references, a resource is released as soon as nothing draws with it anymore.
+ * Textures that dropped their pixels after the upload are the exception: their
+ * resource can't be created again, so the cache holds it until the texture is
+ * gone and frees it here on the GL thread, whichever thread let go of the texture.
+ **/
+class CResourceCache : public TSingleton<CResourceCache>
+{
+public:
+	HMeshResource GetMesh(const HMesh& mesh);
+	HMaterialInstance GetMaterial(const HMaterial& material);
+	HTextureResource GetTexture(const HTexture& texture);
+
+	// Live resources only, entries of released ones are dropped first
+	SResourceCacheStats Stats();
+
+private:
+	template<typename TResource, typename TAsset>
+	std::shared_ptr<TResource> Get(std::unordered_map<const TAsset*, std::weak_ptr<TResource>>& entries, const std::shared_ptr<TAsset>& asset);
+
+	template<typename TResource, typename TAsset>
+	static void Purge(std::unordered_map<const TAsset*, std::weak_ptr<TResource>>& entries);
+
+	void PurgeReleased();
+
+	struct SReleasedTexture
+	{
+		std::weak_ptr<STexture> m_Source;
+		HTextureResource m_Resource;
+	};
+
+	std::unordered_map<const SMesh*, std::weak_ptr<CMeshResource>> m_Meshes;
+	std::unordered_map<const SMaterial*, std::weak_ptr<CMaterialInstance>> m_Materials;
+	std::unordered_map<const STexture*, std::weak_ptr<CTextureResource>> m_Textures;
+	std::unordered_map<const STexture*, SReleasedTexture> m_Released;
+
+	size_t m_Hits = 0;
+	size_t m_Misses = 0;
+};
+}  // namespace NRender
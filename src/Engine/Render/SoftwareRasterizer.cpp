@@ -0,0 +1,825 @@
+#include "SoftwareRasterizer.h"
+
+#include "Material.h"
+#include "Texture.h"
+
+#include <Engine/Camera.h>
+#include <Utils/MeshQuantizer.h>
+#include <Utils/TaskPool.h>
+#include <Utils/TextureCompressor.h>
+
+#include <math.h>
+#include <stdio.h>
+
+#include <algorithm>
+
+namespace NRender
+{
+namespace
+{
+constexpr size_t VERTEX_BATCH = 4096;
+constexpr size_t TRIANGLE_BATCH = 2048;
+
+constexpr int32_t SUBPIXEL_BITS = 4;
+constexpr int32_t SUBPIXELS = 1 << SUBPIXEL_BITS;
+constexpr int32_t BLOCK = 8;
+
+// Triangles are only clipped where they leave a band this many times the viewport, which keeps
+// fixed point window positions small enough for the edge functions of a block to fit 32 bits
+constexpr float GUARD_BAND = 4.0f;
+
+// Near, far and the four sides of the guard band are clipped against, each adds at most a vertex
+constexpr size_t CLIP_PLANES = 6;
+constexpr size_t MAX_POLYGON = 3 + CLIP_PLANES;
+constexpr uint32_t CLIP_MASK = (1u << CLIP_PLANES) - 1;
+constexpr uint32_t NEAR_FAR_MASK = 3;
+
+// The sides of the actual view, anything entirely outside one of them is culled, not clipped
+constexpr uint32_t VIEW_SHIFT = CLIP_PLANES;
+constexpr uint32_t REJECT_MASK = NEAR_FAR_MASK | (15u << VIEW_SHIFT);
+
+constexpr size_t TANGENT = 0;
+constexpr size_t BITANGENT = 3;
+constexpr size_t NORMAL = 6;
+constexpr size_t COLOR = 9;
+constexpr size_t UV = 12;
+
+constexpr float SPECULAR_POWER = 32.0f;
+
+float ClipDistance(const float* position, size_t plane)
+{
+	switch (plane)
+	{
+	case 0: return position[3] + position[2];
+	case 1: return position[3] - position[2];
+	case 2: return GUARD_BAND * position[3] + position[0];
+	case 3: return GUARD_BAND * position[3] - position[0];
+	case 4: return GUARD_BAND * position[3] + position[1];
+	default: return GUARD_BAND * position[3] - position[1];
+	}
+}
+
+uint32_t Outcode(const float* position)
+{
+	uint32_t code = 0;
+
+	for (size_t plane = 0; plane < CLIP_PLANES; ++plane)
+	{
+		code |= uint32_t(ClipDistance(position, plane) < 0.0f) << plane;
+	}
+
+	code |= uint32_t(position[0] < -position[3]) << VIEW_SHIFT;
+	code |= uint32_t(position[0] > position[3]) << (VIEW_SHIFT + 1);
+	code |= uint32_t(position[1] < -position[3]) << (VIEW_SHIFT + 2);
+	code |= uint32_t(position[1] > position[3]) << (VIEW_SHIFT + 3);
+	return code;
+}
+
+float Evaluate(const float (&plane)[3], float x, float y)
+{
+	return plane[0] + plane[1] * x + plane[2] * y;
+}
+
+// The plane through three values at the window positions, shifted so integer pixel coordinates land on pixel centers
+void SetPlane(const double (&x)[3], const double (&y)[3], double area, double v0, double v1, double v2, float (&plane)[3])
+{
+	const double gradient_x = ((v1 - v0) * (y[2] - y[0]) - (v2 - v0) * (y[1] - y[0])) / area;
+	const double gradient_y = ((v2 - v0) * (x[1] - x[0]) - (v1 - v0) * (x[2] - x[0])) / area;
+
+	plane[0] = float(v0 + gradient_x * (0.5 - x[0]) + gradient_y * (0.5 - y[0]));
+	plane[1] = float(gradient_x);
+	plane[2] = float(gradient_y);
+}
+
+void Fetch(const std::vector<uint32_t>& texels, uint16_t width, uint16_t height, float u, float v, float (&texel)[4])
+{
+	// Repeat wrapping, like the samplers' default
+	const int32_t x = std::min(int32_t((u - floorf(u)) * width), width - 1);
+	const int32_t y = std::min(int32_t((v - floorf(v)) * height), height - 1);
+	const uint32_t value = texels[size_t(y) * width + x];
+
+	for (int channel = 0; channel < 4; ++channel)
+	{
+		texel[channel] = float((value >> (channel * 8)) & 0xFF) / 255.0f;
+	}
+}
+
+uint8_t Quantize(float value)
+{
+	return uint8_t(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+}  // namespace
+
+void CSoftwareRasterizer::Resize(uint16_t width, uint16_t height)
+{
+	m_Width = width;
+	m_Height = height;
+	m_TilesX = (width + TileSize - 1) / TileSize;
+	m_TilesY = (height + TileSize - 1) / TileSize;
+	m_Stride = m_TilesX * TileSize;
+
+	m_Color.assign(m_Stride * m_TilesY * TileSize, 0);
+	m_Depth.assign(m_Stride * m_TilesY * TileSize, 1.0f);
+	m_Bins.resize(m_TilesX * m_TilesY);
+}
+
+void CSoftwareRasterizer::Begin(const CCamera& camera)
+{
+	std::fill(m_Color.begin(), m_Color.end(), 0);
+	std::fill(m_Depth.begin(), m_Depth.end(), 1.0f);
+
+	m_ViewProjection = camera.projectionMatrix().matrix() * camera.viewMatrix().matrix();
+	m_Frustum = camera.frustum();
+
+	// Same as basic.frag, which multiplies the inverses in this order
+	const CVector4f direction = camera.projectionMatrix().matrix().inverse() * camera.viewMatrix().matrix().inverse() * CVector4f(0.0f, 0.0f, 1.0f, 0.0f);
+	m_ViewDirection = direction.head<3>().normalized();
+
+	m_Draws.clear();
+	m_VertexCount = 0;
+	m_VertexBatches.clear();
+	m_TriangleBatches.clear();
+	m_Stats = SRasterStats();
+}
+
+void CSoftwareRasterizer::Draw(const SMesh& mesh, const CTransform& transform, size_t lod)
+{
+	++m_Stats.m_Draws;
+
+	const CFrustum frustum = m_Frustum.Transformed(transform);
+
+	if (!frustum.TestBox(CVector3f(&mesh.m_Bounds.m_Min.m_X), CVector3f(&mesh.m_Bounds.m_Max.m_X)))
+	{
+		return;
+	}
+
+	m_Draws.push_back({ &mesh, m_ViewProjection * transform.matrix(), transform.linear(), lod, m_VertexCount });
+	const SDraw& draw = m_Draws.back();
+	m_VertexCount += mesh.m_VertexFormat == EVertexFormat::Packed ? mesh.m_PackedVertices.size() : mesh.m_Vertices.size();
+
+	for (const SMesh::SSubMesh& sub_mesh : mesh.m_SubMeshes)
+	{
+		if (!frustum.TestBox(CVector3f(&sub_mesh.m_Bounds.m_Min.m_X), CVector3f(&sub_mesh.m_Bounds.m_Max.m_X)))
+		{
+			continue;
+		}
+
+		// Materials without a texture sample black, just like an unbound GL texture unit
+		const HMaterial& material = sub_mesh.m_Material < mesh.m_Materials.size() ? mesh.m_Materials[sub_mesh.m_Material] : nullptr;
+		const SSampler* albedo = material ? PrepareSampler(material->m_AlbedoTexture) : nullptr;
+		const SSampler* detail = material ? PrepareSampler(material->m_DetailTexture) : nullptr;
+
+		for (size_t first = 0; first < sub_mesh.m_VertexCount; first += VERTEX_BATCH)
+		{
+			m_VertexBatches.push_back({ &draw, &sub_mesh, sub_mesh.m_VertexOffset + first, std::min(VERTEX_BATCH, sub_mesh.m_VertexCount - first), albedo, detail });
+		}
+
+		const size_t level = std::min(lod, sub_mesh.LodCount() - 1);
+		const size_t index_offset = sub_mesh.LodIndexOffset(level);
+		const size_t index_count = sub_mesh.LodIndexCount(level);
+
+		for (size_t first = 0; first < index_count; first += TRIANGLE_BATCH * 3)
+		{
+			m_TriangleBatches.push_back({ &draw, &sub_mesh, index_offset + first, std::min(TRIANGLE_BATCH * 3, index_count - first), albedo, detail });
+		}
+	}
+}
+
+void CSoftwareRasterizer::End()
+{
+	NUtils::CTaskPool& pool = NUtils::CTaskPool::Instance();
+
+	m_Vertices.resize(m_VertexCount);
+
+	pool.ParallelFor(m_VertexBatches.size(), [this](size_t batch) {
+		ShadeVertices(m_VertexBatches[batch]);
+	});
+
+	m_Setups.resize(m_TriangleBatches.size());
+
+	pool.ParallelFor(m_TriangleBatches.size(), [this](size_t batch) {
+		SetupTriangles(m_TriangleBatches[batch], m_Setups[batch]);
+	});
+
+	// Batches are binned in order, which keeps every tile's triangles in draw order
+	for (std::vector<const STriangle*>& bin : m_Bins)
+	{
+		bin.clear();
+	}
+
+	for (const SSetup& setup : m_Setups)
+	{
+		m_Stats.m_Triangles += setup.m_Stats.m_Triangles;
+		m_Stats.m_CulledTriangles += setup.m_Stats.m_CulledTriangles;
+		m_Stats.m_ClippedTriangles += setup.m_Stats.m_ClippedTriangles;
+
+		for (const STriangle& triangle : setup.m_Triangles)
+		{
+			for (size_t y = triangle.m_MinY / TileSize; y <= size_t(triangle.m_MaxY / TileSize); ++y)
+			{
+				for (size_t x = triangle.m_MinX / TileSize; x <= size_t(triangle.m_MaxX / TileSize); ++x)
+				{
+					m_Bins[y * m_TilesX + x].push_back(&triangle);
+					++m_Stats.m_BinnedTriangles;
+				}
+			}
+		}
+	}
+
+	m_TileStats.assign(m_Bins.size(), SRasterStats());
+
+	pool.ParallelFor(m_Bins.size(), [this](size_t tile) {
+		RasterizeTile(tile, m_TileStats[tile]);
+	});
+
+	for (const SRasterStats& stats : m_TileStats)
+	{
+		m_Stats.m_Fragments += stats.m_Fragments;
+		m_Stats.m_ShadedFragments += stats.m_ShadedFragments;
+	}
+}
+
+bool CSoftwareRasterizer::SaveImage(const char* filename) const
+{
+	FILE* file = fopen(filename, "wb");
+
+	if (!file)
+	{
+		printf("Failed to open image for writing: %s\n", filename);
+		return false;
+	}
+
+	fprintf(file, "P6\n%u %u\n255\n", unsigned(m_Width), unsigned(m_Height));
+	std::vector<uint8_t> row(size_t(m_Width) * 3);
+	bool written = true;
+
+	for (size_t y = m_Height; y-- > 0;)
+	{
+		for (size_t x = 0; x < m_Width; ++x)
+		{
+			const uint32_t pixel = m_Color[y * m_Stride + x];
+			row[x * 3 + 0] = uint8_t(pixel);
+			row[x * 3 + 1] = uint8_t(pixel >> 8);
+			row[x * 3 + 2] = uint8_t(pixel >> 16);
+		}
+
+		written &= fwrite(row.data(), 1, row.size(), file) == row.size();
+	}
+
+	fclose(file);
+
+	if (!written)
+	{
+		printf("Failed to write image: %s\n", filename);
+	}
+
+	return written;
+}
+
+const CSoftwareRasterizer::SSampler* CSoftwareRasterizer::PrepareSampler(const HTexture& texture)
+{
+	if (!texture || !texture->HasPixels())
+	{
+		return nullptr;
+	}
+
+	const auto found = m_Samplers.find(texture.get());
+
+	if (found != m_Samplers.end())
+	{
+		return found->second.m_Levels.empty() ? nullptr : &found->second;
+	}
+
+	SSampler& sampler = m_Samplers[texture.get()];
+	sampler.m_Texture = texture;
+
+	// Compressed textures are expanded and missing mips built, like the GL fallbacks do
+	const STexture* source = texture.get();
+	STexture converted;
+
+	if (IsCompressed(source->m_Format))
+	{
+		if (!NUtils::DecompressTexture(*source, converted))
+		{
+			return nullptr;
+		}
+
+		source = &converted;
+	}
+
+	if (source->m_GenerateMips && source->m_Levels.size() <= 1)
+	{
+		if (source != &converted)
+		{
+			converted = *source;
+		}
+
+		if (!NUtils::GenerateMips(converted))
+		{
+			return nullptr;
+		}
+
+		source = &converted;
+	}
+
+	std::vector<STexture::SLevel> levels = source->m_Levels;
+
+	if (levels.empty())
+	{
+		levels.push_back({ source->m_Width, source->m_Height, 0, source->DataSize() });
+	}
+
+	const size_t channels = FormatSize(source->m_Format);
+
+	for (const STexture::SLevel& level : levels)
+	{
+		const size_t pitch = level.m_Pitch ? level.m_Pitch : level.m_Width * channels;
+
+		if (level.m_Width == 0 || level.m_Height == 0 || level.m_Offset + pitch * (level.m_Height - 1) + level.m_Width * channels > source->DataSize())
+		{
+			printf("Invalid texture level: %s\n", source->m_Name.c_str());
+			sampler.m_Levels.clear();
+			return nullptr;
+		}
+
+		SSampler::SLevel expanded;
+		expanded.m_Width = level.m_Width;
+		expanded.m_Height = level.m_Height;
+		expanded.m_Texels.resize(size_t(level.m_Width) * level.m_Height);
+
+		// Missing channels read as zero and alpha as one, like GL expands them
+		for (size_t y = 0; y < level.m_Height; ++y)
+		{
+			const uint8_t* row = source->Data() + level.m_Offset + y * pitch;
+
+			for (size_t x = 0; x < level.m_Width; ++x)
+			{
+				const uint8_t* pixel = row + x * channels;
+				const uint32_t g = channels > 1 ? pixel[1] : 0;
+				const uint32_t b = channels > 2 ? pixel[2] : 0;
+				const uint32_t a = channels > 3 ? pixel[3] : 0xFF;
+				expanded.m_Texels[y * level.m_Width + x] = pixel[0] | g << 8 | b << 16 | a << 24;
+			}
+		}
+
+		sampler.m_Levels.push_back(std::move(expanded));
+	}
+
+	return &sampler;
+}
+
+void CSoftwareRasterizer::Project(SVertex& vertex) const
+{
+	vertex.m_Outcode = Outcode(vertex.m_Position);
+
+	// Only vertices inside the guard band are ever rasterized, the rest just mustn't overflow
+	const float limit = GUARD_BAND + 1.0f;
+	const float inv_w = vertex.m_Position[3] > 0.0f ? 1.0f / vertex.m_Position[3] : 0.0f;
+	const float x = std::min(std::max(vertex.m_Position[0] * inv_w, -limit), limit);
+	const float y = std::min(std::max(vertex.m_Position[1] * inv_w, -limit), limit);
+
+	vertex.m_WindowX = int32_t(lrintf((x * 0.5f + 0.5f) * m_Width * SUBPIXELS));
+	vertex.m_WindowY = int32_t(lrintf((y * 0.5f + 0.5f) * m_Height * SUBPIXELS));
+	vertex.m_WindowZ = vertex.m_Position[2] * inv_w * 0.5f + 0.5f;
+	vertex.m_InvW = inv_w;
+}
+
+void CSoftwareRasterizer::ShadeVertices(const SBatch& batch)
+{
+	const SDraw& draw = *batch.m_Draw;
+
+	for (size_t v = batch.m_First; v < batch.m_First + batch.m_Count; ++v)
+	{
+		const SMesh::SVertexData vertex = NUtils::GetVertex(*draw.m_Mesh, *batch.m_SubMesh, v);
+		SVertex& shaded = m_Vertices[draw.m_FirstVertex + v];
+
+		const CVector4f position = draw.m_ModelViewProjection * CVector4f(vertex.m_Position.m_X, vertex.m_Position.m_Y, vertex.m_Position.m_Z, 1.0f);
+
+		const CVector3f normal(&vertex.m_Normal.m_X);
+		const CVector3f tangent(&vertex.m_Tangent.m_X);
+		const CVector3f world_normal = (draw.m_Model * normal).normalized();
+		const CVector3f world_tangent = (draw.m_Model * tangent).normalized();
+		const CVector3f world_bitangent = (draw.m_Model * (normal.cross(tangent) * vertex.m_Tangent.m_W)).normalized();
+
+		for (int i = 0; i < 4; ++i)
+		{
+			shaded.m_Position[i] = position[i];
+		}
+
+		for (int i = 0; i < 3; ++i)
+		{
+			shaded.m_Varyings[TANGENT + i] = world_tangent[i];
+			shaded.m_Varyings[BITANGENT + i] = world_bitangent[i];
+			shaded.m_Varyings[NORMAL + i] = world_normal[i];
+			shaded.m_Varyings[COLOR + i] = (&vertex.m_Color.m_X)[i];
+		}
+
+		shaded.m_Varyings[UV + 0] = vertex.m_UV.m_X;
+		shaded.m_Varyings[UV + 1] = vertex.m_UV.m_Y;
+		Project(shaded);
+	}
+}
+
+void CSoftwareRasterizer::SetupTriangles(const SBatch& batch, SSetup& setup) const
+{
+	const SDraw& draw = *batch.m_Draw;
+	const std::vector<uint32_t>& indices = draw.m_Mesh->m_Indices;
+
+	setup.m_Triangles.clear();
+	setup.m_Clipped.clear();
+	setup.m_Stats = SRasterStats();
+
+	for (size_t i = batch.m_First; i + 2 < batch.m_First + batch.m_Count; i += 3)
+	{
+		const SVertex* polygon[MAX_POLYGON];
+		uint32_t all_outside = ~0u;
+		uint32_t any_outside = 0;
+
+		for (size_t k = 0; k < 3; ++k)
+		{
+			polygon[k] = &m_Vertices[draw.m_FirstVertex + indices[i + k]];
+			all_outside &= polygon[k]->m_Outcode;
+			any_outside |= polygon[k]->m_Outcode;
+		}
+
+		++setup.m_Stats.m_Triangles;
+
+		if (all_outside & REJECT_MASK)
+		{
+			++setup.m_Stats.m_CulledTriangles;
+			continue;
+		}
+
+		size_t count = 3;
+
+		if (any_outside & CLIP_MASK)
+		{
+			++setup.m_Stats.m_ClippedTriangles;
+
+			for (size_t plane = 0; plane < CLIP_PLANES && count >= 3; ++plane)
+			{
+				if (!(any_outside & (1u << plane)))
+				{
+					continue;
+				}
+
+				const SVertex* input[MAX_POLYGON];
+				std::copy(polygon, polygon + count, input);
+				const size_t input_count = count;
+				count = 0;
+
+				for (size_t k = 0; k < input_count; ++k)
+				{
+					const SVertex* a = input[k];
+					const SVertex* b = input[(k + 1) % input_count];
+					float distance_a = ClipDistance(a->m_Position, plane);
+					float distance_b = ClipDistance(b->m_Position, plane);
+
+					if (distance_a >= 0.0f)
+					{
+						polygon[count++] = a;
+					}
+
+					if ((distance_a >= 0.0f) == (distance_b >= 0.0f))
+					{
+						continue;
+					}
+
+					// Both triangles sharing an edge cut it from the same end, so their cuts meet exactly
+					if (std::lexicographical_compare(b->m_Position, b->m_Position + 4, a->m_Position, a->m_Position + 4))
+					{
+						std::swap(a, b);
+						std::swap(distance_a, distance_b);
+					}
+
+					const float t = distance_a / (distance_a - distance_b);
+					SVertex clipped;
+
+					for (int j = 0; j < 4; ++j)
+					{
+						clipped.m_Position[j] = a->m_Position[j] + (b->m_Position[j] - a->m_Position[j]) * t;
+					}
+
+					for (size_t j = 0; j < VARYINGS; ++j)
+					{
+						clipped.m_Varyings[j] = a->m_Varyings[j] + (b->m_Varyings[j] - a->m_Varyings[j]) * t;
+					}
+
+					Project(clipped);
+					setup.m_Clipped.push_back(clipped);
+					polygon[count++] = &setup.m_Clipped.back();
+				}
+			}
+		}
+
+		for (size_t k = 1; k + 1 < count; ++k)
+		{
+			AddTriangle(batch, polygon[0], polygon[k], polygon[k + 1], setup);
+		}
+	}
+}
+
+void CSoftwareRasterizer::AddTriangle(const SBatch& batch, const SVertex* v0, const SVertex* v1, const SVertex* v2, SSetup& setup) const
+{
+	STriangle triangle;
+	triangle.m_Vertices[0] = v0;
+	triangle.m_Vertices[1] = v1;
+	triangle.m_Vertices[2] = v2;
+	triangle.m_Albedo = batch.m_Albedo;
+	triangle.m_Detail = batch.m_Detail;
+
+	double x[3], y[3];
+
+	for (size_t k = 0; k < 3; ++k)
+	{
+		const SVertex& vertex = *triangle.m_Vertices[k];
+
+		// Only reachable through degenerate clips, everything in front of the near plane has w above zero
+		if (!(vertex.m_InvW > 0.0f))
+		{
+			++setup.m_Stats.m_CulledTriangles;
+			return;
+		}
+
+		triangle.m_X[k] = vertex.m_WindowX;
+		triangle.m_Y[k] = vertex.m_WindowY;
+		triangle.m_VertexInvW[k] = vertex.m_InvW;
+		x[k] = double(vertex.m_WindowX) / SUBPIXELS;
+		y[k] = double(vertex.m_WindowY) / SUBPIXELS;
+	}
+
+	// Front faces wind counter clockwise, zero area triangles cover nothing
+	const int64_t area = int64_t(triangle.m_X[1] - triangle.m_X[0]) * (triangle.m_Y[2] - triangle.m_Y[0]) - int64_t(triangle.m_X[2] - triangle.m_X[0]) * (triangle.m_Y[1] - triangle.m_Y[0]);
+
+	if (area <= 0)
+	{
+		++setup.m_Stats.m_CulledTriangles;
+		return;
+	}
+
+	// Pixels whose centers the bounds could cover
+	const int32_t min_x = std::min({ triangle.m_X[0], triangle.m_X[1], triangle.m_X[2] });
+	const int32_t min_y = std::min({ triangle.m_Y[0], triangle.m_Y[1], triangle.m_Y[2] });
+	const int32_t max_x = std::max({ triangle.m_X[0], triangle.m_X[1], triangle.m_X[2] });
+	const int32_t max_y = std::max({ triangle.m_Y[0], triangle.m_Y[1], triangle.m_Y[2] });
+
+	triangle.m_MinX = std::max((min_x - SUBPIXELS / 2 + SUBPIXELS - 1) >> SUBPIXEL_BITS, 0);
+	triangle.m_MinY = std::max((min_y - SUBPIXELS / 2 + SUBPIXELS - 1) >> SUBPIXEL_BITS, 0);
+	triangle.m_MaxX = std::min((max_x - SUBPIXELS / 2) >> SUBPIXEL_BITS, int32_t(m_Width) - 1);
+	triangle.m_MaxY = std::min((max_y - SUBPIXELS / 2) >> SUBPIXEL_BITS, int32_t(m_Height) - 1);
+
+	if (triangle.m_MinX > triangle.m_MaxX || triangle.m_MinY > triangle.m_MaxY)
+	{
+		++setup.m_Stats.m_CulledTriangles;
+		return;
+	}
+
+	const double pixel_area = double(area) / (SUBPIXELS * SUBPIXELS);
+	SetPlane(x, y, pixel_area, 0.0, 1.0, 0.0, triangle.m_Weight1);
+	SetPlane(x, y, pixel_area, 0.0, 0.0, 1.0, triangle.m_Weight2);
+	SetPlane(x, y, pixel_area, v0->m_WindowZ, v1->m_WindowZ, v2->m_WindowZ, triangle.m_Depth);
+	SetPlane(x, y, pixel_area, triangle.m_VertexInvW[0], triangle.m_VertexInvW[1], triangle.m_VertexInvW[2], triangle.m_InvW);
+
+	// One mip for the whole triangle, from how many texels land on each of its pixels
+	const float* uv0 = v0->m_Varyings + UV;
+	const float* uv1 = v1->m_Varyings + UV;
+	const float* uv2 = v2->m_Varyings + UV;
+	const float uv_area = fabsf((uv1[0] - uv0[0]) * (uv2[1] - uv0[1]) - (uv2[0] - uv0[0]) * (uv1[1] - uv0[1]));
+
+	auto SelectLod = [&](const SSampler* sampler) {
+		if (!sampler)
+		{
+			return 0.0f;
+		}
+
+		const float texels = uv_area * sampler->m_Levels[0].m_Width * sampler->m_Levels[0].m_Height;
+		return 0.5f * log2f(std::max(texels, 1e-20f) / float(pixel_area));
+	};
+
+	triangle.m_AlbedoLod = SelectLod(triangle.m_Albedo);
+	triangle.m_DetailLod = SelectLod(triangle.m_Detail);
+
+	setup.m_Triangles.push_back(triangle);
+}
+
+void CSoftwareRasterizer::RasterizeTile(size_t tile, SRasterStats& stats)
+{
+	const int32_t x0 = int32_t(tile % m_TilesX) * TileSize;
+	const int32_t y0 = int32_t(tile / m_TilesX) * TileSize;
+	const int32_t x1 = std::min<int32_t>(x0 + TileSize, m_Width);
+	const int32_t y1 = std::min<int32_t>(y0 + TileSize, m_Height);
+
+	for (const STriangle* triangle : m_Bins[tile])
+	{
+		RasterizeTriangle(*triangle, x0, y0, x1, y1, stats);
+	}
+}
+
+void CSoftwareRasterizer::RasterizeTriangle(const STriangle& triangle, int32_t x0, int32_t y0, int32_t x1, int32_t y1, SRasterStats& stats)
+{
+	const int32_t min_x = std::max(triangle.m_MinX, x0);
+	const int32_t min_y = std::max(triangle.m_MinY, y0);
+	const int32_t max_x = std::min(triangle.m_MaxX, x1 - 1);
+	const int32_t max_y = std::min(triangle.m_MaxY, y1 - 1);
+
+	if (min_x > max_x || min_y > max_y)
+	{
+		return;
+	}
+
+	// Edge e runs between the other two vertices and is positive inside. Pixels exactly on an
+	// edge belong to the triangle it's a left or top edge of, so shared edges are drawn once.
+	int64_t edge_x[3], edge_y[3], origin_x[3], origin_y[3], bias[3];
+
+	for (int e = 0; e < 3; ++e)
+	{
+		const int a = (e + 1) % 3;
+		const int b = (e + 2) % 3;
+		edge_x[e] = triangle.m_X[b] - triangle.m_X[a];
+		edge_y[e] = triangle.m_Y[b] - triangle.m_Y[a];
+		origin_x[e] = triangle.m_X[a];
+		origin_y[e] = triangle.m_Y[a];
+		bias[e] = edge_y[e] < 0 || (edge_y[e] == 0 && edge_x[e] < 0) ? 1 : 0;
+	}
+
+	for (int32_t block_y = min_y & ~(BLOCK - 1); block_y <= max_y; block_y += BLOCK)
+	{
+		for (int32_t block_x = min_x & ~(BLOCK - 1); block_x <= max_x; block_x += BLOCK)
+		{
+			// Edges the whole block is inside of are replaced by a constant, the rest are small
+			// enough within a block to step in 32 bits
+			int32_t start[3], step_x[3], step_y[3];
+			bool outside = false;
+
+			for (int e = 0; e < 3 && !outside; ++e)
+			{
+				const int64_t px = int64_t(block_x) * SUBPIXELS + SUBPIXELS / 2 - origin_x[e];
+				const int64_t py = int64_t(block_y) * SUBPIXELS + SUBPIXELS / 2 - origin_y[e];
+				const int64_t value = edge_x[e] * py - edge_y[e] * px + bias[e];
+				const int64_t dx = -edge_y[e] * SUBPIXELS * (BLOCK - 1);
+				const int64_t dy = edge_x[e] * SUBPIXELS * (BLOCK - 1);
+				const int64_t lowest = value + std::min<int64_t>(dx, 0) + std::min<int64_t>(dy, 0);
+				const int64_t highest = value + std::max<int64_t>(dx, 0) + std::max<int64_t>(dy, 0);
+
+				outside = highest <= 0;
+
+				if (lowest > 0)
+				{
+					start[e] = 1;
+					step_x[e] = 0;
+					step_y[e] = 0;
+				}
+				else
+				{
+					start[e] = int32_t(value);
+					step_x[e] = int32_t(-edge_y[e] * SUBPIXELS);
+					step_y[e] = int32_t(edge_x[e] * SUBPIXELS);
+				}
+			}
+
+			if (outside)
+			{
+				continue;
+			}
+
+			for (int32_t row = 0; row < BLOCK; ++row)
+			{
+				const int32_t y = block_y + row;
+
+				if (y < min_y || y > max_y)
+				{
+					continue;
+				}
+
+				const int32_t e0 = start[0] + step_y[0] * row;
+				const int32_t e1 = start[1] + step_y[1] * row;
+				const int32_t e2 = start[2] + step_y[2] * row;
+				uint8_t covered[BLOCK];
+				uint32_t count = 0;
+
+				for (int32_t i = 0; i < BLOCK; ++i)
+				{
+					const int32_t x = block_x + i;
+					covered[i] = (e0 + step_x[0] * i > 0) & (e1 + step_x[1] * i > 0) & (e2 + step_x[2] * i > 0) & (x >= min_x) & (x <= max_x);
+					count += covered[i];
+				}
+
+				if (!count)
+				{
+					continue;
+				}
+
+				stats.m_Fragments += count;
+
+				float* depth = &m_Depth[size_t(y) * m_Stride + block_x];
+				const float row_depth = triangle.m_Depth[0] + triangle.m_Depth[2] * float(y);
+				float z[BLOCK];
+				uint8_t passed[BLOCK];
+
+				for (int32_t i = 0; i < BLOCK; ++i)
+				{
+					z[i] = row_depth + triangle.m_Depth[1] * float(block_x + i);
+					passed[i] = covered[i] & (z[i] < depth[i]);
+				}
+
+				uint32_t* color = &m_Color[size_t(y) * m_Stride + block_x];
+
+				for (int32_t i = 0; i < BLOCK; ++i)
+				{
+					if (passed[i])
+					{
+						depth[i] = z[i];
+						ShadePixel(triangle, block_x + i, y, color[i]);
+						++stats.m_ShadedFragments;
+					}
+				}
+			}
+		}
+	}
+}
+
+void CSoftwareRasterizer::ShadePixel(const STriangle& triangle, int32_t x, int32_t y, uint32_t& pixel) const
+{
+	const float fx = float(x);
+	const float fy = float(y);
+
+	// Screen space weights turned perspective correct
+	const float inv_w = 1.0f / Evaluate(triangle.m_InvW, fx, fy);
+	const float w1 = Evaluate(triangle.m_Weight1, fx, fy) * triangle.m_VertexInvW[1] * inv_w;
+	const float w2 = Evaluate(triangle.m_Weight2, fx, fy) * triangle.m_VertexInvW[2] * inv_w;
+
+	const float* a = triangle.m_Vertices[0]->m_Varyings;
+	const float* b = triangle.m_Vertices[1]->m_Varyings;
+	const float* c = triangle.m_Vertices[2]->m_Varyings;
+	float varyings[VARYINGS];
+
+	for (size_t i = 0; i < VARYINGS; ++i)
+	{
+		varyings[i] = a[i] + (b[i] - a[i]) * w1 + (c[i] - a[i]) * w2;
+	}
+
+	auto Sample = [&](const SSampler* sampler, float lod, float (&texel)[4]) {
+		if (!sampler)
+		{
+			texel[0] = texel[1] = texel[2] = 0.0f;
+			texel[3] = 1.0f;
+			return;
+		}
+
+		// Magnified and single level textures are nearest, minified ones blend the two nearest mips
+		const size_t last = sampler->m_Levels.size() - 1;
+		lod = std::min(std::max(lod, 0.0f), float(last));
+		const size_t level = size_t(lod);
+		const SSampler::SLevel& first = sampler->m_Levels[level];
+		Fetch(first.m_Texels, first.m_Width, first.m_Height, varyings[UV], varyings[UV + 1], texel);
+
+		const float blend = lod - float(level);
+
+		if (blend > 0.0f && level < last)
+		{
+			const SSampler::SLevel& second = sampler->m_Levels[level + 1];
+			float next[4];
+			Fetch(second.m_Texels, second.m_Width, second.m_Height, varyings[UV], varyings[UV + 1], next);
+
+			for (int channel = 0; channel < 4; ++channel)
+			{
+				texel[channel] += (next[channel] - texel[channel]) * blend;
+			}
+		}
+	};
+
+	float albedo[4], detail[4];
+	Sample(triangle.m_Albedo, triangle.m_AlbedoLod, albedo);
+	Sample(triangle.m_Detail, triangle.m_DetailLod, detail);
+
+	// Detail xy is used as is and z rebuilt from it, the way basic.frag reads it
+	const float detail_z = sqrtf(1.0f - std::min(std::max(detail[0] * detail[0] + detail[1] * detail[1], 0.0f), 1.0f));
+	const CVector3f normal = (CVector3f(&varyings[TANGENT]) * detail[0] + CVector3f(&varyings[BITANGENT]) * detail[1] + CVector3f(&varyings[NORMAL]) * detail_z).normalized();
+
+	const CVector3f light = CVector3f::Ones().normalized();
+	const float lambert = std::max(0.0f, normal.dot(light));
+	const CVector3f reflected = -light + 2.0f * normal.dot(light) * normal;
+	const float specular = powf(std::max(m_ViewDirection.dot(reflected), 0.0f), SPECULAR_POWER);
+	const float lighting = lambert + specular;
+
+	float source[4];
+
+	for (int channel = 0; channel < 3; ++channel)
+	{
+		source[channel] = std::min(albedo[channel] * varyings[COLOR + channel] * lighting, 1.0f);
+	}
+
+	source[3] = std::min(albedo[3], 1.0f);
+
+	// Alpha blending with the framebuffer, alpha included, then stored at 8 bits per channel
+	uint32_t blended = 0;
+
+	for (int channel = 0; channel < 4; ++channel)
+	{
+		const float destination = float((pixel >> (channel * 8)) & 0xFF) / 255.0f;
+		blended |= uint32_t(Quantize(source[channel] * source[3] + destination * (1.0f - source[3]))) << (channel * 8);
+	}
+
+	pixel = blended;
+}
+}  // namespace NRender
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include <Engine/Frustum.h>
+#include <Engine/Math.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+class CCamera;
+
+namespace NRender
+{
+struct STexture;
+using HTexture = std::shared_ptr<STexture>;
+
+struct SRasterStats
+{
+	size_t m_Draws = 0;
+	size_t m_Triangles = 0;
+	size_t m_CulledTriangles = 0;
+	size_t m_ClippedTriangles = 0;
+
+	// Triangle and tile pairs, a triangle counts once for every tile it touches
+	size_t m_BinnedTriangles = 0;
+
+	// Pixels covered, and the ones of those passing the depth test
+	size_t m_Fragments = 0;
+	size_t m_ShadedFragments = 0;
+};
+
+/**
+ * Renders meshes on the CPU the way basic.vert and basic.frag do on the GPU, for
+ * headless runs and machines without WebGL. Draws are recorded and everything
+ * happens in End, in stages that each run on the task pool: vertices are shaded
+ * in chunks, triangles are clipped, culled and set up in chunks, then binned
+ * into screen tiles in submission order, and tiles are rasterized in parallel.
+ * Every tile belongs to a single task and sees its triangles in the order they
+ * were drawn, so images come out the same for any thread count.
+ *
+ * Coverage is tested in fixed point with a top-left fill rule, 8x8 blocks at a
+ * time. Each row of a block steps its edge functions and depth across the eight
+ * pixels into coverage and depth masks, only passing pixels are shaded one by
+ * one. Textures are sampled like the GPU samplers are set up, nearest with
+ * linear blends between mips, but the mip is chosen once per triangle.
+ **/
+class CSoftwareRasterizer
+{
+public:
+	static constexpr int TileSize = 64;
+
+	void Resize(uint16_t width, uint16_t height);
+
+	// Clears colour and depth and starts recording draws seen from the camera
+	void Begin(const CCamera& camera);
+
+	// The mesh has to stay alive until End, lod is clamped to the levels each submesh has
+	void Draw(const SMesh& mesh, const CTransform& transform, size_t lod = 0);
+
+	void End();
+
+	uint16_t Width() const { return m_Width; }
+	uint16_t Height() const { return m_Height; }
+
+	// RGBA8 and depth, rows are Stride() pixels apart and go bottom up like glReadPixels returns them
+	size_t Stride() const { return m_Stride; }
+	const std::vector<uint32_t>& Color() const { return m_Color; }
+	const std::vector<float>& Depth() const { return m_Depth; }
+
+	// Statistics of the last frame
+	const SRasterStats& Stats() const { return m_Stats; }
+
+	// Binary PPM, top row first
+	bool SaveImage(const char* filename) const;
+
+private:
+	// Tangent, bitangent and normal, colour and uv
+	static constexpr size_t VARYINGS = 14;
+
+	struct SVertex
+	{
+		float m_Position[4];
+		float m_Varyings[VARYINGS];
+
+		// Left by Project, shared by every triangle using the vertex: the fixed point window position,
+		// depth, 1 / w and the planes the vertex is outside of
+		int32_t m_WindowX, m_WindowY;
+		float m_WindowZ, m_InvW;
+		uint32_t m_Outcode;
+	};
+
+	// Every level converted to RGBA8, so sampling never looks at the format
+	struct SSampler
+	{
+		struct SLevel
+		{
+			uint16_t m_Width = 0;
+			uint16_t m_Height = 0;
+			std::vector<uint32_t> m_Texels;
+		};
+
+		HTexture m_Texture;
+		std::vector<SLevel> m_Levels;
+	};
+
+	struct SDraw
+	{
+		const SMesh* m_Mesh;
+		Eigen::Matrix4f m_ModelViewProjection;
+		CMatrix3f m_Model;
+		size_t m_Lod;
+		size_t m_FirstVertex;
+	};
+
+	// A run of vertices or triangles of a submesh
+	struct SBatch
+	{
+		const SDraw* m_Draw;
+		const SMesh::SSubMesh* m_SubMesh;
+		size_t m_First;
+		size_t m_Count;
+		const SSampler* m_Albedo;
+		const SSampler* m_Detail;
+	};
+
+	struct STriangle
+	{
+		const SVertex* m_Vertices[3];
+		const SSampler* m_Albedo;
+		const SSampler* m_Detail;
+		float m_AlbedoLod;
+		float m_DetailLod;
+
+		// Covered pixels, inclusive and inside the viewport
+		int32_t m_MinX, m_MinY, m_MaxX, m_MaxY;
+
+		// Window positions in fixed point, and 1 / w at each vertex
+		int32_t m_X[3], m_Y[3];
+		float m_VertexInvW[3];
+
+		// Planes over pixel coordinates, value = [0] + [1] * x + [2] * y: the screen space weights
+		// of the second and third vertex, depth and 1 / w
+		float m_Weight1[3], m_Weight2[3], m_Depth[3], m_InvW[3];
+	};
+
+	// Results of setting up one triangle batch, clipped vertices live here as well
+	struct SSetup
+	{
+		std::vector<STriangle> m_Triangles;
+		std::deque<SVertex> m_Clipped;
+		SRasterStats m_Stats;
+	};
+
+	const SSampler* PrepareSampler(const HTexture& texture);
+
+	void Project(SVertex& vertex) const;
+	void ShadeVertices(const SBatch& batch);
+	void SetupTriangles(const SBatch& batch, SSetup& setup) const;
+	void AddTriangle(const SBatch& batch, const SVertex* v0, const SVertex* v1, const SVertex* v2, SSetup& setup) const;
+	void RasterizeTile(size_t tile, SRasterStats& stats);
+	void RasterizeTriangle(const STriangle& triangle, int32_t x0, int32_t y0, int32_t x1, int32_t y1, SRasterStats& stats);
+	void ShadePixel(const STriangle& triangle, int32_t x, int32_t y, uint32_t& pixel) const;
+
+	uint16_t m_Width = 0;
+	uint16_t m_Height = 0;
+	size_t m_Stride = 0;
+	size_t m_TilesX = 0;
+	size_t m_TilesY = 0;
+
+	// Padded to whole tiles, so rows of a block never run past the end
+	std::vector<uint32_t> m_Color;
+	std::vector<float> m_Depth;
+
+	Eigen::Matrix4f m_ViewProjection;
+	CFrustum m_Frustum;
+	CVector3f m_ViewDirection;
+
+	// Batches point at their draw, so draws must not move while recording
+	std::deque<SDraw> m_Draws;
+	std::vector<SVertex> m_Vertices;
+	size_t m_VertexCount = 0;
+	std::vector<SBatch> m_VertexBatches;
+	std::vector<SBatch> m_TriangleBatches;
+	std::vector<SSetup> m_Setups;
+	std::vector<std::vector<const STriangle*>> m_Bins;
+	std::vector<SRasterStats> m_TileStats;
+	std::unordered_map<const STexture*, SSampler> m_Samplers;
+	SRasterStats m_Stats;
+};
+}  // namespace NRender
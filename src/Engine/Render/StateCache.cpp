@@ -0,0 +1,167 @@
+#include "StateCache.h"
+
+#include "RenderStats.h"
+
+#include <stdio.h>
+
+namespace NRender
+{
+bool CStateCache::Update(GLuint& cached, GLuint value)
+{
+	SFrameStats& stats = CRenderStats::Instance().Current();
+
+	if (cached == value)
+	{
+		++stats.m_GLCallsElided;
+		return false;
+	}
+
+	++stats.m_GLCallsIssued;
+	cached = value;
+	return true;
+}
+
+void CStateCache::UseProgram(GLuint program)
+{
+	if (Update(m_Program, program))
+	{
+		glUseProgram(program);
+	}
+}
+
+void CStateCache::BindVertexArray(GLuint vertex_array)
+{
+	if (Update(m_VertexArray, vertex_array))
+	{
+		glBindVertexArray(vertex_array);
+
+		// The element array binding belongs to the vertex array
+		m_ElementArrayBuffer = Unknown;
+	}
+}
+
+void CStateCache::BindBuffer(GLenum target, GLuint buffer)
+{
+	switch (target)
+	{
+	case GL_ARRAY_BUFFER:
+		if (Update(m_ArrayBuffer, buffer))
+		{
+			glBindBuffer(target, buffer);
+		}
+		break;
+	case GL_ELEMENT_ARRAY_BUFFER:
+		if (Update(m_ElementArrayBuffer, buffer))
+		{
+			glBindBuffer(target, buffer);
+		}
+		break;
+	default:
+		++CRenderStats::Instance().Current().m_GLCallsIssued;
+		glBindBuffer(target, buffer);
+		break;
+	}
+}
+
+void CStateCache::ActiveTexture(GLuint unit)
+{
+	if (Update(m_ActiveTexture, unit))
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+	}
+}
+
+void CStateCache::BindTexture(GLuint unit, GLuint texture)
+{
+	if (unit >= TextureUnits)
+	{
+		printf("Invalid texture unit: %u\n", unit);
+		return;
+	}
+
+	// The active unit is only switched when the binding actually changes
+	if (m_Textures[unit] == texture)
+	{
+		++CRenderStats::Instance().Current().m_GLCallsElided;
+		return;
+	}
+
+	ActiveTexture(unit);
+	Update(m_Textures[unit], texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void CStateCache::DeleteProgram(GLuint program)
+{
+	// A program in use stays current until another one is used, so its state is left unknown
+	if (m_Program == program)
+	{
+		m_Program = Unknown;
+	}
+
+	glDeleteProgram(program);
+}
+
+void CStateCache::DeleteVertexArrays(GLsizei count, const GLuint* vertex_arrays)
+{
+	for (GLsizei i = 0; i < count; ++i)
+	{
+		if (vertex_arrays[i] != 0 && m_VertexArray == vertex_arrays[i])
+		{
+			m_VertexArray = 0;
+			m_ElementArrayBuffer = Unknown;
+		}
+	}
+
+	glDeleteVertexArrays(count, vertex_arrays);
+}
+
+void CStateCache::DeleteBuffers(GLsizei count, const GLuint* buffers)
+{
+	for (GLsizei i = 0; i < count; ++i)
+	{
+		if (buffers[i] == 0)
+		{
+			continue;
+		}
+
+		if (m_ArrayBuffer == buffers[i])
+		{
+			m_ArrayBuffer = 0;
+		}
+
+		if (m_ElementArrayBuffer == buffers[i])
+		{
+			m_ElementArrayBuffer = 0;
+		}
+	}
+
+	glDeleteBuffers(count, buffers);
+}
+
+void CStateCache::DeleteTextures(GLsizei count, const GLuint* textures)
+{
+	for (GLsizei i = 0; i < count; ++i)
+	{
+		for (GLuint& bound : m_Textures)
+		{
+			if (textures[i] != 0 && bound == textures[i])
+			{
+				bound = 0;
+			}
+		}
+	}
+
+	glDeleteTextures(count, textures);
+}
+
+void CStateCache::Invalidate()
+{
+	m_Program = Unknown;
+	m_VertexArray = Unknown;
+	m_ArrayBuffer = Unknown;
+	m_ElementArrayBuffer = Unknown;
+	m_ActiveTexture = Unknown;
+	m_Textures.fill(Unknown);
+}
+}  // namespace NRender
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Utils/Singleton.h"
+
+#include <SDL_opengl.h>
+
+#include <stddef.h>
+
+#include <array>
+
+namespace NRender
+{
+/**
+ * Shadows the GL binding state so binding what is already bound never reaches GL.
+ * All engine code binds and deletes objects through here, a binding changed behind
+ * its back has to be followed by Invalidate().
+ **/
+class CStateCache : public TSingleton<CStateCache>
+{
+public:
+	static constexpr size_t TextureUnits = 8;
+
+	CStateCache() { Invalidate(); }
+
+	void UseProgram(GLuint program);
+	void BindVertexArray(GLuint vertex_array);
+	void BindBuffer(GLenum target, GLuint buffer);
+	void BindTexture(GLuint unit, GLuint texture);
+
+	// Deleted objects are unbound by GL, so any cached binding of them is cleared as well
+	void DeleteProgram(GLuint program);
+	void DeleteVertexArrays(GLsizei count, const GLuint* vertex_arrays);
+	void DeleteBuffers(GLsizei count, const GLuint* buffers);
+	void DeleteTextures(GLsizei count, const GLuint* textures);
+
+	// Forgets everything, the next bind of each kind always reaches GL
+	void Invalidate();
+
+	GLuint Program() const { return m_Program; }
+
+private:
+	void ActiveTexture(GLuint unit);
+
+	// Each call either reaches GL or is elided, both are counted in the frame stats
+	bool Update(GLuint& cached, GLuint value);
+
+	// Zero is a valid binding, so unknown state uses a name GL never hands out
+	static constexpr GLuint Unknown = ~0u;
+
+	GLuint m_Program = Unknown;
+	GLuint m_VertexArray = Unknown;
+	GLuint m_ArrayBuffer = Unknown;
+	GLuint m_ElementArrayBuffer = Unknown;
+	GLuint m_ActiveTexture = Unknown;
+	std::array<GLuint, TextureUnits> m_Textures;
+};
+}  // namespace NRender
@@ -0,0 +1,96 @@
+#include "StreamBuffer.h"
+
+#include "RenderStats.h"
+#include "StateCache.h"
+
+#include <algorithm>
+
+namespace NRender
+{
+// A grown buffer holds this many uploads of the size that didn't fit, as the GPU lags a frame or two behind
+constexpr size_t GROWN_UPLOADS = 3;
+
+CStreamBuffer::CStreamBuffer(GLenum target, size_t capacity)
+	: m_Target(target)
+	, m_Ring(capacity)
+{
+}
+
+CStreamBuffer::~CStreamBuffer()
+{
+	for (const SFence& fence : m_Fences)
+	{
+		glDeleteSync(fence.m_Sync);
+	}
+
+	CStateCache::Instance().DeleteBuffers(1, &m_Buffer);
+}
+
+size_t CStreamBuffer::Upload(const void* data, size_t size)
+{
+	if (m_Buffer == 0)
+	{
+		glGenBuffers(1, &m_Buffer);
+		Orphan(m_Ring.Capacity());
+	}
+	else
+	{
+		CStateCache::Instance().BindBuffer(m_Target, m_Buffer);
+	}
+
+	size_t offset = m_Ring.Allocate(size);
+
+	// Everything still in flight keeps its old storage, the fresh one starts out empty
+	if (offset == NUtils::CRingAllocator::Invalid)
+	{
+		size_t capacity = std::max<size_t>(m_Ring.Capacity(), 1);
+
+		while (capacity < size * GROWN_UPLOADS)
+		{
+			capacity *= 2;
+		}
+
+		Orphan(capacity);
+		offset = m_Ring.Allocate(size);
+		++CRenderStats::Instance().Current().m_BufferOrphans;
+	}
+
+	glBufferSubData(m_Target, offset, size, data);
+	CRenderStats::Instance().Current().m_BytesUploaded += size;
+	return offset;
+}
+
+void CStreamBuffer::EndFrame()
+{
+	// Fences signal in order, the first one still pending holds back the rest
+	while (!m_Fences.empty())
+	{
+		const GLenum status = glClientWaitSync(m_Fences.front().m_Sync, 0, 0);
+
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		{
+			break;
+		}
+
+		m_Ring.Release(m_Fences.front().m_Frame);
+		glDeleteSync(m_Fences.front().m_Sync);
+		m_Fences.pop_front();
+	}
+
+	m_Fences.push_back({ m_Ring.EndFrame(), glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+}
+
+void CStreamBuffer::Orphan(size_t capacity)
+{
+	for (const SFence& fence : m_Fences)
+	{
+		glDeleteSync(fence.m_Sync);
+	}
+
+	m_Fences.clear();
+	m_Ring.Reset(capacity);
+
+	CStateCache::Instance().BindBuffer(m_Target, m_Buffer);
+	glBufferData(m_Target, capacity, nullptr, GL_STREAM_DRAW);
+}
+}  // namespace NRender
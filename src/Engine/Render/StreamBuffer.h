@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Utils/BufferAllocator.h"
+
+#include <SDL_opengl.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+
+namespace NRender
+{
+/**
+ * A buffer that is written every frame, like instance transforms or culled
+ * indices. Uploads go to consecutive ranges of one persistent buffer, and a
+ * fence closes each frame, so a range is only written again once the GPU has
+ * read it and uploads never wait on draws still in flight. When the frames in
+ * flight fill the whole buffer it is orphaned instead, growing if a single
+ * upload doesn't fit.
+ **/
+class CStreamBuffer
+{
+public:
+	CStreamBuffer(GLenum target, size_t capacity);
+	~CStreamBuffer();
+
+	CStreamBuffer(const CStreamBuffer&) = delete;
+	CStreamBuffer& operator=(const CStreamBuffer&) = delete;
+
+	// Copies the data into the buffer and returns its byte offset, the buffer is left bound.
+	// Element array uploads bind into the current vertex array, bind none first.
+	size_t Upload(const void* data, size_t size);
+
+	// Fences the frame's uploads, and frees the ranges of frames the GPU has finished
+	void EndFrame();
+
+	GLuint Buffer() const { return m_Buffer; }
+
+private:
+	void Orphan(size_t capacity);
+
+	struct SFence
+	{
+		uint64_t m_Frame;
+		GLsync m_Sync;
+	};
+
+	GLenum m_Target;
+	GLuint m_Buffer = 0;
+	NUtils::CRingAllocator m_Ring;
+	std::deque<SFence> m_Fences;
+};
+}  // namespace NRender
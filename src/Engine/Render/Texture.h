@@ -1,17 +1,95 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
+
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace NRender
 {
+// Uncompressed formats are 8-bits per channel, compressed ones are 4x4 ETC2/EAC blocks
+enum class ETextureFormat : uint8_t
+{
+	R8,
+	RG8,
+	RGB8,
+	RGBA8,
+	ETC2_RGB8,
+	ETC2_RGBA8,
+	EAC_R11,
+	EAC_RG11
+};
+
+inline bool IsCompressed(ETextureFormat format)
+{
+	return format >= ETextureFormat::ETC2_RGB8;
+}
+
+// Bytes per pixel for uncompressed formats, bytes per 4x4 block for compressed ones
+inline size_t FormatSize(ETextureFormat format)
+{
+	switch (format)
+	{
+	case ETextureFormat::R8: return 1;
+	case ETextureFormat::RG8: return 2;
+	case ETextureFormat::RGB8: return 3;
+	case ETextureFormat::RGBA8: return 4;
+	case ETextureFormat::ETC2_RGB8: return 8;
+	case ETextureFormat::ETC2_RGBA8: return 16;
+	case ETextureFormat::EAC_R11: return 8;
+	case ETextureFormat::EAC_RG11: return 16;
+	}
+
+	return 0;
+}
+
+inline size_t LevelSize(ETextureFormat format, size_t width, size_t height)
+{
+	return IsCompressed(format) ? ((width + 3) / 4) * ((height + 3) / 4) * FormatSize(format) : width * height * FormatSize(format);
+}
+
 struct STexture
 {
+	// Levels sit at their offsets into the pixels, largest first
+	struct SLevel
+	{
+		uint16_t m_Width = 0;
+		uint16_t m_Height = 0;
+		size_t m_Offset = 0;
+		size_t m_Size = 0;
+
+		// Bytes from one row to the next, zero when rows are packed tightly
+		size_t m_Pitch = 0;
+	};
+
+	const uint8_t* Data() const { return m_Pixels ? m_Pixels.get() : m_Buffer.data(); }
+	size_t DataSize() const { return m_Pixels ? m_PixelsSize : m_Buffer.size(); }
+	bool HasPixels() const { return m_Pixels || !m_Buffer.empty(); }
+
+	void ReleasePixels()
+	{
+		m_Pixels.reset();
+		m_PixelsSize = 0;
+		std::vector<uint8_t>().swap(m_Buffer);
+	}
+
 	std::string m_Name;
 	uint16_t m_Width = 0;
 	uint16_t m_Height = 0;
-	uint8_t m_BytesPerPixel = 0;
+	ETextureFormat m_Format = ETextureFormat::RGBA8;
+	std::vector<SLevel> m_Levels;
 	std::vector<uint8_t> m_Buffer;
+
+	// Pixels adopted from whatever decoded or mapped them, used instead of m_Buffer so they are never copied
+	std::shared_ptr<const uint8_t> m_Pixels;
+	size_t m_PixelsSize = 0;
+
+	// Textures carrying only their first level get the rest of the chain built by the GPU
+	bool m_GenerateMips = false;
+
+	// Nothing but the GPU needs the pixels, so they are dropped once uploaded
+	bool m_ReleaseAfterUpload = false;
 };
 }  // namespace NRender
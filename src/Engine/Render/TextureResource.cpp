@@ -0,0 +1,216 @@
+#include "TextureResource.h"
+
+#include "StateCache.h"
+#include "Texture.h"
+
+#include <Utils/TextureCompressor.h>
+
+#include <algorithm>
+
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+bool SupportsEtc2()
+{
+	// Core in GLES3, but WebGL2 only has it behind an extension
+	static const bool supported = []() {
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+		for (GLint i = 0; i < count; ++i)
+		{
+			const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+
+			if (extension != nullptr && strstr(extension, "compressed_texture_etc") != nullptr && strstr(extension, "etc1") == nullptr)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}();
+
+	return supported;
+}
+
+struct SFormat
+{
+	GLenum m_InternalFormat;
+	GLenum m_Format;
+};
+
+SFormat GetFormat(NRender::ETextureFormat format)
+{
+	switch (format)
+	{
+	case NRender::ETextureFormat::R8: return { GL_R8, GL_RED };
+	case NRender::ETextureFormat::RG8: return { GL_RG8, GL_RG };
+	case NRender::ETextureFormat::RGB8: return { GL_RGB8, GL_RGB };
+	case NRender::ETextureFormat::RGBA8: return { GL_RGBA8, GL_RGBA };
+	case NRender::ETextureFormat::ETC2_RGB8: return { GL_COMPRESSED_RGB8_ETC2, 0 };
+	case NRender::ETextureFormat::ETC2_RGBA8: return { GL_COMPRESSED_RGBA8_ETC2_EAC, 0 };
+	case NRender::ETextureFormat::EAC_R11: return { GL_COMPRESSED_R11_EAC, 0 };
+	case NRender::ETextureFormat::EAC_RG11: return { GL_COMPRESSED_RG11_EAC, 0 };
+	}
+
+	return { 0, 0 };
+}
+
+// Padded rows are read in place, through either the row length or the alignment
+bool SetUnpackPitch(size_t width, size_t pixel_size, size_t pitch)
+{
+	GLint row_length = 0;
+	GLint alignment = 1;
+
+	if (pitch != 0 && pitch != width * pixel_size)
+	{
+		if (pitch % pixel_size == 0)
+		{
+			row_length = pitch / pixel_size;
+		}
+		else
+		{
+			// Rows of three byte pixels are usually padded to four bytes, which no row length can express
+			alignment = 8;
+
+			while (alignment > 1 && (pitch % alignment != 0 || (width * pixel_size + alignment - 1) / alignment * alignment != pitch))
+			{
+				alignment /= 2;
+			}
+
+			if (alignment == 1)
+			{
+				return false;
+			}
+		}
+	}
+
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, row_length);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+	return true;
+}
+}  // namespace
+
+namespace NRender
+{
+CTextureResource::CTextureResource(HTexture texture)
+	: m_Source(texture)
+{
+	CreateTexture();
+}
+
+CTextureResource::~CTextureResource()
+{
+	DestroyTexture();
+}
+
+void CTextureResource::Reload()
+{
+	// Released pixels can't be uploaded again, the texture we have is still valid though
+	if (m_Source != nullptr && m_Source->HasPixels())
+	{
+		CreateTexture();
+	}
+}
+
+size_t CTextureResource::Size() const
+{
+	return m_Size;
+}
+
+void CTextureResource::CreateTexture()
+{
+	DestroyTexture();
+
+	// GPUs without ETC2 get the texture decoded on the CPU instead
+	const STexture* texture = m_Source.get();
+	STexture decompressed;
+
+	if (IsCompressed(texture->m_Format) && !SupportsEtc2())
+	{
+		if (!NUtils::DecompressTexture(*texture, decompressed))
+		{
+			return;
+		}
+
+		texture = &decompressed;
+	}
+
+	if (texture->m_Levels.empty() || !texture->HasPixels())
+	{
+		printf("Invalid texture: %s\n", texture->m_Name.c_str());
+		return;
+	}
+
+	const SFormat format = GetFormat(texture->m_Format);
+
+	// Uploads go through the last unit, so they never disturb a bound material
+	glGenTextures(1, &m_Texture);
+	CStateCache::Instance().BindTexture(CStateCache::TextureUnits - 1, m_Texture);
+
+	for (size_t i = 0; i < texture->m_Levels.size(); ++i)
+	{
+		const STexture::SLevel& level = texture->m_Levels[i];
+		const uint8_t* data = texture->Data() + level.m_Offset;
+
+		if (IsCompressed(texture->m_Format))
+		{
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glCompressedTexImage2D(GL_TEXTURE_2D, i, format.m_InternalFormat, level.m_Width, level.m_Height, 0, level.m_Size, data);
+			m_Size += level.m_Size;
+		}
+		else if (SetUnpackPitch(level.m_Width, FormatSize(texture->m_Format), level.m_Pitch))
+		{
+			glTexImage2D(GL_TEXTURE_2D, i, format.m_InternalFormat, level.m_Width, level.m_Height, 0, format.m_Format, GL_UNSIGNED_BYTE, data);
+			m_Size += LevelSize(texture->m_Format, level.m_Width, level.m_Height);
+		}
+		else
+		{
+			printf("Texture has an unsupported pitch: %s (%zu bytes)\n", texture->m_Name.c_str(), level.m_Pitch);
+		}
+	}
+
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+	size_t levels = texture->m_Levels.size();
+
+	// The chain below the first level is built straight into GPU memory, the CPU never holds it
+	if (texture->m_GenerateMips && levels == 1 && !IsCompressed(texture->m_Format))
+	{
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+		for (size_t width = texture->m_Levels[0].m_Width, height = texture->m_Levels[0].m_Height; width > 1 || height > 1; ++levels)
+		{
+			width = std::max<size_t>(width / 2, 1);
+			height = std::max<size_t>(height / 2, 1);
+			m_Size += LevelSize(texture->m_Format, width, height);
+		}
+	}
+
+	// Texels stay crisp up close, the mips only kick in when minifying
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_NEAREST_MIPMAP_LINEAR : GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	if (m_Source->m_ReleaseAfterUpload)
+	{
+		m_Source->ReleasePixels();
+
+		// The cache holds this resource for as long as the texture lives, holding the texture here would keep both forever
+		m_Source = nullptr;
+	}
+}
+
+void CTextureResource::DestroyTexture()
+{
+	if (m_Texture != 0)
+	{
+		CStateCache::Instance().DeleteTextures(1, &m_Texture);
+		m_Texture = 0;
+	}
+
+	m_Size = 0;
+}
+}  // namespace NRender
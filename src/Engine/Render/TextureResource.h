@@ -0,0 +1,40 @@
+#pragma once
+
+#include <SDL_opengl.h>
+
+#include <memory>
+
+namespace NRender
+{
+struct STexture;
+using HTexture = std::shared_ptr<STexture>;
+
+// GPU copy of a texture, shared through the resource cache by every material using it
+class CTextureResource
+{
+public:
+	CTextureResource(HTexture texture);
+	~CTextureResource();
+
+	// Textures whose pixels were released after the first upload keep their GL copy
+	void Reload();
+
+	GLuint Handle() const { return m_Texture; }
+
+	// Whether the pixels were dropped after the upload, the resource cache keeps it for the texture from then on
+	bool Released() const { return m_Source == nullptr; }
+
+	// Bytes in GPU memory for all levels, after any fallback decompression or GPU generated mips
+	size_t Size() const;
+
+private:
+	void CreateTexture();
+	void DestroyTexture();
+
+	HTexture m_Source;
+	GLuint m_Texture = 0;
+	size_t m_Size = 0;
+};
+
+using HTextureResource = std::shared_ptr<CTextureResource>;
+}  // namespace NRender
@@ -0,0 +1,34 @@
+#include "UniformBuffer.h"
+
+#include "StateCache.h"
+
+#include <stdio.h>
+
+namespace NRender
+{
+CUniformBuffer::CUniformBuffer(GLuint binding, size_t size)
+	: m_Size(size)
+{
+	glGenBuffers(1, &m_Buffer);
+	CStateCache::Instance().BindBuffer(GL_UNIFORM_BUFFER, m_Buffer);
+	glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, binding, m_Buffer);
+}
+
+CUniformBuffer::~CUniformBuffer()
+{
+	CStateCache::Instance().DeleteBuffers(1, &m_Buffer);
+}
+
+void CUniformBuffer::Update(const void* data, size_t size)
+{
+	if (size > m_Size)
+	{
+		printf("Uniform buffer overflow: %zu > %zu\n", size, m_Size);
+		return;
+	}
+
+	CStateCache::Instance().BindBuffer(GL_UNIFORM_BUFFER, m_Buffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+}
+}  // namespace NRender
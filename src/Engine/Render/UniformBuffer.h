@@ -0,0 +1,22 @@
+#pragma once
+
+#include <SDL_opengl.h>
+
+#include <stddef.h>
+
+namespace NRender
+{
+// Uniform buffer permanently attached to a block binding point, contents are replaced whole
+class CUniformBuffer
+{
+public:
+	CUniformBuffer(GLuint binding, size_t size);
+	~CUniformBuffer();
+
+	void Update(const void* data, size_t size);
+
+private:
+	GLuint m_Buffer = 0;
+	size_t m_Size = 0;
+};
+}  // namespace NRender
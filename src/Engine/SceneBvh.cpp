@@ -0,0 +1,741 @@
+#include "SceneBvh.h"
+
+#include "Frustum.h"
+
+#include <Utils/TaskPool.h>
+
+#include <math.h>
+
+#include <algorithm>
+#include <functional>
+
+namespace
+{
+// Refitting may grow the tree's relative area by this much before it's rebuilt
+constexpr float REBUILD_GROWTH = 1.5f;
+
+constexpr size_t RAY_CHUNK = 256;
+
+// Volume queries gather many more proxies than a ray finds, so far fewer of them make a task
+constexpr size_t QUERY_CHUNK = 4;
+
+// Deep enough for any tree the build makes, it stops splitting at MAX_DEPTH
+constexpr size_t STACK_SIZE = 64;
+
+float BoxArea(const float* min, const float* max)
+{
+	const float x = max[0] - min[0], y = max[1] - min[1], z = max[2] - min[2];
+	return 2.0f * (x * y + y * z + z * x);
+}
+
+// Returns false once the box is behind a plane, and clears the planes it's entirely in front of
+bool TestPlanes(const CVector4f (&planes)[CFrustum::Count], const float* min, const float* max, uint32_t& mask)
+{
+	const float center[3] = { (min[0] + max[0]) * 0.5f, (min[1] + max[1]) * 0.5f, (min[2] + max[2]) * 0.5f };
+	const float extent[3] = { (max[0] - min[0]) * 0.5f, (max[1] - min[1]) * 0.5f, (max[2] - min[2]) * 0.5f };
+
+	for (uint32_t plane = 0; plane < CFrustum::Count; ++plane)
+	{
+		if (!(mask & (1u << plane)))
+		{
+			continue;
+		}
+
+		const CVector4f& p = planes[plane];
+		const float distance = p.x() * center[0] + p.y() * center[1] + p.z() * center[2] + p.w();
+		const float radius = fabsf(p.x()) * extent[0] + fabsf(p.y()) * extent[1] + fabsf(p.z()) * extent[2];
+
+		if (distance < -radius)
+		{
+			return false;
+		}
+
+		if (distance >= radius)
+		{
+			mask &= ~(1u << plane);
+		}
+	}
+
+	return true;
+}
+
+float SquaredDistance(const CVector3f& point, const float* min, const float* max)
+{
+	float distance = 0.0f;
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		const float outside = std::max(std::max(min[axis] - point[axis], point[axis] - max[axis]), 0.0f);
+		distance += outside * outside;
+	}
+
+	return distance;
+}
+
+bool Overlaps(const CVector3f& a_min, const CVector3f& a_max, const float* min, const float* max)
+{
+	return a_min.x() <= max[0] && a_max.x() >= min[0] && a_min.y() <= max[1] && a_max.y() >= min[1] && a_min.z() <= max[2] && a_max.z() >= min[2];
+}
+
+// Where the ray enters the box, INFINITY if it misses it or only gets there past limit
+float Slab(const CVector3f& origin, const CVector3f& inverse, const float* min, const float* max, float limit)
+{
+	float enter = 0.0f;
+	float leave = limit;
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		const float t0 = (min[axis] - origin[axis]) * inverse[axis];
+		const float t1 = (max[axis] - origin[axis]) * inverse[axis];
+		enter = std::max(enter, std::min(t0, t1));
+		leave = std::min(leave, std::max(t0, t1));
+	}
+
+	return enter <= leave ? enter : INFINITY;
+}
+// Each chunk gathers into its own list, which are joined in query order once every chunk is done
+void QueryBatch(size_t count, std::vector<uint32_t>& proxies, std::vector<size_t>& offsets, const std::function<size_t(size_t index, std::vector<uint32_t>& found)>& query)
+{
+	const size_t chunks = (count + QUERY_CHUNK - 1) / QUERY_CHUNK;
+	std::vector<std::vector<uint32_t>> found(chunks);
+	offsets.assign(count + 1, 0);
+
+	NUtils::CTaskPool::Instance().ParallelFor(chunks, [&](size_t chunk) {
+		const size_t last = std::min((chunk + 1) * QUERY_CHUNK, count);
+
+		for (size_t i = chunk * QUERY_CHUNK; i < last; ++i)
+		{
+			offsets[i + 1] = query(i, found[chunk]);
+		}
+	});
+
+	offsets[0] = proxies.size();
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		offsets[i + 1] += offsets[i];
+	}
+
+	proxies.reserve(offsets[count]);
+
+	for (const std::vector<uint32_t>& chunk : found)
+	{
+		proxies.insert(proxies.end(), chunk.begin(), chunk.end());
+	}
+}
+}  // namespace
+
+uint32_t CSceneBvh::Add(const CVector3f& min, const CVector3f& max)
+{
+	uint32_t proxy;
+
+	if (!m_Free.empty())
+	{
+		proxy = m_Free.back();
+		m_Free.pop_back();
+	}
+	else
+	{
+		proxy = uint32_t(m_Boxes.size());
+		m_Boxes.emplace_back();
+		m_Slots.push_back(Invalid);
+		m_Alive.push_back(0);
+	}
+
+	m_Boxes[proxy] = { min, max };
+	m_Slots[proxy] = Invalid;
+	m_Alive[proxy] = 1;
+	m_Restructure = true;
+
+	return proxy;
+}
+
+void CSceneBvh::Remove(uint32_t proxy)
+{
+	// Freeing a proxy twice would hand it out to two owners later
+	if (!m_Alive[proxy])
+	{
+		return;
+	}
+
+	m_Alive[proxy] = 0;
+	m_Free.push_back(proxy);
+	m_Restructure = true;
+}
+
+void CSceneBvh::Update(uint32_t proxy, const CVector3f& min, const CVector3f& max)
+{
+	m_Boxes[proxy] = { min, max };
+
+	// Proxies added since the last build get their box with the coming rebuild
+	const uint32_t slot = m_Slots[proxy];
+
+	if (slot != Invalid)
+	{
+		m_ItemBoxes[slot] = m_Boxes[proxy];
+		MarkDirty(m_ItemLeaves[slot]);
+		m_Changed = true;
+	}
+}
+
+void CSceneBvh::Clear()
+{
+	*this = CSceneBvh();
+}
+
+bool CSceneBvh::Commit()
+{
+	if (m_Restructure || m_Refits >= REBUILD_INTERVAL)
+	{
+		Rebuild();
+		return true;
+	}
+
+	if (!m_Changed)
+	{
+		return false;
+	}
+
+	Refit();
+	++m_Refits;
+
+	if (Cost() > m_BuildCost * REBUILD_GROWTH)
+	{
+		Rebuild();
+		return true;
+	}
+
+	return false;
+}
+
+void CSceneBvh::Rebuild()
+{
+	// Boxes are copied out with their proxy, so the build partitions one contiguous array
+	struct SItem
+	{
+		SBox m_Box;
+		uint32_t m_Proxy;
+	};
+
+	std::vector<SItem> items;
+	items.reserve(m_Boxes.size());
+	SBox root = { CVector3f::Constant(INFINITY), CVector3f::Constant(-INFINITY) };
+
+	for (uint32_t proxy = 0; proxy < m_Boxes.size(); ++proxy)
+	{
+		if (m_Alive[proxy])
+		{
+			items.push_back({ m_Boxes[proxy], proxy });
+			root.m_Min = root.m_Min.cwiseMin(m_Boxes[proxy].m_Min);
+			root.m_Max = root.m_Max.cwiseMax(m_Boxes[proxy].m_Max);
+		}
+	}
+
+	struct STask
+	{
+		uint32_t m_Node;
+		uint32_t m_First;
+		uint32_t m_Count;
+		uint32_t m_Depth;
+		SBox m_Bounds;
+	};
+
+	struct SBin
+	{
+		SBox m_Box = { CVector3f::Constant(INFINITY), CVector3f::Constant(-INFINITY) };
+		uint32_t m_Count = 0;
+
+		void Grow(const SBox& box)
+		{
+			m_Box.m_Min = m_Box.m_Min.cwiseMin(box.m_Min);
+			m_Box.m_Max = m_Box.m_Max.cwiseMax(box.m_Max);
+		}
+
+		float Area() const { return m_Count ? BoxArea(m_Box.m_Min.data(), m_Box.m_Max.data()) : 0.0f; }
+	};
+
+	std::vector<STask> tasks;
+	m_Nodes.clear();
+	m_Parents.clear();
+
+	if (!items.empty())
+	{
+		m_Nodes.reserve(items.size() * 2);
+		m_Parents.reserve(items.size() * 2);
+		m_Nodes.emplace_back();
+		m_Parents.push_back(Invalid);
+		tasks.push_back({ 0, 0, uint32_t(items.size()), 0, root });
+	}
+
+	while (!tasks.empty())
+	{
+		const STask task = tasks.back();
+		tasks.pop_back();
+
+		SNode& node = m_Nodes[task.m_Node];
+		std::copy(task.m_Bounds.m_Min.data(), task.m_Bounds.m_Min.data() + 3, node.m_Min);
+		std::copy(task.m_Bounds.m_Max.data(), task.m_Bounds.m_Max.data() + 3, node.m_Max);
+		node.m_First = task.m_First;
+		node.m_Count = task.m_Count;
+
+		if (task.m_Count <= LEAF_SIZE || task.m_Depth >= MAX_DEPTH)
+		{
+			continue;
+		}
+
+		SItem* first = items.data() + task.m_First;
+		SItem* last = first + task.m_Count;
+
+		// Boxes are binned by their centers, doubled to save the halving, along the axis they spread the most
+		CVector3f center_min = CVector3f::Constant(INFINITY), center_max = CVector3f::Constant(-INFINITY);
+
+		for (const SItem* item = first; item < last; ++item)
+		{
+			const CVector3f center = item->m_Box.m_Min + item->m_Box.m_Max;
+			center_min = center_min.cwiseMin(center);
+			center_max = center_max.cwiseMax(center);
+		}
+
+		int axis = 0;
+		const float extent = (center_max - center_min).maxCoeff(&axis);
+		const float scale = extent > 0.0f ? float(BINS) * 0.9999f / extent : 0.0f;
+
+		auto Bin = [&](const SBox& box) {
+			return std::min(size_t((box.m_Min[axis] + box.m_Max[axis] - center_min[axis]) * scale), BINS - 1);
+		};
+
+		SBin bins[BINS];
+
+		for (const SItem* item = first; item < last; ++item)
+		{
+			SBin& bin = bins[Bin(item->m_Box)];
+			bin.Grow(item->m_Box);
+			++bin.m_Count;
+		}
+
+		// Splitting after bin s costs the area of each side times the boxes on it, the winning sides'
+		// bounds become the children's
+		SBin above[BINS];
+
+		for (size_t s = BINS - 1; s > 0; --s)
+		{
+			above[s - 1] = s < BINS - 1 ? above[s] : SBin();
+			above[s - 1].Grow(bins[s].m_Box);
+			above[s - 1].m_Count += bins[s].m_Count;
+		}
+
+		float best_cost = INFINITY;
+		size_t best_split = BINS;
+		SBox best_bounds[2];
+		SBin below;
+
+		for (size_t s = 0; s + 1 < BINS; ++s)
+		{
+			below.Grow(bins[s].m_Box);
+			below.m_Count += bins[s].m_Count;
+
+			if (below.m_Count == 0 || above[s].m_Count == 0)
+			{
+				continue;
+			}
+
+			const float cost = below.Area() * below.m_Count + above[s].Area() * above[s].m_Count;
+
+			if (cost < best_cost)
+			{
+				best_cost = cost;
+				best_split = s;
+				best_bounds[0] = below.m_Box;
+				best_bounds[1] = above[s].m_Box;
+			}
+		}
+
+		uint32_t left_count;
+
+		if (best_split < BINS)
+		{
+			left_count = uint32_t(std::partition(first, last, [&](const SItem& item) { return Bin(item.m_Box) <= best_split; }) - first);
+		}
+		else
+		{
+			// Every center is the same, any split is as good as another
+			left_count = task.m_Count / 2;
+
+			for (int side = 0; side < 2; ++side)
+			{
+				SBin bounds;
+
+				for (const SItem* item = side ? first + left_count : first; item < (side ? last : first + left_count); ++item)
+				{
+					bounds.Grow(item->m_Box);
+				}
+
+				best_bounds[side] = bounds.m_Box;
+			}
+		}
+
+		const uint32_t left = uint32_t(m_Nodes.size());
+		node.m_First = left;
+		node.m_Count = 0;
+
+		m_Nodes.emplace_back();
+		m_Nodes.emplace_back();
+		m_Parents.push_back(task.m_Node);
+		m_Parents.push_back(task.m_Node);
+
+		tasks.push_back({ left, task.m_First, left_count, task.m_Depth + 1, best_bounds[0] });
+		tasks.push_back({ left + 1, task.m_First + left_count, task.m_Count - left_count, task.m_Depth + 1, best_bounds[1] });
+	}
+
+	m_Items.resize(items.size());
+	m_ItemBoxes.resize(items.size());
+	m_ItemLeaves.resize(items.size());
+	m_Slots.assign(m_Boxes.size(), Invalid);
+	m_Dirty.assign(m_Nodes.size(), 0);
+	m_Area = 0.0;
+
+	for (uint32_t i = 0; i < m_Nodes.size(); ++i)
+	{
+		const SNode& node = m_Nodes[i];
+		m_Area += Area(node);
+
+		for (uint32_t k = node.m_First; k < node.m_First + node.m_Count; ++k)
+		{
+			m_Items[k] = items[k].m_Proxy;
+			m_ItemBoxes[k] = items[k].m_Box;
+			m_ItemLeaves[k] = i;
+			m_Slots[m_Items[k]] = k;
+		}
+	}
+
+	m_BuildCost = Cost();
+	m_Changed = false;
+	m_Restructure = false;
+	m_Refits = 0;
+	++m_Rebuilds;
+}
+
+size_t CSceneBvh::QueryFrustum(const CFrustum& frustum, std::vector<uint32_t>& proxies) const
+{
+	const size_t first = proxies.size();
+
+	if (m_Nodes.empty())
+	{
+		return 0;
+	}
+
+	CVector4f planes[CFrustum::Count];
+
+	for (int plane = 0; plane < CFrustum::Count; ++plane)
+	{
+		planes[plane] = frustum.Plane(CFrustum::EPlane(plane));
+	}
+
+	struct SEntry
+	{
+		uint32_t m_Node;
+		uint32_t m_Mask;
+	};
+
+	SEntry stack[STACK_SIZE];
+	size_t size = 0;
+	stack[size++] = { 0, (1u << CFrustum::Count) - 1 };
+
+	while (size > 0)
+	{
+		const SEntry entry = stack[--size];
+		const SNode& node = m_Nodes[entry.m_Node];
+		uint32_t mask = entry.m_Mask;
+
+		if (mask && !TestPlanes(planes, node.m_Min, node.m_Max, mask))
+		{
+			continue;
+		}
+
+		if (node.m_Count == 0)
+		{
+			stack[size++] = { node.m_First, mask };
+			stack[size++] = { node.m_First + 1, mask };
+			continue;
+		}
+
+		for (uint32_t k = node.m_First; k < node.m_First + node.m_Count; ++k)
+		{
+			uint32_t item_mask = mask;
+
+			if (!mask || TestPlanes(planes, m_ItemBoxes[k].m_Min.data(), m_ItemBoxes[k].m_Max.data(), item_mask))
+			{
+				proxies.push_back(m_Items[k]);
+			}
+		}
+	}
+
+	return proxies.size() - first;
+}
+
+size_t CSceneBvh::QuerySphere(const CVector3f& center, float radius, std::vector<uint32_t>& proxies) const
+{
+	const size_t first = proxies.size();
+	const float radius_squared = radius * radius;
+	uint32_t stack[STACK_SIZE];
+	size_t size = 0;
+
+	if (!m_Nodes.empty())
+	{
+		stack[size++] = 0;
+	}
+
+	while (size > 0)
+	{
+		const SNode& node = m_Nodes[stack[--size]];
+
+		if (SquaredDistance(center, node.m_Min, node.m_Max) > radius_squared)
+		{
+			continue;
+		}
+
+		if (node.m_Count == 0)
+		{
+			stack[size++] = node.m_First;
+			stack[size++] = node.m_First + 1;
+			continue;
+		}
+
+		for (uint32_t k = node.m_First; k < node.m_First + node.m_Count; ++k)
+		{
+			if (SquaredDistance(center, m_ItemBoxes[k].m_Min.data(), m_ItemBoxes[k].m_Max.data()) <= radius_squared)
+			{
+				proxies.push_back(m_Items[k]);
+			}
+		}
+	}
+
+	return proxies.size() - first;
+}
+
+size_t CSceneBvh::QueryBox(const CVector3f& min, const CVector3f& max, std::vector<uint32_t>& proxies) const
+{
+	const size_t first = proxies.size();
+	uint32_t stack[STACK_SIZE];
+	size_t size = 0;
+
+	if (!m_Nodes.empty())
+	{
+		stack[size++] = 0;
+	}
+
+	while (size > 0)
+	{
+		const SNode& node = m_Nodes[stack[--size]];
+
+		if (!Overlaps(min, max, node.m_Min, node.m_Max))
+		{
+			continue;
+		}
+
+		if (node.m_Count == 0)
+		{
+			stack[size++] = node.m_First;
+			stack[size++] = node.m_First + 1;
+			continue;
+		}
+
+		for (uint32_t k = node.m_First; k < node.m_First + node.m_Count; ++k)
+		{
+			if (Overlaps(min, max, m_ItemBoxes[k].m_Min.data(), m_ItemBoxes[k].m_Max.data()))
+			{
+				proxies.push_back(m_Items[k]);
+			}
+		}
+	}
+
+	return proxies.size() - first;
+}
+
+CSceneBvh::SRayHit CSceneBvh::QueryRay(const CVector3f& origin, const CVector3f& direction, float max_distance) const
+{
+	SRayHit hit;
+	hit.m_Distance = max_distance;
+
+	if (m_Nodes.empty())
+	{
+		return hit;
+	}
+
+	const CVector3f inverse = direction.cwiseInverse();
+
+	struct SEntry
+	{
+		uint32_t m_Node;
+		float m_Distance;
+	};
+
+	// Nearer children are popped first, so anything entered beyond the best hit so far is skipped
+	SEntry stack[STACK_SIZE];
+	size_t size = 0;
+	const float root = Slab(origin, inverse, m_Nodes[0].m_Min, m_Nodes[0].m_Max, max_distance);
+
+	if (root != INFINITY)
+	{
+		stack[size++] = { 0, root };
+	}
+
+	while (size > 0)
+	{
+		const SEntry entry = stack[--size];
+
+		if (entry.m_Distance > hit.m_Distance)
+		{
+			continue;
+		}
+
+		const SNode& node = m_Nodes[entry.m_Node];
+
+		if (node.m_Count == 0)
+		{
+			const uint32_t near = node.m_First, far = node.m_First + 1;
+			float near_distance = Slab(origin, inverse, m_Nodes[near].m_Min, m_Nodes[near].m_Max, hit.m_Distance);
+			float far_distance = Slab(origin, inverse, m_Nodes[far].m_Min, m_Nodes[far].m_Max, hit.m_Distance);
+			const bool swap = far_distance < near_distance;
+
+			if (swap)
+			{
+				std::swap(near_distance, far_distance);
+			}
+
+			if (far_distance != INFINITY)
+			{
+				stack[size++] = { swap ? near : far, far_distance };
+			}
+
+			if (near_distance != INFINITY)
+			{
+				stack[size++] = { swap ? far : near, near_distance };
+			}
+
+			continue;
+		}
+
+		for (uint32_t k = node.m_First; k < node.m_First + node.m_Count; ++k)
+		{
+			const float distance = Slab(origin, inverse, m_ItemBoxes[k].m_Min.data(), m_ItemBoxes[k].m_Max.data(), hit.m_Distance);
+
+			if (distance < hit.m_Distance || (distance == hit.m_Distance && hit.m_Proxy == Invalid))
+			{
+				hit.m_Proxy = m_Items[k];
+				hit.m_Distance = distance;
+			}
+		}
+	}
+
+	if (hit.m_Proxy == Invalid)
+	{
+		hit.m_Distance = max_distance;
+	}
+
+	return hit;
+}
+
+void CSceneBvh::QueryFrustums(const CFrustum* frustums, size_t count, std::vector<uint32_t>& proxies, std::vector<size_t>& offsets) const
+{
+	QueryBatch(count, proxies, offsets, [&](size_t index, std::vector<uint32_t>& found) { return QueryFrustum(frustums[index], found); });
+}
+
+void CSceneBvh::QuerySpheres(const CVector3f* centers, const float* radii, size_t count, std::vector<uint32_t>& proxies, std::vector<size_t>& offsets) const
+{
+	QueryBatch(count, proxies, offsets, [&](size_t index, std::vector<uint32_t>& found) { return QuerySphere(centers[index], radii[index], found); });
+}
+
+void CSceneBvh::QueryBoxes(const CVector3f* mins, const CVector3f* maxs, size_t count, std::vector<uint32_t>& proxies, std::vector<size_t>& offsets) const
+{
+	QueryBatch(count, proxies, offsets, [&](size_t index, std::vector<uint32_t>& found) { return QueryBox(mins[index], maxs[index], found); });
+}
+
+void CSceneBvh::QueryRays(const CVector3f* origins, const CVector3f* directions, size_t count, float max_distance, SRayHit* hits) const
+{
+	NUtils::CTaskPool::Instance().ParallelFor((count + RAY_CHUNK - 1) / RAY_CHUNK, [&](size_t chunk) {
+		const size_t last = std::min((chunk + 1) * RAY_CHUNK, count);
+
+		for (size_t i = chunk * RAY_CHUNK; i < last; ++i)
+		{
+			hits[i] = QueryRay(origins[i], directions[i], max_distance);
+		}
+	});
+}
+
+void CSceneBvh::TransformBounds(const CTransform& transform, const CVector3f& min, const CVector3f& max, CVector3f& world_min, CVector3f& world_max)
+{
+	// Arvo: the extent along each world axis is the absolute linear part applied to the local extent
+	const CVector3f center = transform * ((min + max) * 0.5f);
+	const CVector3f extent = transform.linear().cwiseAbs() * ((max - min) * 0.5f);
+	world_min = center - extent;
+	world_max = center + extent;
+}
+
+float CSceneBvh::Cost() const
+{
+	if (m_Nodes.empty())
+	{
+		return 0.0f;
+	}
+
+	const float root = Area(m_Nodes[0]);
+	return root > 0.0f ? float(m_Area / root) : 1.0f;
+}
+
+float CSceneBvh::Area(const SNode& node)
+{
+	return BoxArea(node.m_Min, node.m_Max);
+}
+
+void CSceneBvh::MarkDirty(uint32_t node)
+{
+	// Stops at the first marked ancestor, everything above it is marked already
+	while (node != Invalid && !m_Dirty[node])
+	{
+		m_Dirty[node] = 1;
+		node = m_Parents[node];
+	}
+}
+
+void CSceneBvh::Refit()
+{
+	// Children always come after their parent, so walking backwards refits them first
+	for (size_t i = m_Nodes.size(); i-- > 0;)
+	{
+		if (!m_Dirty[i])
+		{
+			continue;
+		}
+
+		SNode& node = m_Nodes[i];
+		CVector3f min, max;
+
+		if (node.m_Count == 0)
+		{
+			const SNode& left = m_Nodes[node.m_First];
+			const SNode& right = m_Nodes[node.m_First + 1];
+			min = CVector3f(left.m_Min).cwiseMin(CVector3f(right.m_Min));
+			max = CVector3f(left.m_Max).cwiseMax(CVector3f(right.m_Max));
+		}
+		else
+		{
+			min = m_ItemBoxes[node.m_First].m_Min;
+			max = m_ItemBoxes[node.m_First].m_Max;
+
+			for (uint32_t k = node.m_First + 1; k < node.m_First + node.m_Count; ++k)
+			{
+				min = min.cwiseMin(m_ItemBoxes[k].m_Min);
+				max = max.cwiseMax(m_ItemBoxes[k].m_Max);
+			}
+		}
+
+		m_Area -= Area(node);
+		std::copy(min.data(), min.data() + 3, node.m_Min);
+		std::copy(max.data(), max.data() + 3, node.m_Max);
+		m_Area += Area(node);
+		m_Dirty[i] = 0;
+	}
+
+	m_Changed = false;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "Math.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+class CFrustum;
+
+/**
+ * Bounding volume hierarchy over world space boxes, one per proxy, for culling
+ * and spatial queries over many instances. Trees are built top down, splitting
+ * at the cheapest of 16 bins along the axis the box centers spread the most by
+ * the surface area heuristic, into 32 byte nodes with up to four proxies per
+ * leaf. Children are stored next to each other and always after their parent.
+ *
+ * Moving proxies only marks their leaf and its ancestors, Commit then refits
+ * the marked nodes bottom up in one backwards pass. Refitting keeps the tree
+ * valid but lets it decay, so Commit rebuilds once the summed node area grew by
+ * half relative to the root, after REBUILD_INTERVAL refits regardless, and
+ * whenever proxies were added or removed.
+ *
+ * Queries append every proxy whose own box passes, not just its leaf. Frustum
+ * queries drop planes a node is entirely inside of, so the subtrees of nodes
+ * fully in view are gathered without any further tests.
+ **/
+class CSceneBvh
+{
+public:
+	static constexpr uint32_t Invalid = ~0u;
+
+	struct SRayHit
+	{
+		uint32_t m_Proxy = Invalid;
+		float m_Distance = 0.0f;
+	};
+
+	// Ids are reused after removal, a fresh tree hands them out counting up from zero
+	uint32_t Add(const CVector3f& min, const CVector3f& max);
+	void Remove(uint32_t proxy);
+	void Update(uint32_t proxy, const CVector3f& min, const CVector3f& max);
+	void Clear();
+
+	// Brings the tree up to date with every change since the last commit, returns true if it was rebuilt
+	bool Commit();
+	void Rebuild();
+
+	size_t QueryFrustum(const CFrustum& frustum, std::vector<uint32_t>& proxies) const;
+	size_t QuerySphere(const CVector3f& center, float radius, std::vector<uint32_t>& proxies) const;
+	size_t QueryBox(const CVector3f& min, const CVector3f& max, std::vector<uint32_t>& proxies) const;
+
+	// Queries are spread over the task pool in chunks, query i appends its proxies at [offsets[i], offsets[i + 1])
+	void QueryFrustums(const CFrustum* frustums, size_t count, std::vector<uint32_t>& proxies, std::vector<size_t>& offsets) const;
+	void QuerySpheres(const CVector3f* centers, const float* radii, size_t count, std::vector<uint32_t>& proxies, std::vector<size_t>& offsets) const;
+	void QueryBoxes(const CVector3f* mins, const CVector3f* maxs, size_t count, std::vector<uint32_t>& proxies, std::vector<size_t>& offsets) const;
+
+	// Nearest box along the ray within max_distance, a proxy the ray starts in is hit at zero
+	SRayHit QueryRay(const CVector3f& origin, const CVector3f& direction, float max_distance) const;
+
+	// Rays are spread over the task pool in chunks
+	void QueryRays(const CVector3f* origins, const CVector3f* directions, size_t count, float max_distance, SRayHit* hits) const;
+
+	// Axis aligned box around a box in the space of transform
+	static void TransformBounds(const CTransform& transform, const CVector3f& min, const CVector3f& max, CVector3f& world_min, CVector3f& world_max);
+
+	size_t Proxies() const { return m_Boxes.size() - m_Free.size(); }
+	size_t Nodes() const { return m_Nodes.size(); }
+	size_t Rebuilds() const { return m_Rebuilds; }
+
+	// Summed surface area of all nodes relative to the root, how many boxes a query expects to touch
+	float Cost() const;
+
+private:
+	static constexpr size_t LEAF_SIZE = 4;
+	static constexpr size_t BINS = 16;
+	static constexpr size_t MAX_DEPTH = 48;
+	static constexpr size_t REBUILD_INTERVAL = 256;
+
+	struct SBox
+	{
+		CVector3f m_Min;
+		CVector3f m_Max;
+	};
+
+	// Inner nodes have no count and their children at first and first + 1, leaves own count items from first
+	struct SNode
+	{
+		float m_Min[3];
+		uint32_t m_First;
+		float m_Max[3];
+		uint32_t m_Count;
+	};
+
+	static float Area(const SNode& node);
+	void MarkDirty(uint32_t node);
+	void Refit();
+
+	std::vector<SNode> m_Nodes;
+	std::vector<uint32_t> m_Parents;
+	std::vector<uint8_t> m_Dirty;
+
+	// Proxies in leaf order with a copy of their boxes, so leaves test a contiguous run
+	std::vector<uint32_t> m_Items;
+	std::vector<SBox> m_ItemBoxes;
+	std::vector<uint32_t> m_ItemLeaves;
+
+	// Per proxy: its box and where it sits in the items, Invalid until the next build
+	std::vector<SBox> m_Boxes;
+	std::vector<uint32_t> m_Slots;
+	std::vector<uint8_t> m_Alive;
+	std::vector<uint32_t> m_Free;
+
+	bool m_Changed = false;
+	bool m_Restructure = false;
+	double m_Area = 0.0;
+	float m_BuildCost = 0.0f;
+	size_t m_Refits = 0;
+	size_t m_Rebuilds = 0;
+};
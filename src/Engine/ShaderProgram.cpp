@@ -1,5 +1,7 @@
 #include "ShaderProgram.h"
 
+#include "Render/StateCache.h"
+
 #include <string>
 #include <vector>
 #include <cstdio>
@@ -94,8 +96,12 @@ CShaderProgram::CShaderProgram(const char* filename)
 
 	glAttachShader(m_Program, m_VertexShader);
 	glAttachShader(m_Program, m_FragmentShader);
-	glBindAttribLocation(m_Program, 0, "Position");
-	glBindAttribLocation(m_Program, 1, "Normal");
+	glBindAttribLocation(m_Program, Position, "Position");
+	glBindAttribLocation(m_Program, Normal, "Normal");
+	glBindAttribLocation(m_Program, Tangent, "Tangent");
+	glBindAttribLocation(m_Program, Color, "Color");
+	glBindAttribLocation(m_Program, UV, "UV");
+	glBindAttribLocation(m_Program, InstanceMatrix, "InstanceMatrix");
 	glLinkProgram(m_Program);
 
 	GLint linked;
@@ -108,21 +114,90 @@ CShaderProgram::CShaderProgram(const char* filename)
 
 		std::vector<GLchar> error(error_length);
 		glGetProgramInfoLog(m_Program, error_length, &error_length, &error[0]);
-		glDeleteProgram(m_Program);
+		NRender::CStateCache::Instance().DeleteProgram(m_Program);
 		printf("Failed to link shader (%s):\n%s\n", filename, &error[0]);
+		m_Program = 0;
 		return;
 	}
 
-	glUseProgram(m_Program);
-	glUniform1i(glGetUniformLocation(m_Program, "Albedo"), 0);
-	glUniform1i(glGetUniformLocation(m_Program, "Detail"), 1);
+	const GLuint camera_block = glGetUniformBlockIndex(m_Program, "Camera");
+	if (camera_block != GL_INVALID_INDEX)
+	{
+		glUniformBlockBinding(m_Program, camera_block, CameraBlock);
+	}
+
+	Reflect();
+
+	Use();
+	SetUniform(Uniform<int>("Albedo"), 0);
+	SetUniform(Uniform<int>("Detail"), 1);
+}
+
+void CShaderProgram::Use() const
+{
+	NRender::CStateCache::Instance().UseProgram(m_Program);
+}
+
+void CShaderProgram::Reflect()
+{
+	GLint count = 0;
+	GLint max_length = 0;
+	std::vector<GLchar> name;
+
+	// Uniforms inside blocks report a location of -1, they are set through their buffer
+	glGetProgramiv(m_Program, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(m_Program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+	name.resize(max_length + 1);
+
+	m_Uniforms.clear();
+	for (GLint i = 0; i < count; ++i)
+	{
+		SVariable uniform;
+		glGetActiveUniform(m_Program, i, name.size(), nullptr, &uniform.m_Size, &uniform.m_Type, name.data());
+		uniform.m_Name = name.data();
+		uniform.m_Location = glGetUniformLocation(m_Program, name.data());
+		m_Uniforms.push_back(uniform);
+	}
+
+	glGetProgramiv(m_Program, GL_ACTIVE_ATTRIBUTES, &count);
+	glGetProgramiv(m_Program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &max_length);
+	name.resize(max_length + 1);
+
+	m_Attributes.clear();
+	for (GLint i = 0; i < count; ++i)
+	{
+		SVariable attribute;
+		glGetActiveAttrib(m_Program, i, name.size(), nullptr, &attribute.m_Size, &attribute.m_Type, name.data());
+		attribute.m_Name = name.data();
+		attribute.m_Location = glGetAttribLocation(m_Program, name.data());
+		m_Attributes.push_back(attribute);
+	}
+}
+
+GLint CShaderProgram::Location(const char* name, bool (*matches)(GLenum type)) const
+{
+	for (const SVariable& uniform : m_Uniforms)
+	{
+		if (uniform.m_Name == name)
+		{
+			if (!matches(uniform.m_Type))
+			{
+				printf("Uniform type mismatch: %s (0x%04x)\n", name, uniform.m_Type);
+				return -1;
+			}
+
+			return uniform.m_Location;
+		}
+	}
+
+	return -1;
 }
 
 CShaderProgram::~CShaderProgram()
 {
 	if (m_Program)
 	{
-		glDeleteProgram(m_Program);
+		NRender::CStateCache::Instance().DeleteProgram(m_Program);
 	}
 
 	if (m_VertexShader)
@@ -1,15 +1,113 @@
 #pragma once
 
+#include "Math.h"
+
 #include <SDL_opengl.h>
 
+#include <string>
+#include <vector>
+
+// Location of a uniform checked against its declared type, invalid handles are ignored when set
+template<typename T>
+struct TUniform
+{
+	GLint m_Location = -1;
+
+	explicit operator bool() const { return m_Location >= 0; }
+};
+
+template<typename T>
+struct TUniformType;
+
+template<>
+struct TUniformType<int>
+{
+	static bool Matches(GLenum type) { return type == GL_INT || type == GL_SAMPLER_2D; }
+};
+
+template<>
+struct TUniformType<bool>
+{
+	static bool Matches(GLenum type) { return type == GL_BOOL; }
+};
+
+template<>
+struct TUniformType<float>
+{
+	static bool Matches(GLenum type) { return type == GL_FLOAT; }
+};
+
+template<>
+struct TUniformType<CVector3f>
+{
+	static bool Matches(GLenum type) { return type == GL_FLOAT_VEC3; }
+};
+
+template<>
+struct TUniformType<CMatrix4f>
+{
+	static bool Matches(GLenum type) { return type == GL_FLOAT_MAT4; }
+};
+
+inline void SetUniform(TUniform<int> uniform, int value) { glUniform1i(uniform.m_Location, value); }
+inline void SetUniform(TUniform<bool> uniform, bool value) { glUniform1i(uniform.m_Location, value); }
+inline void SetUniform(TUniform<float> uniform, float value) { glUniform1f(uniform.m_Location, value); }
+inline void SetUniform(TUniform<CVector3f> uniform, const CVector3f& value) { glUniform3fv(uniform.m_Location, 1, value.data()); }
+inline void SetUniform(TUniform<CMatrix4f> uniform, const CMatrix4f& value) { glUniformMatrix4fv(uniform.m_Location, 1, GL_FALSE, value.data()); }
+
 class CShaderProgram
 {
 public:
+	// Attribute locations are fixed so vertex arrays work with any program
+	enum EAttribute : GLuint
+	{
+		Position,
+		Normal,
+		Tangent,
+		Color,
+		UV,
+		InstanceMatrix	// Takes four locations, one per column
+	};
+
+	// Uniform block binding points, shared by every program
+	enum EUniformBlock : GLuint
+	{
+		CameraBlock
+	};
+
+	// Active uniform or attribute as reflected after linking
+	struct SVariable
+	{
+		std::string m_Name;
+		GLenum m_Type;
+		GLint m_Size;
+		GLint m_Location;
+	};
+
 	CShaderProgram(const char* source);
 	~CShaderProgram();
 
+	void Use() const;
+	GLuint Handle() const { return m_Program; }
+
+	// Look ups are by name, so handles are meant to be fetched once and kept
+	template<typename T>
+	TUniform<T> Uniform(const char* name) const
+	{
+		return { Location(name, &TUniformType<T>::Matches) };
+	}
+
+	const std::vector<SVariable>& Uniforms() const { return m_Uniforms; }
+	const std::vector<SVariable>& Attributes() const { return m_Attributes; }
+
 private:
+	void Reflect();
+	GLint Location(const char* name, bool (*matches)(GLenum type)) const;
+
 	GLuint m_VertexShader = 0;
 	GLuint m_FragmentShader = 0;
 	GLuint m_Program = 0;
+
+	std::vector<SVariable> m_Uniforms;
+	std::vector<SVariable> m_Attributes;
 };
@@ -0,0 +1,183 @@
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+
+uint32_t CTransformHierarchy::Add(uint32_t parent)
+{
+	const uint32_t node = uint32_t(m_Parent.size());
+
+	m_Parent.push_back(parent < node ? parent : NoParent);
+	m_PositionX.push_back(0.0f);
+	m_PositionY.push_back(0.0f);
+	m_PositionZ.push_back(0.0f);
+	m_RotationX.push_back(0.0f);
+	m_RotationY.push_back(0.0f);
+	m_RotationZ.push_back(0.0f);
+	m_RotationW.push_back(1.0f);
+	m_ScaleX.push_back(1.0f);
+	m_ScaleY.push_back(1.0f);
+	m_ScaleZ.push_back(1.0f);
+
+	m_World.push_back(CTransform::Identity());
+	m_UpdatedIn.push_back(m_Updates);
+	m_Dirty.push_back(0);
+	MarkDirty(node);
+
+	return node;
+}
+
+void CTransformHierarchy::Clear()
+{
+	*this = CTransformHierarchy();
+}
+
+void CTransformHierarchy::SetPosition(uint32_t node, const CVector3f& position)
+{
+	m_PositionX[node] = position.x();
+	m_PositionY[node] = position.y();
+	m_PositionZ[node] = position.z();
+	MarkDirty(node);
+}
+
+void CTransformHierarchy::SetRotation(uint32_t node, const CQuaternion& rotation)
+{
+	m_RotationX[node] = rotation.x();
+	m_RotationY[node] = rotation.y();
+	m_RotationZ[node] = rotation.z();
+	m_RotationW[node] = rotation.w();
+	MarkDirty(node);
+}
+
+void CTransformHierarchy::SetScale(uint32_t node, const CVector3f& scale)
+{
+	m_ScaleX[node] = scale.x();
+	m_ScaleY[node] = scale.y();
+	m_ScaleZ[node] = scale.z();
+	MarkDirty(node);
+}
+
+void CTransformHierarchy::Rotate(uint32_t node, const CQuaternion& rotation)
+{
+	// Renormalized every time, so rotating a little each frame never drifts
+	SetRotation(node, (Rotation(node) * rotation).normalized());
+}
+
+void CTransformHierarchy::Scale(uint32_t node, float scale)
+{
+	SetScale(node, Scale(node) * scale);
+}
+
+CVector3f CTransformHierarchy::Position(uint32_t node) const
+{
+	return CVector3f(m_PositionX[node], m_PositionY[node], m_PositionZ[node]);
+}
+
+CQuaternion CTransformHierarchy::Rotation(uint32_t node) const
+{
+	return CQuaternion(m_RotationW[node], m_RotationX[node], m_RotationY[node], m_RotationZ[node]);
+}
+
+CVector3f CTransformHierarchy::Scale(uint32_t node) const
+{
+	return CVector3f(m_ScaleX[node], m_ScaleY[node], m_ScaleZ[node]);
+}
+
+size_t CTransformHierarchy::Update()
+{
+	const size_t count = m_Parent.size();
+	size_t updated = 0;
+	++m_Updates;
+
+	for (size_t first = m_FirstDirty / COMPOSE_BLOCK * COMPOSE_BLOCK; first < count; first += COMPOSE_BLOCK)
+	{
+		const size_t last = std::min(first + COMPOSE_BLOCK, count);
+		bool any_dirty = false;
+
+		// Parents come first, so their flag is final by the time their children are reached
+		for (size_t i = std::max(first, m_FirstDirty); i < last; ++i)
+		{
+			const uint32_t parent = m_Parent[i];
+			m_Dirty[i] |= parent != NoParent && m_Dirty[parent];
+			any_dirty |= m_Dirty[i];
+		}
+
+		if (!any_dirty)
+		{
+			continue;
+		}
+
+		float local[12][COMPOSE_BLOCK];
+		ComposeLocal(first, last, local);
+
+		for (size_t i = first; i < last; ++i)
+		{
+			if (!m_Dirty[i])
+			{
+				continue;
+			}
+
+			const size_t k = i - first;
+			Eigen::Matrix4f matrix;
+			matrix << local[0][k], local[1][k], local[2][k], local[3][k],
+				local[4][k], local[5][k], local[6][k], local[7][k],
+				local[8][k], local[9][k], local[10][k], local[11][k],
+				0.0f, 0.0f, 0.0f, 1.0f;
+
+			const uint32_t parent = m_Parent[i];
+			m_World[i].matrix() = parent != NoParent ? Eigen::Matrix4f(m_World[parent].matrix() * matrix) : matrix;
+			m_UpdatedIn[i] = m_Updates;
+			++updated;
+		}
+	}
+
+	if (m_FirstDirty < count)
+	{
+		std::fill(m_Dirty.begin() + m_FirstDirty, m_Dirty.end(), 0);
+		m_FirstDirty = count;
+	}
+
+	return updated;
+}
+
+void CTransformHierarchy::MarkDirty(uint32_t node)
+{
+	m_Dirty[node] = 1;
+	m_FirstDirty = std::min<size_t>(m_FirstDirty, node);
+}
+
+void CTransformHierarchy::ComposeLocal(size_t first, size_t last, float (&m)[12][COMPOSE_BLOCK]) const
+{
+	const float* px = m_PositionX.data();
+	const float* py = m_PositionY.data();
+	const float* pz = m_PositionZ.data();
+	const float* qx = m_RotationX.data();
+	const float* qy = m_RotationY.data();
+	const float* qz = m_RotationZ.data();
+	const float* qw = m_RotationW.data();
+	const float* sx = m_ScaleX.data();
+	const float* sy = m_ScaleY.data();
+	const float* sz = m_ScaleZ.data();
+
+	// The rotation matrix of a unit quaternion, its columns scaled by the scale
+	for (size_t i = first, k = 0; i < last; ++i, ++k)
+	{
+		const float xx = qx[i] * qx[i], yy = qy[i] * qy[i], zz = qz[i] * qz[i];
+		const float xy = qx[i] * qy[i], xz = qx[i] * qz[i], yz = qy[i] * qz[i];
+		const float wx = qw[i] * qx[i], wy = qw[i] * qy[i], wz = qw[i] * qz[i];
+
+		m[0][k] = (1.0f - 2.0f * (yy + zz)) * sx[i];
+		m[1][k] = 2.0f * (xy - wz) * sy[i];
+		m[2][k] = 2.0f * (xz + wy) * sz[i];
+		m[3][k] = px[i];
+
+		m[4][k] = 2.0f * (xy + wz) * sx[i];
+		m[5][k] = (1.0f - 2.0f * (xx + zz)) * sy[i];
+		m[6][k] = 2.0f * (yz - wx) * sz[i];
+		m[7][k] = py[i];
+
+		m[8][k] = 2.0f * (xz - wy) * sx[i];
+		m[9][k] = 2.0f * (yz + wx) * sy[i];
+		m[10][k] = (1.0f - 2.0f * (xx + yy)) * sz[i];
+		m[11][k] = pz[i];
+	}
+}
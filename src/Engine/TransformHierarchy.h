@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Math.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+/**
+ * Local translation, rotation and scale of every node, and the world matrices
+ * they combine into, stored as structure of arrays. Nodes are only ever added
+ * after their parent, so walking them in index order visits parents first and
+ * a single forward pass carries dirty flags down to every descendant.
+ *
+ * Update only recomputes nodes that changed and the subtrees below them. Local
+ * matrices are composed in blocks straight from the position, rotation and
+ * scale arrays, and then chained onto their parent's world matrix with a 4x4
+ * product. Local matrices are translation * rotation * scale, so Rotate and
+ * Scale both act in the node's own space.
+ **/
+class CTransformHierarchy
+{
+public:
+	static constexpr uint32_t NoParent = ~0u;
+
+	// The parent has to exist already, which keeps the nodes in topological order
+	uint32_t Add(uint32_t parent = NoParent);
+
+	// Drops every node, anything still holding an index must go as well
+	void Clear();
+
+	size_t Size() const { return m_Parent.size(); }
+	uint32_t Parent(uint32_t node) const { return m_Parent[node]; }
+
+	void SetPosition(uint32_t node, const CVector3f& position);
+	void SetRotation(uint32_t node, const CQuaternion& rotation);
+	void SetScale(uint32_t node, const CVector3f& scale);
+
+	// Composed onto the current rotation or scale
+	void Rotate(uint32_t node, const CQuaternion& rotation);
+	void Scale(uint32_t node, float scale);
+
+	CVector3f Position(uint32_t node) const;
+	CQuaternion Rotation(uint32_t node) const;
+	CVector3f Scale(uint32_t node) const;
+
+	// Recomputes the world matrices of changed nodes and their descendants, returns how many
+	size_t Update();
+
+	// Valid after Update, references stay valid until nodes are added
+	const CTransform& World(uint32_t node) const { return m_World[node]; }
+
+	// Whether the last Update recomputed the node's world matrix, so anything derived from it is stale
+	bool Updated(uint32_t node) const { return m_UpdatedIn[node] == m_Updates; }
+
+private:
+	// Local matrices are composed a block at a time, for blocks with any node to update
+	static constexpr size_t COMPOSE_BLOCK = 64;
+
+	void MarkDirty(uint32_t node);
+
+	// Rows of the local 3x4 matrices of the nodes in [first, last), one array per element
+	void ComposeLocal(size_t first, size_t last, float (&m)[12][COMPOSE_BLOCK]) const;
+
+	std::vector<uint32_t> m_Parent;
+	std::vector<float> m_PositionX, m_PositionY, m_PositionZ;
+	std::vector<float> m_RotationX, m_RotationY, m_RotationZ, m_RotationW;
+	std::vector<float> m_ScaleX, m_ScaleY, m_ScaleZ;
+
+	std::vector<CTransform> m_World;
+
+	// The Update each node's world matrix was last recomputed in
+	std::vector<uint32_t> m_UpdatedIn;
+	uint32_t m_Updates = 0;
+
+	// Set by changes and carried to children by Update, nothing before the first dirty node changed
+	std::vector<uint8_t> m_Dirty;
+	size_t m_FirstDirty = 0;
+};
@@ -1,5 +1,8 @@
 #include "Window.h"
 #include "ShaderProgram.h"
+#include "Camera.h"
+
+#include "Render/UniformBuffer.h"
 
 #include <SDL_video.h>
 #include <SDL_mouse.h>
@@ -48,6 +51,7 @@ bool CWindow::Initialize(const int initial_width, const int initial_height)
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	m_Shader = new CShaderProgram("assets/shaders/basic");
+	m_CameraUniforms = new NRender::CUniformBuffer(CShaderProgram::CameraBlock, sizeof(CCamera::SUniforms));
 	m_Initialized = true;
 	return true;
 }
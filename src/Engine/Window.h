@@ -4,6 +4,11 @@
 
 using SDL_GLContext = void*;
 
+namespace NRender
+{
+class CUniformBuffer;
+}
+
 class CWindow : public TSingleton<CWindow>
 {
 public:
@@ -11,6 +16,9 @@ public:
 	void Present();
 	bool IsInitialized() const { return m_Initialized; };
 
+	class CShaderProgram& Shader() { return *m_Shader; }
+	NRender::CUniformBuffer& CameraUniforms() { return *m_CameraUniforms; }
+
 	bool HasMouse();
 	void GrabMouse();
 	void ReleaseMouse();
@@ -21,4 +29,5 @@ private:
 	class SDL_Window* m_Window = nullptr;
 	SDL_GLContext m_GLContext = nullptr;
 	class CShaderProgram* m_Shader = nullptr;
+	NRender::CUniformBuffer* m_CameraUniforms = nullptr;
 };
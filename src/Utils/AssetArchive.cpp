@@ -0,0 +1,558 @@
+#include "AssetArchive.h"
+
+#include <algorithm>
+
+#include <stdio.h>
+#include <string.h>
+
+#ifndef __EMSCRIPTEN__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+constexpr uint32_t MakeFourCC(const char (&code)[5])
+{
+	return uint32_t(code[0]) | (uint32_t(code[1]) << 8) | (uint32_t(code[2]) << 16) | (uint32_t(code[3]) << 24);
+}
+
+constexpr uint32_t ARCHIVE_MAGIC = MakeFourCC("SKPK");
+constexpr uint32_t ARCHIVE_VERSION = 1;
+constexpr size_t ARCHIVE_ALIGNMENT = 16;
+
+struct SHeader
+{
+	uint32_t m_Magic;
+	uint32_t m_Version;
+	uint32_t m_EntryCount;
+	uint32_t m_Reserved;
+	uint64_t m_PathsSize;
+};
+
+struct SEntryRecord
+{
+	uint64_t m_Hash;
+	uint64_t m_Offset;
+	uint64_t m_Size;
+	uint64_t m_StoredSize;
+	uint32_t m_Path;
+	uint32_t m_PathSize;
+	uint32_t m_Compression;
+	uint32_t m_Reserved;
+};
+
+// Matches need at least four bytes to pay for their token and offset
+constexpr size_t LZ_MIN_MATCH = 4;
+constexpr size_t LZ_MAX_OFFSET = 65535;
+constexpr size_t LZ_HASH_BITS = 16;
+
+size_t Align(size_t value)
+{
+	return (value + ARCHIVE_ALIGNMENT - 1) & ~(ARCHIVE_ALIGNMENT - 1);
+}
+
+// FNV-1a, paths are short enough that anything fancier wouldn't pay off
+uint64_t HashPath(const char* path, size_t size)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash = (hash ^ uint8_t(path[i])) * 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+// Lengths that don't fit their nibble continue in bytes of 255 and a final remainder
+void WriteLength(std::vector<uint8_t>& output, size_t length)
+{
+	for (; length >= 255; length -= 255)
+	{
+		output.push_back(255);
+	}
+
+	output.push_back(uint8_t(length));
+}
+
+bool ReadLength(const uint8_t* input, size_t size, size_t& position, size_t& length)
+{
+	uint8_t byte = 255;
+
+	while (byte == 255)
+	{
+		if (position >= size)
+		{
+			return false;
+		}
+
+		byte = input[position++];
+		length += byte;
+	}
+
+	return true;
+}
+
+// Sequences of a token, literals, and a match unless the input ends after the literals
+void WriteSequence(std::vector<uint8_t>& output, const uint8_t* literals, size_t literal_count, size_t offset, size_t match_length)
+{
+	const size_t match_code = match_length ? match_length - LZ_MIN_MATCH : 0;
+	output.push_back(uint8_t(std::min<size_t>(literal_count, 15) << 4 | std::min<size_t>(match_code, 15)));
+
+	if (literal_count >= 15)
+	{
+		WriteLength(output, literal_count - 15);
+	}
+
+	output.insert(output.end(), literals, literals + literal_count);
+
+	if (match_length == 0)
+	{
+		return;
+	}
+
+	output.push_back(uint8_t(offset));
+	output.push_back(uint8_t(offset >> 8));
+
+	if (match_code >= 15)
+	{
+		WriteLength(output, match_code - 15);
+	}
+}
+
+// Greedy LZ77 in the spirit of LZ4, fast to decode and good enough for meshes and raw textures
+void CompressLZ(const uint8_t* input, size_t size, std::vector<uint8_t>& output)
+{
+	std::vector<size_t> table(size_t(1) << LZ_HASH_BITS, 0);
+	size_t anchor = 0;
+	size_t position = 0;
+
+	output.clear();
+
+	while (position + LZ_MIN_MATCH <= size)
+	{
+		uint32_t sequence;
+		memcpy(&sequence, input + position, sizeof(sequence));
+
+		// Positions are stored off by one, so zero marks an empty slot
+		const size_t hash = (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+		const size_t candidate = table[hash];
+		table[hash] = position + 1;
+
+		if (candidate == 0 || position - (candidate - 1) > LZ_MAX_OFFSET || memcmp(input + candidate - 1, input + position, LZ_MIN_MATCH))
+		{
+			++position;
+			continue;
+		}
+
+		const size_t match = candidate - 1;
+		size_t length = LZ_MIN_MATCH;
+
+		while (position + length < size && input[match + length] == input[position + length])
+		{
+			++length;
+		}
+
+		WriteSequence(output, input + anchor, position - anchor, position - match, length);
+		position += length;
+		anchor = position;
+	}
+
+	WriteSequence(output, input + anchor, size - anchor, 0, 0);
+}
+
+bool DecompressLZ(const uint8_t* input, size_t size, uint8_t* output, size_t output_size)
+{
+	size_t position = 0;
+	size_t written = 0;
+
+	while (position < size)
+	{
+		const uint8_t token = input[position++];
+
+		size_t literals = token >> 4;
+		if (literals == 15 && !ReadLength(input, size, position, literals))
+		{
+			return false;
+		}
+
+		if (literals > size - position || literals > output_size - written)
+		{
+			return false;
+		}
+
+		memcpy(output + written, input + position, literals);
+		position += literals;
+		written += literals;
+
+		if (position == size)
+		{
+			break;
+		}
+
+		if (size - position < 2)
+		{
+			return false;
+		}
+
+		const size_t offset = size_t(input[position]) | size_t(input[position + 1]) << 8;
+		position += 2;
+
+		size_t length = token & 15;
+		if (length == 15 && !ReadLength(input, size, position, length))
+		{
+			return false;
+		}
+
+		length += LZ_MIN_MATCH;
+
+		if (offset == 0 || offset > written || length > output_size - written)
+		{
+			return false;
+		}
+
+		// Matches may overlap what they produce, only those have to be copied a byte at a time
+		if (offset >= length)
+		{
+			memcpy(output + written, output + written - offset, length);
+			written += length;
+			continue;
+		}
+
+		for (size_t i = 0; i < length; ++i, ++written)
+		{
+			output[written] = output[written - offset];
+		}
+	}
+
+	return written == output_size;
+}
+}  // namespace
+
+bool NUtils::PackArchive(const std::vector<SArchiveFile>& files, std::vector<uint8_t>& blob)
+{
+	struct SPacked
+	{
+		const SArchiveFile* m_File;
+		uint64_t m_Hash;
+		std::vector<uint8_t> m_Compressed;
+	};
+
+	std::vector<SPacked> packed(files.size());
+
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		packed[i].m_File = &files[i];
+		packed[i].m_Hash = HashPath(files[i].m_Path.data(), files[i].m_Path.size());
+
+		if (files[i].m_Compress)
+		{
+			CompressLZ(files[i].m_Data.data(), files[i].m_Data.size(), packed[i].m_Compressed);
+
+			if (packed[i].m_Compressed.size() >= files[i].m_Data.size())
+			{
+				packed[i].m_Compressed.clear();
+			}
+		}
+	}
+
+	// The index is ordered by hash, colliding paths are ordered by name so duplicates end up adjacent
+	std::sort(packed.begin(), packed.end(), [](const SPacked& a, const SPacked& b) {
+		return a.m_Hash != b.m_Hash ? a.m_Hash < b.m_Hash : a.m_File->m_Path < b.m_File->m_Path;
+	});
+
+	for (size_t i = 1; i < packed.size(); ++i)
+	{
+		if (packed[i].m_File->m_Path == packed[i - 1].m_File->m_Path)
+		{
+			printf("Archive has a duplicate path: %s\n", packed[i].m_File->m_Path.c_str());
+			return false;
+		}
+	}
+
+	// Lay out the index, the paths and then the data
+	std::vector<SEntryRecord> entries(packed.size());
+	std::string paths;
+
+	for (size_t i = 0; i < packed.size(); ++i)
+	{
+		entries[i].m_Hash = packed[i].m_Hash;
+		entries[i].m_Path = uint32_t(paths.size());
+		entries[i].m_PathSize = uint32_t(packed[i].m_File->m_Path.size());
+		paths += packed[i].m_File->m_Path;
+	}
+
+	size_t offset = Align(sizeof(SHeader) + sizeof(SEntryRecord) * entries.size() + paths.size());
+
+	for (size_t i = 0; i < packed.size(); ++i)
+	{
+		const bool compressed = !packed[i].m_Compressed.empty();
+		entries[i].m_Offset = offset;
+		entries[i].m_Size = packed[i].m_File->m_Data.size();
+		entries[i].m_StoredSize = compressed ? packed[i].m_Compressed.size() : entries[i].m_Size;
+		entries[i].m_Compression = uint32_t(compressed ? EArchiveCompression::LZ : EArchiveCompression::None);
+		entries[i].m_Reserved = 0;
+		offset = Align(offset + entries[i].m_StoredSize);
+	}
+
+	// Write everything out, padding is zeroed so output is deterministic
+	blob.assign(offset, 0);
+
+	const SHeader header = { ARCHIVE_MAGIC, ARCHIVE_VERSION, uint32_t(entries.size()), 0, paths.size() };
+	memcpy(blob.data(), &header, sizeof(header));
+	memcpy(blob.data() + sizeof(header), entries.data(), sizeof(SEntryRecord) * entries.size());
+	memcpy(blob.data() + sizeof(header) + sizeof(SEntryRecord) * entries.size(), paths.data(), paths.size());
+
+	for (size_t i = 0; i < packed.size(); ++i)
+	{
+		const std::vector<uint8_t>& data = packed[i].m_Compressed.empty() ? packed[i].m_File->m_Data : packed[i].m_Compressed;
+
+		if (!data.empty())
+		{
+			memcpy(blob.data() + entries[i].m_Offset, data.data(), data.size());
+		}
+	}
+
+	return true;
+}
+
+bool NUtils::SaveArchive(const char* filename, const std::vector<SArchiveFile>& files)
+{
+	std::vector<uint8_t> blob;
+
+	if (!PackArchive(files, blob))
+	{
+		return false;
+	}
+
+	FILE* file = fopen(filename, "wb");
+
+	if (!file)
+	{
+		printf("Failed to open archive for writing: %s\n", filename);
+		return false;
+	}
+
+	const bool written = fwrite(blob.data(), 1, blob.size(), file) == blob.size();
+	fclose(file);
+
+	if (!written)
+	{
+		printf("Failed to write archive: %s\n", filename);
+	}
+
+	return written;
+}
+
+bool NUtils::CAssetArchive::Mount(const char* filename)
+{
+	std::shared_ptr<const uint8_t> data;
+	size_t size = 0;
+
+#ifdef __EMSCRIPTEN__
+	// There is nothing to map on the web, mounting a fetched buffer directly avoids this copy
+	FILE* file = fopen(filename, "rb");
+
+	if (!file)
+	{
+		printf("Failed to open archive: %s\n", filename);
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+
+	std::shared_ptr<uint8_t> buffer(new uint8_t[size], std::default_delete<uint8_t[]>());
+	rewind(file);
+	const bool read = fread(buffer.get(), 1, size, file) == size;
+	fclose(file);
+
+	if (!read)
+	{
+		printf("Failed to read archive: %s\n", filename);
+		return false;
+	}
+
+	data = buffer;
+#else
+	const int file = open(filename, O_RDONLY);
+	struct stat info;
+
+	if (file < 0 || fstat(file, &info) != 0 || info.st_size == 0)
+	{
+		printf("Failed to open archive: %s\n", filename);
+
+		if (file >= 0)
+		{
+			close(file);
+		}
+
+		return false;
+	}
+
+	// The mapping stays valid after the descriptor is closed, pages are only read in when touched
+	size = size_t(info.st_size);
+	void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+
+	if (address == MAP_FAILED)
+	{
+		printf("Failed to map archive: %s\n", filename);
+		return false;
+	}
+
+	data = std::shared_ptr<const uint8_t>(static_cast<const uint8_t*>(address), [size](const uint8_t* mapped) {
+		munmap(const_cast<uint8_t*>(mapped), size);
+	});
+#endif
+
+	return Mount(data, size);
+}
+
+bool NUtils::CAssetArchive::Mount(std::shared_ptr<const uint8_t> data, size_t size)
+{
+	// Validate the header, the index and every entry up front, lookups trust them afterwards
+	SHeader header;
+
+	if (data == nullptr || size < sizeof(header))
+	{
+		printf("Archive is truncated\n");
+		return false;
+	}
+
+	memcpy(&header, data.get(), sizeof(header));
+
+	if (header.m_Magic != ARCHIVE_MAGIC || header.m_Version != ARCHIVE_VERSION)
+	{
+		printf("Archive has an unsupported format: %08x v%u\n", header.m_Magic, header.m_Version);
+		return false;
+	}
+
+	const size_t paths_offset = sizeof(header) + sizeof(SEntryRecord) * size_t(header.m_EntryCount);
+
+	if (paths_offset > size || header.m_PathsSize > size - paths_offset)
+	{
+		printf("Archive is corrupt\n");
+		return false;
+	}
+
+	for (size_t i = 0; i < header.m_EntryCount; ++i)
+	{
+		SEntryRecord entry;
+		memcpy(&entry, data.get() + sizeof(header) + i * sizeof(entry), sizeof(entry));
+
+		if (entry.m_Offset > size || entry.m_StoredSize > size - entry.m_Offset ||
+			entry.m_Path > header.m_PathsSize || entry.m_PathSize > header.m_PathsSize - entry.m_Path ||
+			entry.m_Compression > uint32_t(EArchiveCompression::LZ) ||
+			(entry.m_Compression == uint32_t(EArchiveCompression::None) && entry.m_StoredSize != entry.m_Size))
+		{
+			printf("Archive has a corrupt entry: %zu\n", i);
+			return false;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Data = std::move(data);
+	m_EntryCount = header.m_EntryCount;
+	m_PathsOffset = paths_offset;
+	return true;
+}
+
+void NUtils::CAssetArchive::Unmount()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Data = nullptr;
+	m_EntryCount = 0;
+	m_PathsOffset = 0;
+}
+
+bool NUtils::CAssetArchive::IsMounted()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Data != nullptr;
+}
+
+bool NUtils::CAssetArchive::Open(const std::string& path, SAssetSlice& slice)
+{
+	std::shared_ptr<const uint8_t> data;
+	size_t entry_count;
+	size_t paths_offset;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		data = m_Data;
+		entry_count = m_EntryCount;
+		paths_offset = m_PathsOffset;
+	}
+
+	if (data == nullptr)
+	{
+		return false;
+	}
+
+	auto ReadEntry = [&data](size_t index) {
+		SEntryRecord entry;
+		memcpy(&entry, data.get() + sizeof(SHeader) + index * sizeof(entry), sizeof(entry));
+		return entry;
+	};
+
+	const uint64_t hash = HashPath(path.data(), path.size());
+
+	// Binary search for the first entry with the hash, then walk any collisions
+	size_t first = 0;
+	size_t count = entry_count;
+
+	while (count > 0)
+	{
+		const size_t step = count / 2;
+
+		if (ReadEntry(first + step).m_Hash < hash)
+		{
+			first += step + 1;
+			count -= step + 1;
+		}
+		else
+		{
+			count = step;
+		}
+	}
+
+	for (size_t i = first; i < entry_count; ++i)
+	{
+		const SEntryRecord entry = ReadEntry(i);
+
+		if (entry.m_Hash != hash)
+		{
+			return false;
+		}
+
+		if (entry.m_PathSize != path.size() || memcmp(data.get() + paths_offset + entry.m_Path, path.data(), path.size()))
+		{
+			continue;
+		}
+
+		if (entry.m_Compression == uint32_t(EArchiveCompression::None))
+		{
+			slice.m_Data = std::shared_ptr<const uint8_t>(data, data.get() + entry.m_Offset);
+			slice.m_Size = entry.m_Size;
+			return true;
+		}
+
+		std::shared_ptr<uint8_t> decompressed(new uint8_t[std::max<size_t>(entry.m_Size, 1)], std::default_delete<uint8_t[]>());
+
+		if (!DecompressLZ(data.get() + entry.m_Offset, entry.m_StoredSize, decompressed.get(), entry.m_Size))
+		{
+			printf("Archived file is corrupt: %s\n", path.c_str());
+			return false;
+		}
+
+		slice.m_Data = decompressed;
+		slice.m_Size = entry.m_Size;
+		return true;
+	}
+
+	return false;
+}
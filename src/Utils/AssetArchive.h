@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Singleton.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace NUtils
+{
+enum class EArchiveCompression : uint32_t
+{
+	None,
+	LZ
+};
+
+// A file to pack, compression is only kept when it actually saves space
+struct SArchiveFile
+{
+	std::string m_Path;
+	std::vector<uint8_t> m_Data;
+	bool m_Compress = false;
+};
+
+// Bytes of an archived file, kept alive by whoever holds the slice
+struct SAssetSlice
+{
+	std::shared_ptr<const uint8_t> m_Data;
+	size_t m_Size = 0;
+};
+
+/**
+ * Archives are a little-endian header, an index of entries sorted by the hash
+ * of their path, a table of paths and 16 byte aligned file data. Lookups are a
+ * binary search over the index, so opening a file never touches the rest.
+ **/
+bool PackArchive(const std::vector<SArchiveFile>& files, std::vector<uint8_t>& blob);
+bool SaveArchive(const char* filename, const std::vector<SArchiveFile>& files);
+
+/**
+ * The mounted asset bundle. Stored files are served as slices of the archive
+ * itself, which is memory mapped natively and a single fetched buffer on the web,
+ * so opening one never copies it. Only compressed files are decoded into a buffer
+ * of their own. Slices share ownership of the archive and outlive an unmount.
+ **/
+class CAssetArchive : public TSingleton<CAssetArchive>
+{
+public:
+	bool Mount(const char* filename);
+	bool Mount(std::shared_ptr<const uint8_t> data, size_t size);
+	void Unmount();
+
+	bool IsMounted();
+
+	// Fails quietly when nothing is mounted or the path isn't archived, callers fall back to the file system
+	bool Open(const std::string& path, SAssetSlice& slice);
+
+private:
+	std::mutex m_Mutex;
+	std::shared_ptr<const uint8_t> m_Data;
+	size_t m_EntryCount = 0;
+	size_t m_PathsOffset = 0;
+};
+}  // namespace NUtils
@@ -0,0 +1,321 @@
+#include "AssetLoader.h"
+#include "BvhBuilder.h"
+#include "CookedMesh.h"
+#include "MeshLoader.h"
+#include "MeshOptimizer.h"
+#include "Profiler.h"
+
+#include <Engine/Render/Mesh.h>
+
+#include <algorithm>
+
+#include <stdio.h>
+
+NUtils::CAssetRequest::CAssetRequest(const std::string& filename, const MeshCallback& on_loaded, const TextureLoader& load_texture)
+	: m_Filename(filename)
+	, m_OnLoaded(on_loaded)
+	, m_LoadTexture(load_texture)
+{
+}
+
+void NUtils::CAssetRequest::Cancel()
+{
+	if (MarkCancelled() && m_Loader)
+	{
+		m_Loader->WakeWorkers();
+	}
+}
+
+bool NUtils::CAssetRequest::MarkCancelled()
+{
+	EAssetState state = m_State;
+
+	// Requests that already ran their callback keep their outcome
+	while (state != EAssetState::Completed && state != EAssetState::Failed && state != EAssetState::Cancelled)
+	{
+		if (m_State.compare_exchange_weak(state, EAssetState::Cancelled))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+NUtils::CAssetLoader::~CAssetLoader()
+{
+	Stop();
+}
+
+void NUtils::CAssetLoader::Start(size_t threads, size_t capacity)
+{
+	Stop();
+
+	m_Capacity = std::max<size_t>(capacity, 1);
+
+	for (size_t i = 0; i < threads; ++i)
+	{
+		m_Workers.emplace_back(&CAssetLoader::Work, this);
+	}
+}
+
+void NUtils::CAssetLoader::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stopping = true;
+
+		for (HAssetRequest& request : m_Requests)
+		{
+			Drop(*request);
+		}
+
+		for (HAssetRequest& request : m_Loaded)
+		{
+			Drop(*request);
+		}
+
+		m_Requests.clear();
+		m_Loaded.clear();
+	}
+
+	m_Queued.notify_all();
+	m_Collected.notify_all();
+
+	// Workers finish the mesh they're parsing, then drop it
+	for (std::thread& worker : m_Workers)
+	{
+		worker.join();
+	}
+
+	m_Workers.clear();
+	m_Stopping = false;
+
+	ReleaseDropped();
+}
+
+NUtils::HAssetRequest NUtils::CAssetLoader::LoadMesh(const std::string& filename, const CAssetRequest::MeshCallback& on_loaded, const TextureLoader& load_texture)
+{
+	HAssetRequest request = std::make_shared<CAssetRequest>(filename, on_loaded, load_texture);
+	request->m_Loader = this;
+	++m_Pending;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Requests.push_back(request);
+	}
+
+	m_Queued.notify_one();
+	return request;
+}
+
+size_t NUtils::CAssetLoader::Update(size_t max_loads)
+{
+	ReleaseDropped();
+
+	// Without workers the GL thread does the loading itself, a single request at a time
+	if (m_Workers.empty())
+	{
+		HAssetRequest request;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			if (!m_Requests.empty() && m_Loaded.size() < m_Capacity)
+			{
+				request = std::move(m_Requests.front());
+				m_Requests.pop_front();
+			}
+		}
+
+		if (request && request->Advance(EAssetState::Queued, EAssetState::Loading))
+		{
+			Load(*request);
+		}
+
+		if (request && request->Advance(EAssetState::Loading, EAssetState::Loaded))
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Loaded.push_back(std::move(request));
+		}
+		else if (request)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			Drop(*request);
+		}
+	}
+
+	size_t completed = 0;
+
+	while (completed < max_loads)
+	{
+		HAssetRequest request;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			if (m_Loaded.empty())
+			{
+				break;
+			}
+
+			request = std::move(m_Loaded.front());
+			m_Loaded.pop_front();
+		}
+
+		m_Collected.notify_one();
+
+		// Cancelled loads are discarded without counting towards the budget
+		const EAssetState outcome = request->m_Mesh ? EAssetState::Completed : EAssetState::Failed;
+
+		// Cancelled on the GL thread, so the mesh can go right away
+		if (!request->Advance(EAssetState::Loaded, outcome))
+		{
+			request->m_Mesh = nullptr;
+			--m_Pending;
+			continue;
+		}
+
+		--m_Pending;
+		++completed;
+
+		// The callback takes over the mesh, the request shouldn't keep it alive
+		const NRender::HMesh mesh = std::move(request->m_Mesh);
+
+		if (request->m_OnLoaded)
+		{
+			PROFILE_ZONE("Mesh loaded");
+			request->m_OnLoaded(mesh);
+		}
+	}
+
+	return completed;
+}
+
+void NUtils::CAssetLoader::Work()
+{
+	CProfiler::Instance().NameThread("Asset loader");
+
+	for (;;)
+	{
+		HAssetRequest request;
+
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Queued.wait(lock, [this]() { return m_Stopping || !m_Requests.empty(); });
+
+			if (m_Stopping)
+			{
+				return;
+			}
+
+			request = std::move(m_Requests.front());
+			m_Requests.pop_front();
+		}
+
+		if (request->Advance(EAssetState::Queued, EAssetState::Loading))
+		{
+			Load(*request);
+		}
+
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		// Waiting for room in the queue, a request cancelled meanwhile frees the worker right away
+		m_Collected.wait(lock, [&]() {
+			return m_Stopping || m_Loaded.size() < m_Capacity || request->State() == EAssetState::Cancelled;
+		});
+
+		if (!m_Stopping && request->Advance(EAssetState::Loading, EAssetState::Loaded))
+		{
+			m_Loaded.push_back(std::move(request));
+		}
+		else
+		{
+			Drop(*request);
+		}
+	}
+}
+
+void NUtils::CAssetLoader::Load(CAssetRequest& request)
+{
+	PROFILE_ZONE("Load mesh");
+	TextureLoader load_texture;
+
+	// Textures are the bulk of the work, so cancelled loads stop decoding them
+	if (request.m_LoadTexture)
+	{
+		load_texture = [&request](const std::string& path) {
+			return request.State() == EAssetState::Cancelled ? nullptr : request.m_LoadTexture(path);
+		};
+	}
+
+	NRender::HMesh mesh = std::make_shared<NRender::SMesh>();
+	bool loaded = LoadCookedMesh(GetCookedMeshPath(request.m_Filename).c_str(), *mesh, load_texture);
+
+#if !defined(ENGINE_HEADLESS) || defined(ENGINE_ASSIMP)
+	if (!loaded && request.State() != EAssetState::Cancelled)
+	{
+		Discard(std::move(mesh));
+		mesh = std::make_shared<NRender::SMesh>();
+		loaded = NUtils::LoadMesh(request.m_Filename.c_str(), "", *mesh, load_texture);
+
+		if (loaded)
+		{
+			OptimizeMesh(*mesh);
+			BuildBvh(*mesh);
+		}
+	}
+#endif
+
+	if (!loaded && request.State() != EAssetState::Cancelled)
+	{
+		printf("Could not load mesh: %s\n", request.m_Filename.c_str());
+	}
+
+	if (loaded)
+	{
+		request.m_Mesh = std::move(mesh);
+	}
+	else
+	{
+		Discard(std::move(mesh));
+	}
+}
+
+void NUtils::CAssetLoader::WakeWorkers()
+{
+	// Taken so the wakeup can't slip in between a worker checking the request and starting to wait
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Collected.notify_all();
+}
+
+void NUtils::CAssetLoader::Drop(CAssetRequest& request)
+{
+	request.MarkCancelled();
+
+	if (request.m_Mesh)
+	{
+		m_Dropped.push_back(std::move(request.m_Mesh));
+	}
+
+	--m_Pending;
+}
+
+void NUtils::CAssetLoader::Discard(NRender::HMesh mesh)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Dropped.push_back(std::move(mesh));
+}
+
+void NUtils::CAssetLoader::ReleaseDropped()
+{
+	std::vector<NRender::HMesh> dropped;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		dropped.swap(m_Dropped);
+	}
+
+	// Released outside the lock, freeing a large mesh shouldn't stall the workers
+	dropped.clear();
+}
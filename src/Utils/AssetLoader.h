@@ -0,0 +1,127 @@
+#pragma once
+
+#include "TextureLoader.h"
+#include "Singleton.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace NRender
+{
+struct SMesh;
+using HMesh = std::shared_ptr<SMesh>;
+}  // namespace NRender
+
+namespace NUtils
+{
+enum class EAssetState : uint8_t
+{
+	Queued,
+	Loading,
+	Loaded,		// Waiting for the GL thread to pick it up
+	Completed,
+	Failed,
+	Cancelled
+};
+
+// Shared between the caller and the loader, the caller may drop it once it no longer cares
+class CAssetLoader;
+
+class CAssetRequest
+{
+public:
+	using MeshCallback = std::function<void(const NRender::HMesh& mesh)>;
+
+	CAssetRequest(const std::string& filename, const MeshCallback& on_loaded, const TextureLoader& load_texture);
+
+	// The callback never runs for a cancelled request, loads already in flight skip their remaining textures
+	void Cancel();
+
+	EAssetState State() const { return m_State; }
+	const std::string& Filename() const { return m_Filename; }
+
+private:
+	friend class CAssetLoader;
+
+	// Fails when the request was cancelled in the meantime
+	bool Advance(EAssetState from, EAssetState to) { return m_State.compare_exchange_strong(from, to); }
+
+	// Returns whether this call cancelled the request, without waking the loader's workers
+	bool MarkCancelled();
+
+	std::string m_Filename;
+	MeshCallback m_OnLoaded;
+	TextureLoader m_LoadTexture;
+	NRender::HMesh m_Mesh;
+	std::atomic<EAssetState> m_State{ EAssetState::Queued };
+
+	// Woken on cancellation, so a worker waiting to queue this request lets go of it
+	CAssetLoader* m_Loader = nullptr;
+};
+
+using HAssetRequest = std::shared_ptr<CAssetRequest>;
+
+/**
+ * Parses meshes and decodes their textures on worker threads. Finished loads wait
+ * in a bounded queue until the GL thread collects them in Update(), where their
+ * callbacks run and may upload. A full queue stalls the workers instead of letting
+ * decoded data pile up faster than the GL thread can take it. Without workers the
+ * loads run inside Update(), one per call. Meshes of dropped requests are released
+ * in Update() as well, never on a worker.
+ **/
+class CAssetLoader : public TSingleton<CAssetLoader>
+{
+public:
+	~CAssetLoader();
+
+	// Restarting cancels everything outstanding
+	void Start(size_t threads, size_t capacity = 4);
+
+	// Cancels everything outstanding and joins the workers
+	void Stop();
+
+	// Prefers the cooked .mesh next to filename, the source is only parsed when there is none
+	HAssetRequest LoadMesh(const std::string& filename, const CAssetRequest::MeshCallback& on_loaded, const TextureLoader& load_texture = nullptr);
+
+	// Called on the GL thread, runs the callbacks of up to max_loads finished loads, failed ones get nullptr
+	size_t Update(size_t max_loads = 1);
+
+	// Queued, in flight and finished loads that haven't been collected yet
+	size_t Pending() const { return m_Pending; }
+
+private:
+	friend class CAssetRequest;
+
+	void Work();
+	void WakeWorkers();
+	void Load(CAssetRequest& request);
+
+	// Called with m_Mutex held. Meshes may share textures with the renderer, so only the GL thread releases them
+	void Drop(CAssetRequest& request);
+	void Discard(NRender::HMesh mesh);
+	void ReleaseDropped();
+
+	std::vector<std::thread> m_Workers;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_Queued;
+	std::condition_variable m_Collected;
+	std::deque<HAssetRequest> m_Requests;
+	std::deque<HAssetRequest> m_Loaded;
+	std::vector<NRender::HMesh> m_Dropped;
+	size_t m_Capacity = 4;
+	bool m_Stopping = false;
+
+	std::atomic<size_t> m_Pending{ 0 };
+};
+}  // namespace NUtils
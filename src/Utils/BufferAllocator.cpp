@@ -0,0 +1,163 @@
+#include "BufferAllocator.h"
+
+#include <algorithm>
+
+namespace NUtils
+{
+CRingAllocator::CRingAllocator(size_t capacity, size_t alignment)
+	: m_Capacity(capacity)
+	, m_Alignment(std::max<size_t>(alignment, 1))
+{
+}
+
+void CRingAllocator::Reset(size_t capacity)
+{
+	m_Capacity = capacity;
+	m_Head = 0;
+	m_Used = 0;
+	m_Released = m_Allocated;
+	m_Frames.clear();
+}
+
+size_t CRingAllocator::Allocate(size_t size)
+{
+	if (size > m_Capacity)
+	{
+		return Invalid;
+	}
+
+	size_t offset = (m_Head + m_Alignment - 1) / m_Alignment * m_Alignment;
+
+	// Ranges never straddle the end, the tail that doesn't fit is skipped and counts as used
+	if (offset + size > m_Capacity)
+	{
+		offset = 0;
+	}
+
+	const size_t skipped = offset >= m_Head ? offset - m_Head : m_Capacity - m_Head;
+
+	// Whatever isn't used lies between the head and the oldest frame in flight
+	if (m_Used + skipped + size > m_Capacity)
+	{
+		return Invalid;
+	}
+
+	m_Used += skipped + size;
+	m_Allocated += skipped + size;
+	m_Head = offset + size;
+	return offset;
+}
+
+uint64_t CRingAllocator::EndFrame()
+{
+	m_Frames.push_back({ m_Frame, m_Allocated });
+	return m_Frame++;
+}
+
+void CRingAllocator::Release(uint64_t frame)
+{
+	while (!m_Frames.empty() && m_Frames.front().m_Frame <= frame)
+	{
+		m_Released = m_Frames.front().m_End;
+		m_Frames.pop_front();
+	}
+
+	m_Used = size_t(m_Allocated - m_Released);
+}
+
+CRangeAllocator::CRangeAllocator(size_t capacity)
+{
+	Grow(capacity);
+}
+
+size_t CRangeAllocator::Allocate(size_t size)
+{
+	if (size == 0)
+	{
+		return 0;
+	}
+
+	auto best = m_Free.end();
+
+	for (auto it = m_Free.begin(); it != m_Free.end(); ++it)
+	{
+		if (it->second >= size && (best == m_Free.end() || it->second < best->second))
+		{
+			best = it;
+		}
+	}
+
+	if (best == m_Free.end())
+	{
+		return Invalid;
+	}
+
+	const size_t offset = best->first;
+	const size_t remaining = best->second - size;
+	m_Free.erase(best);
+
+	if (remaining > 0)
+	{
+		m_Free.emplace(offset + size, remaining);
+	}
+
+	m_Used += size;
+	return offset;
+}
+
+void CRangeAllocator::Free(size_t offset, size_t size)
+{
+	if (size == 0)
+	{
+		return;
+	}
+
+	m_Used -= size;
+	auto next = m_Free.lower_bound(offset);
+
+	if (next != m_Free.end() && offset + size == next->first)
+	{
+		size += next->second;
+		next = m_Free.erase(next);
+	}
+
+	if (next != m_Free.begin())
+	{
+		auto previous = std::prev(next);
+
+		if (previous->first + previous->second == offset)
+		{
+			previous->second += size;
+			return;
+		}
+	}
+
+	m_Free.emplace_hint(next, offset, size);
+}
+
+void CRangeAllocator::Grow(size_t capacity)
+{
+	if (capacity <= m_Capacity)
+	{
+		return;
+	}
+
+	// The new space is freed like any other range, so it merges with a free tail
+	const size_t previous = m_Capacity;
+	m_Capacity = capacity;
+	m_Used += capacity - previous;
+	Free(previous, capacity - previous);
+}
+
+size_t CRangeAllocator::LargestFree() const
+{
+	size_t largest = 0;
+
+	for (const auto& range : m_Free)
+	{
+		largest = std::max(largest, range.second);
+	}
+
+	return largest;
+}
+}  // namespace NUtils
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <map>
+
+namespace NUtils
+{
+/**
+ * Hands out ranges of a fixed size buffer in order, wrapping around at its end,
+ * for data written once and read by the GPU a frame or two later. Allocations
+ * belong to the frame they were made in, and stay in use until that frame is
+ * released, once the GPU is known to be done with it. Only offsets and sizes
+ * are tracked, the storage itself lives elsewhere.
+ **/
+class CRingAllocator
+{
+public:
+	static constexpr size_t Invalid = SIZE_MAX;
+
+	explicit CRingAllocator(size_t capacity = 0, size_t alignment = 256);
+
+	// Forgets every allocation, including those of frames still in flight
+	void Reset(size_t capacity);
+
+	// Returns Invalid when the frames in flight leave no room for size bytes
+	size_t Allocate(size_t size);
+
+	// Closes the current frame and returns its number, to release it with later
+	uint64_t EndFrame();
+
+	// Frees the allocations of every frame up to and including the given one
+	void Release(uint64_t frame);
+
+	size_t Capacity() const { return m_Capacity; }
+	size_t Used() const { return m_Used; }
+
+private:
+	struct SFrame
+	{
+		uint64_t m_Frame;
+		uint64_t m_End;
+	};
+
+	size_t m_Capacity;
+	size_t m_Alignment;
+	size_t m_Head = 0;
+	size_t m_Used = 0;
+
+	// Bytes ever allocated, padding included, frames remember where theirs ended
+	uint64_t m_Allocated = 0;
+	uint64_t m_Released = 0;
+	uint64_t m_Frame = 0;
+	std::deque<SFrame> m_Frames;
+};
+
+/**
+ * Best fit allocator for long lived ranges of a growable buffer, like meshes
+ * sharing one vertex buffer. Freed ranges are merged with their free neighbours,
+ * so churn fragments the buffer as little as possible. Sizes are in whatever
+ * unit the caller counts in, vertices or indices work as well as bytes.
+ **/
+class CRangeAllocator
+{
+public:
+	static constexpr size_t Invalid = SIZE_MAX;
+
+	explicit CRangeAllocator(size_t capacity = 0);
+
+	// Returns Invalid when no free range is large enough, growing is up to the caller
+	size_t Allocate(size_t size);
+	void Free(size_t offset, size_t size);
+
+	// Extends the range at its end, allocations made so far keep their offsets
+	void Grow(size_t capacity);
+
+	size_t Capacity() const { return m_Capacity; }
+	size_t Used() const { return m_Used; }
+	size_t LargestFree() const;
+
+private:
+	// Free ranges by offset, so neighbours are found when merging
+	std::map<size_t, size_t> m_Free;
+	size_t m_Capacity = 0;
+	size_t m_Used = 0;
+};
+}  // namespace NUtils
@@ -0,0 +1,243 @@
+#include "BvhBuilder.h"
+#include "MeshQuantizer.h"
+
+#include <Engine/Math.h>
+#include <Engine/Render/Mesh.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+using SBvh = NRender::SMesh::SBvh;
+
+constexpr size_t LEAF_SIZE = 4;
+constexpr size_t BINS = 16;
+
+struct SBox
+{
+	CVector3f m_Min = CVector3f::Constant(INFINITY);
+	CVector3f m_Max = CVector3f::Constant(-INFINITY);
+
+	void Grow(const SBox& box)
+	{
+		m_Min = m_Min.cwiseMin(box.m_Min);
+		m_Max = m_Max.cwiseMax(box.m_Max);
+	}
+
+	float Area() const
+	{
+		const CVector3f size = (m_Max - m_Min).cwiseMax(0.0f);
+		return 2.0f * (size.x() * size.y() + size.y() * size.z() + size.z() * size.x());
+	}
+};
+
+struct STriangle
+{
+	SBox m_Box;
+	CVector3f m_Corners[3];
+	uint32_t m_Index;
+};
+
+struct SBin
+{
+	SBox m_Box;
+	uint32_t m_Count = 0;
+};
+
+void AddBlocks(const std::vector<STriangle>& triangles, const uint32_t* order, size_t count, std::vector<SBvh::STriangleBlock>& blocks)
+{
+	for (size_t first = 0; first < count; first += 4)
+	{
+		SBvh::STriangleBlock block = {};
+
+		for (size_t lane = 0; lane < 4; ++lane)
+		{
+			block.m_Index[lane] = SBvh::NoTriangle;
+
+			if (first + lane >= count)
+			{
+				continue;
+			}
+
+			const STriangle& triangle = triangles[order[first + lane]];
+			const CVector3f edge1 = triangle.m_Corners[1] - triangle.m_Corners[0];
+			const CVector3f edge2 = triangle.m_Corners[2] - triangle.m_Corners[0];
+
+			block.m_X[lane] = triangle.m_Corners[0].x();
+			block.m_Y[lane] = triangle.m_Corners[0].y();
+			block.m_Z[lane] = triangle.m_Corners[0].z();
+			block.m_Edge1X[lane] = edge1.x();
+			block.m_Edge1Y[lane] = edge1.y();
+			block.m_Edge1Z[lane] = edge1.z();
+			block.m_Edge2X[lane] = edge2.x();
+			block.m_Edge2Y[lane] = edge2.y();
+			block.m_Edge2Z[lane] = edge2.z();
+			block.m_Index[lane] = triangle.m_Index;
+		}
+
+		blocks.push_back(block);
+	}
+}
+}  // namespace
+
+void NUtils::BuildBvh(NRender::SMesh& mesh)
+{
+	SBvh& bvh = mesh.m_Bvh;
+	bvh = SBvh();
+
+	// Triangles as stored, packed positions decoded
+	std::vector<STriangle> triangles;
+
+	for (const NRender::SMesh::SSubMesh& sub_mesh : mesh.m_SubMeshes)
+	{
+		for (size_t i = sub_mesh.m_IndexOffset; i + 2 < sub_mesh.m_IndexOffset + sub_mesh.m_IndexCount; i += 3)
+		{
+			STriangle triangle;
+			triangle.m_Index = uint32_t(i);
+
+			for (size_t k = 0; k < 3; ++k)
+			{
+				triangle.m_Corners[k] = GetVertexPosition(mesh, sub_mesh, mesh.m_Indices[i + k]);
+				triangle.m_Box.Grow({ triangle.m_Corners[k], triangle.m_Corners[k] });
+			}
+
+			triangles.push_back(triangle);
+		}
+	}
+
+	if (triangles.empty())
+	{
+		return;
+	}
+
+	std::vector<uint32_t> order(triangles.size());
+
+	for (uint32_t i = 0; i < order.size(); ++i)
+	{
+		order[i] = i;
+	}
+
+	struct STask
+	{
+		uint32_t m_Node;
+		uint32_t m_First;
+		uint32_t m_Count;
+		uint32_t m_Depth;
+	};
+
+	std::vector<STask> tasks = { { 0, 0, uint32_t(triangles.size()), 0 } };
+	bvh.m_Nodes.emplace_back();
+
+	while (!tasks.empty())
+	{
+		const STask task = tasks.back();
+		tasks.pop_back();
+
+		uint32_t* first = order.data() + task.m_First;
+		uint32_t* last = first + task.m_Count;
+
+		// Bounds of the triangles and of their centroids, doubled to save the halving
+		SBox bounds, centers;
+
+		for (const uint32_t* triangle = first; triangle < last; ++triangle)
+		{
+			const SBox& box = triangles[*triangle].m_Box;
+			const CVector3f center = box.m_Min + box.m_Max;
+			bounds.Grow(box);
+			centers.Grow({ center, center });
+		}
+
+		SBvh::SNode node;
+		std::copy(bounds.m_Min.data(), bounds.m_Min.data() + 3, node.m_Min);
+		std::copy(bounds.m_Max.data(), bounds.m_Max.data() + 3, node.m_Max);
+
+		if (task.m_Count <= LEAF_SIZE || task.m_Depth >= SBvh::MaxDepth)
+		{
+			node.m_First = uint32_t(bvh.m_Blocks.size());
+			node.m_Count = task.m_Count;
+			bvh.m_Nodes[task.m_Node] = node;
+			AddBlocks(triangles, first, task.m_Count, bvh.m_Blocks);
+			continue;
+		}
+
+		const CVector3f extent = centers.m_Max - centers.m_Min;
+
+		auto Bin = [&](uint32_t triangle, int axis) {
+			const SBox& box = triangles[triangle].m_Box;
+			const float offset = box.m_Min[axis] + box.m_Max[axis] - centers.m_Min[axis];
+			return std::min(size_t(offset * (float(BINS) * 0.9999f / extent[axis])), BINS - 1);
+		};
+
+		// Splitting after bin s costs the area of each side times the triangles on it
+		float best_cost = INFINITY;
+		int best_axis = -1;
+		size_t best_split = 0;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (!(extent[axis] > 0.0f))
+			{
+				continue;
+			}
+
+			SBin bins[BINS];
+
+			for (const uint32_t* triangle = first; triangle < last; ++triangle)
+			{
+				SBin& bin = bins[Bin(*triangle, axis)];
+				bin.m_Box.Grow(triangles[*triangle].m_Box);
+				++bin.m_Count;
+			}
+
+			SBin above[BINS];
+
+			for (size_t s = BINS - 1; s > 0; --s)
+			{
+				above[s - 1] = s < BINS - 1 ? above[s] : SBin();
+				above[s - 1].m_Box.Grow(bins[s].m_Box);
+				above[s - 1].m_Count += bins[s].m_Count;
+			}
+
+			SBin below;
+
+			for (size_t s = 0; s + 1 < BINS; ++s)
+			{
+				below.m_Box.Grow(bins[s].m_Box);
+				below.m_Count += bins[s].m_Count;
+
+				if (below.m_Count == 0 || above[s].m_Count == 0)
+				{
+					continue;
+				}
+
+				const float cost = below.m_Box.Area() * below.m_Count + above[s].m_Box.Area() * above[s].m_Count;
+
+				if (cost < best_cost)
+				{
+					best_cost = cost;
+					best_axis = axis;
+					best_split = s;
+				}
+			}
+		}
+
+		// Every centroid in the same place, any split is as good as another
+		uint32_t below_count = task.m_Count / 2;
+
+		if (best_axis >= 0)
+		{
+			below_count = uint32_t(std::partition(first, last, [&](uint32_t triangle) { return Bin(triangle, best_axis) <= best_split; }) - first);
+		}
+
+		node.m_First = uint32_t(bvh.m_Nodes.size());
+		node.m_Count = 0;
+		bvh.m_Nodes[task.m_Node] = node;
+		bvh.m_Nodes.emplace_back();
+		bvh.m_Nodes.emplace_back();
+
+		tasks.push_back({ node.m_First, task.m_First, below_count, task.m_Depth + 1 });
+		tasks.push_back({ node.m_First + 1, task.m_First + below_count, task.m_Count - below_count, task.m_Depth + 1 });
+	}
+}
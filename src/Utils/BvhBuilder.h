@@ -0,0 +1,19 @@
+#pragma once
+
+namespace NRender
+{
+struct SMesh;
+}
+
+namespace NUtils
+{
+/**
+ * Builds the mesh's bounding volume hierarchy over the full detail triangles of
+ * every submesh, top down, splitting at the cheapest of 16 bins per axis by the
+ * surface area heuristic until leaves hold at most four triangles, so every leaf
+ * is a single block. Triangles aren't reordered, but the tree copies positions
+ * and refers to triangles by where their indices start, so it has to be rebuilt
+ * after anything moving vertices or reordering triangles, BuildMeshlets included.
+ **/
+void BuildBvh(NRender::SMesh& mesh);
+}  // namespace NUtils
@@ -0,0 +1,629 @@
+#include "CookedMesh.h"
+#include "AssetArchive.h"
+#include "MeshBounds.h"
+#include "TextureCache.h"
+
+#include <Engine/Render/Material.h>
+#include <Engine/Render/Mesh.h>
+#include <Engine/Render/Texture.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+constexpr uint32_t MakeFourCC(const char (&code)[5])
+{
+	return uint32_t(code[0]) | (uint32_t(code[1]) << 8) | (uint32_t(code[2]) << 16) | (uint32_t(code[3]) << 24);
+}
+
+constexpr uint32_t COOKED_MAGIC = MakeFourCC("SKMH");
+constexpr uint32_t COOKED_VERSION = 6;
+constexpr size_t COOKED_ALIGNMENT = 16;
+constexpr uint32_t COOKED_NO_STRING = UINT32_MAX;
+
+constexpr uint32_t CHUNK_VERTICES = MakeFourCC("VRTX");
+constexpr uint32_t CHUNK_PACKED_VERTICES = MakeFourCC("PVTX");
+constexpr uint32_t CHUNK_INDICES = MakeFourCC("INDX");
+constexpr uint32_t CHUNK_SUBMESHES = MakeFourCC("SUBM");
+constexpr uint32_t CHUNK_LODS = MakeFourCC("LODS");
+constexpr uint32_t CHUNK_MESHLETS = MakeFourCC("MSHL");
+constexpr uint32_t CHUNK_BVH_NODES = MakeFourCC("BVHN");
+constexpr uint32_t CHUNK_BVH_BLOCKS = MakeFourCC("BVHB");
+constexpr uint32_t CHUNK_MATERIALS = MakeFourCC("MATL");
+constexpr uint32_t CHUNK_STRINGS = MakeFourCC("STRS");
+
+struct SHeader
+{
+	uint32_t m_Magic;
+	uint32_t m_Version;
+	uint32_t m_ChunkCount;
+	uint32_t m_Reserved;
+};
+
+struct SChunk
+{
+	uint32_t m_ID;
+	uint32_t m_Stride;
+	uint64_t m_Offset;
+	uint64_t m_Size;
+};
+
+struct SSubMeshRecord
+{
+	uint64_t m_VertexOffset;
+	uint64_t m_VertexCount;
+	uint64_t m_IndexOffset;
+	uint64_t m_IndexCount;
+	uint32_t m_Material;
+	uint32_t m_Name;
+	float m_QuantizationOffset[3];
+	float m_QuantizationScale[3];
+	float m_BoundsMin[3];
+	float m_BoundsMax[3];
+	float m_BoundsCenter[3];
+	float m_BoundsRadius;
+	uint32_t m_FirstLod;
+	uint32_t m_LodCount;
+	uint32_t m_FirstMeshlet;
+	uint32_t m_MeshletCount;
+};
+
+struct SLodRecord
+{
+	uint64_t m_IndexOffset;
+	uint64_t m_IndexCount;
+	float m_Error;
+	uint32_t m_Reserved;
+};
+
+struct SMeshletRecord
+{
+	uint32_t m_IndexOffset;
+	uint32_t m_IndexCount;
+	float m_Center[3];
+	float m_Radius;
+	float m_Axis[3];
+	float m_Cutoff;
+};
+
+struct SMaterialRecord
+{
+	uint32_t m_Name;
+	uint32_t m_AlbedoTexture;
+	uint32_t m_DetailTexture;
+	uint32_t m_Reserved;
+};
+
+size_t Align(size_t value)
+{
+	return (value + COOKED_ALIGNMENT - 1) & ~(COOKED_ALIGNMENT - 1);
+}
+
+class CStringTable
+{
+public:
+	uint32_t Add(const std::string& value)
+	{
+		uint32_t offset = m_Buffer.size();
+		m_Buffer.insert(m_Buffer.end(), value.begin(), value.end());
+		m_Buffer.push_back('\0');
+		return offset;
+	}
+
+	uint32_t Add(const NRender::HTexture& texture)
+	{
+		return texture ? Add(texture->m_Name) : COOKED_NO_STRING;
+	}
+
+	const std::vector<char>& Buffer() const { return m_Buffer; }
+
+private:
+	std::vector<char> m_Buffer;
+};
+
+const SChunk* FindChunk(const SChunk* chunks, uint32_t chunk_count, uint32_t id)
+{
+	for (uint32_t i = 0; i < chunk_count; ++i)
+	{
+		if (chunks[i].m_ID == id)
+		{
+			return &chunks[i];
+		}
+	}
+
+	return nullptr;
+}
+}  // namespace
+
+bool NUtils::CookMesh(const NRender::SMesh& mesh, std::vector<uint8_t>& blob)
+{
+	// Flatten submeshes, materials and their strings
+	CStringTable strings;
+	std::vector<SSubMeshRecord> sub_meshes(mesh.m_SubMeshes.size());
+	std::vector<SLodRecord> lods;
+	std::vector<SMeshletRecord> meshlets(mesh.m_Meshlets.Size());
+	std::vector<SMaterialRecord> materials(mesh.m_Materials.size());
+
+	for (size_t i = 0; i < mesh.m_SubMeshes.size(); ++i)
+	{
+		const NRender::SMesh::SSubMesh& sub_mesh = mesh.m_SubMeshes[i];
+		sub_meshes[i] = {
+			sub_mesh.m_VertexOffset, sub_mesh.m_VertexCount, sub_mesh.m_IndexOffset, sub_mesh.m_IndexCount, uint32_t(sub_mesh.m_Material), strings.Add(sub_mesh.m_Name),
+			{ sub_mesh.m_QuantizationOffset.m_X, sub_mesh.m_QuantizationOffset.m_Y, sub_mesh.m_QuantizationOffset.m_Z },
+			{ sub_mesh.m_QuantizationScale.m_X, sub_mesh.m_QuantizationScale.m_Y, sub_mesh.m_QuantizationScale.m_Z },
+			{ sub_mesh.m_Bounds.m_Min.m_X, sub_mesh.m_Bounds.m_Min.m_Y, sub_mesh.m_Bounds.m_Min.m_Z },
+			{ sub_mesh.m_Bounds.m_Max.m_X, sub_mesh.m_Bounds.m_Max.m_Y, sub_mesh.m_Bounds.m_Max.m_Z },
+			{ sub_mesh.m_Bounds.m_Center.m_X, sub_mesh.m_Bounds.m_Center.m_Y, sub_mesh.m_Bounds.m_Center.m_Z },
+			sub_mesh.m_Bounds.m_Radius,
+			uint32_t(lods.size()),
+			uint32_t(sub_mesh.m_Lods.size()),
+			uint32_t(sub_mesh.m_FirstMeshlet),
+			uint32_t(sub_mesh.m_MeshletCount),
+		};
+
+		for (const NRender::SMesh::SLod& lod : sub_mesh.m_Lods)
+		{
+			lods.push_back({ lod.m_IndexOffset, lod.m_IndexCount, lod.m_Error, 0 });
+		}
+	}
+
+	for (size_t i = 0; i < meshlets.size(); ++i)
+	{
+		const NRender::SMesh::SMeshlets& source = mesh.m_Meshlets;
+		meshlets[i] = {
+			source.m_IndexOffset[i], source.m_IndexCount[i],
+			{ source.m_CenterX[i], source.m_CenterY[i], source.m_CenterZ[i] }, source.m_Radius[i],
+			{ source.m_AxisX[i], source.m_AxisY[i], source.m_AxisZ[i] }, source.m_Cutoff[i],
+		};
+	}
+
+	for (size_t i = 0; i < mesh.m_Materials.size(); ++i)
+	{
+		const NRender::HMaterial& material = mesh.m_Materials[i];
+
+		if (material == nullptr)
+		{
+			materials[i] = { COOKED_NO_STRING, COOKED_NO_STRING, COOKED_NO_STRING, 0 };
+			continue;
+		}
+
+		materials[i] = { strings.Add(material->m_Name), strings.Add(material->m_AlbedoTexture), strings.Add(material->m_DetailTexture), 0 };
+	}
+
+	// Lay out the chunks
+	struct SChunkSource
+	{
+		uint32_t m_ID;
+		uint32_t m_Stride;
+		const void* m_Data;
+		size_t m_Size;
+	};
+
+	// Only the vertex layout the mesh is in gets written
+	const bool packed = mesh.m_VertexFormat == NRender::EVertexFormat::Packed;
+
+	const SChunkSource sources[] = {
+		packed ? SChunkSource{ CHUNK_PACKED_VERTICES, sizeof(NRender::SMesh::SPackedVertexData), mesh.m_PackedVertices.data(), mesh.m_PackedVertices.size() * sizeof(NRender::SMesh::SPackedVertexData) }
+			   : SChunkSource{ CHUNK_VERTICES, sizeof(NRender::SMesh::SVertexData), mesh.m_Vertices.data(), mesh.m_Vertices.size() * sizeof(NRender::SMesh::SVertexData) },
+		{ CHUNK_INDICES, sizeof(uint32_t), mesh.m_Indices.data(), mesh.m_Indices.size() * sizeof(uint32_t) },
+		{ CHUNK_SUBMESHES, sizeof(SSubMeshRecord), sub_meshes.data(), sub_meshes.size() * sizeof(SSubMeshRecord) },
+		{ CHUNK_LODS, sizeof(SLodRecord), lods.data(), lods.size() * sizeof(SLodRecord) },
+		{ CHUNK_MESHLETS, sizeof(SMeshletRecord), meshlets.data(), meshlets.size() * sizeof(SMeshletRecord) },
+		{ CHUNK_BVH_NODES, sizeof(NRender::SMesh::SBvh::SNode), mesh.m_Bvh.m_Nodes.data(), mesh.m_Bvh.m_Nodes.size() * sizeof(NRender::SMesh::SBvh::SNode) },
+		{ CHUNK_BVH_BLOCKS, sizeof(NRender::SMesh::SBvh::STriangleBlock), mesh.m_Bvh.m_Blocks.data(), mesh.m_Bvh.m_Blocks.size() * sizeof(NRender::SMesh::SBvh::STriangleBlock) },
+		{ CHUNK_MATERIALS, sizeof(SMaterialRecord), materials.data(), materials.size() * sizeof(SMaterialRecord) },
+		{ CHUNK_STRINGS, sizeof(char), strings.Buffer().data(), strings.Buffer().size() },
+	};
+	constexpr uint32_t chunk_count = sizeof(sources) / sizeof(sources[0]);
+
+	size_t offset = Align(sizeof(SHeader) + sizeof(SChunk) * chunk_count);
+	SChunk chunks[chunk_count];
+
+	for (uint32_t i = 0; i < chunk_count; ++i)
+	{
+		chunks[i] = { sources[i].m_ID, sources[i].m_Stride, offset, sources[i].m_Size };
+		offset = Align(offset + sources[i].m_Size);
+	}
+
+	// Write everything out, padding is zeroed so output is deterministic
+	blob.assign(offset, 0);
+
+	const SHeader header = { COOKED_MAGIC, COOKED_VERSION, chunk_count, 0 };
+	memcpy(blob.data(), &header, sizeof(header));
+	memcpy(blob.data() + sizeof(header), chunks, sizeof(chunks));
+
+	for (uint32_t i = 0; i < chunk_count; ++i)
+	{
+		if (sources[i].m_Size > 0)
+		{
+			memcpy(blob.data() + chunks[i].m_Offset, sources[i].m_Data, sources[i].m_Size);
+		}
+	}
+
+	return true;
+}
+
+bool NUtils::SaveCookedMesh(const char* filename, const NRender::SMesh& mesh)
+{
+	std::vector<uint8_t> blob;
+
+	if (!CookMesh(mesh, blob))
+	{
+		return false;
+	}
+
+	FILE* file = fopen(filename, "wb");
+
+	if (!file)
+	{
+		printf("Failed to open cooked mesh for writing: %s\n", filename);
+		return false;
+	}
+
+	const bool written = fwrite(blob.data(), 1, blob.size(), file) == blob.size();
+	fclose(file);
+
+	if (!written)
+	{
+		printf("Failed to write cooked mesh: %s\n", filename);
+	}
+
+	return written;
+}
+
+bool NUtils::LoadCookedMesh(const uint8_t* data, size_t size, NRender::SMesh& mesh, const TextureLoader& load_texture)
+{
+	// Validate the header and chunk directory
+	SHeader header;
+
+	if (size < sizeof(header))
+	{
+		printf("Cooked mesh is truncated\n");
+		return false;
+	}
+
+	memcpy(&header, data, sizeof(header));
+
+	if (header.m_Magic != COOKED_MAGIC || header.m_Version != COOKED_VERSION)
+	{
+		printf("Cooked mesh has an unsupported format: %08x v%u\n", header.m_Magic, header.m_Version);
+		return false;
+	}
+
+	if (size < sizeof(header) + sizeof(SChunk) * size_t(header.m_ChunkCount))
+	{
+		printf("Cooked mesh is truncated\n");
+		return false;
+	}
+
+	std::vector<SChunk> chunks(header.m_ChunkCount);
+	memcpy(chunks.data(), data + sizeof(header), sizeof(SChunk) * chunks.size());
+
+	for (const SChunk& chunk : chunks)
+	{
+		if (chunk.m_Offset > size || chunk.m_Size > size - chunk.m_Offset || (chunk.m_Stride && chunk.m_Size % chunk.m_Stride))
+		{
+			printf("Cooked mesh has a corrupt chunk: %08x\n", chunk.m_ID);
+			return false;
+		}
+	}
+
+	const SChunk* vertices = FindChunk(chunks.data(), header.m_ChunkCount, CHUNK_VERTICES);
+	const SChunk* packed_vertices = FindChunk(chunks.data(), header.m_ChunkCount, CHUNK_PACKED_VERTICES);
+	const SChunk* indices = FindChunk(chunks.data(), header.m_ChunkCount, CHUNK_INDICES);
+	const SChunk* sub_meshes = FindChunk(chunks.data(), header.m_ChunkCount, CHUNK_SUBMESHES);
+	const SChunk* lods = FindChunk(chunks.data(), header.m_ChunkCount, CHUNK_LODS);
+	const SChunk* meshlets = FindChunk(chunks.data(), header.m_ChunkCount, CHUNK_MESHLETS);
+	const SChunk* bvh_nodes = FindChunk(chunks.data(), header.m_ChunkCount, CHUNK_BVH_NODES);
+	const SChunk* bvh_blocks = FindChunk(chunks.data(), header.m_ChunkCount, CHUNK_BVH_BLOCKS);
+	const SChunk* materials = FindChunk(chunks.data(), header.m_ChunkCount, CHUNK_MATERIALS);
+	const SChunk* strings = FindChunk(chunks.data(), header.m_ChunkCount, CHUNK_STRINGS);
+
+	if (!(vertices || packed_vertices) || !indices || !sub_meshes || !lods || !meshlets || !bvh_nodes || !bvh_blocks || !materials || !strings)
+	{
+		printf("Cooked mesh is missing chunks\n");
+		return false;
+	}
+
+	if ((vertices && vertices->m_Stride != sizeof(NRender::SMesh::SVertexData)) ||
+		(packed_vertices && packed_vertices->m_Stride != sizeof(NRender::SMesh::SPackedVertexData)) ||
+		indices->m_Stride != sizeof(uint32_t) ||
+		sub_meshes->m_Stride != sizeof(SSubMeshRecord) || lods->m_Stride != sizeof(SLodRecord) ||
+		meshlets->m_Stride != sizeof(SMeshletRecord) || materials->m_Stride != sizeof(SMaterialRecord) ||
+		bvh_nodes->m_Stride != sizeof(NRender::SMesh::SBvh::SNode) || bvh_blocks->m_Stride != sizeof(NRender::SMesh::SBvh::STriangleBlock))
+	{
+		printf("Cooked mesh layout does not match this build\n");
+		return false;
+	}
+
+	// String lookups are bounds checked and must be terminated within the table
+	const char* string_data = reinterpret_cast<const char*>(data + strings->m_Offset);
+
+	auto GetString = [&](uint32_t offset, std::string& value) -> bool {
+		if (offset == COOKED_NO_STRING)
+		{
+			return false;
+		}
+
+		if (offset >= strings->m_Size || !memchr(string_data + offset, '\0', strings->m_Size - offset))
+		{
+			return false;
+		}
+
+		value = string_data + offset;
+		return true;
+	};
+
+	// Geometry is copied straight into place
+	size_t vertex_count = 0;
+
+	if (vertices)
+	{
+		mesh.m_VertexFormat = NRender::EVertexFormat::Float;
+		mesh.m_Vertices.resize(vertices->m_Size / sizeof(NRender::SMesh::SVertexData));
+		memcpy(mesh.m_Vertices.data(), data + vertices->m_Offset, vertices->m_Size);
+		mesh.m_PackedVertices.clear();
+		vertex_count = mesh.m_Vertices.size();
+	}
+	else
+	{
+		mesh.m_VertexFormat = NRender::EVertexFormat::Packed;
+		mesh.m_PackedVertices.resize(packed_vertices->m_Size / sizeof(NRender::SMesh::SPackedVertexData));
+		memcpy(mesh.m_PackedVertices.data(), data + packed_vertices->m_Offset, packed_vertices->m_Size);
+		mesh.m_Vertices.clear();
+		vertex_count = mesh.m_PackedVertices.size();
+	}
+
+	mesh.m_Indices.resize(indices->m_Size / sizeof(uint32_t));
+	memcpy(mesh.m_Indices.data(), data + indices->m_Offset, indices->m_Size);
+
+	// Materials resolve their textures through the loader, the distinct paths are decoded as one batch
+	std::vector<std::string> texture_paths;
+	std::unordered_map<std::string, size_t> texture_indices;
+
+	auto GetTextureIndex = [&](uint32_t offset) -> size_t {
+		std::string path;
+
+		if (!GetString(offset, path))
+		{
+			return SIZE_MAX;
+		}
+
+		const auto inserted = texture_indices.emplace(path, texture_paths.size());
+
+		if (inserted.second)
+		{
+			texture_paths.push_back(path);
+		}
+
+		return inserted.first->second;
+	};
+
+	const size_t material_count = materials->m_Size / sizeof(SMaterialRecord);
+	std::vector<std::pair<size_t, size_t>> material_textures(material_count);
+	mesh.m_Materials.resize(material_count);
+
+	for (size_t i = 0; i < material_count; ++i)
+	{
+		SMaterialRecord record;
+		memcpy(&record, data + materials->m_Offset + i * sizeof(record), sizeof(record));
+
+		NRender::HMaterial material = std::make_shared<NRender::SMaterial>();
+		GetString(record.m_Name, material->m_Name);
+		material_textures[i] = { GetTextureIndex(record.m_AlbedoTexture), GetTextureIndex(record.m_DetailTexture) };
+		mesh.m_Materials[i] = material;
+	}
+
+	// Ranges are checked without adding untrusted values, which could wrap around
+	auto InRange = [](uint64_t offset, uint64_t count, uint64_t size) {
+		return offset <= size && count <= size - offset;
+	};
+
+	// Every index of a range has to name a vertex of the submesh it's drawn with
+	auto IndicesInRange = [&](uint64_t offset, uint64_t count, uint64_t first_vertex, uint64_t vertex_count) {
+		for (uint64_t i = offset; i < offset + count; ++i)
+		{
+			if (mesh.m_Indices[i] < first_vertex || mesh.m_Indices[i] - first_vertex >= vertex_count)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	};
+
+	// Submeshes are validated against the geometry they reference
+	const size_t sub_mesh_count = sub_meshes->m_Size / sizeof(SSubMeshRecord);
+	const size_t lod_count = lods->m_Size / sizeof(SLodRecord);
+	const size_t meshlet_count = meshlets->m_Size / sizeof(SMeshletRecord);
+	mesh.m_SubMeshes.resize(sub_mesh_count);
+	mesh.m_Meshlets.Resize(meshlet_count);
+
+	for (size_t i = 0; i < sub_mesh_count; ++i)
+	{
+		SSubMeshRecord record;
+		memcpy(&record, data + sub_meshes->m_Offset + i * sizeof(record), sizeof(record));
+
+		if (!InRange(record.m_VertexOffset, record.m_VertexCount, vertex_count) ||
+			!InRange(record.m_IndexOffset, record.m_IndexCount, mesh.m_Indices.size()) ||
+			!IndicesInRange(record.m_IndexOffset, record.m_IndexCount, record.m_VertexOffset, record.m_VertexCount) ||
+			record.m_Material >= material_count ||
+			!InRange(record.m_FirstLod, record.m_LodCount, lod_count) ||
+			!InRange(record.m_FirstMeshlet, record.m_MeshletCount, meshlet_count))
+		{
+			printf("Cooked mesh has a corrupt submesh: %zu\n", i);
+			return false;
+		}
+
+		NRender::SMesh::SSubMesh& sub_mesh = mesh.m_SubMeshes[i];
+		GetString(record.m_Name, sub_mesh.m_Name);
+		sub_mesh.m_VertexOffset = record.m_VertexOffset;
+		sub_mesh.m_VertexCount = record.m_VertexCount;
+		sub_mesh.m_IndexOffset = record.m_IndexOffset;
+		sub_mesh.m_IndexCount = record.m_IndexCount;
+		sub_mesh.m_Material = record.m_Material;
+		sub_mesh.m_QuantizationOffset = { record.m_QuantizationOffset[0], record.m_QuantizationOffset[1], record.m_QuantizationOffset[2] };
+		sub_mesh.m_QuantizationScale = { record.m_QuantizationScale[0], record.m_QuantizationScale[1], record.m_QuantizationScale[2] };
+		sub_mesh.m_Bounds.m_Min = { record.m_BoundsMin[0], record.m_BoundsMin[1], record.m_BoundsMin[2] };
+		sub_mesh.m_Bounds.m_Max = { record.m_BoundsMax[0], record.m_BoundsMax[1], record.m_BoundsMax[2] };
+		sub_mesh.m_Bounds.m_Center = { record.m_BoundsCenter[0], record.m_BoundsCenter[1], record.m_BoundsCenter[2] };
+		sub_mesh.m_Bounds.m_Radius = record.m_BoundsRadius;
+		sub_mesh.m_Lods.resize(record.m_LodCount);
+
+		for (uint32_t l = 0; l < record.m_LodCount; ++l)
+		{
+			SLodRecord lod;
+			memcpy(&lod, data + lods->m_Offset + (size_t(record.m_FirstLod) + l) * sizeof(lod), sizeof(lod));
+
+			if (!InRange(lod.m_IndexOffset, lod.m_IndexCount, mesh.m_Indices.size()) ||
+				!IndicesInRange(lod.m_IndexOffset, lod.m_IndexCount, record.m_VertexOffset, record.m_VertexCount))
+			{
+				printf("Cooked mesh has a corrupt level of detail: %zu\n", i);
+				return false;
+			}
+
+			sub_mesh.m_Lods[l] = { lod.m_IndexOffset, lod.m_IndexCount, lod.m_Error };
+		}
+
+		// Clusters have to stay within the full detail range they cull
+		sub_mesh.m_FirstMeshlet = record.m_FirstMeshlet;
+		sub_mesh.m_MeshletCount = record.m_MeshletCount;
+
+		for (size_t m = sub_mesh.m_FirstMeshlet; m < sub_mesh.m_FirstMeshlet + sub_mesh.m_MeshletCount; ++m)
+		{
+			SMeshletRecord meshlet;
+			memcpy(&meshlet, data + meshlets->m_Offset + m * sizeof(meshlet), sizeof(meshlet));
+
+			if (meshlet.m_IndexOffset < sub_mesh.m_IndexOffset || !InRange(meshlet.m_IndexOffset - sub_mesh.m_IndexOffset, meshlet.m_IndexCount, sub_mesh.m_IndexCount))
+			{
+				printf("Cooked mesh has a corrupt meshlet: %zu\n", m);
+				return false;
+			}
+
+			NRender::SMesh::SMeshlets& target = mesh.m_Meshlets;
+			target.m_IndexOffset[m] = meshlet.m_IndexOffset;
+			target.m_IndexCount[m] = meshlet.m_IndexCount;
+			target.m_CenterX[m] = meshlet.m_Center[0];
+			target.m_CenterY[m] = meshlet.m_Center[1];
+			target.m_CenterZ[m] = meshlet.m_Center[2];
+			target.m_Radius[m] = meshlet.m_Radius;
+			target.m_AxisX[m] = meshlet.m_Axis[0];
+			target.m_AxisY[m] = meshlet.m_Axis[1];
+			target.m_AxisZ[m] = meshlet.m_Axis[2];
+			target.m_Cutoff[m] = meshlet.m_Cutoff;
+		}
+	}
+
+	// The tree is copied as is, but every child, block and triangle it points to has to exist
+	NRender::SMesh::SBvh& bvh = mesh.m_Bvh;
+	bvh.m_Nodes.resize(bvh_nodes->m_Size / sizeof(NRender::SMesh::SBvh::SNode));
+	memcpy(bvh.m_Nodes.data(), data + bvh_nodes->m_Offset, bvh_nodes->m_Size);
+	bvh.m_Blocks.resize(bvh_blocks->m_Size / sizeof(NRender::SMesh::SBvh::STriangleBlock));
+	memcpy(bvh.m_Blocks.data(), data + bvh_blocks->m_Offset, bvh_blocks->m_Size);
+
+	// Parents hand their depth down before their children are checked, raycasts only have stack for so many levels
+	std::vector<uint8_t> depths(bvh.m_Nodes.size(), 0);
+
+	for (size_t i = 0; i < bvh.m_Nodes.size(); ++i)
+	{
+		const NRender::SMesh::SBvh::SNode& node = bvh.m_Nodes[i];
+
+		// Children always follow their parent, which also rules out cycles
+		const bool valid = node.m_Count == 0 ? node.m_First > i && InRange(node.m_First, 2, bvh.m_Nodes.size()) && depths[i] < NRender::SMesh::SBvh::MaxDepth
+											 : InRange(node.m_First, (uint64_t(node.m_Count) + 3) / 4, bvh.m_Blocks.size());
+
+		if (!valid)
+		{
+			printf("Cooked mesh has a corrupt bvh node: %zu\n", i);
+			return false;
+		}
+
+		if (node.m_Count == 0)
+		{
+			depths[node.m_First] = std::max<uint8_t>(depths[node.m_First], depths[i] + 1);
+			depths[node.m_First + 1] = std::max<uint8_t>(depths[node.m_First + 1], depths[i] + 1);
+		}
+	}
+
+	for (const NRender::SMesh::SBvh::STriangleBlock& block : bvh.m_Blocks)
+	{
+		for (uint32_t index : block.m_Index)
+		{
+			if (index != NRender::SMesh::SBvh::NoTriangle && !InRange(index, 3, mesh.m_Indices.size()))
+			{
+				printf("Cooked mesh has a corrupt bvh triangle: %u\n", index);
+				return false;
+			}
+		}
+	}
+
+	// Decoding is the bulk of the load, so textures only go through the loader once nothing else can fail
+	const std::vector<NRender::HTexture> textures = LoadTextures(texture_paths, load_texture);
+
+	for (size_t i = 0; i < material_count; ++i)
+	{
+		const std::pair<size_t, size_t>& indices = material_textures[i];
+		mesh.m_Materials[i]->m_AlbedoTexture = indices.first != SIZE_MAX ? textures[indices.first] : nullptr;
+		mesh.m_Materials[i]->m_DetailTexture = indices.second != SIZE_MAX ? textures[indices.second] : nullptr;
+	}
+
+	// Mesh bounds are cheap to rebuild from the submeshes
+	UpdateMeshBounds(mesh);
+
+	return true;
+}
+
+std::string NUtils::GetCookedMeshPath(const std::string& path)
+{
+	const size_t extension = path.find_last_of('.');
+	const size_t directory = path.find_last_of("/\\");
+
+	if (extension == std::string::npos || (directory != std::string::npos && extension < directory))
+	{
+		return path + ".mesh";
+	}
+
+	return path.substr(0, extension) + ".mesh";
+}
+
+bool NUtils::LoadCookedMesh(const char* filename, NRender::SMesh& mesh, const TextureLoader& load_texture)
+{
+	// The mounted archive serves the blob without reading or copying it
+	SAssetSlice slice;
+
+	if (CAssetArchive::Instance().Open(filename, slice))
+	{
+		return LoadCookedMesh(slice.m_Data.get(), slice.m_Size, mesh, load_texture);
+	}
+
+	FILE* file = fopen(filename, "rb");
+
+	if (!file)
+	{
+		return false;
+	}
+
+	// Get file size
+	fseek(file, 0, SEEK_END);
+	size_t file_size = ftell(file);
+
+	// Read file contents
+	std::vector<uint8_t> blob(file_size);
+	rewind(file);
+	const bool read = fread(blob.data(), 1, file_size, file) == file_size;
+	fclose(file);
+
+	if (!read)
+	{
+		printf("Failed to read cooked mesh: %s\n", filename);
+		return false;
+	}
+
+	return LoadCookedMesh(blob.data(), blob.size(), mesh, load_texture);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "TextureLoader.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+namespace NRender
+{
+struct SMesh;
+}
+
+namespace NUtils
+{
+/**
+ * Cooked meshes are a flat little-endian blob: a header, a chunk directory and
+ * 16 byte aligned chunks. Vertices and indices are stored exactly as they sit in
+ * SMesh so loading them is a single copy, materials only store texture paths.
+ **/
+bool CookMesh(const NRender::SMesh& mesh, std::vector<uint8_t>& blob);
+bool SaveCookedMesh(const char* filename, const NRender::SMesh& mesh);
+
+bool LoadCookedMesh(const uint8_t* data, size_t size, NRender::SMesh& mesh, const TextureLoader& load_texture = nullptr);
+bool LoadCookedMesh(const char* filename, NRender::SMesh& mesh, const TextureLoader& load_texture = nullptr);
+
+// Cooked meshes sit next to their source with a .mesh extension
+std::string GetCookedMeshPath(const std::string& path);
+}  // namespace NUtils
@@ -0,0 +1,270 @@
+#include "CookedTexture.h"
+#include "AssetArchive.h"
+
+#include <Engine/Render/Texture.h>
+
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+constexpr uint32_t MakeFourCC(const char (&code)[5])
+{
+	return uint32_t(code[0]) | (uint32_t(code[1]) << 8) | (uint32_t(code[2]) << 16) | (uint32_t(code[3]) << 24);
+}
+
+constexpr uint32_t COOKED_MAGIC = MakeFourCC("SKTX");
+constexpr uint32_t COOKED_VERSION = 1;
+constexpr size_t COOKED_ALIGNMENT = 16;
+
+struct SHeader
+{
+	uint32_t m_Magic;
+	uint32_t m_Version;
+	uint16_t m_Width;
+	uint16_t m_Height;
+	uint8_t m_Format;
+	uint8_t m_Reserved[3];
+	uint32_t m_LevelCount;
+	uint32_t m_Reserved2;
+};
+
+struct SLevelRecord
+{
+	uint16_t m_Width;
+	uint16_t m_Height;
+	uint32_t m_Reserved;
+	uint64_t m_Offset;
+	uint64_t m_Size;
+};
+
+size_t Align(size_t value)
+{
+	return (value + COOKED_ALIGNMENT - 1) & ~(COOKED_ALIGNMENT - 1);
+}
+
+// Validates the header and level directory, the levels are left at their offsets into the blob
+bool ReadLevels(const uint8_t* data, size_t size, NRender::STexture& texture)
+{
+	SHeader header;
+
+	if (size < sizeof(header))
+	{
+		printf("Cooked texture is truncated\n");
+		return false;
+	}
+
+	memcpy(&header, data, sizeof(header));
+
+	if (header.m_Magic != COOKED_MAGIC || header.m_Version != COOKED_VERSION)
+	{
+		printf("Cooked texture has an unsupported format: %08x v%u\n", header.m_Magic, header.m_Version);
+		return false;
+	}
+
+	if (header.m_Format > uint8_t(NRender::ETextureFormat::EAC_RG11) || header.m_LevelCount == 0 ||
+		size < sizeof(header) + sizeof(SLevelRecord) * size_t(header.m_LevelCount))
+	{
+		printf("Cooked texture is corrupt\n");
+		return false;
+	}
+
+	std::vector<SLevelRecord> levels(header.m_LevelCount);
+	memcpy(levels.data(), data + sizeof(header), sizeof(SLevelRecord) * levels.size());
+
+	texture.m_Width = header.m_Width;
+	texture.m_Height = header.m_Height;
+	texture.m_Format = NRender::ETextureFormat(header.m_Format);
+	texture.m_Levels.resize(levels.size());
+
+	// Each level is checked against the size its format needs
+	for (size_t i = 0; i < levels.size(); ++i)
+	{
+		const SLevelRecord& record = levels[i];
+
+		if (record.m_Offset > size || record.m_Size > size - record.m_Offset ||
+			record.m_Size != NRender::LevelSize(texture.m_Format, record.m_Width, record.m_Height))
+		{
+			printf("Cooked texture has a corrupt level: %zu\n", i);
+			return false;
+		}
+
+		texture.m_Levels[i] = { record.m_Width, record.m_Height, size_t(record.m_Offset), size_t(record.m_Size) };
+	}
+
+	return true;
+}
+}  // namespace
+
+bool NUtils::CookTexture(const NRender::STexture& texture, std::vector<uint8_t>& blob)
+{
+	if (texture.m_Levels.empty())
+	{
+		printf("Texture has no levels to cook: %s\n", texture.m_Name.c_str());
+		return false;
+	}
+
+	// Lay out the levels
+	std::vector<SLevelRecord> levels(texture.m_Levels.size());
+	size_t offset = Align(sizeof(SHeader) + sizeof(SLevelRecord) * levels.size());
+
+	for (size_t i = 0; i < levels.size(); ++i)
+	{
+		const NRender::STexture::SLevel& level = texture.m_Levels[i];
+
+		if (level.m_Offset > texture.DataSize() || level.m_Size > texture.DataSize() - level.m_Offset)
+		{
+			printf("Texture has a corrupt level: %s\n", texture.m_Name.c_str());
+			return false;
+		}
+
+		if (level.m_Pitch != 0)
+		{
+			printf("Texture rows have to be packed tightly to be cooked: %s\n", texture.m_Name.c_str());
+			return false;
+		}
+
+		levels[i] = { level.m_Width, level.m_Height, 0, offset, level.m_Size };
+		offset = Align(offset + level.m_Size);
+	}
+
+	// Write everything out, padding is zeroed so output is deterministic
+	blob.assign(offset, 0);
+
+	const SHeader header = { COOKED_MAGIC, COOKED_VERSION, texture.m_Width, texture.m_Height, uint8_t(texture.m_Format), {}, uint32_t(levels.size()), 0 };
+	memcpy(blob.data(), &header, sizeof(header));
+	memcpy(blob.data() + sizeof(header), levels.data(), sizeof(SLevelRecord) * levels.size());
+
+	for (size_t i = 0; i < levels.size(); ++i)
+	{
+		memcpy(blob.data() + levels[i].m_Offset, texture.Data() + texture.m_Levels[i].m_Offset, levels[i].m_Size);
+	}
+
+	return true;
+}
+
+bool NUtils::SaveCookedTexture(const char* filename, const NRender::STexture& texture)
+{
+	std::vector<uint8_t> blob;
+
+	if (!CookTexture(texture, blob))
+	{
+		return false;
+	}
+
+	FILE* file = fopen(filename, "wb");
+
+	if (!file)
+	{
+		printf("Failed to open cooked texture for writing: %s\n", filename);
+		return false;
+	}
+
+	const bool written = fwrite(blob.data(), 1, blob.size(), file) == blob.size();
+	fclose(file);
+
+	if (!written)
+	{
+		printf("Failed to write cooked texture: %s\n", filename);
+	}
+
+	return written;
+}
+
+bool NUtils::LoadCookedTexture(const uint8_t* data, size_t size, NRender::STexture& texture)
+{
+	if (!ReadLevels(data, size, texture))
+	{
+		return false;
+	}
+
+	// Levels are repacked back to back, leaving the header and padding behind
+	size_t buffer_size = 0;
+
+	for (const NRender::STexture::SLevel& level : texture.m_Levels)
+	{
+		buffer_size += level.m_Size;
+	}
+
+	texture.ReleasePixels();
+	texture.m_Buffer.resize(buffer_size);
+	buffer_size = 0;
+
+	for (NRender::STexture::SLevel& level : texture.m_Levels)
+	{
+		memcpy(texture.m_Buffer.data() + buffer_size, data + level.m_Offset, level.m_Size);
+		level.m_Offset = buffer_size;
+		buffer_size += level.m_Size;
+	}
+
+	return true;
+}
+
+std::string NUtils::GetCookedTexturePath(const std::string& path)
+{
+	const size_t extension = path.find_last_of('.');
+	const size_t directory = path.find_last_of("/\\");
+
+	if (extension == std::string::npos || (directory != std::string::npos && extension < directory))
+	{
+		return path + ".tex";
+	}
+
+	return path.substr(0, extension) + ".tex";
+}
+
+bool NUtils::LoadCookedTexture(const char* filename, NRender::STexture& texture)
+{
+	// Archived textures adopt their slice, the levels are used right where the archive has them
+	SAssetSlice slice;
+
+	if (CAssetArchive::Instance().Open(filename, slice))
+	{
+		texture.ReleasePixels();
+		texture.m_Name = filename;
+
+		if (!ReadLevels(slice.m_Data.get(), slice.m_Size, texture))
+		{
+			return false;
+		}
+
+		texture.m_Pixels = slice.m_Data;
+		texture.m_PixelsSize = slice.m_Size;
+		return true;
+	}
+
+	FILE* file = fopen(filename, "rb");
+
+	if (!file)
+	{
+		return false;
+	}
+
+	// Get file size
+	fseek(file, 0, SEEK_END);
+	size_t file_size = ftell(file);
+
+	// The file becomes the buffer, so the levels are used in place rather than copied out of it
+	texture.ReleasePixels();
+	texture.m_Buffer.resize(file_size);
+	rewind(file);
+	const bool read = fread(texture.m_Buffer.data(), 1, file_size, file) == file_size;
+	fclose(file);
+
+	if (!read)
+	{
+		printf("Failed to read cooked texture: %s\n", filename);
+		texture.ReleasePixels();
+		return false;
+	}
+
+	texture.m_Name = filename;
+
+	if (!ReadLevels(texture.m_Buffer.data(), texture.m_Buffer.size(), texture))
+	{
+		texture.ReleasePixels();
+		return false;
+	}
+
+	return true;
+}
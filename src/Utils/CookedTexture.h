@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+namespace NRender
+{
+struct STexture;
+}
+
+namespace NUtils
+{
+/**
+ * Cooked textures share the cooked mesh layout: a little-endian header, a level
+ * directory and 16 byte aligned level data, so every level uploads straight from
+ * the blob. Loading a file keeps the whole blob as the texture buffer and uses the
+ * levels in place, archived files aren't even copied out of the archive. The
+ * texture name isn't stored, loading sets it to the filename.
+ **/
+bool CookTexture(const NRender::STexture& texture, std::vector<uint8_t>& blob);
+bool SaveCookedTexture(const char* filename, const NRender::STexture& texture);
+
+bool LoadCookedTexture(const uint8_t* data, size_t size, NRender::STexture& texture);
+bool LoadCookedTexture(const char* filename, NRender::STexture& texture);
+
+// Cooked textures sit next to their source image with a .tex extension
+std::string GetCookedTexturePath(const std::string& path);
+}  // namespace NUtils
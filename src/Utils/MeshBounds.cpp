@@ -0,0 +1,90 @@
+#include "MeshBounds.h"
+#include "MeshQuantizer.h"
+
+#include <Engine/Math.h>
+#include <Engine/Render/Mesh.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+void SetBounds(NRender::SMesh::SBounds& bounds, const CVector3f& min, const CVector3f& max, const CVector3f& center, float radius)
+{
+	bounds.m_Min = { min.x(), min.y(), min.z() };
+	bounds.m_Max = { max.x(), max.y(), max.z() };
+	bounds.m_Center = { center.x(), center.y(), center.z() };
+	bounds.m_Radius = radius;
+}
+}  // namespace
+
+void NUtils::ComputeBounds(NRender::SMesh& mesh)
+{
+	for (NRender::SMesh::SSubMesh& sub_mesh : mesh.m_SubMeshes)
+	{
+		if (sub_mesh.m_VertexCount == 0)
+		{
+			sub_mesh.m_Bounds = {};
+			continue;
+		}
+
+		CVector3f min = CVector3f::Constant(std::numeric_limits<float>::max());
+		CVector3f max = CVector3f::Constant(std::numeric_limits<float>::lowest());
+
+		for (size_t v = sub_mesh.m_VertexOffset; v < sub_mesh.m_VertexOffset + sub_mesh.m_VertexCount; ++v)
+		{
+			const CVector3f position = GetVertexPosition(mesh, sub_mesh, v);
+			min = min.cwiseMin(position);
+			max = max.cwiseMax(position);
+		}
+
+		// The sphere shares the box center, which is tighter than half the diagonal for most shapes
+		const CVector3f center = (min + max) * 0.5f;
+		float radius_squared = 0.0f;
+
+		for (size_t v = sub_mesh.m_VertexOffset; v < sub_mesh.m_VertexOffset + sub_mesh.m_VertexCount; ++v)
+		{
+			radius_squared = std::max(radius_squared, (GetVertexPosition(mesh, sub_mesh, v) - center).squaredNorm());
+		}
+
+		SetBounds(sub_mesh.m_Bounds, min, max, center, std::sqrt(radius_squared));
+	}
+
+	UpdateMeshBounds(mesh);
+}
+
+void NUtils::UpdateMeshBounds(NRender::SMesh& mesh)
+{
+	CVector3f min = CVector3f::Constant(std::numeric_limits<float>::max());
+	CVector3f max = CVector3f::Constant(std::numeric_limits<float>::lowest());
+	bool empty = true;
+
+	for (const NRender::SMesh::SSubMesh& sub_mesh : mesh.m_SubMeshes)
+	{
+		if (sub_mesh.m_VertexCount > 0)
+		{
+			min = min.cwiseMin(CVector3f(&sub_mesh.m_Bounds.m_Min.m_X));
+			max = max.cwiseMax(CVector3f(&sub_mesh.m_Bounds.m_Max.m_X));
+			empty = false;
+		}
+	}
+
+	if (empty)
+	{
+		mesh.m_Bounds = {};
+		return;
+	}
+
+	const CVector3f center = (min + max) * 0.5f;
+	float radius = 0.0f;
+
+	for (const NRender::SMesh::SSubMesh& sub_mesh : mesh.m_SubMeshes)
+	{
+		if (sub_mesh.m_VertexCount > 0)
+		{
+			radius = std::max(radius, (CVector3f(&sub_mesh.m_Bounds.m_Center.m_X) - center).norm() + sub_mesh.m_Bounds.m_Radius);
+		}
+	}
+
+	SetBounds(mesh.m_Bounds, min, max, center, std::min(radius, (max - center).norm()));
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+namespace NRender
+{
+struct SMesh;
+}
+
+namespace NUtils
+{
+// Computes every submesh's bounds from its vertices, then the mesh bounds
+void ComputeBounds(NRender::SMesh& mesh);
+
+// Recomputes only the mesh bounds from the submesh bounds
+void UpdateMeshBounds(NRender::SMesh& mesh);
+}  // namespace NUtils
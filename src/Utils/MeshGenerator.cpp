@@ -0,0 +1,75 @@
+#include "MeshGenerator.h"
+#include "MeshBounds.h"
+
+#include <Engine/Math.h>
+#include <Engine/Render/Material.h>
+#include <Engine/Render/Mesh.h>
+
+#include <algorithm>
+#include <string>
+
+void NUtils::GenerateSphere(NRender::SMesh& mesh, size_t rings, size_t segments, size_t bands, float radius)
+{
+	rings = std::max<size_t>(rings, 2);
+	segments = std::max<size_t>(segments, 3);
+	bands = std::min(std::max<size_t>(bands, 1), rings);
+
+	mesh.m_Vertices.clear();
+	mesh.m_Indices.clear();
+	mesh.m_SubMeshes.clear();
+	mesh.m_Materials.assign(1, std::make_shared<NRender::SMaterial>());
+	mesh.m_Materials[0]->m_Name = "generated";
+
+	for (size_t band = 0; band < bands; ++band)
+	{
+		// Each band owns its rows so submeshes never share vertices
+		const size_t first_ring = band * rings / bands;
+		const size_t last_ring = (band + 1) * rings / bands;
+		const size_t row_size = segments + 1;
+
+		NRender::SMesh::SSubMesh sub_mesh;
+		sub_mesh.m_Name = "band" + std::to_string(band);
+		sub_mesh.m_VertexOffset = mesh.m_Vertices.size();
+		sub_mesh.m_IndexOffset = mesh.m_Indices.size();
+
+		for (size_t ring = first_ring; ring <= last_ring; ++ring)
+		{
+			const float v = float(ring) / float(rings);
+			const float theta = v * float(M_PI);
+
+			for (size_t segment = 0; segment <= segments; ++segment)
+			{
+				const float u = float(segment) / float(segments);
+				const float phi = u * 2.0f * float(M_PI);
+
+				const CVector3f normal(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+				const CVector3f tangent(-std::sin(phi), 0.0f, std::cos(phi));
+
+				NRender::SMesh::SVertexData vertex_data;
+				vertex_data.m_Position = { normal.x() * radius, normal.y() * radius, normal.z() * radius };
+				vertex_data.m_Normal = { normal.x(), normal.y(), normal.z() };
+				vertex_data.m_Tangent = { tangent.x(), tangent.y(), tangent.z(), 1.0f };
+				vertex_data.m_UV = { u, v };
+				mesh.m_Vertices.push_back(vertex_data);
+			}
+		}
+
+		for (size_t ring = 0; ring < last_ring - first_ring; ++ring)
+		{
+			for (size_t segment = 0; segment < segments; ++segment)
+			{
+				const uint32_t a = sub_mesh.m_VertexOffset + ring * row_size + segment;
+				const uint32_t b = a + row_size;
+
+				mesh.m_Indices.insert(mesh.m_Indices.end(), { a, a + 1, b });
+				mesh.m_Indices.insert(mesh.m_Indices.end(), { a + 1, b + 1, b });
+			}
+		}
+
+		sub_mesh.m_VertexCount = mesh.m_Vertices.size() - sub_mesh.m_VertexOffset;
+		sub_mesh.m_IndexCount = mesh.m_Indices.size() - sub_mesh.m_IndexOffset;
+		mesh.m_SubMeshes.push_back(sub_mesh);
+	}
+
+	ComputeBounds(mesh);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stddef.h>
+
+namespace NRender
+{
+struct SMesh;
+}
+
+namespace NUtils
+{
+// Procedural geometry for placeholders and benchmarks, one submesh per band of rings
+void GenerateSphere(NRender::SMesh& mesh, size_t rings, size_t segments, size_t bands = 1, float radius = 1.0f);
+}  // namespace NUtils
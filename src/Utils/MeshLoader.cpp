@@ -1,4 +1,7 @@
 #include "MeshLoader.h"
+#include "AssetArchive.h"
+#include "MeshBounds.h"
+#include "TextureCache.h"
 
 #include <Engine/Math.h>
 #include <Engine/Render/Material.h>
@@ -6,76 +9,139 @@
 #include <Engine/Render/Texture.h>
 
 #include <algorithm>
+#include <unordered_map>
 #include <vector>
-#include <map>
 
-#include <SDL_image.h>
-#include <SDL_surface.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 
+#include <assimp/DefaultIOSystem.h>
+#include <assimp/IOStream.hpp>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
-static Assimp::Importer importer;
-
-bool NUtils::LoadMesh(const char* filename, const char* asset_path, NRender::SMesh& mesh)
+namespace
 {
-	// Load triangles from the scene
-	importer.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE, aiPrimitiveType_POINT | aiPrimitiveType_LINE);
-	const aiScene* ai_scene = importer.ReadFile(filename, aiProcessPreset_TargetRealtime_Quality | aiProcess_FlipUVs | aiProcess_FixInfacingNormals | aiProcess_ValidateDataStructure);
-	if (!ai_scene)
+// Read only view of an archived file, holding the slice keeps the archive alive
+class CArchiveIOStream : public Assimp::IOStream
+{
+public:
+	explicit CArchiveIOStream(NUtils::SAssetSlice slice) : m_Slice(std::move(slice)) {}
+
+	size_t Read(void* buffer, size_t size, size_t count) override
 	{
-		printf("%s\n", importer.GetErrorString());
-		return false;
-	}
+		if (size == 0)
+		{
+			return 0;
+		}
 
-	// Material helpers
-	using HTexture = std::shared_ptr<NRender::STexture>;
-	std::map<std::string, HTexture> texture_cache;
+		count = std::min(count, (m_Slice.m_Size - m_Position) / size);
+		memcpy(buffer, m_Slice.m_Data.get() + m_Position, size * count);
+		m_Position += size * count;
+		return count;
+	}
 
-	auto GetOrCreateTexture = [&texture_cache](std::string path) -> HTexture {
-		path = std::string("assets/models/textures/") + path;
+	size_t Write(const void*, size_t, size_t) override
+	{
+		return 0;
+	}
 
-		auto texture_pair = texture_cache.find(path);
+	aiReturn Seek(size_t offset, aiOrigin origin) override
+	{
+		const size_t base = origin == aiOrigin_SET ? 0 : origin == aiOrigin_CUR ? m_Position : m_Slice.m_Size;
 
-		if (texture_pair != texture_cache.end())
+		if (offset > m_Slice.m_Size - base)
 		{
-			return texture_pair->second;
+			return aiReturn_FAILURE;
 		}
 
-		SDL_Surface* surface = IMG_Load(path.c_str());
+		m_Position = base + offset;
+		return aiReturn_SUCCESS;
+	}
+
+	size_t Tell() const override
+	{
+		return m_Position;
+	}
+
+	size_t FileSize() const override
+	{
+		return m_Slice.m_Size;
+	}
+
+	void Flush() override {}
+
+private:
+	NUtils::SAssetSlice m_Slice;
+	size_t m_Position = 0;
+};
 
-		if (surface == nullptr)
+// Serves the mounted archive first, so scenes and whatever they reference load from it too
+class CArchiveIOSystem : public Assimp::DefaultIOSystem
+{
+public:
+	bool Exists(const char* filename) const override
+	{
+		NUtils::SAssetSlice slice;
+		return NUtils::CAssetArchive::Instance().Open(filename, slice) || DefaultIOSystem::Exists(filename);
+	}
+
+	Assimp::IOStream* Open(const char* filename, const char* mode) override
+	{
+		NUtils::SAssetSlice slice;
+
+		if (strchr(mode, 'r') && NUtils::CAssetArchive::Instance().Open(filename, slice))
 		{
-			printf("Could not load texture: %s\n", path.c_str());
-			return HTexture(nullptr);
+			return new CArchiveIOStream(std::move(slice));
 		}
 
-		// We're going to assume 8-bits per channel from here on out
-		HTexture texture = std::make_shared<NRender::STexture>();
-		texture->m_Width = surface->w;
-		texture->m_Height = surface->h;
-		texture->m_BytesPerPixel = surface->format->BytesPerPixel;
-		texture->m_Buffer.resize(surface->pitch * surface->h);
+		return DefaultIOSystem::Open(filename, mode);
+	}
+};
+}  // namespace
+
+bool NUtils::LoadMesh(const char* filename, const char* asset_path, NRender::SMesh& mesh, const TextureLoader& load_texture)
+{
+	// Importers aren't thread safe, and meshes may load on several threads at once
+	Assimp::Importer importer;
+	importer.SetIOHandler(new CArchiveIOSystem);
+
+	// Load triangles from the scene
+	importer.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE, aiPrimitiveType_POINT | aiPrimitiveType_LINE);
+	const aiScene* ai_scene = importer.ReadFile(filename, aiProcessPreset_TargetRealtime_Quality | aiProcess_FlipUVs | aiProcess_FixInfacingNormals | aiProcess_ValidateDataStructure);
+	if (!ai_scene)
+	{
+		printf("%s\n", importer.GetErrorString());
+		return false;
+	}
 
-		// Copy the bare minimum data we can
-		size_t size = surface->w * surface->format->BytesPerPixel;
+	// Gather the distinct texture paths first, so they can all be decoded as one batch
+	std::vector<std::string> texture_paths;
+	std::unordered_map<std::string, size_t> texture_indices;
 
-		for (size_t y = 0; y < surface->h; ++y)
+	auto GetTextureIndex = [&](const aiMaterial* ai_material, aiTextureType type) -> size_t {
+		if (ai_material->GetTextureCount(type) == 0)
 		{
-			size_t offset = surface->pitch * y;
-			memcpy(texture->m_Buffer.data() + offset, static_cast<uint8_t*>(surface->pixels) + offset, size);
+			return SIZE_MAX;
 		}
 
-		// Free the surface
-		SDL_FreeSurface(surface);
+		aiString path;
+		ai_material->GetTexture(type, 0, &path);
 
-		// Store the texture in our cache
-		texture_cache.emplace(path, texture);
+		const auto inserted = texture_indices.emplace(std::string("assets/models/textures/") + path.C_Str(), texture_paths.size());
 
-		return texture;
+		if (inserted.second)
+		{
+			texture_paths.push_back(inserted.first->first);
+		}
+
+		return inserted.first->second;
 	};
 
+	std::vector<std::pair<size_t, size_t>> material_textures(ai_scene->mNumMaterials);
+
 	// Preload materials vector
 	mesh.m_Materials.resize(ai_scene->mNumMaterials);
 
@@ -92,21 +158,17 @@ bool NUtils::LoadMesh(const char* filename, const char* asset_path, NRender::SMe
 		aiGetMaterialFloat(ai_material, AI_MATKEY_OPACITY, &transparency);
 		printf("%f\n", transparency);
 
-		if (ai_material->GetTextureCount(aiTextureType_DIFFUSE) > 0)
-		{
-			aiString path;
-			ai_material->GetTexture(aiTextureType_DIFFUSE, 0, &path);
-			material->m_AlbedoTexture = GetOrCreateTexture(path.C_Str());
-		}
+		material_textures[i] = { GetTextureIndex(ai_material, aiTextureType_DIFFUSE), GetTextureIndex(ai_material, aiTextureType_NORMALS) };
+		mesh.m_Materials[i] = material;
+	}
 
-		if (ai_material->GetTextureCount(aiTextureType_NORMALS) > 0)
-		{
-			aiString path;
-			ai_material->GetTexture(aiTextureType_NORMALS, 0, &path);
-			material->m_DetailTexture = GetOrCreateTexture(path.C_Str());
-		};
+	const std::vector<NRender::HTexture> textures = LoadTextures(texture_paths, load_texture);
 
-		mesh.m_Materials[i] = material;
+	for (size_t i = 0; i < mesh.m_Materials.size(); ++i)
+	{
+		const std::pair<size_t, size_t>& indices = material_textures[i];
+		mesh.m_Materials[i]->m_AlbedoTexture = indices.first != SIZE_MAX ? textures[indices.first] : nullptr;
+		mesh.m_Materials[i]->m_DetailTexture = indices.second != SIZE_MAX ? textures[indices.second] : nullptr;
 	}
 
 	// Count total vertices and indices
@@ -187,5 +249,7 @@ bool NUtils::LoadMesh(const char* filename, const char* asset_path, NRender::SMe
 		current_vertex += ai_mesh->mNumVertices;
 	}
 
+	ComputeBounds(mesh);
+
 	return true;
 };
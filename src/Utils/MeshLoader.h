@@ -1,5 +1,7 @@
 #pragma once
 
+#include "TextureLoader.h"
+
 namespace NRender
 {
 struct SMesh;
@@ -7,5 +9,6 @@ struct SMesh;
 
 namespace NUtils
 {
-bool LoadMesh(const char* filename, const char* asset_path, NRender::SMesh& mesh);
+// Textures are resolved through load_texture, when omitted only their paths are recorded
+bool LoadMesh(const char* filename, const char* asset_path, NRender::SMesh& mesh, const TextureLoader& load_texture = nullptr);
 }  // namespace NUtils
@@ -0,0 +1,463 @@
+#include "MeshOptimizer.h"
+#include "MeshQuantizer.h"
+
+#include <Engine/Math.h>
+#include <Engine/Render/Mesh.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+namespace
+{
+using SSubMesh = NRender::SMesh::SSubMesh;
+
+constexpr size_t FORSYTH_CACHE_SIZE = 32;
+constexpr float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+constexpr float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+constexpr float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+constexpr float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+constexpr size_t OVERDRAW_CACHE_SIZE = 16;
+constexpr size_t OVERDRAW_MIN_CLUSTER = 8;
+
+bool IsLocal(const NRender::SMesh& mesh, const SSubMesh& sub_mesh)
+{
+	for (size_t i = sub_mesh.m_IndexOffset; i < sub_mesh.m_IndexOffset + sub_mesh.m_IndexCount; ++i)
+	{
+		const uint32_t index = mesh.m_Indices[i];
+
+		if (index < sub_mesh.m_VertexOffset || index >= sub_mesh.m_VertexOffset + sub_mesh.m_VertexCount)
+		{
+			return false;
+		}
+	}
+
+	return sub_mesh.m_IndexCount % 3 == 0;
+}
+
+// FIFO cache using timestamps, a vertex is cached while fewer than cache_size misses happened since it was loaded
+class CFifoCache
+{
+public:
+	CFifoCache(size_t vertex_count, size_t cache_size)
+		: m_Timestamps(vertex_count, 0)
+		, m_Time(cache_size + 1)
+		, m_CacheSize(cache_size)
+	{
+	}
+
+	void Reset() { m_Time += m_CacheSize + 1; }
+
+	size_t Access(const uint32_t* triangle)
+	{
+		size_t misses = 0;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			if (m_Time - m_Timestamps[triangle[i]] > m_CacheSize)
+			{
+				m_Timestamps[triangle[i]] = m_Time++;
+				++misses;
+			}
+		}
+
+		return misses;
+	}
+
+private:
+	std::vector<size_t> m_Timestamps;
+	size_t m_Time;
+	size_t m_CacheSize;
+};
+
+float ForsythVertexScore(int cache_position, uint32_t valence)
+{
+	if (valence == 0)
+	{
+		return -1.0f;
+	}
+
+	float score = 0.0f;
+
+	if (cache_position >= 0)
+	{
+		if (cache_position < 3)
+		{
+			score = FORSYTH_LAST_TRIANGLE_SCORE;
+		}
+		else
+		{
+			const float scaler = 1.0f / float(FORSYTH_CACHE_SIZE - 3);
+			score = std::pow(1.0f - float(cache_position - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+		}
+	}
+
+	return score + FORSYTH_VALENCE_BOOST_SCALE * std::pow(float(valence), -FORSYTH_VALENCE_BOOST_POWER);
+}
+
+// Indices are local to the submesh here
+void OptimizeVertexCacheForsyth(uint32_t* indices, size_t index_count, size_t vertex_count)
+{
+	const size_t triangle_count = index_count / 3;
+
+	// Build vertex to triangle adjacency
+	std::vector<uint32_t> valence(vertex_count, 0);
+	std::vector<uint32_t> adjacency_offset(vertex_count + 1, 0);
+	std::vector<uint32_t> adjacency(index_count);
+
+	for (size_t i = 0; i < index_count; ++i)
+	{
+		++valence[indices[i]];
+	}
+
+	std::partial_sum(valence.begin(), valence.end(), adjacency_offset.begin() + 1);
+	std::vector<uint32_t> fill(adjacency_offset.begin(), adjacency_offset.end() - 1);
+
+	for (size_t i = 0; i < index_count; ++i)
+	{
+		adjacency[fill[indices[i]]++] = i / 3;
+	}
+
+	// Initial scores, only vertices are tracked as triangles are rescored when touched
+	std::vector<int> cache_position(vertex_count, -1);
+	std::vector<float> vertex_score(vertex_count);
+	std::vector<bool> emitted(triangle_count, false);
+
+	for (size_t v = 0; v < vertex_count; ++v)
+	{
+		vertex_score[v] = ForsythVertexScore(-1, valence[v]);
+	}
+
+	std::vector<uint32_t> output;
+	output.reserve(index_count);
+
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> next_cache;
+	cache.reserve(FORSYTH_CACHE_SIZE + 3);
+	next_cache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+	size_t cursor = 0;
+	int64_t best = -1;
+
+	while (output.size() < index_count)
+	{
+		// Dead ends restart from the next unemitted triangle in input order
+		if (best < 0)
+		{
+			while (emitted[cursor])
+			{
+				++cursor;
+			}
+
+			best = cursor;
+		}
+
+		const uint32_t* triangle = &indices[best * 3];
+		output.insert(output.end(), triangle, triangle + 3);
+		emitted[best] = true;
+
+		// Remove the triangle from its vertices' live adjacency
+		for (int i = 0; i < 3; ++i)
+		{
+			const uint32_t v = triangle[i];
+			uint32_t* begin = &adjacency[adjacency_offset[v]];
+			uint32_t* end = begin + valence[v];
+			*std::find(begin, end, uint32_t(best)) = *(end - 1);
+			--valence[v];
+		}
+
+		// Push the triangle's vertices to the front of the LRU cache
+		next_cache.assign(triangle, triangle + 3);
+
+		for (uint32_t v : cache)
+		{
+			if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+			{
+				next_cache.push_back(v);
+			}
+		}
+
+		for (size_t i = FORSYTH_CACHE_SIZE; i < next_cache.size(); ++i)
+		{
+			cache_position[next_cache[i]] = -1;
+			vertex_score[next_cache[i]] = ForsythVertexScore(-1, valence[next_cache[i]]);
+		}
+
+		next_cache.resize(std::min(next_cache.size(), FORSYTH_CACHE_SIZE));
+		std::swap(cache, next_cache);
+
+		for (size_t i = 0; i < cache.size(); ++i)
+		{
+			cache_position[cache[i]] = i;
+			vertex_score[cache[i]] = ForsythVertexScore(i, valence[cache[i]]);
+		}
+
+		// Rescore the live triangles touching the cache and pick the best one
+		best = -1;
+		float best_score = -1.0f;
+
+		for (uint32_t v : cache)
+		{
+			for (uint32_t a = 0; a < valence[v]; ++a)
+			{
+				const uint32_t t = adjacency[adjacency_offset[v] + a];
+				const float score = vertex_score[indices[t * 3 + 0]] + vertex_score[indices[t * 3 + 1]] + vertex_score[indices[t * 3 + 2]];
+
+				if (score > best_score)
+				{
+					best_score = score;
+					best = t;
+				}
+			}
+		}
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+}  // namespace
+
+NUtils::SVertexCacheStats NUtils::AnalyzeVertexCache(const NRender::SMesh& mesh, size_t cache_size)
+{
+	SVertexCacheStats stats;
+	CFifoCache cache(std::max(mesh.m_Vertices.size(), mesh.m_PackedVertices.size()), cache_size);
+
+	for (const SSubMesh& sub_mesh : mesh.m_SubMeshes)
+	{
+		cache.Reset();
+
+		for (size_t i = 0; i + 3 <= sub_mesh.m_IndexCount; i += 3)
+		{
+			stats.m_Misses += cache.Access(&mesh.m_Indices[sub_mesh.m_IndexOffset + i]);
+		}
+
+		stats.m_Triangles += sub_mesh.m_IndexCount / 3;
+		stats.m_Vertices += sub_mesh.m_VertexCount;
+	}
+
+	return stats;
+}
+
+void NUtils::OptimizeVertexCache(NRender::SMesh& mesh)
+{
+	std::vector<uint32_t> local;
+
+	for (const SSubMesh& sub_mesh : mesh.m_SubMeshes)
+	{
+		if (sub_mesh.m_IndexCount == 0 || !IsLocal(mesh, sub_mesh))
+		{
+			continue;
+		}
+
+		// Every level is drawn on its own, so each gets its own order
+		for (size_t lod = 0; lod < sub_mesh.LodCount(); ++lod)
+		{
+			const size_t index_count = sub_mesh.LodIndexCount(lod);
+			uint32_t* indices = &mesh.m_Indices[sub_mesh.LodIndexOffset(lod)];
+			local.resize(index_count);
+
+			for (size_t i = 0; i < index_count; ++i)
+			{
+				local[i] = indices[i] - sub_mesh.m_VertexOffset;
+			}
+
+			OptimizeVertexCacheForsyth(local.data(), local.size(), sub_mesh.m_VertexCount);
+
+			for (size_t i = 0; i < index_count; ++i)
+			{
+				indices[i] = local[i] + sub_mesh.m_VertexOffset;
+			}
+		}
+	}
+}
+
+void NUtils::OptimizeOverdraw(NRender::SMesh& mesh, float threshold)
+{
+	struct SCluster
+	{
+		size_t m_Start;
+		size_t m_End;
+		float m_Sort;
+	};
+
+	CFifoCache cache(std::max(mesh.m_Vertices.size(), mesh.m_PackedVertices.size()), OVERDRAW_CACHE_SIZE);
+	std::vector<SCluster> clusters;
+	std::vector<uint32_t> sorted;
+
+	for (const SSubMesh& sub_mesh : mesh.m_SubMeshes)
+	{
+		const size_t triangle_count = sub_mesh.m_IndexCount / 3;
+
+		if (triangle_count < OVERDRAW_MIN_CLUSTER * 2 || !IsLocal(mesh, sub_mesh))
+		{
+			continue;
+		}
+
+		uint32_t* indices = &mesh.m_Indices[sub_mesh.m_IndexOffset];
+
+		auto MeasureMisses = [&](const uint32_t* triangles) {
+			size_t misses = 0;
+			cache.Reset();
+
+			for (size_t t = 0; t < triangle_count; ++t)
+			{
+				misses += cache.Access(&triangles[t * 3]);
+			}
+
+			return misses;
+		};
+
+		const size_t original_misses = MeasureMisses(indices);
+		const float target_acmr = threshold * float(original_misses) / float(triangle_count);
+
+		// Split wherever a cluster restarted from a cold cache would stay within the ACMR budget
+		clusters.clear();
+		cache.Reset();
+		size_t cluster_start = 0;
+		size_t cluster_misses = 0;
+
+		for (size_t t = 0; t < triangle_count; ++t)
+		{
+			cluster_misses += cache.Access(&indices[t * 3]);
+
+			const size_t cluster_size = t + 1 - cluster_start;
+
+			if (cluster_size >= OVERDRAW_MIN_CLUSTER && float(cluster_misses) <= target_acmr * float(cluster_size) && t + 1 < triangle_count)
+			{
+				clusters.push_back({ cluster_start, t + 1, 0.0f });
+				cluster_start = t + 1;
+				cluster_misses = 0;
+				cache.Reset();
+			}
+		}
+
+		clusters.push_back({ cluster_start, triangle_count, 0.0f });
+
+		if (clusters.size() < 2)
+		{
+			continue;
+		}
+
+		// Clusters facing away from the submesh center are likely to occlude the rest, so draw them first
+		std::vector<CVector3f> centroids(clusters.size());
+		std::vector<CVector3f> normals(clusters.size());
+		CVector3f center = CVector3f::Zero();
+		float total_area = 0.0f;
+
+		for (size_t c = 0; c < clusters.size(); ++c)
+		{
+			CVector3f centroid = CVector3f::Zero();
+			CVector3f normal = CVector3f::Zero();
+			float area = 0.0f;
+
+			for (size_t t = clusters[c].m_Start; t < clusters[c].m_End; ++t)
+			{
+				const CVector3f p0 = GetVertexPosition(mesh, sub_mesh, indices[t * 3 + 0]);
+				const CVector3f p1 = GetVertexPosition(mesh, sub_mesh, indices[t * 3 + 1]);
+				const CVector3f p2 = GetVertexPosition(mesh, sub_mesh, indices[t * 3 + 2]);
+				const CVector3f cross = (p1 - p0).cross(p2 - p0);
+				const float triangle_area = cross.norm();
+
+				centroid += (p0 + p1 + p2) * (triangle_area / 3.0f);
+				normal += cross;
+				area += triangle_area;
+			}
+
+			center += centroid;
+			total_area += area;
+			centroids[c] = area > 0.0f ? CVector3f(centroid / area) : CVector3f::Zero();
+			normals[c] = normal.normalized();
+		}
+
+		center = total_area > 0.0f ? CVector3f(center / total_area) : CVector3f::Zero();
+
+		for (size_t c = 0; c < clusters.size(); ++c)
+		{
+			clusters[c].m_Sort = (centroids[c] - center).dot(normals[c]);
+		}
+
+		std::stable_sort(clusters.begin(), clusters.end(), [](const SCluster& a, const SCluster& b) {
+			return a.m_Sort > b.m_Sort;
+		});
+
+		sorted.clear();
+
+		for (const SCluster& cluster : clusters)
+		{
+			sorted.insert(sorted.end(), indices + cluster.m_Start * 3, indices + cluster.m_End * 3);
+		}
+
+		if (float(MeasureMisses(sorted.data())) <= float(original_misses) * threshold)
+		{
+			std::copy(sorted.begin(), sorted.end(), indices);
+		}
+	}
+}
+
+void NUtils::OptimizeVertexFetch(NRender::SMesh& mesh)
+{
+	const bool packed = mesh.m_VertexFormat == NRender::EVertexFormat::Packed;
+	std::vector<uint32_t> remap;
+	std::vector<NRender::SMesh::SVertexData> vertices;
+	std::vector<NRender::SMesh::SPackedVertexData> packed_vertices;
+
+	for (const SSubMesh& sub_mesh : mesh.m_SubMeshes)
+	{
+		if (sub_mesh.m_VertexCount == 0 || !IsLocal(mesh, sub_mesh))
+		{
+			continue;
+		}
+
+		// Assign new slots in order of first use, unreferenced vertices go last
+		remap.assign(sub_mesh.m_VertexCount, UINT32_MAX);
+		uint32_t next = 0;
+
+		for (size_t i = sub_mesh.m_IndexOffset; i < sub_mesh.m_IndexOffset + sub_mesh.m_IndexCount; ++i)
+		{
+			uint32_t& slot = remap[mesh.m_Indices[i] - sub_mesh.m_VertexOffset];
+			slot = slot == UINT32_MAX ? next++ : slot;
+			mesh.m_Indices[i] = sub_mesh.m_VertexOffset + slot;
+		}
+
+		for (uint32_t& slot : remap)
+		{
+			slot = slot == UINT32_MAX ? next++ : slot;
+		}
+
+		// Coarser levels share the vertices, the order follows the full detail level
+		for (const NRender::SMesh::SLod& level : sub_mesh.m_Lods)
+		{
+			for (size_t i = level.m_IndexOffset; i < level.m_IndexOffset + level.m_IndexCount; ++i)
+			{
+				mesh.m_Indices[i] = sub_mesh.m_VertexOffset + remap[mesh.m_Indices[i] - sub_mesh.m_VertexOffset];
+			}
+		}
+
+		auto Permute = [&](auto& source, auto& scratch) {
+			auto begin = source.begin() + sub_mesh.m_VertexOffset;
+			scratch.assign(begin, begin + sub_mesh.m_VertexCount);
+
+			for (size_t v = 0; v < sub_mesh.m_VertexCount; ++v)
+			{
+				begin[remap[v]] = scratch[v];
+			}
+		};
+
+		if (packed)
+		{
+			Permute(mesh.m_PackedVertices, packed_vertices);
+		}
+		else
+		{
+			Permute(mesh.m_Vertices, vertices);
+		}
+	}
+}
+
+void NUtils::OptimizeMesh(NRender::SMesh& mesh)
+{
+	OptimizeVertexCache(mesh);
+	OptimizeOverdraw(mesh);
+	OptimizeVertexFetch(mesh);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stddef.h>
+
+namespace NRender
+{
+struct SMesh;
+}
+
+namespace NUtils
+{
+// Post-transform cache behaviour of a mesh, simulated as a FIFO flushed between submeshes
+struct SVertexCacheStats
+{
+	size_t m_Triangles = 0;
+	size_t m_Vertices = 0;
+	size_t m_Misses = 0;
+
+	// Average cache miss ratio, transformed vertices per triangle (0.5 is ideal, 3.0 worst)
+	float ACMR() const { return m_Triangles ? float(m_Misses) / float(m_Triangles) : 0.0f; }
+
+	// Average transform to vertex ratio, how often each vertex is transformed (1.0 is ideal)
+	float ATVR() const { return m_Vertices ? float(m_Misses) / float(m_Vertices) : 0.0f; }
+};
+
+SVertexCacheStats AnalyzeVertexCache(const NRender::SMesh& mesh, size_t cache_size = 16);
+
+// Reorders triangles within each submesh for post-transform cache reuse (Forsyth)
+void OptimizeVertexCache(NRender::SMesh& mesh);
+
+// Sorts clusters of cache optimized triangles so outward facing ones draw first,
+// the order is kept when it would raise the ACMR of a submesh beyond threshold
+void OptimizeOverdraw(NRender::SMesh& mesh, float threshold = 1.05f);
+
+// Reorders vertices within each submesh to match the order indices first use them
+void OptimizeVertexFetch(NRender::SMesh& mesh);
+
+// Runs all of the above, submesh ranges are preserved
+void OptimizeMesh(NRender::SMesh& mesh);
+}  // namespace NUtils
@@ -0,0 +1,220 @@
+#include "MeshQuantizer.h"
+
+#include <Engine/Math.h>
+
+#include <Eigen/Core>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+using SVertexData = NRender::SMesh::SVertexData;
+using SPackedVertexData = NRender::SMesh::SPackedVertexData;
+
+int16_t PackSnorm(float value)
+{
+	return int16_t(std::lround(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f));
+}
+
+float UnpackSnorm(int16_t value)
+{
+	return std::max(float(value) / 32767.0f, -1.0f);
+}
+
+uint8_t PackUnorm8(float value)
+{
+	return uint8_t(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 255.0f));
+}
+
+uint16_t PackHalf(float value)
+{
+	return Eigen::half(value).x;
+}
+
+float UnpackHalf(uint16_t value)
+{
+	Eigen::half half;
+	half.x = value;
+	return float(half);
+}
+
+// Octahedral mapping, see "A Survey of Efficient Representations for Independent Unit Vectors"
+void PackOctahedral(const CVector3f& direction, int16_t (&packed)[2])
+{
+	CVector3f n = direction / std::max(direction.cwiseAbs().sum(), std::numeric_limits<float>::min());
+	CVector2f xy = n.head<2>();
+
+	if (n.z() < 0.0f)
+	{
+		xy.x() = (1.0f - std::abs(n.y())) * (n.x() >= 0.0f ? 1.0f : -1.0f);
+		xy.y() = (1.0f - std::abs(n.x())) * (n.y() >= 0.0f ? 1.0f : -1.0f);
+	}
+
+	packed[0] = PackSnorm(xy.x());
+	packed[1] = PackSnorm(xy.y());
+}
+
+CVector3f UnpackOctahedral(const int16_t (&packed)[2])
+{
+	CVector3f n(UnpackSnorm(packed[0]), UnpackSnorm(packed[1]), 0.0f);
+	n.z() = 1.0f - std::abs(n.x()) - std::abs(n.y());
+
+	const float t = std::max(-n.z(), 0.0f);
+	n.x() += n.x() >= 0.0f ? -t : t;
+	n.y() += n.y() >= 0.0f ? -t : t;
+
+	return n.normalized();
+}
+
+float AngleBetween(const CVector3f& a, const CVector3f& b)
+{
+	if (a.isZero() || b.isZero())
+	{
+		return 0.0f;
+	}
+
+	return std::acos(std::min(std::max(a.normalized().dot(b.normalized()), -1.0f), 1.0f)) * (180.0f / float(M_PI));
+}
+}  // namespace
+
+void NUtils::QuantizeMesh(NRender::SMesh& mesh)
+{
+	if (mesh.m_VertexFormat == NRender::EVertexFormat::Packed)
+	{
+		return;
+	}
+
+	mesh.m_PackedVertices.resize(mesh.m_Vertices.size());
+
+	for (NRender::SMesh::SSubMesh& sub_mesh : mesh.m_SubMeshes)
+	{
+		// Each submesh gets its own bounds so small parts keep their precision
+		CVector3f min = CVector3f::Constant(std::numeric_limits<float>::max());
+		CVector3f max = CVector3f::Constant(std::numeric_limits<float>::lowest());
+
+		for (size_t v = sub_mesh.m_VertexOffset; v < sub_mesh.m_VertexOffset + sub_mesh.m_VertexCount; ++v)
+		{
+			const CVector3f position(&mesh.m_Vertices[v].m_Position.m_X);
+			min = min.cwiseMin(position);
+			max = max.cwiseMax(position);
+		}
+
+		if (sub_mesh.m_VertexCount == 0)
+		{
+			min = max = CVector3f::Zero();
+		}
+
+		const CVector3f extent = max - min;
+		sub_mesh.m_QuantizationOffset = { min.x(), min.y(), min.z() };
+		sub_mesh.m_QuantizationScale = { extent.x(), extent.y(), extent.z() };
+
+		for (size_t v = sub_mesh.m_VertexOffset; v < sub_mesh.m_VertexOffset + sub_mesh.m_VertexCount; ++v)
+		{
+			const SVertexData& vertex = mesh.m_Vertices[v];
+			SPackedVertexData& packed = mesh.m_PackedVertices[v];
+
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				const float position = (&vertex.m_Position.m_X)[axis];
+				const float normalized = extent[axis] > 0.0f ? (position - min[axis]) / extent[axis] : 0.0f;
+				packed.m_Position[axis] = uint16_t(std::lround(std::min(std::max(normalized, 0.0f), 1.0f) * 65535.0f));
+			}
+
+			packed.m_Position[3] = vertex.m_Tangent.m_W < 0.0f ? 0 : 65535;
+
+			PackOctahedral(CVector3f(&vertex.m_Normal.m_X), packed.m_Normal);
+			PackOctahedral(CVector3f(&vertex.m_Tangent.m_X), packed.m_Tangent);
+
+			packed.m_Color[0] = PackUnorm8(vertex.m_Color.m_X);
+			packed.m_Color[1] = PackUnorm8(vertex.m_Color.m_Y);
+			packed.m_Color[2] = PackUnorm8(vertex.m_Color.m_Z);
+			packed.m_Color[3] = 255;
+
+			packed.m_UV[0] = PackHalf(vertex.m_UV.m_X);
+			packed.m_UV[1] = PackHalf(vertex.m_UV.m_Y);
+		}
+	}
+
+	mesh.m_VertexFormat = NRender::EVertexFormat::Packed;
+	mesh.m_Vertices.clear();
+	mesh.m_Vertices.shrink_to_fit();
+}
+
+void NUtils::DequantizeVertices(const NRender::SMesh& mesh, std::vector<NRender::SMesh::SVertexData>& vertices)
+{
+	if (mesh.m_VertexFormat == NRender::EVertexFormat::Float)
+	{
+		vertices = mesh.m_Vertices;
+		return;
+	}
+
+	vertices.resize(mesh.m_PackedVertices.size());
+
+	for (const NRender::SMesh::SSubMesh& sub_mesh : mesh.m_SubMeshes)
+	{
+		for (size_t v = sub_mesh.m_VertexOffset; v < sub_mesh.m_VertexOffset + sub_mesh.m_VertexCount; ++v)
+		{
+			vertices[v] = GetVertex(mesh, sub_mesh, v);
+		}
+	}
+}
+
+NRender::SMesh::SVertexData NUtils::GetVertex(const NRender::SMesh& mesh, const NRender::SMesh::SSubMesh& sub_mesh, size_t index)
+{
+	if (mesh.m_VertexFormat == NRender::EVertexFormat::Float)
+	{
+		return mesh.m_Vertices[index];
+	}
+
+	const SPackedVertexData& packed = mesh.m_PackedVertices[index];
+	SVertexData vertex;
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		(&vertex.m_Position.m_X)[axis] = (&sub_mesh.m_QuantizationOffset.m_X)[axis] + (&sub_mesh.m_QuantizationScale.m_X)[axis] * (packed.m_Position[axis] / 65535.0f);
+	}
+
+	const CVector3f normal = UnpackOctahedral(packed.m_Normal);
+	const CVector3f tangent = UnpackOctahedral(packed.m_Tangent);
+	vertex.m_Normal = { normal.x(), normal.y(), normal.z() };
+	vertex.m_Tangent = { tangent.x(), tangent.y(), tangent.z(), packed.m_Position[3] ? 1.0f : -1.0f };
+	vertex.m_Color = { packed.m_Color[0] / 255.0f, packed.m_Color[1] / 255.0f, packed.m_Color[2] / 255.0f };
+	vertex.m_UV = { UnpackHalf(packed.m_UV[0]), UnpackHalf(packed.m_UV[1]) };
+	return vertex;
+}
+
+CVector3f NUtils::GetVertexPosition(const NRender::SMesh& mesh, const NRender::SMesh::SSubMesh& sub_mesh, size_t index)
+{
+	if (mesh.m_VertexFormat == NRender::EVertexFormat::Packed)
+	{
+		const SPackedVertexData& vertex = mesh.m_PackedVertices[index];
+		const CVector3f quantized(vertex.m_Position[0], vertex.m_Position[1], vertex.m_Position[2]);
+		return CVector3f(&sub_mesh.m_QuantizationOffset.m_X) + CVector3f(&sub_mesh.m_QuantizationScale.m_X).cwiseProduct(quantized / 65535.0f);
+	}
+
+	return CVector3f(&mesh.m_Vertices[index].m_Position.m_X);
+}
+
+NUtils::SQuantizationError NUtils::MeasureQuantizationError(const std::vector<NRender::SMesh::SVertexData>& reference, const NRender::SMesh& mesh)
+{
+	std::vector<SVertexData> vertices;
+	DequantizeVertices(mesh, vertices);
+
+	SQuantizationError error;
+
+	for (size_t v = 0; v < std::min(reference.size(), vertices.size()); ++v)
+	{
+		const SVertexData& a = reference[v];
+		const SVertexData& b = vertices[v];
+
+		error.m_Position = std::max(error.m_Position, (CVector3f(&a.m_Position.m_X) - CVector3f(&b.m_Position.m_X)).cwiseAbs().maxCoeff());
+		error.m_Normal = std::max(error.m_Normal, AngleBetween(CVector3f(&a.m_Normal.m_X), CVector3f(&b.m_Normal.m_X)));
+		error.m_Tangent = std::max(error.m_Tangent, AngleBetween(CVector3f(&a.m_Tangent.m_X), CVector3f(&b.m_Tangent.m_X)));
+		error.m_Color = std::max(error.m_Color, (CVector3f(&a.m_Color.m_X) - CVector3f(&b.m_Color.m_X)).cwiseAbs().maxCoeff());
+		error.m_UV = std::max(error.m_UV, (CVector2f(&a.m_UV.m_X) - CVector2f(&b.m_UV.m_X)).cwiseAbs().maxCoeff());
+	}
+
+	return error;
+}
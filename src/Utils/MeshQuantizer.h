@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vector>
+
+#include <Engine/Math.h>
+#include <Engine/Render/Mesh.h>
+
+namespace NUtils
+{
+// Largest error introduced by packing, positions in mesh units and directions in degrees
+struct SQuantizationError
+{
+	float m_Position = 0.0f;
+	float m_Normal = 0.0f;
+	float m_Tangent = 0.0f;
+	float m_Color = 0.0f;
+	float m_UV = 0.0f;
+};
+
+// Converts a float mesh to the packed layout, releasing the float vertices
+void QuantizeMesh(NRender::SMesh& mesh);
+
+// Expands packed vertices back into the float layout
+void DequantizeVertices(const NRender::SMesh& mesh, std::vector<NRender::SMesh::SVertexData>& vertices);
+
+// Reads a single vertex, expanded to the float layout if it's packed
+NRender::SMesh::SVertexData GetVertex(const NRender::SMesh& mesh, const NRender::SMesh::SSubMesh& sub_mesh, size_t index);
+
+// Reads a single vertex position regardless of the mesh's vertex format
+CVector3f GetVertexPosition(const NRender::SMesh& mesh, const NRender::SMesh::SSubMesh& sub_mesh, size_t index);
+
+SQuantizationError MeasureQuantizationError(const std::vector<NRender::SMesh::SVertexData>& reference, const NRender::SMesh& mesh);
+}  // namespace NUtils
@@ -0,0 +1,481 @@
+#include "MeshSimplifier.h"
+#include "MeshQuantizer.h"
+
+#include <Engine/Math.h>
+#include <Engine/Render/Mesh.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+using SSubMesh = NRender::SMesh::SSubMesh;
+
+// Collapses that turn a triangle by more than about 85 degrees are rejected as flips
+constexpr double FLIP_THRESHOLD = 0.1;
+
+// Levels have to drop at least this share of the triangles of the level before
+constexpr double MIN_REDUCTION = 0.1;
+
+// Symmetric 4x4 matrix of the summed, area weighted squared distances to triangle planes
+struct SQuadric
+{
+	double m_A00 = 0.0, m_A01 = 0.0, m_A02 = 0.0, m_A03 = 0.0;
+	double m_A11 = 0.0, m_A12 = 0.0, m_A13 = 0.0;
+	double m_A22 = 0.0, m_A23 = 0.0;
+	double m_A33 = 0.0;
+	double m_Weight = 0.0;
+
+	void AddPlane(double a, double b, double c, double d, double weight)
+	{
+		m_A00 += weight * a * a, m_A01 += weight * a * b, m_A02 += weight * a * c, m_A03 += weight * a * d;
+		m_A11 += weight * b * b, m_A12 += weight * b * c, m_A13 += weight * b * d;
+		m_A22 += weight * c * c, m_A23 += weight * c * d;
+		m_A33 += weight * d * d;
+		m_Weight += weight;
+	}
+
+	SQuadric& operator+=(const SQuadric& other)
+	{
+		m_A00 += other.m_A00, m_A01 += other.m_A01, m_A02 += other.m_A02, m_A03 += other.m_A03;
+		m_A11 += other.m_A11, m_A12 += other.m_A12, m_A13 += other.m_A13;
+		m_A22 += other.m_A22, m_A23 += other.m_A23;
+		m_A33 += other.m_A33;
+		m_Weight += other.m_Weight;
+		return *this;
+	}
+
+	// Mean squared distance of the point to the planes
+	double Evaluate(const CVector3f& point) const
+	{
+		const double x = point.x(), y = point.y(), z = point.z();
+		const double error = m_A00 * x * x + 2.0 * m_A01 * x * y + 2.0 * m_A02 * x * z + 2.0 * m_A03 * x +
+							 m_A11 * y * y + 2.0 * m_A12 * y * z + 2.0 * m_A13 * y +
+							 m_A22 * z * z + 2.0 * m_A23 * z +
+							 m_A33;
+
+		return m_Weight > 0.0 ? std::max(error, 0.0) / m_Weight : 0.0;
+	}
+};
+
+// Simplifies one submesh step by step, the state carries over so each level builds on the last
+class CSimplifier
+{
+public:
+	CSimplifier(const NRender::SMesh& mesh, const SSubMesh& sub_mesh)
+		: m_Offset(uint32_t(sub_mesh.m_VertexOffset))
+	{
+		const size_t vertex_count = sub_mesh.m_VertexCount;
+		m_Positions.resize(vertex_count);
+		m_Canonical.resize(vertex_count);
+
+		for (size_t i = 0; i < vertex_count; ++i)
+		{
+			m_Positions[i] = NUtils::GetVertexPosition(mesh, sub_mesh, m_Offset + i);
+		}
+
+		m_Indices.resize(sub_mesh.m_IndexCount);
+
+		for (size_t i = 0; i < sub_mesh.m_IndexCount; ++i)
+		{
+			m_Indices[i] = mesh.m_Indices[sub_mesh.m_IndexOffset + i] - m_Offset;
+		}
+
+		WeldPositions();
+		LockVertices();
+		ComputeQuadrics();
+	}
+
+	size_t Triangles() const { return m_Indices.size() / 3; }
+	float Error() const { return float(std::sqrt(m_Error)); }
+
+	void AppendIndices(std::vector<uint32_t>& indices) const
+	{
+		for (uint32_t index : m_Indices)
+		{
+			indices.push_back(index + m_Offset);
+		}
+	}
+
+	// Collapses edges in passes of independent collapses, cheapest first, until the target is met or nothing can go
+	void Simplify(size_t target_triangles)
+	{
+		while (Triangles() > target_triangles && Pass(target_triangles))
+		{
+		}
+	}
+
+private:
+	struct SCollapse
+	{
+		uint32_t m_From;
+		uint32_t m_To;
+		double m_Cost;
+	};
+
+	// Vertices split for their attributes share a position, they're treated as one vertex
+	void WeldPositions()
+	{
+		std::unordered_map<uint64_t, std::vector<uint32_t>> buckets;
+		m_GroupSize.assign(m_Positions.size(), 0);
+
+		for (uint32_t i = 0; i < m_Positions.size(); ++i)
+		{
+			uint32_t bits[3];
+			memcpy(bits, m_Positions[i].data(), sizeof(bits));
+
+			const uint64_t hash = (uint64_t(bits[0]) * 73856093u) ^ (uint64_t(bits[1]) * 19349663u) ^ (uint64_t(bits[2]) * 83492791u);
+			std::vector<uint32_t>& bucket = buckets[hash];
+
+			m_Canonical[i] = i;
+
+			for (uint32_t other : bucket)
+			{
+				if (m_Positions[other] == m_Positions[i])
+				{
+					m_Canonical[i] = other;
+					break;
+				}
+			}
+
+			if (m_Canonical[i] == i)
+			{
+				bucket.push_back(i);
+			}
+
+			++m_GroupSize[m_Canonical[i]];
+		}
+	}
+
+	// Seams, borders and non-manifold edges stay put
+	void LockVertices()
+	{
+		m_Locked.assign(m_Positions.size(), false);
+
+		for (uint32_t i = 0; i < m_Positions.size(); ++i)
+		{
+			m_Locked[i] = m_GroupSize[m_Canonical[i]] > 1;
+		}
+
+		std::unordered_map<uint64_t, uint32_t> edges;
+
+		auto EdgeKey = [](uint32_t a, uint32_t b) { return (uint64_t(a) << 32) | b; };
+
+		for (size_t i = 0; i < m_Indices.size(); i += 3)
+		{
+			for (size_t e = 0; e < 3; ++e)
+			{
+				++edges[EdgeKey(m_Canonical[m_Indices[i + e]], m_Canonical[m_Indices[i + (e + 1) % 3]])];
+			}
+		}
+
+		for (const std::pair<const uint64_t, uint32_t>& edge : edges)
+		{
+			const uint32_t a = uint32_t(edge.first >> 32);
+			const uint32_t b = uint32_t(edge.first);
+			const auto opposite = edges.find(EdgeKey(b, a));
+
+			if (edge.second != 1 || opposite == edges.end() || opposite->second != 1)
+			{
+				m_Locked[a] = true;
+				m_Locked[b] = true;
+			}
+		}
+	}
+
+	void ComputeQuadrics()
+	{
+		m_Quadrics.assign(m_Positions.size(), SQuadric());
+
+		for (size_t i = 0; i < m_Indices.size(); i += 3)
+		{
+			const CVector3f& p0 = m_Positions[m_Indices[i + 0]];
+			const CVector3f normal = (m_Positions[m_Indices[i + 1]] - p0).cross(m_Positions[m_Indices[i + 2]] - p0);
+			const double area = normal.norm();
+
+			if (area <= 0.0)
+			{
+				continue;
+			}
+
+			const CVector3f unit = normal / float(area);
+			const double distance = -unit.dot(p0);
+
+			for (size_t k = 0; k < 3; ++k)
+			{
+				m_Quadrics[m_Canonical[m_Indices[i + k]]].AddPlane(unit.x(), unit.y(), unit.z(), distance, area * 0.5);
+			}
+		}
+	}
+
+	// Triangles around each welded vertex
+	void BuildAdjacency()
+	{
+		m_AdjacencyOffsets.assign(m_Positions.size() + 1, 0);
+
+		for (uint32_t index : m_Indices)
+		{
+			++m_AdjacencyOffsets[m_Canonical[index] + 1];
+		}
+
+		for (size_t i = 1; i < m_AdjacencyOffsets.size(); ++i)
+		{
+			m_AdjacencyOffsets[i] += m_AdjacencyOffsets[i - 1];
+		}
+
+		m_Adjacency.resize(m_Indices.size());
+		std::vector<uint32_t> cursor(m_AdjacencyOffsets.begin(), m_AdjacencyOffsets.end() - 1);
+
+		for (size_t i = 0; i < m_Indices.size(); ++i)
+		{
+			m_Adjacency[cursor[m_Canonical[m_Indices[i]]]++] = uint32_t(i / 3);
+		}
+	}
+
+	// The edge's two triangles have to be the only ones the endpoints share, or the collapse pinches the surface
+	bool KeepsManifold(uint32_t from, uint32_t to)
+	{
+		++m_Stamp;
+		size_t shared_triangles = 0;
+
+		for (uint32_t a = m_AdjacencyOffsets[from]; a < m_AdjacencyOffsets[from + 1]; ++a)
+		{
+			const uint32_t* triangle = &m_Indices[m_Adjacency[a] * 3];
+			bool has_to = false;
+
+			for (size_t k = 0; k < 3; ++k)
+			{
+				m_Marks[m_Canonical[triangle[k]]] = m_Stamp;
+				has_to |= m_Canonical[triangle[k]] == to;
+			}
+
+			shared_triangles += has_to;
+		}
+
+		// Count the distinct neighbours of to that are also neighbours of from, besides the two endpoints
+		const uint32_t stamp = m_Stamp;
+		++m_Stamp;
+		size_t shared_neighbours = 0;
+
+		for (uint32_t a = m_AdjacencyOffsets[to]; a < m_AdjacencyOffsets[to + 1]; ++a)
+		{
+			const uint32_t* triangle = &m_Indices[m_Adjacency[a] * 3];
+
+			for (size_t k = 0; k < 3; ++k)
+			{
+				const uint32_t vertex = m_Canonical[triangle[k]];
+
+				if (vertex != from && vertex != to && m_Marks[vertex] == stamp)
+				{
+					m_Marks[vertex] = m_Stamp;
+					++shared_neighbours;
+				}
+			}
+		}
+
+		return shared_triangles == 2 && shared_neighbours == 2;
+	}
+
+	// Moving from onto to mustn't turn any of the triangles that survive the collapse over
+	bool KeepsOrientation(uint32_t from, const CVector3f& target) const
+	{
+		for (uint32_t a = m_AdjacencyOffsets[from]; a < m_AdjacencyOffsets[from + 1]; ++a)
+		{
+			const uint32_t* triangle = &m_Indices[m_Adjacency[a] * 3];
+			CVector3f before[3];
+			CVector3f after[3];
+			bool degenerate = false;
+
+			for (size_t k = 0; k < 3; ++k)
+			{
+				before[k] = m_Positions[triangle[k]];
+				after[k] = m_Canonical[triangle[k]] == from ? target : before[k];
+				degenerate |= m_Canonical[triangle[k]] != from && after[k] == target;
+			}
+
+			if (degenerate)
+			{
+				continue;
+			}
+
+			const CVector3f normal_before = (before[1] - before[0]).cross(before[2] - before[0]);
+			const CVector3f normal_after = (after[1] - after[0]).cross(after[2] - after[0]);
+
+			if (normal_before.dot(normal_after) <= FLIP_THRESHOLD * normal_before.norm() * normal_after.norm())
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool Pass(size_t target_triangles)
+	{
+		BuildAdjacency();
+		m_Marks.resize(m_Positions.size(), 0);
+
+		// Every edge out of a removable vertex is a candidate, costed by the merged quadric at the target.
+		// Interior edges show up once in each direction, border edges have locked ends anyway
+		std::vector<SCollapse> collapses;
+		collapses.reserve(m_Indices.size());
+
+		for (size_t i = 0; i < m_Indices.size(); i += 3)
+		{
+			for (size_t e = 0; e < 3; ++e)
+			{
+				const uint32_t from = m_Indices[i + e];
+				const uint32_t to = m_Indices[i + (e + 1) % 3];
+
+				if (m_Locked[from])
+				{
+					continue;
+				}
+
+				SQuadric merged = m_Quadrics[from];
+				merged += m_Quadrics[m_Canonical[to]];
+				collapses.push_back({ from, to, merged.Evaluate(m_Positions[to]) });
+			}
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const SCollapse& a, const SCollapse& b) { return a.m_Cost < b.m_Cost; });
+
+		// Collapses touching the neighbourhood of an earlier one wait for the next pass, its adjacency is stale
+		std::vector<bool> touched(m_Positions.size(), false);
+		std::vector<uint32_t> remap(m_Positions.size());
+		size_t triangles = Triangles();
+		bool collapsed = false;
+
+		for (uint32_t i = 0; i < remap.size(); ++i)
+		{
+			remap[i] = i;
+		}
+
+		for (const SCollapse& collapse : collapses)
+		{
+			const uint32_t from = collapse.m_From;
+			const uint32_t to = m_Canonical[collapse.m_To];
+
+			if (triangles <= target_triangles)
+			{
+				break;
+			}
+
+			if (touched[from] || touched[to] || !KeepsManifold(from, to) || !KeepsOrientation(from, m_Positions[to]))
+			{
+				continue;
+			}
+
+			for (uint32_t a = m_AdjacencyOffsets[from]; a < m_AdjacencyOffsets[from + 1]; ++a)
+			{
+				const uint32_t* triangle = &m_Indices[m_Adjacency[a] * 3];
+
+				for (size_t k = 0; k < 3; ++k)
+				{
+					touched[m_Canonical[triangle[k]]] = true;
+				}
+			}
+
+			// Triangles of the collapsed edge go away, two for a manifold edge
+			triangles -= 2;
+			remap[from] = collapse.m_To;
+			m_Quadrics[to] += m_Quadrics[from];
+			m_Error = std::max(m_Error, collapse.m_Cost);
+			collapsed = true;
+		}
+
+		// Apply the collapses and drop the triangles that fell flat
+		size_t write = 0;
+
+		for (size_t i = 0; i < m_Indices.size(); i += 3)
+		{
+			const uint32_t a = remap[m_Indices[i + 0]];
+			const uint32_t b = remap[m_Indices[i + 1]];
+			const uint32_t c = remap[m_Indices[i + 2]];
+
+			if (m_Canonical[a] == m_Canonical[b] || m_Canonical[b] == m_Canonical[c] || m_Canonical[c] == m_Canonical[a])
+			{
+				continue;
+			}
+
+			m_Indices[write++] = a;
+			m_Indices[write++] = b;
+			m_Indices[write++] = c;
+		}
+
+		m_Indices.resize(write);
+		return collapsed;
+	}
+
+	uint32_t m_Offset;
+	std::vector<CVector3f> m_Positions;
+	std::vector<uint32_t> m_Canonical;
+	std::vector<uint32_t> m_GroupSize;
+	std::vector<bool> m_Locked;
+	std::vector<SQuadric> m_Quadrics;
+	std::vector<uint32_t> m_Indices;
+
+	std::vector<uint32_t> m_AdjacencyOffsets;
+	std::vector<uint32_t> m_Adjacency;
+	std::vector<uint32_t> m_Marks;
+	uint32_t m_Stamp = 0;
+
+	// Squared, the largest cost of any collapse so far
+	double m_Error = 0.0;
+};
+
+bool IsSimplifiable(const NRender::SMesh& mesh, const SSubMesh& sub_mesh)
+{
+	for (size_t i = sub_mesh.m_IndexOffset; i < sub_mesh.m_IndexOffset + sub_mesh.m_IndexCount; ++i)
+	{
+		const uint32_t index = mesh.m_Indices[i];
+
+		if (index < sub_mesh.m_VertexOffset || index >= sub_mesh.m_VertexOffset + sub_mesh.m_VertexCount)
+		{
+			return false;
+		}
+	}
+
+	return sub_mesh.m_IndexCount % 3 == 0 && sub_mesh.m_IndexCount > 0;
+}
+}  // namespace
+
+void NUtils::GenerateLods(NRender::SMesh& mesh, size_t max_lods, float ratio)
+{
+	for (SSubMesh& sub_mesh : mesh.m_SubMeshes)
+	{
+		sub_mesh.m_Lods.clear();
+
+		if (!IsSimplifiable(mesh, sub_mesh))
+		{
+			continue;
+		}
+
+		CSimplifier simplifier(mesh, sub_mesh);
+		size_t previous = simplifier.Triangles();
+		size_t target = previous;
+
+		for (size_t lod = 0; lod < max_lods; ++lod)
+		{
+			target = size_t(target * ratio);
+			simplifier.Simplify(target);
+
+			if (simplifier.Triangles() == 0 || double(simplifier.Triangles()) > double(previous) * (1.0 - MIN_REDUCTION))
+			{
+				break;
+			}
+
+			NRender::SMesh::SLod level;
+			level.m_IndexOffset = mesh.m_Indices.size();
+			level.m_IndexCount = simplifier.Triangles() * 3;
+			level.m_Error = simplifier.Error();
+			simplifier.AppendIndices(mesh.m_Indices);
+			sub_mesh.m_Lods.push_back(level);
+
+			previous = simplifier.Triangles();
+		}
+	}
+}
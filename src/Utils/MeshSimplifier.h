@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stddef.h>
+
+namespace NRender
+{
+struct SMesh;
+}
+
+namespace NUtils
+{
+/**
+ * Quadric error edge collapses, each removed vertex is merged into one of its
+ * neighbours so every level indexes the submesh's own vertices. Vertices on
+ * borders, UV or normal seams and non-manifold edges are never removed, which
+ * keeps silhouettes and texture seams intact at the cost of some reduction.
+ *
+ * Up to max_lods coarser index ranges are appended per submesh, each with about
+ * ratio times the triangles of the level before. Levels that barely reduce the
+ * one before are left out, so a submesh may get fewer. Any existing levels are
+ * replaced, run it before OptimizeMesh so the new ranges are optimized as well.
+ **/
+void GenerateLods(NRender::SMesh& mesh, size_t max_lods = 4, float ratio = 0.5f);
+}  // namespace NUtils
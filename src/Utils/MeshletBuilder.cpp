@@ -0,0 +1,267 @@
+#include "MeshletBuilder.h"
+#include "MeshQuantizer.h"
+
+#include <Engine/Math.h>
+#include <Engine/Render/Mesh.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+namespace
+{
+using SSubMesh = NRender::SMesh::SSubMesh;
+
+// Clusters whose normals spread further than about 84 degrees from the axis never face away
+constexpr float CONE_MIN_DOT = 0.1f;
+
+bool IsLocal(const NRender::SMesh& mesh, const SSubMesh& sub_mesh)
+{
+	for (size_t i = sub_mesh.m_IndexOffset; i < sub_mesh.m_IndexOffset + sub_mesh.m_IndexCount; ++i)
+	{
+		const uint32_t index = mesh.m_Indices[i];
+
+		if (index < sub_mesh.m_VertexOffset || index >= sub_mesh.m_VertexOffset + sub_mesh.m_VertexCount)
+		{
+			return false;
+		}
+	}
+
+	return sub_mesh.m_IndexCount % 3 == 0;
+}
+
+void ComputeBounds(const std::vector<CVector3f>& positions, const uint32_t* indices, size_t index_count, NRender::SMesh::SMeshlets& meshlets, size_t meshlet)
+{
+	CVector3f min = CVector3f::Constant(FLT_MAX);
+	CVector3f max = CVector3f::Constant(-FLT_MAX);
+
+	for (size_t i = 0; i < index_count; ++i)
+	{
+		min = min.cwiseMin(positions[indices[i]]);
+		max = max.cwiseMax(positions[indices[i]]);
+	}
+
+	const CVector3f center = (min + max) * 0.5f;
+	float radius = 0.0f;
+
+	for (size_t i = 0; i < index_count; ++i)
+	{
+		radius = std::max(radius, (positions[indices[i]] - center).squaredNorm());
+	}
+
+	// The cone axis averages the triangle normals, its spread is the normal furthest from it
+	CVector3f axis = CVector3f::Zero();
+
+	for (size_t i = 0; i < index_count; i += 3)
+	{
+		const CVector3f& p0 = positions[indices[i]];
+		const CVector3f normal = (positions[indices[i + 1]] - p0).cross(positions[indices[i + 2]] - p0);
+		const float length = normal.norm();
+		axis += length > 0.0f ? CVector3f(normal / length) : CVector3f::Zero();
+	}
+
+	const float axis_length = axis.norm();
+	axis = axis_length > 0.0f ? CVector3f(axis / axis_length) : CVector3f::Zero();
+	float min_dot = axis_length > 0.0f ? 1.0f : -1.0f;
+
+	for (size_t i = 0; i < index_count; i += 3)
+	{
+		const CVector3f& p0 = positions[indices[i]];
+		const CVector3f normal = (positions[indices[i + 1]] - p0).cross(positions[indices[i + 2]] - p0);
+		const float length = normal.norm();
+
+		if (length > 0.0f)
+		{
+			min_dot = std::min(min_dot, axis.dot(normal) / length);
+		}
+	}
+
+	meshlets.m_CenterX[meshlet] = center.x();
+	meshlets.m_CenterY[meshlet] = center.y();
+	meshlets.m_CenterZ[meshlet] = center.z();
+	meshlets.m_Radius[meshlet] = std::sqrt(radius);
+	meshlets.m_AxisX[meshlet] = axis.x();
+	meshlets.m_AxisY[meshlet] = axis.y();
+	meshlets.m_AxisZ[meshlet] = axis.z();
+	meshlets.m_Cutoff[meshlet] = min_dot > CONE_MIN_DOT ? std::sqrt(1.0f - min_dot * min_dot) : 1.0f;
+}
+}  // namespace
+
+void NUtils::BuildMeshlets(NRender::SMesh& mesh, size_t max_vertices, size_t max_triangles)
+{
+	max_vertices = std::max<size_t>(max_vertices, 3);
+	max_triangles = std::max<size_t>(max_triangles, 1);
+
+	NRender::SMesh::SMeshlets& meshlets = mesh.m_Meshlets;
+	meshlets.Resize(0);
+
+	std::vector<CVector3f> positions;
+	std::vector<CVector3f> centroids;
+	std::vector<uint32_t> valence;
+	std::vector<uint32_t> adjacency_offset;
+	std::vector<uint32_t> adjacency;
+	std::vector<uint32_t> vertex_marks;
+	std::vector<bool> assigned;
+	std::vector<uint32_t> local;
+	std::vector<uint32_t> reordered;
+	std::vector<uint32_t> cluster_vertices;
+	std::vector<uint32_t> cluster_triangles;
+
+	for (SSubMesh& sub_mesh : mesh.m_SubMeshes)
+	{
+		sub_mesh.m_FirstMeshlet = meshlets.Size();
+		sub_mesh.m_MeshletCount = 0;
+
+		if (sub_mesh.m_IndexCount == 0 || !IsLocal(mesh, sub_mesh))
+		{
+			continue;
+		}
+
+		const size_t vertex_count = sub_mesh.m_VertexCount;
+		const size_t triangle_count = sub_mesh.m_IndexCount / 3;
+		uint32_t* indices = &mesh.m_Indices[sub_mesh.m_IndexOffset];
+
+		positions.resize(vertex_count);
+		local.resize(sub_mesh.m_IndexCount);
+
+		for (size_t v = 0; v < vertex_count; ++v)
+		{
+			positions[v] = GetVertexPosition(mesh, sub_mesh, sub_mesh.m_VertexOffset + v);
+		}
+
+		for (size_t i = 0; i < sub_mesh.m_IndexCount; ++i)
+		{
+			local[i] = indices[i] - sub_mesh.m_VertexOffset;
+		}
+
+		// Vertex to triangle adjacency, clusters grow across it
+		valence.assign(vertex_count, 0);
+		adjacency_offset.assign(vertex_count + 1, 0);
+		adjacency.resize(local.size());
+		centroids.resize(triangle_count);
+
+		for (uint32_t index : local)
+		{
+			++valence[index];
+		}
+
+		std::partial_sum(valence.begin(), valence.end(), adjacency_offset.begin() + 1);
+		std::vector<uint32_t> fill(adjacency_offset.begin(), adjacency_offset.end() - 1);
+
+		for (size_t i = 0; i < local.size(); ++i)
+		{
+			adjacency[fill[local[i]]++] = uint32_t(i / 3);
+		}
+
+		for (size_t t = 0; t < triangle_count; ++t)
+		{
+			centroids[t] = (positions[local[t * 3 + 0]] + positions[local[t * 3 + 1]] + positions[local[t * 3 + 2]]) / 3.0f;
+		}
+
+		// Vertices are marked with the cluster they were last added to, so marks never need clearing
+		vertex_marks.assign(vertex_count, 0);
+		assigned.assign(triangle_count, false);
+		reordered.clear();
+
+		size_t cursor = 0;
+		uint32_t cluster = 0;
+
+		while (reordered.size() < local.size())
+		{
+			// Seeds follow the incoming order, which the cache optimizer left spatially coherent
+			while (assigned[cursor])
+			{
+				++cursor;
+			}
+
+			++cluster;
+			cluster_vertices.clear();
+			cluster_triangles.clear();
+			CVector3f centroid_sum = CVector3f::Zero();
+
+			auto AddTriangle = [&](size_t t) {
+				assigned[t] = true;
+				cluster_triangles.push_back(uint32_t(t));
+				centroid_sum += centroids[t];
+
+				for (size_t k = 0; k < 3; ++k)
+				{
+					const uint32_t v = local[t * 3 + k];
+
+					if (vertex_marks[v] != cluster)
+					{
+						vertex_marks[v] = cluster;
+						cluster_vertices.push_back(v);
+					}
+				}
+			};
+
+			AddTriangle(cursor);
+
+			// Grow by the triangle adding the fewest new vertices, the closest one on ties
+			while (cluster_triangles.size() < max_triangles)
+			{
+				const CVector3f centroid = centroid_sum / float(cluster_triangles.size());
+				int64_t best = -1;
+				size_t best_new = 3;
+				float best_distance = FLT_MAX;
+
+				for (uint32_t v : cluster_vertices)
+				{
+					for (uint32_t a = adjacency_offset[v]; a < adjacency_offset[v + 1]; ++a)
+					{
+						const uint32_t t = adjacency[a];
+
+						if (assigned[t])
+						{
+							continue;
+						}
+
+						const size_t added = size_t(vertex_marks[local[t * 3 + 0]] != cluster) +
+											 size_t(vertex_marks[local[t * 3 + 1]] != cluster) +
+											 size_t(vertex_marks[local[t * 3 + 2]] != cluster);
+						const float distance = (centroids[t] - centroid).squaredNorm();
+
+						if (cluster_vertices.size() + added <= max_vertices && (added < best_new || (added == best_new && distance < best_distance)))
+						{
+							best = t;
+							best_new = added;
+							best_distance = distance;
+						}
+					}
+				}
+
+				if (best < 0)
+				{
+					break;
+				}
+
+				AddTriangle(size_t(best));
+			}
+
+			// Within a cluster the incoming, cache friendly order is kept
+			std::sort(cluster_triangles.begin(), cluster_triangles.end());
+
+			const size_t meshlet = meshlets.Size();
+			meshlets.Resize(meshlet + 1);
+			meshlets.m_IndexOffset[meshlet] = uint32_t(sub_mesh.m_IndexOffset + reordered.size());
+			meshlets.m_IndexCount[meshlet] = uint32_t(cluster_triangles.size() * 3);
+
+			for (uint32_t t : cluster_triangles)
+			{
+				reordered.insert(reordered.end(), &local[t * 3], &local[t * 3] + 3);
+			}
+
+			ComputeBounds(positions, &reordered[reordered.size() - cluster_triangles.size() * 3], cluster_triangles.size() * 3, meshlets, meshlet);
+		}
+
+		for (size_t i = 0; i < sub_mesh.m_IndexCount; ++i)
+		{
+			indices[i] = reordered[i] + sub_mesh.m_VertexOffset;
+		}
+
+		sub_mesh.m_MeshletCount = meshlets.Size() - sub_mesh.m_FirstMeshlet;
+	}
+}
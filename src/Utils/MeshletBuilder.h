@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stddef.h>
+
+namespace NRender
+{
+struct SMesh;
+}
+
+namespace NUtils
+{
+/**
+ * Splits the full detail range of every submesh into clusters of at most
+ * max_triangles triangles touching at most max_vertices vertices, and computes
+ * their bounding spheres and normal cones. Clusters grow over shared vertices,
+ * preferring triangles close to the cluster, so they stay compact enough to cull.
+ *
+ * Triangles are reordered so each cluster is contiguous, anything reordering
+ * them afterwards invalidates the clusters. Run it after OptimizeMesh, which
+ * leaves the order within each cluster cache friendly.
+ **/
+void BuildMeshlets(NRender::SMesh& mesh, size_t max_vertices = 64, size_t max_triangles = 124);
+}  // namespace NUtils
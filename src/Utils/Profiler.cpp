@@ -0,0 +1,250 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include <stdio.h>
+
+std::atomic<bool> NUtils::CProfiler::s_Enabled{ false };
+thread_local NUtils::CProfiler::SRing* NUtils::CProfiler::t_Ring = nullptr;
+
+// Zones open on this thread, which is the depth of the next one
+static thread_local uint32_t t_Depth = 0;
+
+static void AppendString(std::string& json, const char* text)
+{
+	json += '"';
+
+	for (; *text; ++text)
+	{
+		if (*text == '"' || *text == '\\')
+		{
+			json += '\\';
+		}
+
+		json += uint8_t(*text) < 0x20 ? ' ' : *text;
+	}
+
+	json += '"';
+}
+
+void NUtils::CProfiler::SetEnabled(bool enabled)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	// Time spent disabled doesn't belong to any frame
+	m_FrameStart = Now();
+	s_Enabled.store(enabled, std::memory_order_relaxed);
+}
+
+uint64_t NUtils::CProfiler::Now()
+{
+	static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void NUtils::CProfiler::NameThread(const char* name)
+{
+	SRing& ring = ThreadRing();
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	ring.m_Name = name;
+}
+
+void NUtils::CProfiler::BeginFrame()
+{
+	if (!IsEnabled())
+	{
+		return;
+	}
+
+	SRing& ring = ThreadRing();
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	SProfileFrame frame;
+	frame.m_Index = m_FrameIndex.load(std::memory_order_relaxed);
+	frame.m_Start = m_FrameStart;
+	frame.m_End = Now();
+	m_Frames.push_back(frame);
+	m_FrameEvents.push_back(0);
+
+	Collect(ring);
+
+	// Zones go along with the frame that collected them
+	if (m_Frames.size() > FrameHistory)
+	{
+		m_Events.erase(m_Events.begin(), m_Events.begin() + m_FrameEvents.front());
+		m_Frames.pop_front();
+		m_FrameEvents.pop_front();
+	}
+
+	m_FrameStart = frame.m_End;
+	m_FrameIndex.store(frame.m_Index + 1, std::memory_order_relaxed);
+}
+
+void NUtils::CProfiler::AddGpuZone(uint64_t frame, const char* name, uint64_t start, double milliseconds)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	if (m_Frames.empty() || frame < m_Frames.front().m_Index || frame > m_Frames.back().m_Index)
+	{
+		return;
+	}
+
+	SProfileFrame& profile_frame = m_Frames[frame - m_Frames.front().m_Index];
+	profile_frame.m_GpuMs = std::max(profile_frame.m_GpuMs, 0.0) + milliseconds;
+
+	// There are no GPU timestamps, so the zone is placed where the CPU issued it
+	m_Events.push_back({ name, start, start + uint64_t(milliseconds * 1e6), GpuThread, 0 });
+	++m_FrameEvents.back();
+}
+
+std::vector<NUtils::SProfileFrame> NUtils::CProfiler::Frames()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return std::vector<SProfileFrame>(m_Frames.begin(), m_Frames.end());
+}
+
+std::vector<NUtils::SProfileEvent> NUtils::CProfiler::Events()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return std::vector<SProfileEvent>(m_Events.begin(), m_Events.end());
+}
+
+size_t NUtils::CProfiler::Dropped()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	size_t dropped = 0;
+
+	for (const std::unique_ptr<SRing>& ring : m_Rings)
+	{
+		dropped += ring->m_Dropped.load(std::memory_order_relaxed);
+	}
+
+	return dropped;
+}
+
+void NUtils::CProfiler::ExportChromeTrace(std::string& json)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	char buffer[128];
+
+	json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GPU\"}}";
+
+	for (const std::unique_ptr<SRing>& ring : m_Rings)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "Thread %u", ring->m_Thread);
+		snprintf(buffer, sizeof(buffer), ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", ring->m_Thread);
+		json += buffer;
+		AppendString(json, ring->m_Name.empty() ? name : ring->m_Name.c_str());
+		json += "}}";
+	}
+
+	// Complete events, timestamps and durations are in microseconds
+	for (const SProfileEvent& event : m_Events)
+	{
+		json += ",\n{\"name\":";
+		AppendString(json, event.m_Name);
+		snprintf(buffer, sizeof(buffer), ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+				 event.m_Thread == GpuThread ? "gpu" : "cpu",
+				 event.m_Start * 1e-3, (event.m_End - event.m_Start) * 1e-3,
+				 event.m_Thread);
+		json += buffer;
+	}
+
+	json += "\n]}\n";
+}
+
+bool NUtils::CProfiler::SaveChromeTrace(const char* filename)
+{
+	std::string json;
+	ExportChromeTrace(json);
+
+	FILE* file = fopen(filename, "wb");
+
+	if (!file)
+	{
+		printf("Failed to open trace for writing: %s\n", filename);
+		return false;
+	}
+
+	const bool written = fwrite(json.data(), 1, json.size(), file) == json.size();
+	fclose(file);
+
+	if (!written)
+	{
+		printf("Failed to write trace: %s\n", filename);
+	}
+
+	return written;
+}
+
+void NUtils::CProfiler::Record(const char* name, uint64_t start, uint64_t end, uint32_t depth)
+{
+	SRing& ring = ThreadRing();
+	const uint64_t head = ring.m_Head.load(std::memory_order_relaxed);
+
+	// A full ring means frames aren't being collected quickly enough, drop rather than wait
+	if (head - ring.m_Tail.load(std::memory_order_acquire) >= RingCapacity)
+	{
+		ring.m_Dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	ring.m_Events[head % RingCapacity] = { name, start, end, ring.m_Thread, depth };
+	ring.m_Head.store(head + 1, std::memory_order_release);
+}
+
+NUtils::CProfiler::SRing& NUtils::CProfiler::ThreadRing()
+{
+	if (t_Ring)
+	{
+		return *t_Ring;
+	}
+
+	// Rings outlive their threads, a thread that exits leaves its last zones to be collected
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Rings.push_back(std::make_unique<SRing>());
+	m_Rings.back()->m_Thread = uint32_t(m_Rings.size());
+	t_Ring = m_Rings.back().get();
+	return *m_Rings.back();
+}
+
+void NUtils::CProfiler::Collect(SRing& frame_ring)
+{
+	SProfileFrame& frame = m_Frames.back();
+
+	for (const std::unique_ptr<SRing>& ring : m_Rings)
+	{
+		const uint64_t head = ring->m_Head.load(std::memory_order_acquire);
+		uint64_t tail = ring->m_Tail.load(std::memory_order_relaxed);
+
+		for (; tail < head; ++tail)
+		{
+			const SProfileEvent& event = ring->m_Events[tail % RingCapacity];
+			m_Events.push_back(event);
+			++m_FrameEvents.back();
+
+			if (ring.get() == &frame_ring && event.m_Depth == 0 && event.m_Start >= frame.m_Start)
+			{
+				frame.m_CpuMs += (event.m_End - event.m_Start) * 1e-6;
+			}
+		}
+
+		ring->m_Tail.store(head, std::memory_order_release);
+	}
+}
+
+void NUtils::CProfileZone::Begin(const char* name)
+{
+	m_Name = name;
+	m_Start = CProfiler::Now();
+	++t_Depth;
+}
+
+void NUtils::CProfileZone::End()
+{
+	--t_Depth;
+	CProfiler::Instance().Record(m_Name, m_Start, CProfiler::Now(), t_Depth);
+}
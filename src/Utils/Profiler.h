@@ -0,0 +1,148 @@
+#pragma once
+
+#include "Singleton.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace NUtils
+{
+// A finished zone, times are nanoseconds since the profiler was first used
+struct SProfileEvent
+{
+	const char* m_Name;
+	uint64_t m_Start;
+	uint64_t m_End;
+	uint32_t m_Thread;
+	uint32_t m_Depth;
+};
+
+struct SProfileFrame
+{
+	uint64_t m_Index = 0;
+	uint64_t m_Start = 0;
+	uint64_t m_End = 0;
+
+	// Time spent in the outermost zones of the thread running the frames
+	double m_CpuMs = 0.0;
+
+	// Negative until the GPU timer resolves the frame, which never happens without one
+	double m_GpuMs = -1.0;
+
+	double FrameMs() const { return (m_End - m_Start) * 1e-6; }
+};
+
+/**
+ * Hierarchical zones recorded on any thread. Each thread writes its zones to a
+ * ring of its own without taking a lock, the thread running the frames drains
+ * the rings whenever a frame begins and keeps the last FrameHistory frames for
+ * display and export. Zones dropped because a ring filled up are counted.
+ * While disabled a zone costs a relaxed load and a branch.
+ **/
+class CProfiler : public TSingleton<CProfiler>
+{
+public:
+	static constexpr size_t RingCapacity = 4096;
+	static constexpr size_t FrameHistory = 240;
+
+	// GPU zones are exported as a thread of their own
+	static constexpr uint32_t GpuThread = 0;
+
+	static bool IsEnabled() { return s_Enabled.load(std::memory_order_relaxed); }
+	void SetEnabled(bool enabled);
+
+	static uint64_t Now();
+
+	// Names the calling thread in exports
+	void NameThread(const char* name);
+
+	// Closes the previous frame and collects every thread's zones, call first thing each frame
+	void BeginFrame();
+
+	// GPU results arrive a few frames late, they're attached to the frame that issued them
+	void AddGpuZone(uint64_t frame, const char* name, uint64_t start, double milliseconds);
+	uint64_t FrameIndex() const { return m_FrameIndex.load(std::memory_order_relaxed); }
+
+	// Completed frames and their zones, oldest first
+	std::vector<SProfileFrame> Frames();
+	std::vector<SProfileEvent> Events();
+	size_t Dropped();
+
+	// Chrome's trace event format, loads in chrome://tracing and Perfetto
+	void ExportChromeTrace(std::string& json);
+	bool SaveChromeTrace(const char* filename);
+
+	void Record(const char* name, uint64_t start, uint64_t end, uint32_t depth);
+
+private:
+	// Written by its thread only, drained by the frame thread only
+	struct SRing
+	{
+		SProfileEvent m_Events[RingCapacity];
+		std::atomic<uint64_t> m_Head{ 0 };
+		std::atomic<uint64_t> m_Tail{ 0 };
+		std::atomic<size_t> m_Dropped{ 0 };
+		uint32_t m_Thread = 0;
+		std::string m_Name;
+	};
+
+	SRing& ThreadRing();
+	void Collect(SRing& frame_ring);
+
+	static std::atomic<bool> s_Enabled;
+	static thread_local SRing* t_Ring;
+
+	std::mutex m_Mutex;
+	std::vector<std::unique_ptr<SRing>> m_Rings;
+	std::deque<SProfileFrame> m_Frames;
+
+	// Events in the order they were collected, with how many each frame collected
+	std::deque<SProfileEvent> m_Events;
+	std::deque<size_t> m_FrameEvents;
+	std::atomic<uint64_t> m_FrameIndex{ 0 };
+	uint64_t m_FrameStart = 0;
+};
+
+class CProfileZone
+{
+public:
+	explicit CProfileZone(const char* name)
+	{
+		if (CProfiler::IsEnabled())
+		{
+			Begin(name);
+		}
+	}
+
+	~CProfileZone()
+	{
+		if (m_Name)
+		{
+			End();
+		}
+	}
+
+	CProfileZone(const CProfileZone&) = delete;
+	CProfileZone& operator=(const CProfileZone&) = delete;
+
+private:
+	void Begin(const char* name);
+	void End();
+
+	const char* m_Name = nullptr;
+	uint64_t m_Start = 0;
+};
+}  // namespace NUtils
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+// Times the rest of the enclosing scope, names are kept by pointer so they have to be literals
+#define PROFILE_ZONE(name) NUtils::CProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
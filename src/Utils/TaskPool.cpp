@@ -0,0 +1,158 @@
+#include "TaskPool.h"
+#include "Profiler.h"
+
+// Queue of the pool worker running on this thread, threads outside the pool have none
+static thread_local size_t t_Queue = ~size_t(0);
+
+NUtils::CTaskPool::~CTaskPool()
+{
+	Stop();
+}
+
+void NUtils::CTaskPool::Start(size_t threads)
+{
+	Stop();
+
+	for (size_t i = 0; i < threads; ++i)
+	{
+		m_Queues.push_back(std::make_unique<SQueue>());
+	}
+
+	for (size_t i = 0; i < threads; ++i)
+	{
+		m_Workers.emplace_back(&CTaskPool::Work, this, i);
+	}
+}
+
+void NUtils::CTaskPool::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stopping = true;
+	}
+
+	m_Wake.notify_all();
+
+	for (std::thread& worker : m_Workers)
+	{
+		worker.join();
+	}
+
+	m_Workers.clear();
+	m_Queues.clear();
+	m_Stopping = false;
+}
+
+void NUtils::CTaskPool::ParallelFor(size_t count, const std::function<void(size_t index)>& function)
+{
+	// Nothing to share the work with, don't bother queueing it
+	if (m_Workers.empty() || count < 2)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			function(i);
+		}
+
+		return;
+	}
+
+	SBatch batch;
+	batch.m_Function = &function;
+	batch.m_Remaining = count;
+
+	// Workers keep the batch to themselves until someone steals, outside threads spread it out
+	const bool worker = t_Queue < m_Queues.size();
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		SQueue& queue = *m_Queues[worker ? t_Queue : i % m_Queues.size()];
+		std::lock_guard<std::mutex> lock(queue.m_Mutex);
+		queue.m_Tasks.push_back({ &batch, i });
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Queued += count;
+	}
+
+	m_Wake.notify_all();
+
+	// Help out until nothing is left to take, the rest of the batch is running elsewhere by then
+	while (TryRun(worker ? t_Queue : 0))
+	{
+	}
+
+	std::unique_lock<std::mutex> lock(batch.m_Mutex);
+	batch.m_Done.wait(lock, [&batch]() { return batch.m_Remaining == 0; });
+}
+
+bool NUtils::CTaskPool::TryRun(size_t queue)
+{
+	STask task = {};
+	bool found = false;
+
+	for (size_t i = 0; i < m_Queues.size() && !found; ++i)
+	{
+		SQueue& victim = *m_Queues[(queue + i) % m_Queues.size()];
+		std::lock_guard<std::mutex> lock(victim.m_Mutex);
+
+		if (victim.m_Tasks.empty())
+		{
+			continue;
+		}
+
+		// The newest task of our own queue is the most likely to be cache warm, thieves take the oldest
+		if (i == 0 && queue == t_Queue)
+		{
+			task = victim.m_Tasks.back();
+			victim.m_Tasks.pop_back();
+		}
+		else
+		{
+			task = victim.m_Tasks.front();
+			victim.m_Tasks.pop_front();
+		}
+
+		found = true;
+	}
+
+	if (!found)
+	{
+		return false;
+	}
+
+	--m_Queued;
+	(*task.m_Batch->m_Function)(task.m_Index);
+
+	// Counted under the lock, so the batch can't go out of scope before we're done notifying
+	std::lock_guard<std::mutex> lock(task.m_Batch->m_Mutex);
+
+	if (--task.m_Batch->m_Remaining == 0)
+	{
+		task.m_Batch->m_Done.notify_all();
+	}
+
+	return true;
+}
+
+void NUtils::CTaskPool::Work(size_t queue)
+{
+	t_Queue = queue;
+	CProfiler::Instance().NameThread("Task pool");
+
+	for (;;)
+	{
+		if (TryRun(queue))
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Wake.wait(lock, [this]() { return m_Stopping || m_Queued > 0; });
+
+		if (m_Stopping)
+		{
+			return;
+		}
+	}
+}
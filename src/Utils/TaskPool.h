@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Singleton.h"
+
+#include <stddef.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace NUtils
+{
+/**
+ * Work stealing pool for short, independent batches of work. Every worker owns a
+ * deque, it takes its own work from the back and steals from the front of the
+ * others once it runs dry. The thread starting a batch works on it as well, so
+ * batches may be started from inside a task or from threads outside the pool.
+ **/
+class CTaskPool : public TSingleton<CTaskPool>
+{
+public:
+	~CTaskPool();
+
+	// Restarting is only allowed while no batch is running
+	void Start(size_t threads);
+	void Stop();
+
+	size_t Threads() const { return m_Workers.size(); }
+
+	// Calls function for every index below count and returns once all calls are done
+	void ParallelFor(size_t count, const std::function<void(size_t index)>& function);
+
+private:
+	struct SBatch
+	{
+		const std::function<void(size_t index)>* m_Function = nullptr;
+		size_t m_Remaining = 0;
+		std::mutex m_Mutex;
+		std::condition_variable m_Done;
+	};
+
+	struct STask
+	{
+		SBatch* m_Batch;
+		size_t m_Index;
+	};
+
+	struct SQueue
+	{
+		std::mutex m_Mutex;
+		std::deque<STask> m_Tasks;
+	};
+
+	// Runs a task from the given queue, or one stolen from any other, returns false if there was none
+	bool TryRun(size_t queue);
+	void Work(size_t queue);
+
+	std::vector<std::unique_ptr<SQueue>> m_Queues;
+	std::vector<std::thread> m_Workers;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_Wake;
+	std::atomic<size_t> m_Queued{ 0 };
+	bool m_Stopping = false;
+};
+}  // namespace NUtils
@@ -0,0 +1,101 @@
+#include "TextureCache.h"
+#include "Profiler.h"
+#include "TaskPool.h"
+
+#include <Engine/Render/Texture.h>
+
+NRender::HTexture NUtils::CTextureCache::Get(const std::string& path, const TextureLoader& load_texture)
+{
+	std::promise<NRender::HTexture> promise;
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	for (;;)
+	{
+		SEntry& entry = m_Entries[path];
+
+		if (NRender::HTexture texture = entry.m_Texture.lock())
+		{
+			++m_Hits;
+			return texture;
+		}
+
+		if (!entry.m_Loading.valid())
+		{
+			break;
+		}
+
+		// A decode that failed, or was cancelled by its requester, is retried by each waiter
+		std::shared_future<NRender::HTexture> loading = entry.m_Loading;
+		lock.unlock();
+
+		if (NRender::HTexture texture = loading.get())
+		{
+			lock.lock();
+			++m_Hits;
+			return texture;
+		}
+
+		lock.lock();
+	}
+
+	++m_Misses;
+	m_Entries[path].m_Loading = promise.get_future().share();
+	lock.unlock();
+
+	// Decoded outside the lock, other paths shouldn't wait on this one
+	NRender::HTexture texture;
+
+	{
+		PROFILE_ZONE("Decode texture");
+		texture = load_texture(path);
+	}
+
+	lock.lock();
+	SEntry& entry = m_Entries[path];
+	entry.m_Texture = texture;
+	entry.m_Loading = {};
+	lock.unlock();
+
+	promise.set_value(texture);
+	return texture;
+}
+
+NUtils::STextureCacheStats NUtils::CTextureCache::Stats()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	for (auto it = m_Entries.begin(); it != m_Entries.end();)
+	{
+		it = it->second.m_Texture.expired() && !it->second.m_Loading.valid() ? m_Entries.erase(it) : std::next(it);
+	}
+
+	STextureCacheStats stats;
+	stats.m_Hits = m_Hits;
+	stats.m_Misses = m_Misses;
+	stats.m_Textures = m_Entries.size();
+	return stats;
+}
+
+std::vector<NRender::HTexture> NUtils::LoadTextures(const std::vector<std::string>& paths, const TextureLoader& load_texture)
+{
+	std::vector<NRender::HTexture> textures(paths.size());
+
+	if (!load_texture)
+	{
+		for (size_t i = 0; i < paths.size(); ++i)
+		{
+			textures[i] = std::make_shared<NRender::STexture>();
+			textures[i]->m_Name = paths[i];
+		}
+
+		return textures;
+	}
+
+	PROFILE_ZONE("Load textures");
+
+	CTaskPool::Instance().ParallelFor(paths.size(), [&](size_t index) {
+		textures[index] = CTextureCache::Instance().Get(paths[index], load_texture);
+	});
+
+	return textures;
+}
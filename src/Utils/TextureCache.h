@@ -0,0 +1,54 @@
+#pragma once
+
+#include "TextureLoader.h"
+#include "Singleton.h"
+
+#include <stddef.h>
+
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace NUtils
+{
+struct STextureCacheStats
+{
+	size_t m_Hits = 0;
+	size_t m_Misses = 0;
+	size_t m_Textures = 0;
+};
+
+/**
+ * Decoded textures by path, shared by every mesh in the process. Only weak
+ * references are kept, so a texture is decoded once for as long as anything
+ * holds on to it. Threads asking for a texture that is still being decoded wait
+ * for that decode instead of starting their own.
+ **/
+class CTextureCache : public TSingleton<CTextureCache>
+{
+public:
+	// The first loader to ask for a path decodes it, failed loads aren't cached
+	NRender::HTexture Get(const std::string& path, const TextureLoader& load_texture);
+
+	// Live textures only, entries of released ones are dropped first
+	STextureCacheStats Stats();
+
+private:
+	struct SEntry
+	{
+		std::weak_ptr<NRender::STexture> m_Texture;
+		std::shared_future<NRender::HTexture> m_Loading;
+	};
+
+	std::mutex m_Mutex;
+	std::unordered_map<std::string, SEntry> m_Entries;
+	size_t m_Hits = 0;
+	size_t m_Misses = 0;
+};
+
+// Decodes the paths as a single parallel batch on the task pool, going through the cache.
+// Without a loader the textures are only named, for tools that just pass the references on.
+std::vector<NRender::HTexture> LoadTextures(const std::vector<std::string>& paths, const TextureLoader& load_texture);
+}  // namespace NUtils
@@ -0,0 +1,684 @@
+#include "TextureCompressor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <stdio.h>
+
+namespace
+{
+using ETextureFormat = NRender::ETextureFormat;
+
+// ETC1 intensity modifiers, a pixel index picks +a, +b, -a or -b
+constexpr int ETC_MODIFIERS[8][2] = {
+	{ 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 },
+};
+
+constexpr int EAC_MODIFIERS[16][8] = {
+	{ -3, -6, -9, -15, 2, 5, 8, 14 },
+	{ -3, -7, -10, -13, 2, 6, 9, 12 },
+	{ -2, -5, -8, -13, 1, 4, 7, 12 },
+	{ -2, -4, -6, -13, 1, 3, 5, 12 },
+	{ -3, -6, -8, -12, 2, 5, 7, 11 },
+	{ -3, -7, -9, -11, 2, 6, 8, 10 },
+	{ -4, -7, -8, -11, 3, 6, 7, 10 },
+	{ -3, -5, -8, -11, 2, 4, 7, 10 },
+	{ -2, -6, -8, -10, 1, 5, 7, 9 },
+	{ -2, -5, -8, -10, 1, 4, 7, 9 },
+	{ -2, -4, -8, -10, 1, 3, 7, 9 },
+	{ -2, -5, -7, -10, 1, 4, 6, 9 },
+	{ -3, -4, -7, -10, 2, 3, 6, 9 },
+	{ -1, -2, -3, -10, 0, 1, 2, 9 },
+	{ -4, -6, -8, -9, 3, 5, 7, 8 },
+	{ -3, -5, -7, -9, 2, 4, 6, 8 },
+};
+
+// A decoded 4x4 block, pixels in row major order with four channels each
+using SBlock = uint8_t[16][4];
+
+int Clamp(int value, int low, int high)
+{
+	return std::min(std::max(value, low), high);
+}
+
+int EtcModifier(int table, int index)
+{
+	const int modifier = ETC_MODIFIERS[table][index & 1];
+	return index & 2 ? -modifier : modifier;
+}
+
+void WriteBigEndian(uint64_t value, uint8_t* output)
+{
+	for (int i = 0; i < 8; ++i)
+	{
+		output[i] = uint8_t(value >> (56 - i * 8));
+	}
+}
+
+uint64_t ReadBigEndian(const uint8_t* input)
+{
+	uint64_t value = 0;
+	for (int i = 0; i < 8; ++i)
+	{
+		value = (value << 8) | input[i];
+	}
+
+	return value;
+}
+
+// ETC indices are stored column major, x * 4 + y
+int ColumnMajor(int pixel)
+{
+	return (pixel & 3) * 4 + (pixel >> 2);
+}
+
+bool InSubBlock(int pixel, bool flip, int sub_block)
+{
+	return (flip ? (pixel >> 2) >= 2 : (pixel & 3) >= 2) == (sub_block == 1);
+}
+
+// Picks the table and per pixel indices for one half block around a fixed base color
+int EncodeSubBlock(const SBlock& block, bool flip, int sub_block, const int (&base)[3], int& best_table, int (&indices)[16])
+{
+	int best_error = std::numeric_limits<int>::max();
+
+	for (int table = 0; table < 8; ++table)
+	{
+		int error = 0;
+		int table_indices[16];
+
+		for (int pixel = 0; pixel < 16; ++pixel)
+		{
+			if (!InSubBlock(pixel, flip, sub_block))
+			{
+				continue;
+			}
+
+			int pixel_error = std::numeric_limits<int>::max();
+
+			for (int index = 0; index < 4; ++index)
+			{
+				int candidate = 0;
+				for (int c = 0; c < 3; ++c)
+				{
+					const int difference = Clamp(base[c] + EtcModifier(table, index), 0, 255) - block[pixel][c];
+					candidate += difference * difference;
+				}
+
+				if (candidate < pixel_error)
+				{
+					pixel_error = candidate;
+					table_indices[pixel] = index;
+				}
+			}
+
+			error += pixel_error;
+		}
+
+		if (error < best_error)
+		{
+			best_error = error;
+			best_table = table;
+
+			for (int pixel = 0; pixel < 16; ++pixel)
+			{
+				if (InSubBlock(pixel, flip, sub_block))
+				{
+					indices[pixel] = table_indices[pixel];
+				}
+			}
+		}
+	}
+
+	return best_error;
+}
+
+// Individual and differential ETC1 modes, which ETC2 RGB decoders read unchanged
+uint64_t EncodeEtc1(const SBlock& block)
+{
+	uint64_t best_block = 0;
+	int best_error = std::numeric_limits<int>::max();
+
+	for (int flip = 0; flip < 2; ++flip)
+	{
+		int average[2][3] = {};
+
+		for (int pixel = 0; pixel < 16; ++pixel)
+		{
+			const int sub_block = InSubBlock(pixel, flip, 1) ? 1 : 0;
+			for (int c = 0; c < 3; ++c)
+			{
+				average[sub_block][c] += block[pixel][c];
+			}
+		}
+
+		for (int differential = 0; differential < 2; ++differential)
+		{
+			int quantized[2][3];
+			int base[2][3];
+
+			for (int sub_block = 0; sub_block < 2; ++sub_block)
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					const int value = (average[sub_block][c] + 4) / 8;
+
+					if (differential)
+					{
+						quantized[sub_block][c] = (value * 31 + 127) / 255;
+						base[sub_block][c] = (quantized[sub_block][c] << 3) | (quantized[sub_block][c] >> 2);
+					}
+					else
+					{
+						quantized[sub_block][c] = (value * 15 + 127) / 255;
+						base[sub_block][c] = quantized[sub_block][c] * 17;
+					}
+				}
+			}
+
+			// Deltas outside the 3-bit range would select the other ETC2 modes
+			if (differential)
+			{
+				bool representable = true;
+				for (int c = 0; c < 3; ++c)
+				{
+					const int delta = quantized[1][c] - quantized[0][c];
+					representable &= delta >= -4 && delta <= 3;
+				}
+
+				if (!representable)
+				{
+					continue;
+				}
+			}
+
+			int tables[2] = {};
+			int indices[16] = {};
+			const int error = EncodeSubBlock(block, flip, 0, base[0], tables[0], indices) + EncodeSubBlock(block, flip, 1, base[1], tables[1], indices);
+
+			if (error >= best_error)
+			{
+				continue;
+			}
+
+			uint32_t high = 0;
+			uint32_t low = 0;
+
+			if (differential)
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					high |= uint32_t(quantized[0][c]) << (27 - c * 8);
+					high |= uint32_t((quantized[1][c] - quantized[0][c]) & 7) << (24 - c * 8);
+				}
+			}
+			else
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					high |= uint32_t(quantized[0][c]) << (28 - c * 8);
+					high |= uint32_t(quantized[1][c]) << (24 - c * 8);
+				}
+			}
+
+			high |= uint32_t(tables[0]) << 5 | uint32_t(tables[1]) << 2 | uint32_t(differential) << 1 | uint32_t(flip);
+
+			for (int pixel = 0; pixel < 16; ++pixel)
+			{
+				const int bit = ColumnMajor(pixel);
+				low |= uint32_t(indices[pixel] >> 1) << (16 + bit) | uint32_t(indices[pixel] & 1) << bit;
+			}
+
+			best_error = error;
+			best_block = uint64_t(high) << 32 | low;
+		}
+	}
+
+	return best_block;
+}
+
+void DecodeEtc1(uint64_t encoded, SBlock& block)
+{
+	const uint32_t high = uint32_t(encoded >> 32);
+	const uint32_t low = uint32_t(encoded);
+	const bool flip = high & 1;
+	const bool differential = high & 2;
+	const int tables[2] = { int(high >> 5) & 7, int(high >> 2) & 7 };
+
+	int base[2][3];
+	for (int c = 0; c < 3; ++c)
+	{
+		if (differential)
+		{
+			const int first = (high >> (27 - c * 8)) & 31;
+			const int delta = int((high >> (24 - c * 8)) & 7) - ((high >> (24 - c * 8)) & 4 ? 8 : 0);
+			const int second = first + delta;
+			base[0][c] = (first << 3) | (first >> 2);
+			base[1][c] = (second << 3) | (second >> 2);
+		}
+		else
+		{
+			base[0][c] = ((high >> (28 - c * 8)) & 15) * 17;
+			base[1][c] = ((high >> (24 - c * 8)) & 15) * 17;
+		}
+	}
+
+	for (int pixel = 0; pixel < 16; ++pixel)
+	{
+		const int bit = ColumnMajor(pixel);
+		const int index = int((low >> (16 + bit)) & 1) << 1 | int((low >> bit) & 1);
+		const int sub_block = InSubBlock(pixel, flip, 1) ? 1 : 0;
+
+		for (int c = 0; c < 3; ++c)
+		{
+			block[pixel][c] = uint8_t(Clamp(base[sub_block][c] + EtcModifier(tables[sub_block], index), 0, 255));
+		}
+	}
+}
+
+// EAC decodes to 8 bits for alpha, or to 11 bits for the R11 and RG11 formats
+int DecodeEacValue(int base, int multiplier, int modifier, bool eleven_bit)
+{
+	if (!eleven_bit)
+	{
+		return Clamp(base + modifier * multiplier, 0, 255);
+	}
+
+	const int value = Clamp(base * 8 + 4 + (multiplier ? modifier * multiplier * 8 : modifier), 0, 2047);
+	return (value * 255 + 1023) / 2047;
+}
+
+uint64_t EncodeEac(const SBlock& block, int channel, bool eleven_bit)
+{
+	int low = 255;
+	int high = 0;
+
+	for (int pixel = 0; pixel < 16; ++pixel)
+	{
+		low = std::min<int>(low, block[pixel][channel]);
+		high = std::max<int>(high, block[pixel][channel]);
+	}
+
+	uint64_t best_block = 0;
+	int best_error = std::numeric_limits<int>::max();
+
+	// Only multipliers and bases close to what spans the block's range are searched
+	for (int table = 0; table < 16 && best_error > 0; ++table)
+	{
+		const int* modifiers = EAC_MODIFIERS[table];
+		const int range = modifiers[7] - modifiers[3];
+		const int ideal_multiplier = Clamp((high - low + range / 2) / range, 1, 15);
+
+		for (int multiplier = std::max(ideal_multiplier - 1, 1); multiplier <= std::min(ideal_multiplier + 1, 15); ++multiplier)
+		{
+			const int center = (low + high - (modifiers[7] + modifiers[3]) * multiplier) / 2;
+
+			for (int base = Clamp(center - 1, 0, 255); base <= Clamp(center + 1, 0, 255); ++base)
+			{
+				int error = 0;
+				uint64_t indices = 0;
+
+				for (int pixel = 0; pixel < 16 && error < best_error; ++pixel)
+				{
+					int pixel_error = std::numeric_limits<int>::max();
+					int best_index = 0;
+
+					for (int index = 0; index < 8; ++index)
+					{
+						const int difference = DecodeEacValue(base, multiplier, modifiers[index], eleven_bit) - block[pixel][channel];
+
+						if (difference * difference < pixel_error)
+						{
+							pixel_error = difference * difference;
+							best_index = index;
+						}
+					}
+
+					error += pixel_error;
+					indices |= uint64_t(best_index) << (45 - ColumnMajor(pixel) * 3);
+				}
+
+				if (error < best_error)
+				{
+					best_error = error;
+					best_block = uint64_t(base) << 56 | uint64_t(multiplier) << 52 | uint64_t(table) << 48 | indices;
+				}
+			}
+		}
+	}
+
+	return best_block;
+}
+
+void DecodeEac(uint64_t encoded, SBlock& block, int channel, bool eleven_bit)
+{
+	const int base = int(encoded >> 56);
+	const int multiplier = int(encoded >> 52) & 15;
+	const int* modifiers = EAC_MODIFIERS[(encoded >> 48) & 15];
+
+	for (int pixel = 0; pixel < 16; ++pixel)
+	{
+		const int index = int(encoded >> (45 - ColumnMajor(pixel) * 3)) & 7;
+		block[pixel][channel] = uint8_t(DecodeEacValue(base, multiplier, modifiers[index], eleven_bit));
+	}
+}
+
+// Channels missing from the source read as zero, except alpha which reads as opaque
+void ReadBlock(const uint8_t* pixels, size_t width, size_t height, size_t channels, size_t block_x, size_t block_y, SBlock& block)
+{
+	for (int pixel = 0; pixel < 16; ++pixel)
+	{
+		// Blocks hanging over the edge repeat the last row and column
+		const size_t x = std::min(block_x * 4 + (pixel & 3), width - 1);
+		const size_t y = std::min(block_y * 4 + (pixel >> 2), height - 1);
+		const uint8_t* source = pixels + (y * width + x) * channels;
+
+		for (size_t c = 0; c < 4; ++c)
+		{
+			block[pixel][c] = c < channels ? source[c] : (c == 3 ? 255 : 0);
+		}
+	}
+}
+
+void WriteBlock(const SBlock& block, size_t width, size_t height, size_t channels, size_t block_x, size_t block_y, uint8_t* pixels)
+{
+	for (int pixel = 0; pixel < 16; ++pixel)
+	{
+		const size_t x = block_x * 4 + (pixel & 3);
+		const size_t y = block_y * 4 + (pixel >> 2);
+
+		if (x < width && y < height)
+		{
+			std::copy(block[pixel], block[pixel] + channels, pixels + (y * width + x) * channels);
+		}
+	}
+}
+
+void EncodeBlock(const SBlock& block, ETextureFormat format, uint8_t* output)
+{
+	switch (format)
+	{
+	case ETextureFormat::ETC2_RGB8:
+		WriteBigEndian(EncodeEtc1(block), output);
+		break;
+	case ETextureFormat::ETC2_RGBA8:
+		WriteBigEndian(EncodeEac(block, 3, false), output);
+		WriteBigEndian(EncodeEtc1(block), output + 8);
+		break;
+	case ETextureFormat::EAC_R11:
+		WriteBigEndian(EncodeEac(block, 0, true), output);
+		break;
+	case ETextureFormat::EAC_RG11:
+		WriteBigEndian(EncodeEac(block, 0, true), output);
+		WriteBigEndian(EncodeEac(block, 1, true), output + 8);
+		break;
+	default:
+		break;
+	}
+}
+
+void DecodeBlock(const uint8_t* input, ETextureFormat format, SBlock& block)
+{
+	switch (format)
+	{
+	case ETextureFormat::ETC2_RGB8:
+		DecodeEtc1(ReadBigEndian(input), block);
+		break;
+	case ETextureFormat::ETC2_RGBA8:
+		DecodeEac(ReadBigEndian(input), block, 3, false);
+		DecodeEtc1(ReadBigEndian(input + 8), block);
+		break;
+	case ETextureFormat::EAC_R11:
+		DecodeEac(ReadBigEndian(input), block, 0, true);
+		break;
+	case ETextureFormat::EAC_RG11:
+		DecodeEac(ReadBigEndian(input), block, 0, true);
+		DecodeEac(ReadBigEndian(input + 8), block, 1, true);
+		break;
+	default:
+		break;
+	}
+}
+
+// A texture loaded before levels were tracked is one level spanning the whole buffer
+std::vector<NRender::STexture::SLevel> GetLevels(const NRender::STexture& texture)
+{
+	if (!texture.m_Levels.empty())
+	{
+		return texture.m_Levels;
+	}
+
+	return { { texture.m_Width, texture.m_Height, 0, texture.DataSize() } };
+}
+
+bool ValidateLevels(const NRender::STexture& texture)
+{
+	// Padded rows are only ever uploaded, processing works on tightly packed levels
+	for (const NRender::STexture::SLevel& level : GetLevels(texture))
+	{
+		if (level.m_Width == 0 || level.m_Height == 0 || level.m_Pitch != 0 || level.m_Size < NRender::LevelSize(texture.m_Format, level.m_Width, level.m_Height) ||
+			level.m_Offset > texture.DataSize() || level.m_Size > texture.DataSize() - level.m_Offset)
+		{
+			printf("Texture has a corrupt level: %s\n", texture.m_Name.c_str());
+			return false;
+		}
+	}
+
+	return true;
+}
+}  // namespace
+
+NRender::ETextureFormat NUtils::UncompressedFormat(ETextureFormat format)
+{
+	switch (format)
+	{
+	case ETextureFormat::ETC2_RGB8: return ETextureFormat::RGB8;
+	case ETextureFormat::ETC2_RGBA8: return ETextureFormat::RGBA8;
+	case ETextureFormat::EAC_R11: return ETextureFormat::R8;
+	case ETextureFormat::EAC_RG11: return ETextureFormat::RG8;
+	default: return format;
+	}
+}
+
+bool NUtils::GenerateMips(NRender::STexture& texture)
+{
+	if (NRender::IsCompressed(texture.m_Format))
+	{
+		printf("Mips can only be generated for uncompressed textures: %s\n", texture.m_Name.c_str());
+		return false;
+	}
+
+	if (!ValidateLevels(texture))
+	{
+		return false;
+	}
+
+	const size_t channels = NRender::FormatSize(texture.m_Format);
+	const NRender::STexture::SLevel top = GetLevels(texture).front();
+
+	std::vector<NRender::STexture::SLevel> levels = { { top.m_Width, top.m_Height, 0, top.m_Size } };
+	std::vector<uint8_t> buffer(texture.Data() + top.m_Offset, texture.Data() + top.m_Offset + top.m_Size);
+
+	while (levels.back().m_Width > 1 || levels.back().m_Height > 1)
+	{
+		const NRender::STexture::SLevel source = levels.back();
+
+		NRender::STexture::SLevel level;
+		level.m_Width = std::max(source.m_Width / 2, 1);
+		level.m_Height = std::max(source.m_Height / 2, 1);
+		level.m_Offset = buffer.size();
+		level.m_Size = NRender::LevelSize(texture.m_Format, level.m_Width, level.m_Height);
+		buffer.resize(buffer.size() + level.m_Size);
+
+		// Each texel averages the 2x2 footprint below it, odd edges reuse their last row or column
+		const uint8_t* input = buffer.data() + source.m_Offset;
+		uint8_t* output = buffer.data() + level.m_Offset;
+
+		for (size_t y = 0; y < level.m_Height; ++y)
+		{
+			const size_t y0 = std::min<size_t>(y * 2, source.m_Height - 1);
+			const size_t y1 = std::min<size_t>(y * 2 + 1, source.m_Height - 1);
+
+			for (size_t x = 0; x < level.m_Width; ++x)
+			{
+				const size_t x0 = std::min<size_t>(x * 2, source.m_Width - 1);
+				const size_t x1 = std::min<size_t>(x * 2 + 1, source.m_Width - 1);
+
+				for (size_t c = 0; c < channels; ++c)
+				{
+					const int sum = input[(y0 * source.m_Width + x0) * channels + c] + input[(y0 * source.m_Width + x1) * channels + c] +
+									input[(y1 * source.m_Width + x0) * channels + c] + input[(y1 * source.m_Width + x1) * channels + c];
+					output[(y * level.m_Width + x) * channels + c] = uint8_t((sum + 2) / 4);
+				}
+			}
+		}
+
+		levels.push_back(level);
+	}
+
+	texture.m_Levels = std::move(levels);
+	texture.m_Buffer = std::move(buffer);
+	texture.m_Pixels.reset();
+	texture.m_PixelsSize = 0;
+	return true;
+}
+
+bool NUtils::CompressTexture(const NRender::STexture& source, ETextureFormat format, NRender::STexture& compressed)
+{
+	if (NRender::IsCompressed(source.m_Format) || !NRender::IsCompressed(format))
+	{
+		printf("Textures can only be compressed from an uncompressed format: %s\n", source.m_Name.c_str());
+		return false;
+	}
+
+	if (!ValidateLevels(source))
+	{
+		return false;
+	}
+
+	const size_t channels = NRender::FormatSize(source.m_Format);
+	const size_t block_size = NRender::FormatSize(format);
+
+	compressed.m_Name = source.m_Name;
+	compressed.m_Width = source.m_Width;
+	compressed.m_Height = source.m_Height;
+	compressed.m_Format = format;
+	compressed.m_Levels.clear();
+	compressed.m_Buffer.clear();
+	compressed.m_Pixels.reset();
+	compressed.m_PixelsSize = 0;
+
+	for (const NRender::STexture::SLevel& source_level : GetLevels(source))
+	{
+		NRender::STexture::SLevel level = source_level;
+		level.m_Offset = compressed.m_Buffer.size();
+		level.m_Size = NRender::LevelSize(format, level.m_Width, level.m_Height);
+		compressed.m_Buffer.resize(compressed.m_Buffer.size() + level.m_Size);
+
+		const size_t blocks_x = (level.m_Width + 3) / 4;
+		const size_t blocks_y = (level.m_Height + 3) / 4;
+		const uint8_t* pixels = source.Data() + source_level.m_Offset;
+		uint8_t* output = compressed.m_Buffer.data() + level.m_Offset;
+
+		for (size_t block_y = 0; block_y < blocks_y; ++block_y)
+		{
+			for (size_t block_x = 0; block_x < blocks_x; ++block_x)
+			{
+				SBlock block;
+				ReadBlock(pixels, level.m_Width, level.m_Height, channels, block_x, block_y, block);
+				EncodeBlock(block, format, output + (block_y * blocks_x + block_x) * block_size);
+			}
+		}
+
+		compressed.m_Levels.push_back(level);
+	}
+
+	return true;
+}
+
+bool NUtils::DecompressTexture(const NRender::STexture& source, NRender::STexture& decompressed)
+{
+	if (!NRender::IsCompressed(source.m_Format))
+	{
+		decompressed = source;
+		return true;
+	}
+
+	if (!ValidateLevels(source))
+	{
+		return false;
+	}
+
+	const ETextureFormat format = UncompressedFormat(source.m_Format);
+	const size_t channels = NRender::FormatSize(format);
+	const size_t block_size = NRender::FormatSize(source.m_Format);
+
+	decompressed.m_Name = source.m_Name;
+	decompressed.m_Width = source.m_Width;
+	decompressed.m_Height = source.m_Height;
+	decompressed.m_Format = format;
+	decompressed.m_Levels.clear();
+	decompressed.m_Buffer.clear();
+	decompressed.m_Pixels.reset();
+	decompressed.m_PixelsSize = 0;
+
+	for (const NRender::STexture::SLevel& source_level : source.m_Levels)
+	{
+		NRender::STexture::SLevel level = source_level;
+		level.m_Offset = decompressed.m_Buffer.size();
+		level.m_Size = NRender::LevelSize(format, level.m_Width, level.m_Height);
+		decompressed.m_Buffer.resize(decompressed.m_Buffer.size() + level.m_Size);
+
+		const size_t blocks_x = (level.m_Width + 3) / 4;
+		const size_t blocks_y = (level.m_Height + 3) / 4;
+		const uint8_t* input = source.Data() + source_level.m_Offset;
+		uint8_t* pixels = decompressed.m_Buffer.data() + level.m_Offset;
+
+		for (size_t block_y = 0; block_y < blocks_y; ++block_y)
+		{
+			for (size_t block_x = 0; block_x < blocks_x; ++block_x)
+			{
+				SBlock block = {};
+				DecodeBlock(input + (block_y * blocks_x + block_x) * block_size, source.m_Format, block);
+				WriteBlock(block, level.m_Width, level.m_Height, channels, block_x, block_y, pixels);
+			}
+		}
+
+		decompressed.m_Levels.push_back(level);
+	}
+
+	return true;
+}
+
+float NUtils::MeasureTextureError(const NRender::STexture& reference, const NRender::STexture& texture)
+{
+	NRender::STexture decoded;
+
+	if (NRender::IsCompressed(reference.m_Format) || !DecompressTexture(texture, decoded) || reference.m_Width != decoded.m_Width || reference.m_Height != decoded.m_Height)
+	{
+		return 0.0f;
+	}
+
+	const size_t reference_channels = NRender::FormatSize(reference.m_Format);
+	const size_t channels = NRender::FormatSize(decoded.m_Format);
+	const size_t pixel_count = size_t(decoded.m_Width) * decoded.m_Height;
+
+	// The first level doesn't have to start the buffer, e.g. when a cooked file is used in place
+	const uint8_t* reference_pixels = reference.Data() + GetLevels(reference).front().m_Offset;
+	const uint8_t* decoded_pixels = decoded.Data() + decoded.m_Levels.front().m_Offset;
+
+	double squared_error = 0.0;
+	for (size_t i = 0; i < pixel_count; ++i)
+	{
+		for (size_t c = 0; c < channels; ++c)
+		{
+			const int expected = c < reference_channels ? reference_pixels[i * reference_channels + c] : (c == 3 ? 255 : 0);
+			const int difference = expected - decoded_pixels[i * channels + c];
+			squared_error += difference * difference;
+		}
+	}
+
+	const double mean = squared_error / double(pixel_count * channels);
+	return mean > 0.0 ? float(10.0 * std::log10(255.0 * 255.0 / mean)) : std::numeric_limits<float>::infinity();
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <Engine/Render/Texture.h>
+
+namespace NUtils
+{
+// Replaces the levels of an uncompressed texture with a box filtered chain down to 1x1
+bool GenerateMips(NRender::STexture& texture);
+
+// Encodes every level of an uncompressed texture as ETC2/EAC blocks, channels the format lacks are dropped
+bool CompressTexture(const NRender::STexture& source, NRender::ETextureFormat format, NRender::STexture& compressed);
+
+// Decodes to the matching uncompressed format, the fallback for GPUs without ETC2
+bool DecompressTexture(const NRender::STexture& source, NRender::STexture& decompressed);
+
+// Uncompressed format holding the same channels as the given format
+NRender::ETextureFormat UncompressedFormat(NRender::ETextureFormat format);
+
+// Peak signal to noise ratio of the first level in dB, over the channels of the compressed texture
+float MeasureTextureError(const NRender::STexture& reference, const NRender::STexture& texture);
+}  // namespace NUtils
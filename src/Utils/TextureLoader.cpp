@@ -0,0 +1,67 @@
+#include "TextureLoader.h"
+#include "AssetArchive.h"
+#include "CookedTexture.h"
+
+#include <Engine/Render/Texture.h>
+
+#include <stdio.h>
+
+#include <SDL_image.h>
+#include <SDL_surface.h>
+
+NRender::HTexture NUtils::LoadTexture(const std::string& path)
+{
+	NRender::HTexture texture = std::make_shared<NRender::STexture>();
+
+	// Loaded textures are only uploaded, their pixels aren't needed on the CPU afterwards
+	texture->m_ReleaseAfterUpload = true;
+
+	// Prefer the cooked texture, it already has its mips and is usually compressed
+	if (LoadCookedTexture(GetCookedTexturePath(path).c_str(), *texture))
+	{
+		texture->m_Name = path;
+		return texture;
+	}
+
+	// Archived images are decoded straight out of their slice
+	SAssetSlice slice;
+	SDL_Surface* surface = CAssetArchive::Instance().Open(path, slice)
+		? IMG_Load_RW(SDL_RWFromConstMem(slice.m_Data.get(), int(slice.m_Size)), 1)
+		: IMG_Load(path.c_str());
+
+	if (surface == nullptr)
+	{
+		printf("Could not load texture: %s\n", path.c_str());
+		return NRender::HTexture(nullptr);
+	}
+
+	// We're going to assume 8-bits per channel from here on out
+	static const NRender::ETextureFormat formats[] = {
+		NRender::ETextureFormat::R8,
+		NRender::ETextureFormat::RG8,
+		NRender::ETextureFormat::RGB8,
+		NRender::ETextureFormat::RGBA8,
+	};
+
+	if (surface->format->BytesPerPixel < 1 || surface->format->BytesPerPixel > 4)
+	{
+		printf("Invalid texture: %s (%hhu bytes per pixel)\n", path.c_str(), surface->format->BytesPerPixel);
+		SDL_FreeSurface(surface);
+		return NRender::HTexture(nullptr);
+	}
+
+	texture->m_Name = path;
+	texture->m_Width = surface->w;
+	texture->m_Height = surface->h;
+	texture->m_Format = formats[surface->format->BytesPerPixel - 1];
+
+	// Adopt the surface rather than copying it, its padded rows are read in place on upload
+	texture->m_Levels = { { texture->m_Width, texture->m_Height, 0, size_t(surface->pitch) * surface->h, size_t(surface->pitch) } };
+	texture->m_Pixels = std::shared_ptr<const uint8_t>(std::shared_ptr<SDL_Surface>(surface, SDL_FreeSurface), static_cast<const uint8_t*>(surface->pixels));
+	texture->m_PixelsSize = texture->m_Levels[0].m_Size;
+
+	// Uncooked textures still get mips, just no compression
+	texture->m_GenerateMips = true;
+
+	return texture;
+}
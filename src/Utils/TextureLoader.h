@@ -0,0 +1,19 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace NRender
+{
+struct STexture;
+using HTexture = std::shared_ptr<NRender::STexture>;
+}  // namespace NRender
+
+namespace NUtils
+{
+// Resolves a texture path to a texture, loaders may return nullptr on failure
+using TextureLoader = std::function<NRender::HTexture(const std::string& path)>;
+
+NRender::HTexture LoadTexture(const std::string& path);
+}  // namespace NUtils
@@ -2,106 +2,448 @@
 #include <SDL_image.h>
 
 #include <emscripten.h>
+#include <emscripten/fetch.h>
 #include <emscripten/html5.h>
 
 #include <cmath>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "Engine/Camera.h"
+#include "Engine/FixedTimestep.h"
+#include "Engine/SceneBvh.h"
+#include "Engine/ShaderProgram.h"
+#include "Engine/TransformHierarchy.h"
 #include "Engine/Window.h"
 
+#include "Engine/Render/GpuTimer.h"
 #include "Engine/Render/Mesh.h"
 #include "Engine/Render/MeshInstance.h"
+#include "Engine/Render/OcclusionBuffer.h"
+#include "Engine/Render/ProfilerOverlay.h"
+#include "Engine/Render/Raycast.h"
+#include "Engine/Render/RenderQueue.h"
+#include "Engine/Render/ResourceCache.h"
+#include "Engine/Render/RenderStats.h"
 
-#include "Utils/MeshLoader.h"
+#include "Utils/AssetArchive.h"
+#include "Utils/AssetLoader.h"
+#include "Utils/MeshGenerator.h"
+#include "Utils/Profiler.h"
+#include "Utils/TaskPool.h"
 
 static CCamera s_Camera;
 static double s_LastTime = 0.0;
 static int s_Width, s_Height;
 static const char* s_Canvas = "#canvas";
+static const int s_GridSize = 4;
+static const float s_InstanceScale = 0.1f;
 
-void OnUpdate()
+static CTransformHierarchy s_Transforms;
+static std::vector<std::unique_ptr<NRender::CMeshInstance>> s_Instances;
+static NRender::COcclusionBuffer s_Occlusion;
+
+// Proxies are the instances' indices, the tree is cleared whenever the instances are
+static CSceneBvh s_Scene;
+static std::vector<uint32_t> s_Visible;
+
+// Simulation advances in fixed ticks, frames render in between its last two states
+struct SSimulationState
 {
-	const double time = emscripten_performance_now() * 0.001;
-	const double delta = time - s_LastTime;
+	CFrame m_Camera;
+	std::vector<CFrame> m_Instances;
+};
 
-	SDL_Event event;
+static CFixedTimestep s_Timestep(1.0 / 60.0, 4);
+static SSimulationState s_Previous;
+static SSimulationState s_Current;
+static NUtils::HAssetRequest s_MeshRequest;
+static bool s_ArchiveFetched = false;
 
-	while (SDL_PollEvent(&event))
+// Lays the instances out on a grid, one and a half mesh widths apart, each hiding the ones behind it
+static void PlaceInstances(const NRender::HMeshResource& resource)
+{
+	const NRender::SMesh::SBounds& bounds = resource->Mesh().m_Bounds;
+	const float spacing = 1.5f * s_InstanceScale * std::max(bounds.m_Max.m_X - bounds.m_Min.m_X, bounds.m_Max.m_Z - bounds.m_Min.m_Z);
+
+	s_Instances.clear();
+	s_Transforms.Clear();
+	s_Scene.Clear();
+
+	for (int z = -s_GridSize; z <= s_GridSize; ++z)
 	{
-		switch (event.type)
+		for (int x = -s_GridSize; x <= s_GridSize; ++x)
 		{
-		case SDL_MOUSEMOTION:
-			if (CWindow::Instance().HasMouse())
-			{
-				s_Camera.localRotate(CQuaternion(
-					Eigen::AngleAxisf(-event.motion.yrel * M_PI * (1.0f / 1024.0f), Eigen::Vector3f::UnitX()) *
-					Eigen::AngleAxisf(-event.motion.xrel * M_PI * (1.0f / 1024.0f), Eigen::Vector3f::UnitY())));
-			}
-			break;
+			s_Instances.push_back(std::make_unique<NRender::CMeshInstance>(resource, s_Transforms));
+			s_Instances.back()->Scale(s_InstanceScale);
+			s_Instances.back()->SetPosition(x * spacing, 0.0f, z * spacing);
+			s_Instances.back()->SetOccluder(true);
+
+			// Boxes are filled in once the hierarchy has computed the world matrices
+			s_Scene.Add(CVector3f::Zero(), CVector3f::Zero());
 		}
 	}
 
-	static float cam_speed = 5;
-	const Uint8 buttons = SDL_GetMouseState(NULL, NULL);
-	if (buttons & SDL_BUTTON_LMASK)
+	// New instances start out at rest, there is no earlier state to blend from
+	s_Current.m_Instances.clear();
+
+	for (const std::unique_ptr<NRender::CMeshInstance>& instance : s_Instances)
 	{
-		CWindow::Instance().GrabMouse();
+		s_Current.m_Instances.emplace_back(s_Transforms.Position(instance->Node()), s_Transforms.Rotation(instance->Node()));
 	}
 
+	s_Previous.m_Instances = s_Current.m_Instances;
+}
+
+// One tick of camera motion from the held keys and of the instances turning
+static void Simulate(float tick)
+{
+	static const float cam_speed = 5;
+
+	s_Previous = s_Current;
+
 	const Uint8* keys = SDL_GetKeyboardState(NULL);
+	CVector3f move = CVector3f::Zero();
+
 	if (keys[SDL_SCANCODE_W])
 	{
-		s_Camera.localTranslate(-CVector3f::UnitZ() * delta * cam_speed);
+		move -= CVector3f::UnitZ();
 	}
 	if (keys[SDL_SCANCODE_A])
 	{
-		s_Camera.localTranslate(-CVector3f::UnitX() * delta * cam_speed);
+		move -= CVector3f::UnitX();
 	}
 	if (keys[SDL_SCANCODE_S])
 	{
-		s_Camera.localTranslate(CVector3f::UnitZ() * delta * cam_speed);
+		move += CVector3f::UnitZ();
 	}
 	if (keys[SDL_SCANCODE_D])
 	{
-		s_Camera.localTranslate(CVector3f::UnitX() * delta * cam_speed);
+		move += CVector3f::UnitX();
 	}
 	if (keys[SDL_SCANCODE_LCTRL])
 	{
-		s_Camera.localTranslate(-CVector3f::UnitY() * delta * cam_speed);
+		move -= CVector3f::UnitY();
 	}
 	if (keys[SDL_SCANCODE_SPACE])
 	{
-		s_Camera.localTranslate(CVector3f::UnitY() * delta * cam_speed);
+		move += CVector3f::UnitY();
 	}
 
+	CFrame& camera = s_Current.m_Camera;
+	camera.position += camera.orientation * move * (tick * cam_speed);
+
+	// Renormalized every tick, so turning a little each time never drifts
+	const CQuaternion spin(Eigen::AngleAxisf(0.125f * float(M_PI) * tick, CVector3f::UnitY()));
+
+	for (CFrame& frame : s_Current.m_Instances)
+	{
+		frame.orientation = (frame.orientation * spin).normalized();
+	}
+}
+
+static void OnMeshLoaded(const NRender::HMesh& mesh)
+{
+	if (mesh == nullptr)
+	{
+		return;
+	}
+
+	// Swapping the resource drops the last reference to the placeholder, which frees it
+	PlaceInstances(NRender::CResourceCache::Instance().GetMesh(mesh));
+
+	const NRender::SResourceCacheStats cache = NRender::CResourceCache::Instance().Stats();
+	printf("GPU resources: %zu meshes (%zu bytes), %zu materials, %zu textures (%zu bytes); %zu hits, %zu misses\n",
+		   cache.m_Meshes, cache.m_BufferBytes, cache.m_Materials,
+		   cache.m_Textures, cache.m_TextureBytes, cache.m_Hits, cache.m_Misses);
+}
+
+// The archive is mounted straight from the fetched buffer, which is freed along with the fetch
+static void OnArchiveFetched(emscripten_fetch_t* fetch)
+{
+	std::shared_ptr<const uint8_t> data(reinterpret_cast<const uint8_t*>(fetch->data), [fetch](const uint8_t*) {
+		emscripten_fetch_close(fetch);
+	});
+
+	NUtils::CAssetArchive::Instance().Mount(data, size_t(fetch->numBytes));
+	s_ArchiveFetched = true;
+}
+
+// Without an archive everything still loads from the preloaded files
+static void OnArchiveFailed(emscripten_fetch_t* fetch)
+{
+	printf("Could not fetch asset archive: %s (%hu)\n", fetch->url, fetch->status);
+	emscripten_fetch_close(fetch);
+	s_ArchiveFetched = true;
+}
+
+// Reports the triangle in the middle of the view, every instance is tested as there are only a few
+static void PickInstance()
+{
+	NRender::SRayHit closest;
+	size_t picked = s_Instances.size();
+
+	for (size_t i = 0; i < s_Instances.size(); ++i)
+	{
+		NRender::SRayHit hit;
+
+		if (s_Instances[i]->Raycast(s_Camera.position(), s_Camera.direction(), picked < s_Instances.size() ? closest.m_Distance : INFINITY, hit))
+		{
+			closest = hit;
+			picked = i;
+		}
+	}
+
+	if (picked == s_Instances.size())
+	{
+		printf("Picked nothing\n");
+		return;
+	}
+
+	printf("Picked instance %zu, submesh %zu, triangle %zu at %.2f (u %.2f, v %.2f)\n",
+		   picked, closest.m_SubMesh, closest.m_Triangle, closest.m_Distance, closest.m_U, closest.m_V);
+}
+
+// Hands the trace to the browser as a download, there is nowhere else to save it
+static void ExportTrace()
+{
+	std::string json;
+	NUtils::CProfiler::Instance().ExportChromeTrace(json);
+
+	EM_ASM({
+		const link = document.createElement('a');
+		link.href = URL.createObjectURL(new Blob([HEAPU8.slice($0, $0 + $1)], { type: 'application/json' }));
+		link.download = 'trace.json';
+		link.click();
+		setTimeout(() => URL.revokeObjectURL(link.href), 1000);
+	}, json.data(), json.size());
+}
+
+void OnUpdate()
+{
+	NUtils::CProfiler::Instance().BeginFrame();
+	NRender::CGpuTimer::Instance().BeginFrame();
+	PROFILE_ZONE("Frame");
+
+	const double time = emscripten_performance_now() * 0.001;
+	const double delta = time - s_LastTime;
+
+	SDL_Event event;
+
+	while (SDL_PollEvent(&event))
+	{
+		switch (event.type)
+		{
+		case SDL_MOUSEMOTION:
+			if (CWindow::Instance().HasMouse())
+			{
+				// Looking around goes straight into the simulated camera, the next frames blend toward it
+				CFrame& camera = s_Current.m_Camera;
+				camera.orientation = (camera.orientation * CQuaternion(
+					Eigen::AngleAxisf(-event.motion.yrel * M_PI * (1.0f / 1024.0f), Eigen::Vector3f::UnitX()) *
+					Eigen::AngleAxisf(-event.motion.xrel * M_PI * (1.0f / 1024.0f), Eigen::Vector3f::UnitY()))).normalized();
+			}
+			break;
+		case SDL_KEYDOWN:
+			// P toggles profiling along with its graph, T downloads the frames profiled so far, F picks what's in the middle
+			if (event.key.repeat)
+			{
+				break;
+			}
+
+			if (event.key.keysym.sym == SDLK_p)
+			{
+				const bool enabled = !NUtils::CProfiler::IsEnabled();
+				NUtils::CProfiler::Instance().SetEnabled(enabled);
+				NRender::CProfilerOverlay::Instance().SetVisible(enabled);
+			}
+			else if (event.key.keysym.sym == SDLK_t)
+			{
+				ExportTrace();
+			}
+			else if (event.key.keysym.sym == SDLK_f)
+			{
+				PickInstance();
+			}
+			break;
+		}
+	}
+
+	const Uint8 buttons = SDL_GetMouseState(NULL, NULL);
+	if (buttons & SDL_BUTTON_LMASK)
+	{
+		CWindow::Instance().GrabMouse();
+	}
+
+	// Slow frames run several ticks to catch up, but never more than the limit
+	{
+		PROFILE_ZONE("Simulate");
+		const size_t ticks = s_Timestep.Advance(delta);
+
+		for (size_t tick = 0; tick < ticks; ++tick)
+		{
+			Simulate(float(s_Timestep.Tick()));
+		}
+	}
+
+	const float alpha = s_Timestep.Alpha();
+	s_Camera.setCFrame(s_Previous.m_Camera.lerp(alpha, s_Current.m_Camera));
+
 	if (CWindow::Instance().IsInitialized())
 	{
-		s_Camera.activateGL();
+		NRender::CRenderStats::Instance().BeginFrame();
+		s_Camera.activateGL(CWindow::Instance().CameraUniforms());
+
+		static NRender::CRenderQueue queue;
+
+		if (s_Instances.empty())
+		{
+			// A sphere stands in for every instance while the real mesh streams in
+			std::shared_ptr<NRender::SMesh> placeholder = std::make_shared<NRender::SMesh>();
+			NUtils::GenerateSphere(*placeholder, 16, 32, 1, 50.0f);
+			PlaceInstances(NRender::CResourceCache::Instance().GetMesh(placeholder));
+		}
+
+		// Wait on the archive, so the mesh is read from it when there is one
+		if (s_MeshRequest == nullptr && s_ArchiveFetched)
+		{
+			s_MeshRequest = NUtils::CAssetLoader::Instance().LoadMesh("assets/models/muro.obj", &OnMeshLoaded, NUtils::LoadTexture);
+		}
+
+		// Only the uploads happen on this thread, a single finished mesh per frame
+		{
+			PROFILE_ZONE("Stream");
+			NUtils::CAssetLoader::Instance().Update(1);
+		}
+
+		{
+			PROFILE_ZONE("Interpolate");
+
+			for (size_t i = 0; i < s_Instances.size(); ++i)
+			{
+				const CFrame frame = s_Previous.m_Instances[i].lerp(alpha, s_Current.m_Instances[i]);
+				s_Instances[i]->SetPosition(frame.position);
+				s_Instances[i]->SetRotation(frame.orientation);
+			}
+
+			NRender::CRenderStats::Instance().Current().m_UpdatedTransforms = s_Transforms.Update();
+		}
 
-		static float timer = 0.f;
-		timer += delta;
+		{
+			PROFILE_ZONE("Refit");
 
-		static bool loaded = false;
-		static std::shared_ptr<NRender::SMesh> mesh = std::make_shared<NRender::SMesh>();
-		static NRender::CMeshInstance mesh_instance(mesh);
+			for (uint32_t i = 0; i < s_Instances.size(); ++i)
+			{
+				if (s_Instances[i]->Moved())
+				{
+					CVector3f min, max;
+					s_Instances[i]->WorldBounds(min, max);
+					s_Scene.Update(i, min, max);
+				}
+			}
+
+			s_Scene.Commit();
+		}
 
-		if (!loaded)
 		{
-			NUtils::LoadMesh("assets/models/muro.obj", "", *mesh);
-			mesh_instance.Reload();
-			mesh_instance.Scale(0.1f);
-			loaded = true;
+			PROFILE_ZONE("Occlusion");
+
+			s_Occlusion.Begin(s_Camera);
+			for (std::unique_ptr<NRender::CMeshInstance>& instance : s_Instances)
+			{
+				if (instance->IsOccluder())
+				{
+					instance->AddOccluder(s_Occlusion);
+				}
+			}
+			s_Occlusion.Finish();
+
+			NRender::SFrameStats& stats = NRender::CRenderStats::Instance().Current();
+			stats.m_OccluderTriangles = s_Occlusion.Stats().m_RasterizedTriangles;
+			stats.m_OcclusionMs = s_Occlusion.Stats().m_BuildMs;
 		}
 
-		CMatrix3f m(Eigen::AngleAxisf(0.125 * M_PI * delta, CVector3f::UnitY()));
+		{
+			PROFILE_ZONE("Cull");
+
+			queue.Clear();
+			s_Visible.clear();
+			s_Scene.QueryFrustum(s_Camera.frustum(), s_Visible);
+
+			// Instances the tree rejected never reach Submit, which counts the rest
+			NRender::CRenderStats::Instance().Current().m_CulledInstances += s_Instances.size() - s_Visible.size();
+
+			for (uint32_t proxy : s_Visible)
+			{
+				s_Instances[proxy]->Submit(queue, s_Camera, &s_Occlusion);
+			}
+		}
 
-		mesh_instance.Rotate(m);
-		mesh_instance.Draw();
+		{
+			PROFILE_ZONE("Sort");
+			queue.Sort();
+		}
 
-		CWindow::Instance().Present();
+		{
+			PROFILE_ZONE("Submit");
+			PROFILE_GPU_ZONE("Scene");
+			queue.Submit(CWindow::Instance().Shader());
+		}
+
+		{
+			PROFILE_GPU_ZONE("Overlay");
+			NRender::CProfilerOverlay::Instance().Draw(s_Width, s_Height);
+		}
+
+		{
+			PROFILE_ZONE("Present");
+			CWindow::Instance().Present();
+		}
+
+		static double stats_time = 0.0;
+		if (time - stats_time > 5.0)
+		{
+			const NRender::SFrameStats& stats = NRender::CRenderStats::Instance().Current();
+			printf("Transforms: %zu updated; instances: %zu visible, %zu culled; submeshes: %zu visible, %zu culled; occlusion: %zu instances, %zu submeshes occluded, %zu occluder triangles, %.2f ms; triangles: %zu of %zu; clusters: %zu visible, %zu culled; draw calls: %zu; binds: %zu materials, %zu vertex arrays; GL binds: %zu issued, %zu elided; uploads: %.1f KB, %zu orphaned buffers; simulation: %zu ticks, %zu dropped\n",
+				   stats.m_UpdatedTransforms,
+				   stats.m_VisibleInstances, stats.m_CulledInstances,
+				   stats.m_VisibleSubMeshes, stats.m_CulledSubMeshes,
+				   stats.m_OccludedInstances, stats.m_OccludedSubMeshes, stats.m_OccluderTriangles, stats.m_OcclusionMs,
+				   stats.m_Triangles, stats.m_FullDetailTriangles,
+				   stats.m_VisibleMeshlets, stats.m_CulledMeshlets,
+				   stats.m_DrawCalls, stats.m_MaterialBinds, stats.m_VertexArrayBinds,
+				   stats.m_GLCallsIssued, stats.m_GLCallsElided,
+				   stats.m_BytesUploaded / 1024.0, stats.m_BufferOrphans,
+				   s_Timestep.Ticks(), s_Timestep.DroppedTicks());
+
+			if (NUtils::CProfiler::IsEnabled())
+			{
+				const std::vector<NUtils::SProfileFrame> frames = NUtils::CProfiler::Instance().Frames();
+				double cpu_ms = 0.0, cpu_max_ms = 0.0, gpu_ms = 0.0;
+				size_t gpu_frames = 0;
+
+				for (const NUtils::SProfileFrame& frame : frames)
+				{
+					cpu_ms += frame.m_CpuMs;
+					cpu_max_ms = std::max(cpu_max_ms, frame.m_CpuMs);
+					gpu_ms += std::max(frame.m_GpuMs, 0.0);
+					gpu_frames += frame.m_GpuMs >= 0.0;
+				}
+
+				printf("Frame: CPU %.2f ms mean, %.2f ms longest; GPU %.2f ms mean (%zu frames)\n",
+					   cpu_ms / std::max<size_t>(frames.size(), 1), cpu_max_ms,
+					   gpu_ms / std::max<size_t>(gpu_frames, 1), frames.size());
+			}
+
+			stats_time = time;
+		}
 	}
 
 	s_LastTime = time;
@@ -145,9 +487,24 @@ int main()
 		return -1;
 	}
 
+	NUtils::CAssetLoader::Instance().Start(2);
+	NUtils::CTaskPool::Instance().Start(2);
+
+	NUtils::CProfiler::Instance().NameThread("Main");
+	NRender::CGpuTimer::Instance().Initialize();
+
+	emscripten_fetch_attr_t fetch;
+	emscripten_fetch_attr_init(&fetch);
+	strcpy(fetch.requestMethod, "GET");
+	fetch.attributes = EMSCRIPTEN_FETCH_LOAD_TO_MEMORY;
+	fetch.onsuccess = OnArchiveFetched;
+	fetch.onerror = OnArchiveFailed;
+	emscripten_fetch(&fetch, "assets.pak");
+
 	s_Camera.setPosition(CVector3f(35.0f, 35.0f, 35.0f));
 	s_Camera.setTarget(CVector3f(0.0f, 12.0f, 0.0f));
 	s_Camera.setViewport(s_Width, s_Height);
+	s_Current.m_Camera = s_Previous.m_Camera = s_Camera.frame();
 
 	emscripten_set_resize_callback(EMSCRIPTEN_EVENT_TARGET_WINDOW, 0, 0, OnResize);
 	emscripten_set_pointerlockchange_callback(EMSCRIPTEN_EVENT_TARGET_DOCUMENT, 0, 0, OnLockChange);
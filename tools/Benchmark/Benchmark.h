@@ -0,0 +1,45 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "Engine/Render/Mesh.h"
+
+namespace NBenchmark
+{
+struct SContext
+{
+	std::string m_MeshFilename;
+	NRender::SMesh m_Mesh;
+	int m_Iterations = 10;
+	size_t m_Instances = 10000;
+
+	// Where the raster suite writes its frame, nowhere if empty
+	std::string m_ImageFilename;
+};
+
+// Returns the mean time of a single iteration in milliseconds
+double Measure(int iterations, const std::function<void()>& function);
+void Report(const char* name, double milliseconds, const char* format = nullptr, ...);
+
+bool RunLoad(SContext& context);
+bool RunStream(SContext& context);
+bool RunArchive(SContext& context);
+bool RunQuantize(SContext& context);
+bool RunOptimize(SContext& context);
+bool RunLod(SContext& context);
+bool RunTransform(SContext& context);
+bool RunHierarchy(SContext& context);
+bool RunTimestep(SContext& context);
+bool RunCull(SContext& context);
+bool RunOcclusion(SContext& context);
+bool RunSceneBvh(SContext& context);
+bool RunRaycast(SContext& context);
+bool RunCluster(SContext& context);
+bool RunSort(SContext& context);
+bool RunUpload(SContext& context);
+bool RunRaster(SContext& context);
+bool RunTexture(SContext& context);
+bool RunDecode(SContext& context);
+bool RunProfile(SContext& context);
+}  // namespace NBenchmark
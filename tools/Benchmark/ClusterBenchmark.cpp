@@ -0,0 +1,257 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "Engine/Camera.h"
+#include "Engine/Frustum.h"
+#include "Engine/Math.h"
+#include "Engine/Render/ClusterCulling.h"
+#include "Utils/MeshOptimizer.h"
+#include "Utils/MeshQuantizer.h"
+#include "Utils/MeshletBuilder.h"
+
+namespace
+{
+// What a triangle costs the GPU, generously fast so clusters have to earn their CPU time
+constexpr double TRIANGLE_MS = 1e-6;
+
+struct SView
+{
+	const char* m_Name;
+	CCamera m_Camera;
+	std::vector<CTransform> m_Transforms;
+};
+
+// Packs a triangle's indices, meshes here stay well below 2^21 vertices
+uint64_t TriangleKey(const uint32_t* triangle)
+{
+	return (uint64_t(triangle[0]) << 42) | (uint64_t(triangle[1]) << 21) | uint64_t(triangle[2]);
+}
+
+// Any triangle facing the eye with a corner inside the frustum has to survive culling
+bool ValidateCulling(const NRender::SMesh& mesh, const NRender::SMesh::SSubMesh& sub_mesh, const CFrustum& frustum, const CVector3f& eye, const std::vector<uint32_t>& indices)
+{
+	std::unordered_set<uint64_t> kept;
+
+	for (size_t i = 0; i + 3 <= indices.size(); i += 3)
+	{
+		kept.insert(TriangleKey(&indices[i]));
+	}
+
+	for (size_t i = sub_mesh.m_IndexOffset; i < sub_mesh.m_IndexOffset + sub_mesh.m_IndexCount; i += 3)
+	{
+		const uint32_t* triangle = &mesh.m_Indices[i];
+		const CVector3f p0 = NUtils::GetVertexPosition(mesh, sub_mesh, triangle[0]);
+		const CVector3f p1 = NUtils::GetVertexPosition(mesh, sub_mesh, triangle[1]);
+		const CVector3f p2 = NUtils::GetVertexPosition(mesh, sub_mesh, triangle[2]);
+
+		const bool facing = (p1 - p0).cross(p2 - p0).dot(eye - p0) > 0.0f;
+		const bool inside = frustum.TestBox(p0, p0) || frustum.TestBox(p1, p1) || frustum.TestBox(p2, p2);
+
+		if (facing && inside && !kept.count(TriangleKey(triangle)))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+}  // namespace
+
+bool NBenchmark::RunCluster(SContext& context)
+{
+	NRender::SMesh mesh = context.m_Mesh;
+	NUtils::OptimizeMesh(mesh);
+	const NRender::SMesh optimized = mesh;
+
+	const double build_ms = Measure(std::max(context.m_Iterations / 10, 1), [&]() {
+		mesh.m_Indices = optimized.m_Indices;
+		NUtils::BuildMeshlets(mesh);
+	});
+
+	const NRender::SMesh::SMeshlets& meshlets = mesh.m_Meshlets;
+	size_t cullable_cones = 0;
+	size_t triangles = 0;
+
+	for (size_t i = 0; i < meshlets.Size(); ++i)
+	{
+		cullable_cones += meshlets.m_Cutoff[i] < 1.0f;
+		triangles += meshlets.m_IndexCount[i] / 3;
+	}
+
+	Report("build", build_ms, "%zu meshlets, %.1f triangles each, %zu with normal cones",
+		   meshlets.Size(), double(triangles) / std::max<size_t>(meshlets.Size(), 1), cullable_cones);
+
+	// Clusters have to cover their submesh exactly, each one contiguous and in order
+	bool succeeded = meshlets.Size() > 0 && triangles * 3 == mesh.m_Indices.size();
+
+	for (const NRender::SMesh::SSubMesh& sub_mesh : mesh.m_SubMeshes)
+	{
+		size_t next = sub_mesh.m_IndexOffset;
+
+		for (size_t m = sub_mesh.m_FirstMeshlet; m < sub_mesh.m_FirstMeshlet + sub_mesh.m_MeshletCount; ++m)
+		{
+			succeeded &= meshlets.m_IndexOffset[m] == next && meshlets.m_IndexCount[m] <= 124 * 3;
+			next += meshlets.m_IndexCount[m];
+		}
+
+		succeeded &= next == sub_mesh.m_IndexOffset + sub_mesh.m_IndexCount;
+	}
+
+	// Scattered instances as in the scene suites, fewer as every visible one is at full detail here,
+	// and a single instance filling the view up close
+	SView views[2];
+	views[0].m_Name = "scattered";
+	views[1].m_Name = "close up";
+
+	for (SView& view : views)
+	{
+		view.m_Camera.setViewport(1280, 720);
+		view.m_Camera.setPosition(CVector3f::Zero());
+		view.m_Camera.setTarget(-CVector3f::UnitZ());
+	}
+
+	std::mt19937 random(1337);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+	std::uniform_real_distribution<float> angle(0.0f, 2.0f * float(M_PI));
+	views[0].m_Transforms.resize(std::min<size_t>(context.m_Instances, 1000));
+
+	for (CTransform& transform : views[0].m_Transforms)
+	{
+		transform.setIdentity();
+		transform.translation() = CVector3f(position(random), position(random) * 0.1f, position(random));
+		transform.rotate(CAngleAxisf(angle(random), CVector3f::UnitY()));
+		transform.scale(10.0f);
+	}
+
+	// Just outside the bounding sphere, so most of the mesh is off to the sides or facing away
+	const float close_scale = 100.0f;
+	views[1].m_Transforms.resize(1);
+	views[1].m_Transforms[0].setIdentity();
+	views[1].m_Transforms[0].translation() = CVector3f(0.0f, 0.0f, -mesh.m_Bounds.m_Radius * close_scale * 1.05f);
+	views[1].m_Transforms[0].scale(close_scale);
+
+	std::vector<uint32_t> indices;
+
+	for (const SView& view : views)
+	{
+		const CCamera& camera = view.m_Camera;
+		size_t whole_triangles = 0;
+		size_t whole_submeshes = 0;
+
+		// Submeshes surviving the box tests are drawn whole, as CMeshInstance::Submit did before clusters
+		const double whole_ms = Measure(context.m_Iterations, [&]() {
+			whole_triangles = 0;
+			whole_submeshes = 0;
+
+			for (const CTransform& transform : view.m_Transforms)
+			{
+				const CFrustum frustum = camera.frustum().Transformed(transform);
+
+				if (!frustum.TestBox(CVector3f(&mesh.m_Bounds.m_Min.m_X), CVector3f(&mesh.m_Bounds.m_Max.m_X)))
+				{
+					continue;
+				}
+
+				for (const NRender::SMesh::SSubMesh& sub_mesh : mesh.m_SubMeshes)
+				{
+					if (frustum.TestBox(CVector3f(&sub_mesh.m_Bounds.m_Min.m_X), CVector3f(&sub_mesh.m_Bounds.m_Max.m_X)))
+					{
+						whole_triangles += sub_mesh.m_IndexCount / 3;
+						++whole_submeshes;
+					}
+				}
+			}
+		});
+
+		size_t visible_meshlets = 0;
+		size_t total_meshlets = 0;
+		size_t clustered_submeshes = 0;
+		size_t drawn_triangles = 0;
+
+		// View heights grow linearly with distance
+		const float unit_view_height = camera.pixelSize(1.0f) * camera.vpHeight();
+
+		// Submeshes big enough on screen are cluster culled, the rest drawn whole, as CMeshInstance::Submit does
+		const double cluster_ms = Measure(context.m_Iterations, [&]() {
+			indices.clear();
+			visible_meshlets = 0;
+			total_meshlets = 0;
+			clustered_submeshes = 0;
+			drawn_triangles = 0;
+
+			for (const CTransform& transform : view.m_Transforms)
+			{
+				const CFrustum frustum = camera.frustum().Transformed(transform);
+
+				if (!frustum.TestBox(CVector3f(&mesh.m_Bounds.m_Min.m_X), CVector3f(&mesh.m_Bounds.m_Max.m_X)))
+				{
+					continue;
+				}
+
+				const CVector3f eye = transform.inverse() * camera.position();
+				const float scale = transform.linear().colwise().norm().maxCoeff();
+
+				for (const NRender::SMesh::SSubMesh& sub_mesh : mesh.m_SubMeshes)
+				{
+					if (!frustum.TestBox(CVector3f(&sub_mesh.m_Bounds.m_Min.m_X), CVector3f(&sub_mesh.m_Bounds.m_Max.m_X)))
+					{
+						continue;
+					}
+
+					const CVector3f center = transform * CVector3f(&sub_mesh.m_Bounds.m_Center.m_X);
+					const float distance = std::max((center - camera.position()).norm() - sub_mesh.m_Bounds.m_Radius * scale, 0.0f);
+					const float view_height = distance * unit_view_height;
+					const float screen_size = view_height > 0.0f ? 2.0f * sub_mesh.m_Bounds.m_Radius * scale / view_height : INFINITY;
+
+					if (!NRender::ShouldCullMeshlets(sub_mesh, screen_size))
+					{
+						drawn_triangles += sub_mesh.m_IndexCount / 3;
+						continue;
+					}
+
+					const size_t offset = indices.size();
+					visible_meshlets += NRender::CullMeshlets(mesh, sub_mesh, frustum, eye, scale, true, 0, indices);
+					total_meshlets += sub_mesh.m_MeshletCount;
+					drawn_triangles += (indices.size() - offset) / 3;
+					++clustered_submeshes;
+				}
+			}
+		});
+
+		char name[48];
+		snprintf(name, sizeof(name), "%s whole", view.m_Name);
+		Report(name, whole_ms, "%zu submeshes, %zu triangles", whole_submeshes, whole_triangles);
+
+		snprintf(name, sizeof(name), "%s clusters", view.m_Name);
+		Report(name, cluster_ms, "%zu submeshes culled, %zu / %zu meshlets, %zu triangles (%.1f%% saved), %.1f MB of indices",
+			   clustered_submeshes, visible_meshlets, total_meshlets, drawn_triangles,
+			   100.0 - 100.0 * drawn_triangles / std::max<size_t>(whole_triangles, 1), indices.size() * sizeof(uint32_t) / 1e6);
+
+		succeeded &= drawn_triangles <= whole_triangles && visible_meshlets <= total_meshlets;
+
+		// Culling has to cost less than drawing the triangles it saves, the screen size test aside
+		succeeded &= cluster_ms <= whole_ms * 1.5 + (whole_triangles - drawn_triangles) * TRIANGLE_MS;
+
+		// Conservative culling is checked triangle by triangle on a handful of instances
+		for (size_t i = 0; i < std::min<size_t>(view.m_Transforms.size(), 64); ++i)
+		{
+			const CTransform& transform = view.m_Transforms[i];
+			const CFrustum frustum = camera.frustum().Transformed(transform);
+			const CVector3f eye = transform.inverse() * camera.position();
+			const float scale = transform.linear().colwise().norm().maxCoeff();
+
+			for (const NRender::SMesh::SSubMesh& sub_mesh : mesh.m_SubMeshes)
+			{
+				indices.clear();
+				NRender::CullMeshlets(mesh, sub_mesh, frustum, eye, scale, true, 0, indices);
+				succeeded &= ValidateCulling(mesh, sub_mesh, frustum, eye, indices);
+			}
+		}
+	}
+
+	return succeeded;
+}
@@ -0,0 +1,129 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "Engine/Math.h"
+#include "Engine/TransformHierarchy.h"
+
+namespace
+{
+// Straightforward recomputation of every world matrix, parents always come first
+void ComputeReference(const CTransformHierarchy& hierarchy, std::vector<CTransform>& world)
+{
+	world.resize(hierarchy.Size());
+
+	for (uint32_t i = 0; i < hierarchy.Size(); ++i)
+	{
+		CTransform local = CTransform::Identity();
+		local.translate(hierarchy.Position(i));
+		local.rotate(hierarchy.Rotation(i));
+		local.scale(hierarchy.Scale(i));
+
+		const uint32_t parent = hierarchy.Parent(i);
+		world[i] = parent != CTransformHierarchy::NoParent ? world[parent] * local : local;
+	}
+}
+
+bool Matches(const CTransformHierarchy& hierarchy, const std::vector<CTransform>& reference)
+{
+	for (uint32_t i = 0; i < hierarchy.Size(); ++i)
+	{
+		const float tolerance = 1e-4f * std::max(1.0f, reference[i].matrix().cwiseAbs().maxCoeff());
+
+		if ((hierarchy.World(i).matrix() - reference[i].matrix()).cwiseAbs().maxCoeff() > tolerance)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+}  // namespace
+
+bool NBenchmark::RunHierarchy(SContext& context)
+{
+	std::mt19937 random(1337);
+	std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+	std::uniform_real_distribution<float> angle(0.0f, 2.0f * float(M_PI));
+	std::uniform_real_distribution<float> scale(0.5f, 1.5f);
+
+	// A four way tree ten times the instance count, a dozen levels deep at the default count
+	const size_t count = context.m_Instances * 10;
+	CTransformHierarchy hierarchy;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint32_t node = hierarchy.Add(i > 0 ? uint32_t((i - 1) / 4) : CTransformHierarchy::NoParent);
+		hierarchy.SetPosition(node, CVector3f(position(random), position(random), position(random)));
+		hierarchy.SetRotation(node, CQuaternion(CAngleAxisf(angle(random), CVector3f(position(random), position(random), 1.0f).normalized())));
+		hierarchy.SetScale(node, CVector3f::Constant(scale(random)));
+	}
+
+	std::vector<CTransform> reference;
+	bool succeeded = hierarchy.Update() == count;
+
+	ComputeReference(hierarchy, reference);
+	succeeded &= Matches(hierarchy, reference);
+
+	const CQuaternion rotation(CAngleAxisf(0.125f * float(M_PI) / 60.0f, CVector3f::UnitY()));
+
+	const double reference_ms = Measure(context.m_Iterations, [&]() {
+		ComputeReference(hierarchy, reference);
+	});
+
+	Report("naive full update", reference_ms, "%zu nodes", count);
+
+	size_t updated = 0;
+
+	const double all_ms = Measure(context.m_Iterations, [&]() {
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			hierarchy.Rotate(i, rotation);
+		}
+
+		updated = hierarchy.Update();
+	});
+
+	Report("every node rotated", all_ms, "%zu updated", updated);
+	succeeded &= updated == count;
+
+	// Scattered changes recompute their subtrees only, mostly leaves in a wide tree
+	std::uniform_int_distribution<uint32_t> node(0, uint32_t(count - 1));
+	std::vector<uint32_t> changed(count / 100);
+
+	const double some_ms = Measure(context.m_Iterations, [&]() {
+		for (uint32_t& i : changed)
+		{
+			i = node(random);
+			hierarchy.Rotate(i, rotation);
+		}
+
+		updated = hierarchy.Update();
+	});
+
+	Report("1% rotated", some_ms, "%zu changed, %zu updated", changed.size(), updated);
+	succeeded &= updated >= changed.size() / 2 && updated < count;
+
+	// Moving a node near the root drags a quarter of the tree along
+	const double subtree_ms = Measure(context.m_Iterations, [&]() {
+		hierarchy.Rotate(1, rotation);
+		updated = hierarchy.Update();
+	});
+
+	Report("subtree rotated", subtree_ms, "%zu updated", updated);
+
+	const double clean_ms = Measure(context.m_Iterations, [&]() {
+		updated = hierarchy.Update();
+	});
+
+	Report("nothing changed", clean_ms, "%zu updated", updated);
+	succeeded &= updated == 0;
+
+	// Partial updates have to end up where recomputing everything does
+	ComputeReference(hierarchy, reference);
+	succeeded &= Matches(hierarchy, reference);
+
+	return succeeded;
+}
@@ -0,0 +1,346 @@
+#include "Benchmark.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+#include "Utils/AssetArchive.h"
+#include "Utils/AssetLoader.h"
+#include "Utils/CookedMesh.h"
+#include "Utils/MeshLoader.h"
+
+bool NBenchmark::RunLoad(SContext& context)
+{
+	const NRender::SMesh& source = context.m_Mesh;
+
+	std::vector<uint8_t> blob;
+	NUtils::CookMesh(source, blob);
+
+	const std::string cooked_filename = "benchmark.mesh";
+
+	if (!NUtils::SaveCookedMesh(cooked_filename.c_str(), source))
+	{
+		return false;
+	}
+
+	// Make sure the cooked path reproduces the source exactly before timing it
+	NRender::SMesh cooked;
+
+	if (!NUtils::LoadCookedMesh(blob.data(), blob.size(), cooked) ||
+		cooked.m_Vertices.size() != source.m_Vertices.size() ||
+		cooked.m_Indices != source.m_Indices ||
+		cooked.m_SubMeshes.size() != source.m_SubMeshes.size() ||
+		memcmp(cooked.m_Vertices.data(), source.m_Vertices.data(), source.m_Vertices.size() * sizeof(NRender::SMesh::SVertexData)))
+	{
+		remove(cooked_filename.c_str());
+		return false;
+	}
+
+#ifdef ENGINE_ASSIMP
+	const std::string& filename = context.m_MeshFilename;
+
+	if (!filename.empty() && (filename.size() < 5 || filename.compare(filename.size() - 5, 5, ".mesh")))
+	{
+		const double assimp_ms = Measure(context.m_Iterations, [&]() {
+			NRender::SMesh mesh;
+			NUtils::LoadMesh(context.m_MeshFilename.c_str(), "", mesh);
+		});
+
+		Report("assimp", assimp_ms);
+	}
+#endif
+
+	const double cooked_ms = Measure(context.m_Iterations, [&]() {
+		NRender::SMesh mesh;
+		NUtils::LoadCookedMesh(cooked_filename.c_str(), mesh);
+	});
+
+	const double memory_ms = Measure(context.m_Iterations, [&]() {
+		NRender::SMesh mesh;
+		NUtils::LoadCookedMesh(blob.data(), blob.size(), mesh);
+	});
+
+	remove(cooked_filename.c_str());
+
+	Report("cooked (file)", cooked_ms, "%zu bytes", blob.size());
+	Report("cooked (memory)", memory_ms);
+
+	return true;
+}
+
+struct SStreamResult
+{
+	double m_TotalMs = 0.0;
+	double m_MeanUpdateMs = 0.0;
+	double m_LongestUpdateMs = 0.0;
+	bool m_Valid = true;
+};
+
+// Streams copies of the cooked mesh through the loader, polling it like the frame loop would
+static SStreamResult Stream(const char* filename, size_t loads, size_t threads, size_t expected_vertices)
+{
+	NUtils::CAssetLoader& loader = NUtils::CAssetLoader::Instance();
+	loader.Start(threads);
+
+	SStreamResult result;
+	std::vector<NUtils::HAssetRequest> requests;
+	size_t completed = 0;
+	size_t updates = 0;
+
+	result.m_TotalMs = NBenchmark::Measure(1, [&]() {
+		for (size_t i = 0; i < loads; ++i)
+		{
+			requests.push_back(loader.LoadMesh(filename, [&](const NRender::HMesh& mesh) {
+				result.m_Valid &= mesh != nullptr && mesh->m_Vertices.size() == expected_vertices;
+				++completed;
+			}));
+		}
+
+		// Every other load is cancelled, none of those may reach their callback
+		for (size_t i = 1; i < loads; i += 2)
+		{
+			requests[i]->Cancel();
+		}
+
+		while (loader.Pending())
+		{
+			const double update_ms = NBenchmark::Measure(1, [&]() { loader.Update(1); });
+			result.m_MeanUpdateMs += update_ms;
+			result.m_LongestUpdateMs = std::max(result.m_LongestUpdateMs, update_ms);
+			++updates;
+
+			// Stands in for the rest of the frame, workers keep going meanwhile
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+	});
+
+	loader.Stop();
+
+	result.m_MeanUpdateMs /= std::max<size_t>(updates, 1);
+	result.m_Valid &= completed == (loads + 1) / 2;
+
+	for (size_t i = 0; i < loads; ++i)
+	{
+		result.m_Valid &= requests[i]->State() == (i % 2 ? NUtils::EAssetState::Cancelled : NUtils::EAssetState::Completed);
+	}
+
+	return result;
+}
+
+bool NBenchmark::RunStream(SContext& context)
+{
+	const std::string cooked_filename = "benchmark.mesh";
+
+	if (!NUtils::SaveCookedMesh(cooked_filename.c_str(), context.m_Mesh))
+	{
+		return false;
+	}
+
+	const size_t loads = 16;
+	const size_t vertices = context.m_Mesh.m_Vertices.size();
+
+	// Without workers each load stalls the update that runs it, with them only the hand over is left
+	const SStreamResult sync = Stream(cooked_filename.c_str(), loads, 0, vertices);
+	const SStreamResult async = Stream(cooked_filename.c_str(), loads, 2, vertices);
+
+	remove(cooked_filename.c_str());
+
+	Report("main thread", sync.m_TotalMs, "update %.3f ms mean, %.3f ms longest", sync.m_MeanUpdateMs, sync.m_LongestUpdateMs);
+	Report("2 workers", async.m_TotalMs, "update %.3f ms mean, %.3f ms longest", async.m_MeanUpdateMs, async.m_LongestUpdateMs);
+
+	return sync.m_Valid && async.m_Valid;
+}
+
+static bool ReadFile(const std::string& filename, std::vector<uint8_t>& data)
+{
+	FILE* file = fopen(filename.c_str(), "rb");
+
+	if (!file)
+	{
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	data.resize(ftell(file));
+	rewind(file);
+
+	const bool read = fread(data.data(), 1, data.size(), file) == data.size();
+	fclose(file);
+	return read;
+}
+
+// Every archived file has to come back exactly as it went in
+static bool ValidateArchive(const std::vector<NUtils::SArchiveFile>& files)
+{
+	for (const NUtils::SArchiveFile& file : files)
+	{
+		NUtils::SAssetSlice slice;
+
+		if (!NUtils::CAssetArchive::Instance().Open(file.m_Path, slice) ||
+			slice.m_Size != file.m_Data.size() ||
+			memcmp(slice.m_Data.get(), file.m_Data.data(), slice.m_Size))
+		{
+			printf("Archived file doesn't match: %s\n", file.m_Path.c_str());
+			return false;
+		}
+	}
+
+	NUtils::SAssetSlice slice;
+	return !NUtils::CAssetArchive::Instance().Open("benchmark_archive/missing.mesh", slice);
+}
+
+bool NBenchmark::RunArchive(SContext& context)
+{
+	const std::string directory = "benchmark_archive";
+	const std::string archive_filename = "benchmark.pak";
+	const size_t file_count = 64;
+
+	// Half cooked meshes and half raw gradients, like the textures that aren't cooked
+	std::vector<NUtils::SArchiveFile> files(file_count);
+	std::vector<uint8_t> mesh_blob;
+	NUtils::CookMesh(context.m_Mesh, mesh_blob);
+
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+
+	for (size_t i = 0; i < file_count; ++i)
+	{
+		NUtils::SArchiveFile& file = files[i];
+		char name[64];
+
+		if (i % 2 == 0)
+		{
+			snprintf(name, sizeof(name), "/mesh_%03zu.mesh", i);
+			file.m_Data = mesh_blob;
+		}
+		else
+		{
+			snprintf(name, sizeof(name), "/image_%03zu.raw", i);
+			file.m_Data.resize(64 * 64 * 4);
+
+			for (size_t j = 0; j < file.m_Data.size(); ++j)
+			{
+				file.m_Data[j] = uint8_t((j / 4 % 64) * (j % 4 + 1) + i);
+			}
+		}
+
+		file.m_Path = directory + name;
+		file.m_Compress = true;
+
+		FILE* output = fopen(file.m_Path.c_str(), "wb");
+
+		if (!output || fwrite(file.m_Data.data(), 1, file.m_Data.size(), output) != file.m_Data.size())
+		{
+			printf("Failed to write file: %s\n", file.m_Path.c_str());
+
+			if (output)
+			{
+				fclose(output);
+			}
+
+			std::filesystem::remove_all(directory, error);
+			return false;
+		}
+
+		fclose(output);
+	}
+
+	size_t total_size = 0;
+
+	for (const NUtils::SArchiveFile& file : files)
+	{
+		total_size += file.m_Data.size();
+	}
+
+	// Loose files first, reading each one into a buffer of its own
+	const double files_ms = Measure(context.m_Iterations, [&]() {
+		std::vector<uint8_t> data;
+
+		for (const NUtils::SArchiveFile& file : files)
+		{
+			ReadFile(file.m_Path, data);
+		}
+	});
+
+	const std::string mesh_filename = files[0].m_Path;
+
+	const double mesh_file_ms = Measure(context.m_Iterations, [&]() {
+		NRender::SMesh mesh;
+		NUtils::LoadCookedMesh(mesh_filename.c_str(), mesh);
+	});
+
+	std::filesystem::remove_all(directory, error);
+
+	// Stored entries, mapped from disk
+	std::vector<NUtils::SArchiveFile> stored = files;
+
+	for (NUtils::SArchiveFile& file : stored)
+	{
+		file.m_Compress = false;
+	}
+
+	if (!NUtils::SaveArchive(archive_filename.c_str(), stored) || !NUtils::CAssetArchive::Instance().Mount(archive_filename.c_str()))
+	{
+		remove(archive_filename.c_str());
+		return false;
+	}
+
+	const size_t stored_size = size_t(std::filesystem::file_size(archive_filename, error));
+	remove(archive_filename.c_str());
+
+	if (!ValidateArchive(files))
+	{
+		NUtils::CAssetArchive::Instance().Unmount();
+		return false;
+	}
+
+	const double stored_ms = Measure(context.m_Iterations, [&]() {
+		for (const NUtils::SArchiveFile& file : files)
+		{
+			NUtils::SAssetSlice slice;
+			NUtils::CAssetArchive::Instance().Open(file.m_Path, slice);
+		}
+	});
+
+	NRender::SMesh archived_mesh;
+	const bool mesh_valid = NUtils::LoadCookedMesh(mesh_filename.c_str(), archived_mesh) &&
+							archived_mesh.m_Vertices.size() == context.m_Mesh.m_Vertices.size() &&
+							archived_mesh.m_Indices == context.m_Mesh.m_Indices;
+
+	const double mesh_archive_ms = Measure(context.m_Iterations, [&]() {
+		NRender::SMesh mesh;
+		NUtils::LoadCookedMesh(mesh_filename.c_str(), mesh);
+	});
+
+	// Compressed entries, mounted from memory like a fetched archive
+	std::vector<uint8_t> compressed_blob;
+
+	if (!mesh_valid || !NUtils::PackArchive(files, compressed_blob) ||
+		!NUtils::CAssetArchive::Instance().Mount(std::shared_ptr<const uint8_t>(compressed_blob.data(), [](const uint8_t*) {}), compressed_blob.size()) ||
+		!ValidateArchive(files))
+	{
+		NUtils::CAssetArchive::Instance().Unmount();
+		return false;
+	}
+
+	const double compressed_ms = Measure(context.m_Iterations, [&]() {
+		for (const NUtils::SArchiveFile& file : files)
+		{
+			NUtils::SAssetSlice slice;
+			NUtils::CAssetArchive::Instance().Open(file.m_Path, slice);
+		}
+	});
+
+	NUtils::CAssetArchive::Instance().Unmount();
+
+	Report("files", files_ms, "%zu files, %zu bytes", files.size(), total_size);
+	Report("archive (stored)", stored_ms, "%zu bytes", stored_size);
+	Report("archive (lz)", compressed_ms, "%zu bytes, ratio %.2f", compressed_blob.size(), double(total_size) / compressed_blob.size());
+	Report("mesh (file)", mesh_file_ms);
+	Report("mesh (archive)", mesh_archive_ms);
+
+	return true;
+}
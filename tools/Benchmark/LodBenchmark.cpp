@@ -0,0 +1,267 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Engine/Camera.h"
+#include "Engine/Frustum.h"
+#include "Engine/Math.h"
+#include "Utils/CookedMesh.h"
+#include "Utils/MeshOptimizer.h"
+#include "Utils/MeshQuantizer.h"
+#include "Utils/MeshSimplifier.h"
+
+namespace
+{
+// Only every few original vertices are measured against a level, brute force over its triangles
+constexpr size_t DEVIATION_STRIDE = 7;
+
+// Closest point on a triangle (Ericson, Real-Time Collision Detection 5.1.5)
+CVector3f ClosestPointOnTriangle(const CVector3f& p, const CVector3f& a, const CVector3f& b, const CVector3f& c)
+{
+	const CVector3f ab = b - a, ac = c - a, ap = p - a;
+	const float d1 = ab.dot(ap), d2 = ac.dot(ap);
+
+	if (d1 <= 0.0f && d2 <= 0.0f)
+	{
+		return a;
+	}
+
+	const CVector3f bp = p - b;
+	const float d3 = ab.dot(bp), d4 = ac.dot(bp);
+
+	if (d3 >= 0.0f && d4 <= d3)
+	{
+		return b;
+	}
+
+	const float vc = d1 * d4 - d3 * d2;
+
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+	{
+		return a + ab * (d1 / (d1 - d3));
+	}
+
+	const CVector3f cp = p - c;
+	const float d5 = ab.dot(cp), d6 = ac.dot(cp);
+
+	if (d6 >= 0.0f && d5 <= d6)
+	{
+		return c;
+	}
+
+	const float vb = d5 * d2 - d1 * d6;
+
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+	{
+		return a + ac * (d2 / (d2 - d6));
+	}
+
+	const float va = d3 * d6 - d5 * d4;
+
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+	{
+		return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+	}
+
+	const float denominator = 1.0f / (va + vb + vc);
+	return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+struct SDeviation
+{
+	float m_Max = 0.0f;
+	double m_Sum = 0.0;
+	size_t m_Samples = 0;
+};
+
+// Distance from sampled vertices of the full detail surface to the level's surface
+void MeasureDeviation(const NRender::SMesh& mesh, const NRender::SMesh::SSubMesh& sub_mesh, size_t lod, SDeviation& deviation)
+{
+	const uint32_t* indices = &mesh.m_Indices[sub_mesh.LodIndexOffset(lod)];
+	const size_t index_count = sub_mesh.LodIndexCount(lod);
+	std::vector<CVector3f> triangles(index_count);
+
+	for (size_t i = 0; i < index_count; ++i)
+	{
+		triangles[i] = NUtils::GetVertexPosition(mesh, sub_mesh, indices[i]);
+	}
+
+	for (size_t i = 0; i < sub_mesh.m_IndexCount; i += 3 * DEVIATION_STRIDE)
+	{
+		const CVector3f point = NUtils::GetVertexPosition(mesh, sub_mesh, mesh.m_Indices[sub_mesh.m_IndexOffset + i]);
+		float nearest = FLT_MAX;
+
+		for (size_t t = 0; t < index_count; t += 3)
+		{
+			nearest = std::min(nearest, (ClosestPointOnTriangle(point, triangles[t], triangles[t + 1], triangles[t + 2]) - point).squaredNorm());
+		}
+
+		nearest = std::sqrt(nearest);
+		deviation.m_Max = std::max(deviation.m_Max, nearest);
+		deviation.m_Sum += nearest;
+		++deviation.m_Samples;
+	}
+}
+}  // namespace
+
+bool NBenchmark::RunLod(SContext& context)
+{
+	NRender::SMesh mesh;
+
+	const double generate_ms = Measure(std::max(context.m_Iterations / 10, 1), [&]() {
+		mesh = context.m_Mesh;
+		NUtils::GenerateLods(mesh);
+	});
+
+	size_t max_lods = 0;
+	size_t full_triangles = 0;
+
+	for (const NRender::SMesh::SSubMesh& sub_mesh : mesh.m_SubMeshes)
+	{
+		max_lods = std::max(max_lods, sub_mesh.LodCount());
+		full_triangles += sub_mesh.m_IndexCount / 3;
+	}
+
+	Report("generate", generate_ms, "%zu submeshes, %zu triangles, up to %zu levels", mesh.m_SubMeshes.size(), full_triangles, max_lods);
+
+	// Ranges must stay within their submesh's vertices, get smaller and never claim less error than the level before
+	bool succeeded = max_lods > 1;
+
+	for (const NRender::SMesh::SSubMesh& sub_mesh : mesh.m_SubMeshes)
+	{
+		for (size_t lod = 1; lod < sub_mesh.LodCount(); ++lod)
+		{
+			const size_t offset = sub_mesh.LodIndexOffset(lod);
+			const size_t count = sub_mesh.LodIndexCount(lod);
+
+			succeeded &= count % 3 == 0 && offset + count <= mesh.m_Indices.size();
+			succeeded &= count < sub_mesh.LodIndexCount(lod - 1);
+			succeeded &= lod == 1 || sub_mesh.m_Lods[lod - 1].m_Error >= sub_mesh.m_Lods[lod - 2].m_Error;
+
+			for (size_t i = offset; i < offset + count; ++i)
+			{
+				succeeded &= mesh.m_Indices[i] >= sub_mesh.m_VertexOffset && mesh.m_Indices[i] < sub_mesh.m_VertexOffset + sub_mesh.m_VertexCount;
+			}
+		}
+	}
+
+	// Per level over all submeshes, submeshes that ran out of levels count with their coarsest one
+	const float radius = std::max(mesh.m_Bounds.m_Radius, FLT_MIN);
+
+	for (size_t lod = 1; lod < max_lods; ++lod)
+	{
+		SDeviation deviation;
+		size_t triangles = 0;
+		float error = 0.0f;
+
+		for (const NRender::SMesh::SSubMesh& sub_mesh : mesh.m_SubMeshes)
+		{
+			const size_t level = std::min(lod, sub_mesh.LodCount() - 1);
+			triangles += sub_mesh.LodIndexCount(level) / 3;
+			error = std::max(error, level ? sub_mesh.m_Lods[level - 1].m_Error : 0.0f);
+			MeasureDeviation(mesh, sub_mesh, level, deviation);
+		}
+
+		char name[32];
+		snprintf(name, sizeof(name), "level %zu", lod);
+		Report(name, 0.0, "%zu triangles (%.1f%%), quadric error %.3f%%, deviation max %.3f%% mean %.4f%% of radius",
+			   triangles, 100.0 * triangles / std::max<size_t>(full_triangles, 1), 100.0f * error / radius,
+			   100.0f * deviation.m_Max / radius, 100.0 * deviation.m_Sum / std::max<size_t>(deviation.m_Samples, 1) / radius);
+	}
+
+	// Levels have to survive the optimizer and a trip through the cooked format
+	NRender::SMesh cooked;
+	std::vector<uint8_t> blob;
+	NUtils::OptimizeMesh(mesh);
+	succeeded &= NUtils::CookMesh(mesh, blob) && NUtils::LoadCookedMesh(blob.data(), blob.size(), cooked);
+	succeeded &= cooked.m_Indices == mesh.m_Indices && cooked.m_SubMeshes.size() == mesh.m_SubMeshes.size();
+
+	for (size_t i = 0; succeeded && i < mesh.m_SubMeshes.size(); ++i)
+	{
+		const NRender::SMesh::SSubMesh& a = mesh.m_SubMeshes[i];
+		const NRender::SMesh::SSubMesh& b = cooked.m_SubMeshes[i];
+		succeeded &= a.LodCount() == b.LodCount();
+
+		for (size_t lod = 0; succeeded && lod < a.LodCount(); ++lod)
+		{
+			succeeded &= a.LodIndexOffset(lod) == b.LodIndexOffset(lod) && a.LodIndexCount(lod) == b.LodIndexCount(lod);
+		}
+	}
+
+	// Instances scattered around the camera as in the scene suites, levels picked as CMeshInstance::Submit does
+	CCamera camera;
+	camera.setViewport(1280, 720);
+	camera.setPosition(CVector3f::Zero());
+	camera.setTarget(-CVector3f::UnitZ());
+
+	std::mt19937 random(1337);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+	std::vector<CTransform> transforms(context.m_Instances);
+
+	for (CTransform& transform : transforms)
+	{
+		transform.setIdentity();
+		transform.translation() = CVector3f(position(random), position(random) * 0.1f, position(random));
+	}
+
+	const CVector3f mesh_min(&mesh.m_Bounds.m_Min.m_X);
+	const CVector3f mesh_max(&mesh.m_Bounds.m_Max.m_X);
+
+	for (float pixels : { 0.5f, 1.0f, 4.0f })
+	{
+		size_t full_detail = 0;
+		size_t selected = 0;
+		std::vector<size_t> histogram(max_lods, 0);
+
+		const double select_ms = Measure(context.m_Iterations, [&]() {
+			full_detail = 0;
+			selected = 0;
+			std::fill(histogram.begin(), histogram.end(), 0);
+
+			for (const CTransform& transform : transforms)
+			{
+				if (!camera.frustum().Transformed(transform).TestBox(mesh_min, mesh_max))
+				{
+					continue;
+				}
+
+				const CTransform model_view = camera.viewMatrix() * transform;
+				const float scale = transform.linear().colwise().norm().maxCoeff();
+
+				for (const NRender::SMesh::SSubMesh& sub_mesh : mesh.m_SubMeshes)
+				{
+					const CVector3f center = model_view * CVector3f(&sub_mesh.m_Bounds.m_Center.m_X);
+					const float distance = std::max(center.norm() - sub_mesh.m_Bounds.m_Radius * scale, 0.0f);
+					const size_t lod = sub_mesh.SelectLod(camera.pixelSize(distance) * pixels / scale);
+
+					full_detail += sub_mesh.m_IndexCount / 3;
+					selected += sub_mesh.LodIndexCount(lod) / 3;
+					++histogram[lod];
+				}
+			}
+		});
+
+		char name[32], levels[64] = "";
+		snprintf(name, sizeof(name), "select at %g px", pixels);
+
+		for (size_t lod = 0; lod < max_lods; ++lod)
+		{
+			const size_t length = strlen(levels);
+			snprintf(levels + length, sizeof(levels) - length, "%s%zu", lod ? "/" : "", histogram[lod]);
+		}
+
+		Report(name, select_ms, "%zu of %zu triangles (%.1f%% saved), submeshes per level %s",
+			   selected, full_detail, 100.0 - 100.0 * selected / std::max<size_t>(full_detail, 1), levels);
+
+		succeeded &= full_detail > 0 && selected < full_detail;
+	}
+
+	return succeeded;
+}
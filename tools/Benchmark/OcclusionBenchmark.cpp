@@ -0,0 +1,203 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "Engine/Camera.h"
+#include "Engine/Render/OcclusionBuffer.h"
+#include "Engine/Render/SoftwareRasterizer.h"
+#include "Utils/MeshBounds.h"
+
+namespace
+{
+constexpr uint16_t WIDTH = 640;
+constexpr uint16_t HEIGHT = 480;
+
+// Two triangles, counter clockwise seen from the side the quad faces
+void AddQuad(NRender::SMesh& mesh, const CVector3f& a, const CVector3f& b, const CVector3f& c, const CVector3f& d)
+{
+	const uint32_t first = uint32_t(mesh.m_Vertices.size());
+	const CVector3f normal = (b - a).cross(c - a).normalized();
+	const CVector3f tangent = (b - a).normalized();
+
+	for (const CVector3f& position : { a, b, c, d })
+	{
+		NRender::SMesh::SVertexData vertex;
+		vertex.m_Position = { position.x(), position.y(), position.z() };
+		vertex.m_Normal = { normal.x(), normal.y(), normal.z() };
+		vertex.m_Tangent = { tangent.x(), tangent.y(), tangent.z(), 1.0f };
+		mesh.m_Vertices.push_back(vertex);
+	}
+
+	mesh.m_Indices.insert(mesh.m_Indices.end(), { first, first + 1, first + 2, first, first + 2, first + 3 });
+}
+
+void FinishMesh(NRender::SMesh& mesh)
+{
+	NRender::SMesh::SSubMesh sub_mesh;
+	sub_mesh.m_VertexCount = mesh.m_Vertices.size();
+	sub_mesh.m_IndexCount = mesh.m_Indices.size();
+	mesh.m_SubMeshes.push_back(sub_mesh);
+	NUtils::ComputeBounds(mesh);
+}
+
+// A wall facing the camera with a doorway from the ground up to the given height
+void AddWall(NRender::SMesh& mesh, float depth, float door_min_x, float door_max_x, float door_height)
+{
+	const float extent = 100.0f;
+	const float ground = -10.0f;
+
+	AddQuad(mesh, { -extent, ground, depth }, { door_min_x, ground, depth }, { door_min_x, extent, depth }, { -extent, extent, depth });
+	AddQuad(mesh, { door_max_x, ground, depth }, { extent, ground, depth }, { extent, extent, depth }, { door_max_x, extent, depth });
+	AddQuad(mesh, { door_min_x, door_height, depth }, { door_max_x, door_height, depth }, { door_max_x, extent, depth }, { door_min_x, extent, depth });
+}
+
+// The box in world space with its faces turned outwards
+void AddBox(NRender::SMesh& mesh, const CVector3f& min, const CVector3f& max, const CTransform& transform)
+{
+	CVector3f corners[8];
+
+	for (int corner = 0; corner < 8; ++corner)
+	{
+		corners[corner] = transform * CVector3f(corner & 1 ? max.x() : min.x(), corner & 2 ? max.y() : min.y(), corner & 4 ? max.z() : min.z());
+	}
+
+	static const int faces[6][4] = { { 0, 4, 6, 2 }, { 1, 3, 7, 5 }, { 0, 1, 5, 4 }, { 2, 6, 7, 3 }, { 0, 2, 3, 1 }, { 4, 5, 7, 6 } };
+
+	for (const int* face : faces)
+	{
+		AddQuad(mesh, corners[face[0]], corners[face[1]], corners[face[2]], corners[face[3]]);
+	}
+}
+}  // namespace
+
+bool NBenchmark::RunOcclusion(SContext& context)
+{
+	const NRender::SMesh& mesh = context.m_Mesh;
+
+	// Two walls, the doorway of the far one off to the side of the near one's
+	NRender::SMesh walls;
+	AddWall(walls, -20.0f, -4.0f, 4.0f, 6.0f);
+	AddWall(walls, -60.0f, 10.0f, 20.0f, 8.0f);
+	FinishMesh(walls);
+
+	// Occludees about two units across, scattered behind the near wall
+	std::mt19937 random(1337);
+	std::uniform_real_distribution<float> position_x(-80.0f, 80.0f);
+	std::uniform_real_distribution<float> position_y(-8.0f, 10.0f);
+	std::uniform_real_distribution<float> position_z(-200.0f, -25.0f);
+	std::uniform_real_distribution<float> angle(0.0f, 2.0f * float(M_PI));
+
+	const float scale = 1.0f / std::max(mesh.m_Bounds.m_Radius, 1e-3f);
+	const CVector3f center(&mesh.m_Bounds.m_Center.m_X);
+	std::vector<CTransform> transforms(context.m_Instances);
+
+	for (CTransform& transform : transforms)
+	{
+		transform.setIdentity();
+		transform.translate(CVector3f(position_x(random), position_y(random), position_z(random)));
+		transform.rotate(CAngleAxisf(angle(random), CVector3f::UnitY()));
+		transform.scale(scale);
+		transform.translate(-center);
+	}
+
+	CCamera camera;
+	camera.setViewport(WIDTH, HEIGHT);
+	camera.setPosition(CVector3f(0.0f, 2.0f, 0.0f));
+	camera.setTarget(CVector3f(0.0f, 2.0f, -1.0f));
+
+	NRender::COcclusionBuffer occlusion;
+
+	const double build_ms = Measure(context.m_Iterations, [&]() {
+		occlusion.Begin(camera);
+		occlusion.AddOccluder(walls, CTransform::Identity());
+		occlusion.Finish();
+	});
+
+	const NRender::SOcclusionStats stats = occlusion.Stats();
+
+	Report("build", build_ms, "%ux%u, %zu levels, %zu of %zu occluder triangles rasterized",
+		   occlusion.Width(), occlusion.Height(), occlusion.Levels(), stats.m_RasterizedTriangles, stats.m_Triangles);
+
+	// Frustum first and occlusion for what's left, submeshes only once their instance survived, as Submit does
+	const CFrustum& frustum = camera.frustum();
+	size_t in_frustum = 0, occluded_instances = 0, occluded_sub_meshes = 0, visible_sub_meshes = 0;
+
+	auto Cull = [&](NRender::SMesh* hidden) {
+		in_frustum = occluded_instances = occluded_sub_meshes = visible_sub_meshes = 0;
+
+		for (const CTransform& transform : transforms)
+		{
+			const CVector3f min(&mesh.m_Bounds.m_Min.m_X);
+			const CVector3f max(&mesh.m_Bounds.m_Max.m_X);
+
+			if (!frustum.Transformed(transform).TestBox(min, max))
+			{
+				continue;
+			}
+
+			++in_frustum;
+
+			if (occlusion.IsOccluded(min, max, transform))
+			{
+				++occluded_instances;
+
+				if (hidden)
+				{
+					AddBox(*hidden, min, max, transform);
+				}
+
+				continue;
+			}
+
+			for (const NRender::SMesh::SSubMesh& sub_mesh : mesh.m_SubMeshes)
+			{
+				const CVector3f sub_min(&sub_mesh.m_Bounds.m_Min.m_X);
+				const CVector3f sub_max(&sub_mesh.m_Bounds.m_Max.m_X);
+
+				if (mesh.m_SubMeshes.size() > 1 && occlusion.IsOccluded(sub_min, sub_max, transform))
+				{
+					++occluded_sub_meshes;
+
+					if (hidden)
+					{
+						AddBox(*hidden, sub_min, sub_max, transform);
+					}
+
+					continue;
+				}
+
+				++visible_sub_meshes;
+			}
+		}
+	};
+
+	const double test_ms = Measure(context.m_Iterations, [&]() { Cull(nullptr); });
+
+	Report("test", test_ms, "%zu in frustum, %zu occluded, %zu submeshes occluded, %zu visible, %.1f M tests/s",
+		   in_frustum, occluded_instances, occluded_sub_meshes, visible_sub_meshes, (in_frustum + (in_frustum - occluded_instances) * mesh.m_SubMeshes.size()) / test_ms / 1e3);
+
+	// Culling has to be conservative: everything rejected lies behind the walls in the real frame, so
+	// drawing the bounds of all of it after the walls must not pass the depth test anywhere
+	NRender::CSoftwareRasterizer rasterizer;
+	rasterizer.Resize(WIDTH, HEIGHT);
+
+	rasterizer.Begin(camera);
+	rasterizer.Draw(walls, CTransform::Identity());
+	rasterizer.End();
+	const size_t wall_fragments = rasterizer.Stats().m_ShadedFragments;
+
+	NRender::SMesh hidden;
+	Cull(&hidden);
+	FinishMesh(hidden);
+	rasterizer.Begin(camera);
+	rasterizer.Draw(walls, CTransform::Identity());
+	rasterizer.Draw(hidden, CTransform::Identity());
+	rasterizer.End();
+	const size_t hidden_fragments = rasterizer.Stats().m_ShadedFragments - wall_fragments;
+
+	Report("conservative", 0.0, "%zu boxes, %zu fragments in front of the walls", hidden.m_Indices.size() / 36, hidden_fragments);
+
+	return hidden_fragments == 0 && occluded_instances > 0 && occluded_instances < in_frustum;
+}
@@ -0,0 +1,120 @@
+#include "Benchmark.h"
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "Utils/Profiler.h"
+#include "Utils/TaskPool.h"
+
+namespace
+{
+const size_t s_Frames = 100;
+const size_t s_ZonesPerFrame = 100;
+
+// Nested pairs of zones, the inner one around a little bit of work so the compiler can't drop it
+void RecordFrames(volatile uint32_t& sink)
+{
+	for (size_t frame = 0; frame < s_Frames; ++frame)
+	{
+		NUtils::CProfiler::Instance().BeginFrame();
+
+		for (size_t i = 0; i < s_ZonesPerFrame; ++i)
+		{
+			PROFILE_ZONE("Outer");
+			PROFILE_ZONE("Inner");
+			sink = sink + uint32_t(i);
+		}
+	}
+}
+}  // namespace
+
+bool NBenchmark::RunProfile(SContext& context)
+{
+	NUtils::CProfiler& profiler = NUtils::CProfiler::Instance();
+	volatile uint32_t sink = 0;
+
+	const size_t zones = s_Frames * s_ZonesPerFrame * 2;
+
+	profiler.SetEnabled(false);
+	const double disabled_ms = Measure(context.m_Iterations, [&]() { RecordFrames(sink); });
+
+	profiler.SetEnabled(true);
+	const double enabled_ms = Measure(context.m_Iterations, [&]() { RecordFrames(sink); });
+
+	// Zones from every pool thread have to come back nested and complete
+	NUtils::CTaskPool::Instance().Start(2);
+
+	const size_t frames = 10;
+	const size_t tasks = 64;
+	profiler.BeginFrame();
+	const uint64_t start = NUtils::CProfiler::Now();
+
+	for (size_t frame = 0; frame < frames; ++frame)
+	{
+		NUtils::CTaskPool::Instance().ParallelFor(tasks, [&](size_t index) {
+			PROFILE_ZONE("Task");
+			PROFILE_ZONE("Task work");
+			sink = sink + uint32_t(index);
+		});
+
+		profiler.BeginFrame();
+	}
+
+	NUtils::CTaskPool::Instance().Stop();
+
+	const std::vector<NUtils::SProfileEvent> events = profiler.Events();
+	size_t outer = 0;
+	size_t inner = 0;
+	bool valid = profiler.Dropped() == 0;
+
+	for (const NUtils::SProfileEvent& event : events)
+	{
+		if (event.m_Start < start || strncmp(event.m_Name, "Task", 4))
+		{
+			continue;
+		}
+
+		const bool is_outer = !strcmp(event.m_Name, "Task");
+		outer += is_outer;
+		inner += !is_outer;
+		valid &= event.m_End >= event.m_Start && event.m_Depth == (is_outer ? 0 : 1);
+
+		// Every inner zone lies within an outer zone of its own thread
+		if (!is_outer)
+		{
+			bool nested = false;
+
+			for (const NUtils::SProfileEvent& parent : events)
+			{
+				nested |= parent.m_Thread == event.m_Thread && parent.m_Depth == 0 && !strcmp(parent.m_Name, "Task") &&
+						  parent.m_Start <= event.m_Start && parent.m_End >= event.m_End;
+			}
+
+			valid &= nested;
+		}
+	}
+
+	valid &= outer == frames * tasks && inner == frames * tasks;
+
+	// One complete event per zone in the trace
+	std::string json;
+	profiler.ExportChromeTrace(json);
+
+	size_t trace_events = 0;
+	for (size_t position = json.find("\"ph\":\"X\""); position != std::string::npos; position = json.find("\"ph\":\"X\"", position + 1))
+	{
+		++trace_events;
+	}
+
+	valid &= trace_events == profiler.Events().size();
+
+	profiler.SetEnabled(false);
+
+	Report("disabled", disabled_ms, "%.2f ns per zone", disabled_ms * 1e6 / zones);
+	Report("enabled", enabled_ms, "%.2f ns per zone", enabled_ms * 1e6 / zones);
+	Report("trace", 0.0, "%zu events, %zu bytes", trace_events, json.size());
+
+	return valid;
+}
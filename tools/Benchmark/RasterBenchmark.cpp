@@ -0,0 +1,241 @@
+#include "Benchmark.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Engine/Camera.h"
+#include "Engine/Render/Material.h"
+#include "Engine/Render/SoftwareRasterizer.h"
+#include "Engine/Render/Texture.h"
+#include "Utils/MeshBounds.h"
+#include "Utils/TaskPool.h"
+
+namespace
+{
+constexpr uint16_t WIDTH = 640;
+constexpr uint16_t HEIGHT = 480;
+
+// Left without mips so the rasterizer has to build them, like the GPU would
+NRender::HTexture MakeChecker(uint16_t size)
+{
+	NRender::HTexture texture = std::make_shared<NRender::STexture>();
+	texture->m_Name = "checker";
+	texture->m_Width = size;
+	texture->m_Height = size;
+	texture->m_Format = NRender::ETextureFormat::RGBA8;
+	texture->m_GenerateMips = true;
+	texture->m_Buffer.resize(size_t(size) * size * 4);
+
+	for (size_t y = 0; y < size; ++y)
+	{
+		for (size_t x = 0; x < size; ++x)
+		{
+			const bool odd = ((x / 16) ^ (y / 16)) & 1;
+			uint8_t* pixel = &texture->m_Buffer[(y * size + x) * 4];
+			pixel[0] = odd ? 230 : 40;
+			pixel[1] = odd ? 200 : 90;
+			pixel[2] = odd ? 120 : 160;
+			pixel[3] = 255;
+		}
+	}
+
+	return texture;
+}
+
+// Two channels of gentle bumps, basic.frag takes them as the tangent space xy of the normal
+NRender::HTexture MakeBumps(uint16_t size)
+{
+	NRender::HTexture texture = std::make_shared<NRender::STexture>();
+	texture->m_Name = "bumps";
+	texture->m_Width = size;
+	texture->m_Height = size;
+	texture->m_Format = NRender::ETextureFormat::RG8;
+	texture->m_Buffer.resize(size_t(size) * size * 2);
+
+	for (size_t y = 0; y < size; ++y)
+	{
+		for (size_t x = 0; x < size; ++x)
+		{
+			const float angle = 2.0f * float(M_PI) * 4.0f / size;
+			texture->m_Buffer[(y * size + x) * 2 + 0] = uint8_t(40.0f + 30.0f * sinf(x * angle));
+			texture->m_Buffer[(y * size + x) * 2 + 1] = uint8_t(40.0f + 30.0f * cosf(y * angle));
+		}
+	}
+
+	return texture;
+}
+
+// A jittered grid reaching well past the guard band on every side, facing the camera
+void MakeWall(NRender::SMesh& mesh, size_t cells, float extent, float depth)
+{
+	std::mt19937 random(1337);
+	std::uniform_real_distribution<float> jitter(-0.3f, 0.3f);
+	const float cell = 2.0f * extent / cells;
+
+	mesh = NRender::SMesh();
+
+	for (size_t y = 0; y <= cells; ++y)
+	{
+		for (size_t x = 0; x <= cells; ++x)
+		{
+			const bool border = x == 0 || y == 0 || x == cells || y == cells;
+
+			NRender::SMesh::SVertexData vertex;
+			vertex.m_Position = { -extent + (x + (border ? 0.0f : jitter(random))) * cell, -extent + (y + (border ? 0.0f : jitter(random))) * cell, depth };
+			vertex.m_Normal = { 0.0f, 0.0f, 1.0f };
+			vertex.m_Tangent = { 1.0f, 0.0f, 0.0f, 1.0f };
+			mesh.m_Vertices.push_back(vertex);
+		}
+	}
+
+	for (uint32_t y = 0; y < cells; ++y)
+	{
+		for (uint32_t x = 0; x < cells; ++x)
+		{
+			const uint32_t corner = y * uint32_t(cells + 1) + x;
+			const uint32_t above = corner + uint32_t(cells + 1);
+			mesh.m_Indices.insert(mesh.m_Indices.end(), { corner, corner + 1, above + 1, corner, above + 1, above });
+		}
+	}
+
+	NRender::SMesh::SSubMesh sub_mesh;
+	sub_mesh.m_VertexCount = mesh.m_Vertices.size();
+	sub_mesh.m_IndexCount = mesh.m_Indices.size();
+	mesh.m_SubMeshes.push_back(sub_mesh);
+	NUtils::ComputeBounds(mesh);
+}
+
+uint64_t Hash(const NRender::CSoftwareRasterizer& rasterizer)
+{
+	uint64_t hash = 14695981039346656037ull;
+
+	for (size_t y = 0; y < rasterizer.Height(); ++y)
+	{
+		for (size_t x = 0; x < rasterizer.Width(); ++x)
+		{
+			uint32_t depth;
+			memcpy(&depth, &rasterizer.Depth()[y * rasterizer.Stride() + x], sizeof(depth));
+
+			for (uint32_t value : { rasterizer.Color()[y * rasterizer.Stride() + x], depth })
+			{
+				hash = (hash ^ value) * 1099511628211ull;
+			}
+		}
+	}
+
+	return hash;
+}
+}  // namespace
+
+bool NBenchmark::RunRaster(SContext& context)
+{
+	// The mesh with textures of its own where it has none, untextured materials would render black
+	NRender::SMesh mesh = context.m_Mesh;
+	const NRender::HTexture checker = MakeChecker(256);
+	const NRender::HTexture bumps = MakeBumps(128);
+
+	for (NRender::HMaterial& material : mesh.m_Materials)
+	{
+		material = std::make_shared<NRender::SMaterial>(material ? *material : NRender::SMaterial());
+		material->m_AlbedoTexture = material->m_AlbedoTexture ? material->m_AlbedoTexture : checker;
+		material->m_DetailTexture = material->m_DetailTexture ? material->m_DetailTexture : bumps;
+	}
+
+	// A few rows of instances, each turned differently, filling the view
+	const float radius = std::max(mesh.m_Bounds.m_Radius, 1e-3f);
+	const CVector3f center(&mesh.m_Bounds.m_Center.m_X);
+	std::vector<CTransform> transforms;
+
+	for (int y = 0; y < 3; ++y)
+	{
+		for (int x = 0; x < 4; ++x)
+		{
+			CTransform transform = CTransform::Identity();
+			transform.translate(CVector3f((x - 1.5f) * 2.5f * radius, (y - 1.0f) * 2.5f * radius, 0.0f) - center);
+			transform.rotate(CAngleAxisf(0.4f * (x + 4 * y), CVector3f(1.0f, 1.0f, 0.0f).normalized()));
+			transforms.push_back(transform);
+		}
+	}
+
+	CCamera camera;
+	camera.setViewport(WIDTH, HEIGHT);
+	camera.setPosition(CVector3f(0.0f, 0.0f, 6.5f * radius));
+	camera.setTarget(CVector3f::Zero());
+
+	NRender::CSoftwareRasterizer rasterizer;
+	rasterizer.Resize(WIDTH, HEIGHT);
+
+	auto Render = [&]() {
+		rasterizer.Begin(camera);
+
+		for (const CTransform& transform : transforms)
+		{
+			rasterizer.Draw(mesh, transform);
+		}
+
+		rasterizer.End();
+	};
+
+	NUtils::CTaskPool& pool = NUtils::CTaskPool::Instance();
+	const size_t threads = std::max(std::thread::hardware_concurrency(), 2u);
+	bool succeeded = true;
+
+	pool.Start(0);
+	const double serial_ms = Measure(context.m_Iterations, Render);
+	const uint64_t serial_hash = Hash(rasterizer);
+	const NRender::SRasterStats stats = rasterizer.Stats();
+
+	// Tiles are independent and see their triangles in draw order, so threads can't change a pixel
+	pool.Start(threads);
+	const double parallel_ms = Measure(context.m_Iterations, Render);
+	succeeded &= Hash(rasterizer) == serial_hash;
+
+	if (!context.m_ImageFilename.empty())
+	{
+		succeeded &= rasterizer.SaveImage(context.m_ImageFilename.c_str());
+	}
+
+	Report("serial", serial_ms, "%zu triangles, %zu culled, %zu clipped, %.1f M triangles/s, image %016llx",
+		   stats.m_Triangles, stats.m_CulledTriangles, stats.m_ClippedTriangles, stats.m_Triangles / serial_ms / 1e3, (unsigned long long)serial_hash);
+	Report("parallel", parallel_ms, "%zu threads, %.2fx, %zu binned, %zu fragments, %zu shaded, %.1f M fragments/s",
+		   threads, serial_ms / parallel_ms, stats.m_BinnedTriangles, stats.m_Fragments, stats.m_ShadedFragments, stats.m_Fragments / parallel_ms / 1e3);
+
+	succeeded &= stats.m_ShadedFragments > 0 && stats.m_ShadedFragments <= stats.m_Fragments;
+
+	// Triangles sharing edges have to cover every pixel exactly once, no gaps and no overdraw. A fine
+	// wall has lots of shared edges, the cells of a coarse one cross the guard band and get clipped.
+	camera.setPosition(CVector3f::Zero());
+	camera.setTarget(-CVector3f::UnitZ());
+
+	for (size_t cells : { 128, 4 })
+	{
+		NRender::SMesh wall;
+		MakeWall(wall, cells, cells > 4 ? 40.0f : 100.0f, -10.0f);
+
+		NRender::SRasterStats wall_stats;
+
+		const double wall_ms = Measure(context.m_Iterations, [&]() {
+			rasterizer.Begin(camera);
+			rasterizer.Draw(wall, CTransform::Identity());
+			rasterizer.End();
+			wall_stats = rasterizer.Stats();
+		});
+
+		char name[32];
+		snprintf(name, sizeof(name), "%zux%zu wall", cells, cells);
+		Report(name, wall_ms, "%zu triangles, %zu clipped, %zu fragments for %zu pixels",
+			   wall_stats.m_Triangles, wall_stats.m_ClippedTriangles, wall_stats.m_Fragments, size_t(WIDTH) * HEIGHT);
+
+		succeeded &= cells > 4 || wall_stats.m_ClippedTriangles > 0;
+		succeeded &= wall_stats.m_Fragments == size_t(WIDTH) * HEIGHT && wall_stats.m_ShadedFragments == wall_stats.m_Fragments;
+	}
+
+	pool.Stop();
+
+	return succeeded;
+}
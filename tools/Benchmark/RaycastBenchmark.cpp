@@ -0,0 +1,188 @@
+#include "Benchmark.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Engine/Render/Raycast.h"
+#include "Utils/BvhBuilder.h"
+#include "Utils/CookedMesh.h"
+#include "Utils/MeshQuantizer.h"
+#include "Utils/TaskPool.h"
+
+namespace
+{
+constexpr size_t RAY_COUNT = 256 * 1024;
+constexpr size_t RAY_CHUNK = 256;
+constexpr size_t CHECKED_RAYS = 1000;
+
+// Every triangle tested on its own, the same way the leaves do it
+bool NearestTriangle(const NRender::SMesh& mesh, const CVector3f& origin, const CVector3f& direction, float max_distance, NRender::SRayHit& hit)
+{
+	bool found = false;
+	hit.m_Distance = max_distance;
+
+	for (size_t s = 0; s < mesh.m_SubMeshes.size(); ++s)
+	{
+		const NRender::SMesh::SSubMesh& sub_mesh = mesh.m_SubMeshes[s];
+
+		for (size_t i = 0; i + 2 < sub_mesh.m_IndexCount; i += 3)
+		{
+			const uint32_t* indices = &mesh.m_Indices[sub_mesh.m_IndexOffset + i];
+			const CVector3f a = NUtils::GetVertexPosition(mesh, sub_mesh, indices[0]);
+			const CVector3f edge1 = NUtils::GetVertexPosition(mesh, sub_mesh, indices[1]) - a;
+			const CVector3f edge2 = NUtils::GetVertexPosition(mesh, sub_mesh, indices[2]) - a;
+
+			const CVector3f p = direction.cross(edge2);
+			const float det = edge1.dot(p);
+
+			if (det == 0.0f)
+			{
+				continue;
+			}
+
+			const CVector3f offset = origin - a;
+			const CVector3f q = offset.cross(edge1);
+			const float u = offset.dot(p) / det;
+			const float v = direction.dot(q) / det;
+			const float t = edge2.dot(q) / det;
+
+			if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t < hit.m_Distance)
+			{
+				found = true;
+				hit = { s, i / 3, t, u, v };
+			}
+		}
+	}
+
+	return found;
+}
+
+bool SameTree(const NRender::SMesh::SBvh& a, const NRender::SMesh::SBvh& b)
+{
+	return a.m_Nodes.size() == b.m_Nodes.size() && a.m_Blocks.size() == b.m_Blocks.size() &&
+		   !memcmp(a.m_Nodes.data(), b.m_Nodes.data(), a.m_Nodes.size() * sizeof(a.m_Nodes[0])) &&
+		   !memcmp(a.m_Blocks.data(), b.m_Blocks.data(), a.m_Blocks.size() * sizeof(a.m_Blocks[0]));
+}
+}  // namespace
+
+bool NBenchmark::RunRaycast(SContext& context)
+{
+	NRender::SMesh mesh = context.m_Mesh;
+	NUtils::CTaskPool& pool = NUtils::CTaskPool::Instance();
+	bool succeeded = true;
+
+	const double build_ms = Measure(context.m_Iterations, [&]() { NUtils::BuildBvh(mesh); });
+
+	size_t leaves = 0;
+
+	for (const NRender::SMesh::SBvh::SNode& node : mesh.m_Bvh.m_Nodes)
+	{
+		leaves += node.m_Count != 0;
+	}
+
+	Report("build", build_ms, "%zu triangles, %zu nodes, %zu leaves", mesh.m_Indices.size() / 3, mesh.m_Bvh.m_Nodes.size(), leaves);
+
+	// The tree survives cooking unchanged
+	std::vector<uint8_t> blob;
+	NRender::SMesh cooked;
+	succeeded &= NUtils::CookMesh(mesh, blob) && NUtils::LoadCookedMesh(blob.data(), blob.size(), cooked) && SameTree(mesh.m_Bvh, cooked.m_Bvh);
+
+	// Rays from a sphere around the mesh toward random points within its bounds, most of them hit
+	const CVector3f min(&mesh.m_Bounds.m_Min.m_X), max(&mesh.m_Bounds.m_Max.m_X);
+	const CVector3f center = (min + max) * 0.5f;
+	const float radius = std::max((max - min).norm() * 0.5f, 1e-3f);
+
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::normal_distribution<float> normal;
+	std::vector<CVector3f> origins(RAY_COUNT), directions(RAY_COUNT);
+
+	for (size_t r = 0; r < RAY_COUNT; ++r)
+	{
+		const CVector3f target = min + (max - min).cwiseProduct(CVector3f(unit(random), unit(random), unit(random)));
+		origins[r] = center + CVector3f(normal(random), normal(random), normal(random)).normalized() * 2.0f * radius;
+		directions[r] = (target - origins[r]).normalized();
+	}
+
+	const float max_distance = 4.0f * radius;
+	std::vector<NRender::SRayHit> hits(RAY_COUNT);
+	std::vector<uint8_t> closest(RAY_COUNT), any(RAY_COUNT);
+
+	auto CastClosest = [&](size_t first, size_t last) {
+		for (size_t r = first; r < last; ++r)
+		{
+			closest[r] = NRender::RaycastClosest(mesh, origins[r], directions[r], max_distance, hits[r]);
+		}
+	};
+
+	auto CastAny = [&](size_t first, size_t last) {
+		for (size_t r = first; r < last; ++r)
+		{
+			NRender::SRayHit hit;
+			any[r] = NRender::RaycastAny(mesh, origins[r], directions[r], max_distance, hit);
+		}
+	};
+
+	const double closest_ms = Measure(context.m_Iterations, [&]() { CastClosest(0, RAY_COUNT); });
+	const double any_ms = Measure(context.m_Iterations, [&]() { CastAny(0, RAY_COUNT); });
+	const size_t hit_count = std::count(closest.begin(), closest.end(), 1);
+
+	Report("closest hit", closest_ms, "%zu rays, %zu hits, %.2f M rays/s", RAY_COUNT, hit_count, RAY_COUNT / closest_ms / 1e3);
+	Report("any hit", any_ms, "%.2f M rays/s", RAY_COUNT / any_ms / 1e3);
+
+	const unsigned int threads = std::max(std::thread::hardware_concurrency(), 2u);
+	pool.Start(threads);
+
+	const double closest_parallel_ms = Measure(context.m_Iterations, [&]() {
+		pool.ParallelFor(RAY_COUNT / RAY_CHUNK, [&](size_t chunk) { CastClosest(chunk * RAY_CHUNK, (chunk + 1) * RAY_CHUNK); });
+	});
+
+	const double any_parallel_ms = Measure(context.m_Iterations, [&]() {
+		pool.ParallelFor(RAY_COUNT / RAY_CHUNK, [&](size_t chunk) { CastAny(chunk * RAY_CHUNK, (chunk + 1) * RAY_CHUNK); });
+	});
+
+	pool.Stop();
+
+	Report("closest hit parallel", closest_parallel_ms, "%u threads, %.2f M rays/s", threads, RAY_COUNT / closest_parallel_ms / 1e3);
+	Report("any hit parallel", any_parallel_ms, "%u threads, %.2f M rays/s", threads, RAY_COUNT / any_parallel_ms / 1e3);
+
+	// Checked against brute force, some from inside the mesh so rays start within leaves
+	size_t mismatches = 0;
+
+	for (size_t r = 0; r < CHECKED_RAYS; ++r)
+	{
+		const CVector3f origin = r % 2 ? origins[r] : center;
+		NRender::SRayHit hit, any_hit, expected;
+		const bool found = NRender::RaycastClosest(mesh, origin, directions[r], max_distance, hit);
+		const bool any_found = NRender::RaycastAny(mesh, origin, directions[r], max_distance, any_hit);
+		const bool expected_found = NearestTriangle(mesh, origin, directions[r], max_distance, expected);
+
+		// Triangles sharing the hit point may tie, so only the distance has to match
+		const bool same = found == expected_found && any_found == expected_found &&
+						  (!found || (fabsf(hit.m_Distance - expected.m_Distance) <= 1e-4f * radius && any_hit.m_Distance >= hit.m_Distance));
+
+		mismatches += !same;
+	}
+
+	Report("brute force check", 0.0, "%zu of %zu rays differ", mismatches, CHECKED_RAYS);
+	succeeded &= mismatches == 0;
+
+	// The cooked tree reports the very same hits
+	for (size_t r = 0; r < CHECKED_RAYS; ++r)
+	{
+		NRender::SRayHit loaded;
+
+		if (closest[r] != NRender::RaycastClosest(cooked, origins[r], directions[r], max_distance, loaded) ||
+			(closest[r] && (loaded.m_SubMesh != hits[r].m_SubMesh || loaded.m_Triangle != hits[r].m_Triangle || loaded.m_Distance != hits[r].m_Distance)))
+		{
+			succeeded = false;
+		}
+	}
+
+	return succeeded;
+}
@@ -0,0 +1,250 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "Engine/Camera.h"
+#include "Engine/Frustum.h"
+#include "Engine/Math.h"
+#include "Engine/Render/RenderQueue.h"
+
+namespace
+{
+struct SScene
+{
+	CCamera m_Camera;
+	CVector3f m_Min;
+	CVector3f m_Max;
+	std::vector<CTransform> m_Transforms;
+	std::vector<size_t> m_Materials;
+};
+
+// Instances are scattered around the camera so roughly a fifth of them are in view
+void BuildScene(const NBenchmark::SContext& context, SScene& scene)
+{
+	std::mt19937 random(1337);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+	std::uniform_real_distribution<float> angle(0.0f, 2.0f * float(M_PI));
+	std::uniform_int_distribution<size_t> material(0, 31);
+
+	scene.m_Camera.setViewport(1280, 720);
+	scene.m_Camera.setPosition(CVector3f::Zero());
+	scene.m_Camera.setTarget(-CVector3f::UnitZ());
+
+	scene.m_Min = CVector3f(&context.m_Mesh.m_Bounds.m_Min.m_X);
+	scene.m_Max = CVector3f(&context.m_Mesh.m_Bounds.m_Max.m_X);
+
+	scene.m_Transforms.resize(context.m_Instances);
+	scene.m_Materials.resize(context.m_Instances);
+
+	for (size_t i = 0; i < context.m_Instances; ++i)
+	{
+		scene.m_Transforms[i].setIdentity();
+		scene.m_Transforms[i].translation() = CVector3f(position(random), position(random) * 0.1f, position(random));
+		scene.m_Transforms[i].rotate(CAngleAxisf(angle(random), CVector3f::UnitY()));
+		scene.m_Materials[i] = material(random);
+	}
+}
+}  // namespace
+
+bool NBenchmark::RunTransform(SContext& context)
+{
+	SScene scene;
+	BuildScene(context, scene);
+
+	const Eigen::Matrix4f view_projection = scene.m_Camera.projectionMatrix().matrix() * scene.m_Camera.viewMatrix().matrix();
+	const CMatrix3f rotation(CAngleAxisf(0.125f * float(M_PI) / 60.0f, CVector3f::UnitY()));
+	std::vector<Eigen::Matrix4f> model_view_projection(scene.m_Transforms.size());
+
+	const double transform_ms = Measure(context.m_Iterations, [&]() {
+		for (size_t i = 0; i < scene.m_Transforms.size(); ++i)
+		{
+			scene.m_Transforms[i].rotate(rotation);
+			model_view_projection[i] = view_projection * scene.m_Transforms[i].matrix();
+		}
+	});
+
+	Report("rotate + mvp", transform_ms, "%zu instances", scene.m_Transforms.size());
+
+	return model_view_projection.back().allFinite();
+}
+
+bool NBenchmark::RunCull(SContext& context)
+{
+	SScene scene;
+	BuildScene(context, scene);
+
+	const Eigen::Matrix4f view_projection = scene.m_Camera.projectionMatrix().matrix() * scene.m_Camera.viewMatrix().matrix();
+	size_t visible = 0;
+
+	// Brute force reference: every bounding box corner is taken to clip space
+	const double brute_force_ms = Measure(context.m_Iterations, [&]() {
+		visible = 0;
+
+		for (const CTransform& transform : scene.m_Transforms)
+		{
+			const Eigen::Matrix4f model_view_projection = view_projection * transform.matrix();
+			int outside[6] = {};
+
+			for (int corner = 0; corner < 8; ++corner)
+			{
+				const CVector4f local((corner & 1) ? scene.m_Max.x() : scene.m_Min.x(),
+									  (corner & 2) ? scene.m_Max.y() : scene.m_Min.y(),
+									  (corner & 4) ? scene.m_Max.z() : scene.m_Min.z(),
+									  1.0f);
+				const CVector4f clip = model_view_projection * local;
+
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					outside[axis * 2 + 0] += clip[axis] < -clip.w();
+					outside[axis * 2 + 1] += clip[axis] > clip.w();
+				}
+			}
+
+			visible += std::find(std::begin(outside), std::end(outside), 8) == std::end(outside);
+		}
+	});
+
+	Report("brute force", brute_force_ms, "%zu / %zu visible", visible, scene.m_Transforms.size());
+
+	// Frustum planes moved into each instance's space, as CMeshInstance::Submit does
+	const CFrustum& frustum = scene.m_Camera.frustum();
+	size_t plane_visible = 0;
+
+	const double planes_ms = Measure(context.m_Iterations, [&]() {
+		plane_visible = 0;
+
+		for (const CTransform& transform : scene.m_Transforms)
+		{
+			plane_visible += frustum.Transformed(transform).TestBox(scene.m_Min, scene.m_Max);
+		}
+	});
+
+	Report("local planes", planes_ms, "%zu / %zu visible", plane_visible, scene.m_Transforms.size());
+
+	// World space spheres in structure of arrays, culled in a single batch
+	const NRender::SMesh::SBounds& bounds = context.m_Mesh.m_Bounds;
+	std::vector<float> x(scene.m_Transforms.size()), y(x.size()), z(x.size()), radius(x.size());
+	std::vector<uint8_t> sphere_visible(x.size());
+	size_t batch_visible = 0;
+
+	const double spheres_ms = Measure(context.m_Iterations, [&]() {
+		for (size_t i = 0; i < scene.m_Transforms.size(); ++i)
+		{
+			const CTransform& transform = scene.m_Transforms[i];
+			const CVector3f center = transform * CVector3f(&bounds.m_Center.m_X);
+			x[i] = center.x(), y[i] = center.y(), z[i] = center.z();
+			radius[i] = bounds.m_Radius * transform.linear().colwise().norm().maxCoeff();
+		}
+
+		batch_visible = frustum.CullSpheres(x.data(), y.data(), z.data(), radius.data(), x.size(), sphere_visible.data());
+	});
+
+	Report("batched spheres", spheres_ms, "%zu / %zu visible", batch_visible, scene.m_Transforms.size());
+
+	// Boxes are exact for the clip test, spheres may only ever keep more
+	return visible > 0 && visible < scene.m_Transforms.size() && plane_visible == visible && batch_visible >= visible;
+}
+
+bool NBenchmark::RunSort(SContext& context)
+{
+	SScene scene;
+	BuildScene(context, scene);
+
+	struct SDrawRecord
+	{
+		size_t m_Material;
+		float m_Depth;
+		size_t m_Instance;
+	};
+
+	std::vector<SDrawRecord> records(scene.m_Transforms.size());
+
+	for (size_t i = 0; i < scene.m_Transforms.size(); ++i)
+	{
+		const CVector3f view_position = scene.m_Camera.viewMatrix() * scene.m_Transforms[i].translation();
+		records[i] = { scene.m_Materials[i], -view_position.z(), i };
+	}
+
+	// Material first to minimize state changes, then front to back
+	auto Compare = [](const SDrawRecord& a, const SDrawRecord& b) {
+		return a.m_Material != b.m_Material ? a.m_Material < b.m_Material : a.m_Depth < b.m_Depth;
+	};
+
+	std::vector<SDrawRecord> sorted;
+
+	const double sort_ms = Measure(context.m_Iterations, [&]() {
+		sorted = records;
+		std::sort(sorted.begin(), sorted.end(), Compare);
+	});
+
+	Report("material, depth", sort_ms, "%zu records", sorted.size());
+
+	// Packed keys through the render queue, one packet per submesh with instances spread over a few vertex arrays
+	const uint32_t vertex_arrays = 16;
+	std::vector<NRender::SDrawPacket> packets;
+	packets.reserve(scene.m_Transforms.size() * context.m_Mesh.m_SubMeshes.size());
+
+	for (size_t i = 0; i < scene.m_Transforms.size(); ++i)
+	{
+		const CTransform model_view = scene.m_Camera.viewMatrix() * scene.m_Transforms[i];
+
+		NRender::SDrawPacket packet;
+		packet.m_VertexArray = 1 + uint32_t(i % vertex_arrays);
+		packet.m_Transform = &scene.m_Transforms[i];
+
+		for (size_t j = 0; j < context.m_Mesh.m_SubMeshes.size(); ++j)
+		{
+			const NRender::SMesh::SSubMesh& sub_mesh = context.m_Mesh.m_SubMeshes[j];
+			const float depth = -(model_view * CVector3f(&sub_mesh.m_Bounds.m_Center.m_X)).z();
+			packet.m_SubMesh = &sub_mesh;
+			packet.m_Key = NRender::CRenderQueue::MakeSortKey(0, uint32_t(scene.m_Materials[i]), packet.m_VertexArray, uint32_t(j), 0, depth);
+			packets.push_back(packet);
+		}
+	}
+
+	NRender::CRenderQueue queue;
+
+	const double queue_ms = Measure(context.m_Iterations, [&]() {
+		queue.Clear();
+
+		for (const NRender::SDrawPacket& packet : packets)
+		{
+			queue.Push(packet);
+		}
+
+		queue.Sort();
+	});
+
+	// Material and vertex array binds a submission would make in push order versus sorted order
+	auto CountBinds = [](const NRender::SDrawPacket& a, const NRender::SDrawPacket& b) {
+		return size_t((a.m_Key >> 40) != (b.m_Key >> 40)) + size_t(((a.m_Key >> 24) & 0xFFFF) != ((b.m_Key >> 24) & 0xFFFF));
+	};
+
+	size_t unsorted_binds = packets.empty() ? 0 : 2;
+	size_t sorted_binds = unsorted_binds;
+	bool keys_sorted = true;
+
+	for (size_t i = 1; i < packets.size(); ++i)
+	{
+		unsorted_binds += CountBinds(packets[i - 1], packets[i]);
+		sorted_binds += CountBinds(queue.Sorted(i - 1), queue.Sorted(i));
+		keys_sorted &= queue.Sorted(i - 1).m_Key <= queue.Sorted(i).m_Key;
+	}
+
+	Report("render queue", queue_ms, "%zu packets, %zu binds unsorted, %zu sorted", queue.Size(), unsorted_binds, sorted_binds);
+
+	// Instanced draws left once runs of the same submesh are merged, and the transforms gathered for them
+	const double batch_ms = Measure(context.m_Iterations, [&]() { queue.Batch(); });
+
+	size_t batched = 0;
+	for (const NRender::CRenderQueue::SBatch& batch : queue.Batches())
+	{
+		batched += batch.m_Count;
+	}
+
+	Report("instance batches", batch_ms, "%zu draws for %zu packets", queue.Batches().size(), batched);
+
+	return std::is_sorted(sorted.begin(), sorted.end(), Compare) && keys_sorted && queue.Size() == packets.size() && batched == packets.size();
+}
@@ -0,0 +1,365 @@
+#include "Benchmark.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Engine/Camera.h"
+#include "Engine/Frustum.h"
+#include "Engine/SceneBvh.h"
+#include "Utils/TaskPool.h"
+
+namespace
+{
+constexpr size_t QUERIES = 16;
+
+struct SInstances
+{
+	std::vector<CTransform> m_Transforms;
+	std::vector<CVector3f> m_Min;
+	std::vector<CVector3f> m_Max;
+};
+
+// Spread over a square growing with the count so the density, and the share in view, stay the same
+void Scatter(const NRender::SMesh& mesh, size_t count, SInstances& instances)
+{
+	std::mt19937 random(1337);
+	const float extent = 500.0f * sqrtf(count / 10000.0f);
+	std::uniform_real_distribution<float> position(-extent, extent);
+	std::uniform_real_distribution<float> angle(0.0f, 2.0f * float(M_PI));
+
+	instances.m_Transforms.resize(count);
+	instances.m_Min.resize(count);
+	instances.m_Max.resize(count);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		CTransform& transform = instances.m_Transforms[i];
+		transform.setIdentity();
+		transform.translate(CVector3f(position(random), position(random) * 0.1f, position(random)));
+		transform.rotate(CAngleAxisf(angle(random), CVector3f(1.0f, 2.0f, 0.5f).normalized()));
+		CSceneBvh::TransformBounds(transform, CVector3f(&mesh.m_Bounds.m_Min.m_X), CVector3f(&mesh.m_Bounds.m_Max.m_X), instances.m_Min[i], instances.m_Max[i]);
+	}
+}
+
+bool SameSet(std::vector<uint32_t> a, std::vector<uint32_t> b)
+{
+	std::sort(a.begin(), a.end());
+	std::sort(b.begin(), b.end());
+	return a == b;
+}
+
+// Brute force nearest box along a ray, the same slab test the tree uses
+CSceneBvh::SRayHit NearestBox(const SInstances& instances, const CVector3f& origin, const CVector3f& direction, float max_distance)
+{
+	const CVector3f inverse = direction.cwiseInverse();
+	CSceneBvh::SRayHit hit;
+	hit.m_Distance = max_distance;
+
+	for (size_t i = 0; i < instances.m_Min.size(); ++i)
+	{
+		const CVector3f t0 = (instances.m_Min[i] - origin).cwiseProduct(inverse);
+		const CVector3f t1 = (instances.m_Max[i] - origin).cwiseProduct(inverse);
+		const float enter = std::max(t0.cwiseMin(t1).maxCoeff(), 0.0f);
+		const float leave = std::min(t0.cwiseMax(t1).minCoeff(), hit.m_Distance);
+
+		if (enter <= leave && (enter < hit.m_Distance || hit.m_Proxy == CSceneBvh::Invalid))
+		{
+			hit.m_Proxy = uint32_t(i);
+			hit.m_Distance = enter;
+		}
+	}
+
+	return hit;
+}
+}  // namespace
+
+bool NBenchmark::RunSceneBvh(SContext& context)
+{
+	const NRender::SMesh& mesh = context.m_Mesh;
+	const float radius = std::max(mesh.m_Bounds.m_Radius, 1e-3f);
+	NUtils::CTaskPool& pool = NUtils::CTaskPool::Instance();
+	bool succeeded = true;
+
+	pool.Start(std::max(std::thread::hardware_concurrency(), 2u));
+
+	for (size_t count : { context.m_Instances, context.m_Instances * 10, context.m_Instances * 100 })
+	{
+		printf(" %zu instances\n", count);
+
+		SInstances instances;
+		Scatter(mesh, count, instances);
+
+		CSceneBvh bvh;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			bvh.Add(instances.m_Min[i], instances.m_Max[i]);
+		}
+
+		const double build_ms = Measure(context.m_Iterations, [&]() { bvh.Rebuild(); });
+		const float build_cost = bvh.Cost();
+
+		Report("build", build_ms, "%zu nodes, cost %.1f", bvh.Nodes(), build_cost);
+
+		// Every instance turns a little and drifts, the way an animated scene moves each frame
+		const CMatrix3f rotation(CAngleAxisf(0.125f * float(M_PI) / 60.0f, CVector3f::UnitY()));
+		const size_t rebuilds = bvh.Rebuilds();
+
+		const double refit_ms = Measure(context.m_Iterations, [&]() {
+			for (size_t i = 0; i < count; ++i)
+			{
+				CTransform& transform = instances.m_Transforms[i];
+				transform.linear() = rotation * transform.linear();
+				transform.translation().x() += 0.01f * radius;
+				CSceneBvh::TransformBounds(transform, CVector3f(&mesh.m_Bounds.m_Min.m_X), CVector3f(&mesh.m_Bounds.m_Max.m_X), instances.m_Min[i], instances.m_Max[i]);
+				bvh.Update(uint32_t(i), instances.m_Min[i], instances.m_Max[i]);
+			}
+
+			bvh.Commit();
+		});
+
+		Report("move + refit", refit_ms, "cost %.1f, %zu rebuilds", bvh.Cost(), bvh.Rebuilds() - rebuilds);
+
+		// Frustum queries against testing every box, from cameras looking in different directions
+		std::vector<CFrustum> frustums;
+
+		for (size_t q = 0; q < QUERIES; ++q)
+		{
+			const float yaw = 2.0f * float(M_PI) * q / QUERIES;
+			CCamera camera;
+			camera.setViewport(1280, 720);
+			camera.setPosition(CVector3f::Zero());
+			camera.setTarget(CVector3f(sinf(yaw), -0.05f, -cosf(yaw)));
+			frustums.push_back(camera.frustum());
+		}
+
+		std::vector<uint32_t> found, expected;
+		size_t visible = 0;
+
+		const double linear_ms = Measure(context.m_Iterations, [&]() {
+			visible = 0;
+
+			for (const CFrustum& frustum : frustums)
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					visible += frustum.TestBox(instances.m_Min[i], instances.m_Max[i]);
+				}
+			}
+		});
+
+		const double frustum_ms = Measure(context.m_Iterations, [&]() {
+			found.clear();
+
+			for (const CFrustum& frustum : frustums)
+			{
+				bvh.QueryFrustum(frustum, found);
+			}
+		});
+
+		Report("frustum linear", linear_ms / QUERIES, "%.1f visible", double(visible) / QUERIES);
+		Report("frustum query", frustum_ms / QUERIES, "%.1f visible, %.1fx", double(found.size()) / QUERIES, linear_ms / frustum_ms);
+		succeeded &= found.size() == visible;
+
+		// Sphere and box queries of a few instance sizes around random points
+		std::mt19937 random(7);
+		std::uniform_int_distribution<size_t> pick(0, count - 1);
+		std::vector<CVector3f> centers;
+
+		for (size_t q = 0; q < QUERIES; ++q)
+		{
+			centers.push_back((instances.m_Min[pick(random)] + instances.m_Max[pick(random)]) * 0.5f);
+		}
+
+		const float reach = 20.0f * radius;
+		size_t sphere_found = 0, box_found = 0;
+
+		const double sphere_ms = Measure(context.m_Iterations, [&]() {
+			found.clear();
+
+			for (const CVector3f& center : centers)
+			{
+				bvh.QuerySphere(center, reach, found);
+			}
+
+			sphere_found = found.size();
+		});
+
+		const double box_ms = Measure(context.m_Iterations, [&]() {
+			found.clear();
+
+			for (const CVector3f& center : centers)
+			{
+				bvh.QueryBox(center - CVector3f::Constant(reach), center + CVector3f::Constant(reach), found);
+			}
+
+			box_found = found.size();
+		});
+
+		Report("sphere query", sphere_ms / QUERIES, "%.1f found", double(sphere_found) / QUERIES);
+		Report("box query", box_ms / QUERIES, "%.1f found", double(box_found) / QUERIES);
+
+		// The same queries in batches over the task pool, which have to find what they find one by one and in order
+		const std::vector<float> radii(QUERIES, reach);
+		std::vector<CVector3f> mins, maxs;
+
+		for (const CVector3f& center : centers)
+		{
+			mins.push_back(center - CVector3f::Constant(reach));
+			maxs.push_back(center + CVector3f::Constant(reach));
+		}
+
+		std::vector<uint32_t> batched;
+		std::vector<size_t> offsets;
+
+		const double frustum_batch_ms = Measure(context.m_Iterations, [&]() {
+			batched.clear();
+			bvh.QueryFrustums(frustums.data(), QUERIES, batched, offsets);
+		});
+
+		expected.clear();
+
+		for (const CFrustum& frustum : frustums)
+		{
+			bvh.QueryFrustum(frustum, expected);
+		}
+
+		succeeded &= batched == expected && offsets.back() == batched.size();
+
+		const double sphere_batch_ms = Measure(context.m_Iterations, [&]() {
+			batched.clear();
+			bvh.QuerySpheres(centers.data(), radii.data(), QUERIES, batched, offsets);
+		});
+
+		expected.clear();
+
+		for (const CVector3f& center : centers)
+		{
+			bvh.QuerySphere(center, reach, expected);
+		}
+
+		succeeded &= batched == expected && offsets.back() == batched.size();
+
+		const double box_batch_ms = Measure(context.m_Iterations, [&]() {
+			batched.clear();
+			bvh.QueryBoxes(mins.data(), maxs.data(), QUERIES, batched, offsets);
+		});
+
+		expected.clear();
+
+		for (size_t q = 0; q < QUERIES; ++q)
+		{
+			bvh.QueryBox(mins[q], maxs[q], expected);
+		}
+
+		succeeded &= batched == expected && offsets.back() == batched.size();
+
+		Report("frustum batch", frustum_batch_ms / QUERIES, "%zu queries, %.1fx", QUERIES, frustum_ms / frustum_batch_ms);
+		Report("sphere batch", sphere_batch_ms / QUERIES, "%zu queries, %.1fx", QUERIES, sphere_ms / sphere_batch_ms);
+		Report("box batch", box_batch_ms / QUERIES, "%zu queries, %.1fx", QUERIES, box_ms / box_batch_ms);
+
+		// Checked against brute force on a few of each
+		for (size_t q = 0; q < 4; ++q)
+		{
+			const CVector3f& center = centers[q];
+			found.clear();
+			bvh.QueryFrustum(frustums[q], found);
+			expected.clear();
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (frustums[q].TestBox(instances.m_Min[i], instances.m_Max[i]))
+				{
+					expected.push_back(uint32_t(i));
+				}
+			}
+
+			succeeded &= SameSet(found, expected);
+			found.clear();
+			bvh.QuerySphere(center, reach, found);
+			expected.clear();
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				const CVector3f nearest = center.cwiseMax(instances.m_Min[i]).cwiseMin(instances.m_Max[i]);
+
+				if ((nearest - center).squaredNorm() <= reach * reach)
+				{
+					expected.push_back(uint32_t(i));
+				}
+			}
+
+			succeeded &= SameSet(found, expected);
+			found.clear();
+			bvh.QueryBox(center - CVector3f::Constant(reach), center + CVector3f::Constant(reach), found);
+			expected.clear();
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				if ((instances.m_Min[i].array() <= (center.array() + reach)).all() && (instances.m_Max[i].array() >= (center.array() - reach)).all())
+				{
+					expected.push_back(uint32_t(i));
+				}
+			}
+
+			succeeded &= SameSet(found, expected);
+		}
+
+		// Rays from above the scene down at random points, in one batch over the task pool
+		const size_t ray_count = 64 * 1024;
+		std::vector<CVector3f> origins(ray_count), directions(ray_count);
+		std::vector<CSceneBvh::SRayHit> hits(ray_count);
+
+		for (size_t r = 0; r < ray_count; ++r)
+		{
+			const CVector3f target = (instances.m_Min[pick(random)] + instances.m_Max[pick(random)]) * 0.5f;
+			origins[r] = target + CVector3f(0.3f, 1.0f, 0.2f) * 100.0f * radius;
+			directions[r] = (target - origins[r]).normalized();
+		}
+
+		const float max_distance = 1000.0f * radius;
+
+		const double rays_ms = Measure(context.m_Iterations, [&]() {
+			bvh.QueryRays(origins.data(), directions.data(), ray_count, max_distance, hits.data());
+		});
+
+		const size_t hit_count = std::count_if(hits.begin(), hits.end(), [](const CSceneBvh::SRayHit& hit) { return hit.m_Proxy != CSceneBvh::Invalid; });
+
+		Report("ray batch", rays_ms, "%zu rays, %zu hits, %.2f M rays/s", ray_count, hit_count, ray_count / rays_ms / 1e3);
+
+		for (size_t r = 0; r < 16; ++r)
+		{
+			const CSceneBvh::SRayHit expected_hit = NearestBox(instances, origins[r], directions[r], max_distance);
+			succeeded &= hits[r].m_Distance == expected_hit.m_Distance;
+		}
+
+		// Removed proxies drop out with the rebuild the next commit makes
+		for (size_t i = 0; i < count; i += 7)
+		{
+			bvh.Remove(uint32_t(i));
+		}
+
+		succeeded &= bvh.Commit() && bvh.Proxies() == count - (count + 6) / 7;
+		found.clear();
+		bvh.QueryFrustum(frustums[0], found);
+		expected.clear();
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (i % 7 != 0 && frustums[0].TestBox(instances.m_Min[i], instances.m_Max[i]))
+			{
+				expected.push_back(uint32_t(i));
+			}
+		}
+
+		succeeded &= SameSet(found, expected);
+	}
+
+	pool.Stop();
+
+	return succeeded;
+}
@@ -0,0 +1,239 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "Engine/Render/Material.h"
+#include "Engine/Render/Texture.h"
+
+#include "Utils/CookedMesh.h"
+#include "Utils/CookedTexture.h"
+#include "Utils/MeshGenerator.h"
+#include "Utils/TaskPool.h"
+#include "Utils/TextureCache.h"
+#include "Utils/TextureCompressor.h"
+
+namespace
+{
+// Smooth gradients, hard edges and noise, roughly what albedo and normal maps mix
+void GenerateTexture(NRender::STexture& texture, uint16_t size, NRender::ETextureFormat format)
+{
+	std::mt19937 random(1337);
+	std::uniform_int_distribution<int> noise(-12, 12);
+
+	const size_t channels = NRender::FormatSize(format);
+	texture.m_Name = "<generated>";
+	texture.m_Width = size;
+	texture.m_Height = size;
+	texture.m_Format = format;
+	texture.m_Buffer.resize(size_t(size) * size * channels);
+	texture.m_Levels = { { size, size, 0, texture.m_Buffer.size() } };
+
+	for (size_t y = 0; y < size; ++y)
+	{
+		for (size_t x = 0; x < size; ++x)
+		{
+			const bool checker = ((x / 64) ^ (y / 64)) & 1;
+			const int values[4] = {
+				int(x * 255 / size),
+				int(y * 255 / size),
+				checker ? 200 : 40,
+				int(127.5 + 127.5 * sin(x * 0.05) * cos(y * 0.05)),
+			};
+
+			for (size_t c = 0; c < channels; ++c)
+			{
+				const int value = values[c] + noise(random);
+				texture.m_Buffer[(y * size + x) * channels + c] = uint8_t(value < 0 ? 0 : value > 255 ? 255 : value);
+			}
+		}
+	}
+}
+}  // namespace
+
+bool NBenchmark::RunTexture(SContext& context)
+{
+	struct SCase
+	{
+		const char* m_Name;
+		NRender::ETextureFormat m_Source;
+		NRender::ETextureFormat m_Target;
+	};
+
+	const SCase cases[] = {
+		{ "etc2 rgb", NRender::ETextureFormat::RGB8, NRender::ETextureFormat::ETC2_RGB8 },
+		{ "etc2 rgba", NRender::ETextureFormat::RGBA8, NRender::ETextureFormat::ETC2_RGBA8 },
+		{ "eac rg", NRender::ETextureFormat::RG8, NRender::ETextureFormat::EAC_RG11 },
+	};
+
+	const uint16_t size = 512;
+	bool valid = true;
+
+	for (const SCase& test : cases)
+	{
+		printf(" %s\n", test.m_Name);
+
+		NRender::STexture source;
+		GenerateTexture(source, size, test.m_Source);
+		const size_t base_size = source.m_Buffer.size();
+
+		NRender::STexture mipped;
+		const double mips_ms = Measure(context.m_Iterations, [&]() {
+			mipped = source;
+			NUtils::GenerateMips(mipped);
+		});
+
+		Report("mips", mips_ms, "%zu levels, %zu bytes from %zu", mipped.m_Levels.size(), mipped.m_Buffer.size(), base_size);
+
+		// Encoding is an offline step and much slower, a single pass is enough to time it
+		NRender::STexture compressed;
+		const double compress_ms = Measure(1, [&]() { NUtils::CompressTexture(mipped, test.m_Target, compressed); });
+		const float psnr = NUtils::MeasureTextureError(mipped, compressed);
+
+		Report("compress", compress_ms, "%zu bytes, %.1f%% saved, %.2f dB",
+			   compressed.m_Buffer.size(), 100.0 * (1.0 - double(compressed.m_Buffer.size()) / mipped.m_Buffer.size()), psnr);
+
+		// What the runtime pays before handing levels to GL, with and without ETC2 support
+		std::vector<uint8_t> blob;
+		NUtils::CookTexture(compressed, blob);
+
+		NRender::STexture loaded;
+		const double load_ms = Measure(context.m_Iterations, [&]() { NUtils::LoadCookedTexture(blob.data(), blob.size(), loaded); });
+		Report("load cooked", load_ms, "%zu bytes", blob.size());
+
+		// Files are read straight into the texture buffer and their levels used where they are
+		const std::string filename = "benchmark.tex";
+		valid &= NUtils::SaveCookedTexture(filename.c_str(), compressed);
+
+		NRender::STexture in_place;
+		const double file_ms = Measure(context.m_Iterations, [&]() { NUtils::LoadCookedTexture(filename.c_str(), in_place); });
+		Report("load cooked (file)", file_ms, "%zu bytes held, levels in place", in_place.m_Buffer.size());
+		remove(filename.c_str());
+
+		for (size_t i = 0; i < compressed.m_Levels.size() && i < in_place.m_Levels.size(); ++i)
+		{
+			const NRender::STexture::SLevel& expected = compressed.m_Levels[i];
+			const NRender::STexture::SLevel& level = in_place.m_Levels[i];
+			valid &= level.m_Size == expected.m_Size && !memcmp(in_place.Data() + level.m_Offset, compressed.Data() + expected.m_Offset, level.m_Size);
+		}
+
+		valid &= in_place.m_Levels.size() == compressed.m_Levels.size();
+
+		NRender::STexture decompressed;
+		const double fallback_ms = Measure(context.m_Iterations, [&]() { NUtils::DecompressTexture(loaded, decompressed); });
+		Report("fallback decode", fallback_ms, "%zu bytes", decompressed.m_Buffer.size());
+
+		valid &= loaded.m_Buffer == compressed.m_Buffer && loaded.m_Levels.size() == compressed.m_Levels.size();
+		valid &= decompressed.m_Format == test.m_Source && decompressed.m_Buffer.size() == mipped.m_Buffer.size();
+		valid &= psnr > 30.0f;
+	}
+
+	return valid;
+}
+
+bool NBenchmark::RunDecode(SContext& context)
+{
+	const size_t texture_count = 8;
+	const size_t material_count = 16;
+	const size_t threads = std::max(std::thread::hardware_concurrency(), 2u);
+
+	// Uncompressed cooked textures without mips, loading them is a read plus mip generation
+	std::vector<std::string> paths;
+	NRender::STexture source;
+	GenerateTexture(source, 512, NRender::ETextureFormat::RGBA8);
+
+	for (size_t i = 0; i < texture_count; ++i)
+	{
+		paths.push_back("benchmark_" + std::to_string(i) + ".tex");
+
+		if (!NUtils::SaveCookedTexture(paths.back().c_str(), source))
+		{
+			return false;
+		}
+	}
+
+	// Every material shares its textures with a neighbour, like albedo and detail maps reused across a scene
+	NRender::SMesh mesh;
+	NUtils::GenerateSphere(mesh, 16, 32, material_count);
+	mesh.m_Materials.resize(material_count);
+
+	for (size_t i = 0; i < material_count; ++i)
+	{
+		mesh.m_Materials[i] = std::make_shared<NRender::SMaterial>();
+		mesh.m_Materials[i]->m_AlbedoTexture = std::make_shared<NRender::STexture>();
+		mesh.m_Materials[i]->m_AlbedoTexture->m_Name = paths[i % texture_count];
+		mesh.m_Materials[i]->m_DetailTexture = std::make_shared<NRender::STexture>();
+		mesh.m_Materials[i]->m_DetailTexture->m_Name = paths[(i + 1) % texture_count];
+		mesh.m_SubMeshes[i].m_Material = i;
+	}
+
+	std::vector<uint8_t> blob;
+	NUtils::CookMesh(mesh, blob);
+
+	std::atomic<size_t> decodes{ 0 };
+
+	auto LoadTexture = [&decodes](const std::string& path) {
+		NRender::HTexture texture = std::make_shared<NRender::STexture>();
+
+		if (!NUtils::LoadCookedTexture(path.c_str(), *texture) || !NUtils::GenerateMips(*texture))
+		{
+			return NRender::HTexture(nullptr);
+		}
+
+		++decodes;
+		return texture;
+	};
+
+	bool valid = true;
+
+	// Meshes are dropped after each load, which releases their textures and leaves the cache cold
+	auto LoadCold = [&]() {
+		NRender::SMesh loaded;
+		const size_t before = decodes;
+		valid &= NUtils::LoadCookedMesh(blob.data(), blob.size(), loaded, LoadTexture);
+		valid &= decodes - before == texture_count;
+		valid &= loaded.m_Materials[0]->m_DetailTexture == loaded.m_Materials[1]->m_AlbedoTexture;
+	};
+
+	NUtils::CTaskPool::Instance().Start(0);
+	const double serial_ms = Measure(context.m_Iterations, LoadCold);
+
+	NUtils::CTaskPool::Instance().Start(threads);
+	const double parallel_ms = Measure(context.m_Iterations, LoadCold);
+
+	// While one mesh holds on to them, other meshes referencing the same paths decode nothing
+	NRender::SMesh first;
+	valid &= NUtils::LoadCookedMesh(blob.data(), blob.size(), first, LoadTexture);
+	const size_t before = decodes;
+
+	const double cached_ms = Measure(context.m_Iterations, [&]() {
+		NRender::SMesh loaded;
+		valid &= NUtils::LoadCookedMesh(blob.data(), blob.size(), loaded, LoadTexture);
+		valid &= loaded.m_Materials[0]->m_AlbedoTexture == first.m_Materials[0]->m_AlbedoTexture;
+	});
+
+	valid &= decodes == before;
+
+	NUtils::CTaskPool::Instance().Stop();
+
+	for (const std::string& path : paths)
+	{
+		remove(path.c_str());
+	}
+
+	const NUtils::STextureCacheStats stats = NUtils::CTextureCache::Instance().Stats();
+
+	Report("serial", serial_ms, "%zu textures, %zu materials", texture_count, material_count);
+	Report("parallel", parallel_ms, "%zu threads, %.2fx", threads, serial_ms / parallel_ms);
+	Report("cached", cached_ms, "%zu hits, %zu misses", stats.m_Hits, stats.m_Misses);
+
+	return valid;
+}
@@ -0,0 +1,137 @@
+#include "Benchmark.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "Engine/Camera.h"
+#include "Engine/FixedTimestep.h"
+#include "Engine/TransformHierarchy.h"
+
+namespace
+{
+constexpr double TICK = 1.0 / 60.0;
+constexpr size_t MAX_TICKS = 4;
+
+// Radians per second the simulated frames turn, as the demo's instances do
+constexpr float SPIN = 0.125f * float(M_PI);
+
+struct SClient
+{
+	const char* m_Name;
+	double m_FrameTime;
+	double m_Jitter;
+
+	// A single frame this long halfway through, as when the page comes back from the background
+	double m_Stall;
+};
+
+// Runs a client for ten seconds, checking the frames render a steady spin the same way a clock would
+bool RunClient(const SClient& client)
+{
+	std::mt19937 random(1337);
+	std::uniform_real_distribution<double> jitter(-client.m_Jitter, client.m_Jitter);
+
+	CFixedTimestep timestep(TICK, MAX_TICKS);
+	CFrame previous, current;
+	const CQuaternion spin(CAngleAxisf(SPIN * float(TICK), CVector3f::UnitY()));
+
+	size_t frames = 0, max_ticks = 0;
+	double time = 0.0, lost = 0.0;
+	float max_error = 0.0f;
+	bool stalled = client.m_Stall <= 0.0;
+
+	while (time < 10.0)
+	{
+		double elapsed = std::max(client.m_FrameTime + jitter(random), 0.0);
+
+		if (!stalled && time >= 5.0)
+		{
+			elapsed = client.m_Stall;
+			stalled = true;
+		}
+
+		time += elapsed;
+
+		const size_t dropped = timestep.DroppedTicks();
+		const size_t ticks = timestep.Advance(elapsed);
+		lost += (timestep.DroppedTicks() - dropped) * TICK;
+		max_ticks = std::max(max_ticks, ticks);
+
+		for (size_t tick = 0; tick < ticks; ++tick)
+		{
+			previous = current;
+			current.orientation = (current.orientation * spin).normalized();
+		}
+
+		// Rendering runs a tick behind the clock, less whatever was dropped
+		const CFrame frame = previous.lerp(timestep.Alpha(), current);
+		const float expected = fmodf(float(SPIN * std::max(time - lost - TICK, 0.0)), 2.0f * float(M_PI));
+		const CQuaternion reference(CAngleAxisf(expected, CVector3f::UnitY()));
+		max_error = std::max(max_error, frame.orientation.angularDistance(reference));
+		++frames;
+	}
+
+	NBenchmark::Report(client.m_Name, 0.0, "%zu frames, %.2f ticks per frame, at most %zu, %zu dropped, %.5f rad off",
+					   frames, double(timestep.Ticks()) / frames, max_ticks, timestep.DroppedTicks(), max_error);
+
+	const size_t expected_ticks = size_t((time - lost) / TICK + 1e-6);
+	return max_ticks <= MAX_TICKS && max_error < 1e-3f && timestep.Ticks() + 1 >= expected_ticks && timestep.Ticks() <= expected_ticks;
+}
+}  // namespace
+
+bool NBenchmark::RunTimestep(SContext& context)
+{
+	bool succeeded = true;
+
+	const SClient clients[] = {
+		{ "144 Hz", 1.0 / 144.0, 0.0, 0.0 },
+		{ "60 Hz", 1.0 / 60.0, 0.0, 0.0 },
+		{ "60 Hz jittered", 1.0 / 60.0, 0.004, 0.0 },
+		{ "20 Hz", 1.0 / 20.0, 0.0, 0.0 },
+		{ "10 Hz", 1.0 / 10.0, 0.0, 0.0 },
+		{ "60 Hz with stall", 1.0 / 60.0, 0.0, 2.0 },
+	};
+
+	for (const SClient& client : clients)
+	{
+		succeeded &= RunClient(client);
+	}
+
+	// What rendering adds to every frame, blending each instance's two states into the hierarchy
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> angle(0.0f, 2.0f * float(M_PI));
+
+	const size_t count = context.m_Instances;
+	CTransformHierarchy hierarchy;
+	std::vector<CFrame> previous(count), current(count);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		hierarchy.Add();
+		previous[i] = CFrame(CVector3f(position(random), 0.0f, position(random)), CQuaternion(CAngleAxisf(angle(random), CVector3f::UnitY())));
+		current[i] = CFrame(previous[i].position + CVector3f::UnitX(), previous[i].orientation * CQuaternion(CAngleAxisf(SPIN * float(TICK), CVector3f::UnitY())));
+	}
+
+	float alpha = 0.0f;
+
+	const double interpolate_ms = Measure(context.m_Iterations, [&]() {
+		alpha = fmodf(alpha + 0.37f, 1.0f);
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const CFrame frame = previous[i].lerp(alpha, current[i]);
+			hierarchy.SetPosition(i, frame.position);
+			hierarchy.SetRotation(i, frame.orientation);
+		}
+
+		hierarchy.Update();
+	});
+
+	Report("interpolate", interpolate_ms, "%zu instances", count);
+
+	return succeeded;
+}
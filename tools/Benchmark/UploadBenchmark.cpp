@@ -0,0 +1,258 @@
+#include "Benchmark.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "Utils/BufferAllocator.h"
+
+namespace
+{
+constexpr size_t FRAMES = 600;
+constexpr size_t MATRIX_SIZE = 64;
+
+struct SLiveRange
+{
+	uint64_t m_Frame;
+	size_t m_Offset;
+	size_t m_Size;
+};
+
+struct SRingResult
+{
+	size_t m_Orphans = 0;
+	size_t m_Bytes = 0;
+	size_t m_PeakUsed = 0;
+	bool m_Valid = true;
+};
+
+// Frames upload a varying number of instance transforms, and the GPU releases them lag frames later.
+// Running out of room orphans the storage, like CStreamBuffer does. Checking keeps every live range
+// around to make sure no upload ever lands on one the GPU might still read.
+SRingResult SimulateRing(size_t capacity, size_t instances, size_t lag, bool check, std::vector<uint8_t>& storage, const std::vector<uint8_t>& source)
+{
+	SRingResult result;
+	NUtils::CRingAllocator ring(capacity);
+	std::deque<SLiveRange> live;
+	std::deque<uint64_t> in_flight;
+	std::mt19937 random(1337);
+	std::uniform_int_distribution<size_t> visible(instances / 2, instances);
+
+	for (size_t frame = 0; frame < FRAMES; ++frame)
+	{
+		// A few uploads a frame, transforms and a smaller batch like culled indices
+		for (size_t upload = 0; upload < 3; ++upload)
+		{
+			const size_t size = visible(random) * MATRIX_SIZE >> upload;
+			size_t offset = ring.Allocate(size);
+
+			if (offset == NUtils::CRingAllocator::Invalid)
+			{
+				ring.Reset(capacity);
+				live.clear();
+				in_flight.clear();
+				offset = ring.Allocate(size);
+				++result.m_Orphans;
+			}
+
+			if (check)
+			{
+				for (const SLiveRange& range : live)
+				{
+					result.m_Valid &= offset + size <= range.m_Offset || range.m_Offset + range.m_Size <= offset;
+				}
+
+				live.push_back({ frame, offset, size });
+			}
+
+			result.m_Valid &= offset + size <= capacity;
+			memcpy(&storage[offset], source.data(), size);
+			result.m_Bytes += size;
+			result.m_PeakUsed = std::max(result.m_PeakUsed, ring.Used());
+		}
+
+		in_flight.push_back(ring.EndFrame());
+
+		if (in_flight.size() > lag)
+		{
+			ring.Release(in_flight.front());
+
+			while (!live.empty() && live.front().m_Frame <= in_flight.front())
+			{
+				live.pop_front();
+			}
+
+			in_flight.pop_front();
+		}
+	}
+
+	return result;
+}
+
+bool Overlaps(std::vector<std::pair<size_t, size_t>> ranges)
+{
+	std::sort(ranges.begin(), ranges.end());
+
+	for (size_t i = 1; i < ranges.size(); ++i)
+	{
+		if (ranges[i - 1].first + ranges[i - 1].second > ranges[i].first)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+}  // namespace
+
+bool NBenchmark::RunUpload(SContext& context)
+{
+	bool succeeded = true;
+
+	// Per frame streaming, a fresh allocation each frame stands in for orphaning with glBufferData
+	const size_t instances = std::min<size_t>(context.m_Instances, 100000);
+	const size_t frame_size = instances * MATRIX_SIZE * 7 / 4;
+	std::vector<uint8_t> source(instances * MATRIX_SIZE, 1);
+
+	const double reallocate_ms = Measure(context.m_Iterations, [&]() {
+		std::mt19937 random(1337);
+		std::uniform_int_distribution<size_t> visible(instances / 2, instances);
+
+		for (size_t frame = 0; frame < FRAMES; ++frame)
+		{
+			for (size_t upload = 0; upload < 3; ++upload)
+			{
+				std::vector<uint8_t> buffer(source.begin(), source.begin() + (visible(random) * MATRIX_SIZE >> upload));
+				succeeded &= !buffer.empty();
+			}
+		}
+	});
+
+	Report("reallocate", reallocate_ms / FRAMES, "per frame, %.1f KB uploaded", frame_size * 0.75 / 1024.0);
+
+	for (size_t lag = 1; lag <= 3; ++lag)
+	{
+		// Room for three frames, a GPU lagging three frames behind has to orphan now and then
+		std::vector<uint8_t> storage(frame_size * 3);
+		SRingResult result;
+
+		const double ring_ms = Measure(context.m_Iterations, [&]() {
+			result = SimulateRing(storage.size(), instances, lag, false, storage, source);
+		});
+
+		char name[32];
+		snprintf(name, sizeof(name), "ring, %zu frame lag", lag);
+		Report(name, ring_ms / FRAMES, "per frame, %.1f KB uploaded, %zu orphans over %zu frames, %.0f%% peak use",
+			   double(result.m_Bytes) / FRAMES / 1024.0, result.m_Orphans, FRAMES, 100.0 * result.m_PeakUsed / storage.size());
+
+		succeeded &= SimulateRing(storage.size(), instances, lag, true, storage, source).m_Valid;
+		succeeded &= lag > 1 || result.m_Orphans == 0;
+	}
+
+	// Meshes coming and going in shared buffers, sized like the submeshes of the loaded mesh
+	std::vector<size_t> sizes;
+
+	for (const NRender::SMesh::SSubMesh& sub_mesh : context.m_Mesh.m_SubMeshes)
+	{
+		sizes.push_back(std::max<size_t>(sub_mesh.m_VertexCount, 1));
+	}
+
+	std::mt19937 random(1337);
+	std::vector<std::pair<size_t, size_t>> allocations;
+	NUtils::CRangeAllocator allocator;
+	size_t grows = 0;
+
+	const double churn_ms = Measure(1, [&]() {
+		for (size_t i = 0; i < 20000; ++i)
+		{
+			// Grows to about 256 live meshes, then frees as often as it allocates
+			if (allocations.size() > 256 || (allocations.size() > 128 && random() % 2))
+			{
+				const size_t index = random() % allocations.size();
+				allocator.Free(allocations[index].first, allocations[index].second);
+				allocations[index] = allocations.back();
+				allocations.pop_back();
+				continue;
+			}
+
+			const size_t size = sizes[random() % sizes.size()] * (1 + random() % 4);
+			size_t offset = allocator.Allocate(size);
+
+			if (offset == NUtils::CRangeAllocator::Invalid)
+			{
+				allocator.Grow(std::max(allocator.Capacity() * 2, allocator.Capacity() + size));
+				offset = allocator.Allocate(size);
+				++grows;
+			}
+
+			allocations.emplace_back(offset, size);
+		}
+	});
+
+	size_t used = 0;
+
+	for (const std::pair<size_t, size_t>& allocation : allocations)
+	{
+		used += allocation.second;
+		succeeded &= allocation.first + allocation.second <= allocator.Capacity();
+	}
+
+	const size_t free = allocator.Capacity() - allocator.Used();
+	Report("shared buffer churn", churn_ms, "20000 operations, %zu live, %zu grows, %.0f%% used, largest free range %.0f%% of free space",
+		   allocations.size(), grows, 100.0 * used / std::max<size_t>(allocator.Capacity(), 1), 100.0 * allocator.LargestFree() / std::max<size_t>(free, 1));
+
+	succeeded &= used == allocator.Used() && !Overlaps(allocations);
+
+	// Packing the mesh into a shared buffer a few times over, rebased indices have to find their own vertices
+	const NRender::SMesh& mesh = context.m_Mesh;
+	const size_t vertex_count = mesh.m_VertexFormat == NRender::EVertexFormat::Packed ? mesh.m_PackedVertices.size() : mesh.m_Vertices.size();
+	NUtils::CRangeAllocator vertices(vertex_count * 2);
+	std::vector<size_t> first_vertices;
+	std::vector<uint32_t> shared_indices;
+
+	const double pack_ms = Measure(context.m_Iterations, [&]() {
+		first_vertices.clear();
+		shared_indices.clear();
+		vertices = NUtils::CRangeAllocator(vertex_count * 2);
+
+		for (size_t copy = 0; copy < 4; ++copy)
+		{
+			size_t first_vertex = vertices.Allocate(vertex_count);
+
+			if (first_vertex == NUtils::CRangeAllocator::Invalid)
+			{
+				vertices.Grow(vertices.Capacity() * 2);
+				first_vertex = vertices.Allocate(vertex_count);
+			}
+
+			first_vertices.push_back(first_vertex);
+
+			for (uint32_t index : mesh.m_Indices)
+			{
+				shared_indices.push_back(index + uint32_t(first_vertex));
+			}
+		}
+	});
+
+	Report("rebase indices", pack_ms, "4 copies, %.1f MB of indices", shared_indices.size() * sizeof(uint32_t) / 1e6);
+
+	std::vector<std::pair<size_t, size_t>> copies;
+
+	for (size_t copy = 0; copy < first_vertices.size(); ++copy)
+	{
+		copies.emplace_back(first_vertices[copy], vertex_count);
+
+		for (size_t i = 0; i < mesh.m_Indices.size(); ++i)
+		{
+			const uint32_t index = shared_indices[copy * mesh.m_Indices.size() + i];
+			succeeded &= index >= first_vertices[copy] && index < first_vertices[copy] + vertex_count && index - first_vertices[copy] == mesh.m_Indices[i];
+		}
+	}
+
+	succeeded &= !Overlaps(copies);
+
+	return succeeded;
+}
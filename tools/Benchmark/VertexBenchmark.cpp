@@ -0,0 +1,105 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <array>
+#include <random>
+
+#include "Utils/MeshOptimizer.h"
+#include "Utils/MeshQuantizer.h"
+
+bool NBenchmark::RunQuantize(SContext& context)
+{
+	if (context.m_Mesh.m_VertexFormat != NRender::EVertexFormat::Float)
+	{
+		Report("skipped", 0.0, "mesh is already packed");
+		return true;
+	}
+
+	NRender::SMesh packed;
+
+	const double quantize_ms = Measure(context.m_Iterations, [&]() {
+		packed = context.m_Mesh;
+		NUtils::QuantizeMesh(packed);
+	});
+
+	std::vector<NRender::SMesh::SVertexData> vertices;
+
+	const double dequantize_ms = Measure(context.m_Iterations, [&]() {
+		NUtils::DequantizeVertices(packed, vertices);
+	});
+
+	const NUtils::SQuantizationError error = NUtils::MeasureQuantizationError(context.m_Mesh.m_Vertices, packed);
+	const size_t vertex_count = packed.m_PackedVertices.size();
+
+	Report("quantize", quantize_ms, "%zu -> %zu bytes per vertex, %zu -> %zu bytes",
+		   sizeof(NRender::SMesh::SVertexData), sizeof(NRender::SMesh::SPackedVertexData),
+		   vertex_count * sizeof(NRender::SMesh::SVertexData), vertex_count * sizeof(NRender::SMesh::SPackedVertexData));
+	Report("dequantize", dequantize_ms, "error: position %g, normal %g deg, tangent %g deg, color %g, uv %g",
+		   error.m_Position, error.m_Normal, error.m_Tangent, error.m_Color, error.m_UV);
+
+	// Anything beyond these bounds means the packing is broken rather than lossy
+	return error.m_Normal < 0.1f && error.m_Tangent < 0.1f && error.m_Color <= 0.5f / 255.0f + 1e-6f;
+}
+
+bool NBenchmark::RunOptimize(SContext& context)
+{
+	// Assimp output isn't always as orderly as generated meshes, so a shuffled copy is measured too
+	NRender::SMesh shuffled = context.m_Mesh;
+	std::mt19937 random(1337);
+
+	for (const NRender::SMesh::SSubMesh& sub_mesh : shuffled.m_SubMeshes)
+	{
+		uint32_t* triangles = &shuffled.m_Indices[sub_mesh.m_IndexOffset];
+
+		for (size_t t = sub_mesh.m_IndexCount / 3; t > 1; --t)
+		{
+			std::swap_ranges(triangles + (t - 1) * 3, triangles + t * 3, triangles + std::uniform_int_distribution<size_t>(0, t - 1)(random) * 3);
+		}
+	}
+
+	bool succeeded = true;
+
+	for (const NRender::SMesh* source : { &context.m_Mesh, &shuffled })
+	{
+		const char* name = source == &shuffled ? "shuffled" : "source";
+		const NUtils::SVertexCacheStats before = NUtils::AnalyzeVertexCache(*source);
+
+		NRender::SMesh optimized;
+
+		const double optimize_ms = Measure(context.m_Iterations, [&]() {
+			optimized = *source;
+			NUtils::OptimizeMesh(optimized);
+		});
+
+		const NUtils::SVertexCacheStats after = NUtils::AnalyzeVertexCache(optimized);
+
+		Report(name, optimize_ms, "ACMR %.3f -> %.3f, ATVR %.3f -> %.3f", before.ACMR(), after.ACMR(), before.ATVR(), after.ATVR());
+
+		// Optimizing must keep every submesh's triangles, only their order may change
+		std::vector<NRender::SMesh::SVertexData> source_vertices, optimized_vertices;
+		NUtils::DequantizeVertices(*source, source_vertices);
+		NUtils::DequantizeVertices(optimized, optimized_vertices);
+
+		for (const NRender::SMesh::SSubMesh& sub_mesh : source->m_SubMeshes)
+		{
+			auto Triangles = [&](const NRender::SMesh& mesh, const std::vector<NRender::SMesh::SVertexData>& vertices) {
+				std::vector<std::array<float, 9>> triangles(sub_mesh.m_IndexCount / 3);
+
+				for (size_t i = 0; i < sub_mesh.m_IndexCount; ++i)
+				{
+					const NRender::SMesh::SVector3& position = vertices[mesh.m_Indices[sub_mesh.m_IndexOffset + i]].m_Position;
+					std::copy(&position.m_X, &position.m_X + 3, triangles[i / 3].begin() + (i % 3) * 3);
+				}
+
+				std::sort(triangles.begin(), triangles.end());
+				return triangles;
+			};
+
+			succeeded &= Triangles(*source, source_vertices) == Triangles(optimized, optimized_vertices);
+		}
+
+		succeeded &= after.m_Misses <= before.m_Misses;
+	}
+
+	return succeeded;
+}
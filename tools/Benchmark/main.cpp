@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Benchmark.h"
+
+#include "Utils/CookedMesh.h"
+#include "Utils/MeshGenerator.h"
+#include "Utils/MeshLoader.h"
+
+using CClock = std::chrono::steady_clock;
+
+double NBenchmark::Measure(int iterations, const std::function<void()>& function)
+{
+	const CClock::time_point start = CClock::now();
+
+	for (int i = 0; i < iterations; ++i)
+	{
+		function();
+	}
+
+	return std::chrono::duration<double, std::milli>(CClock::now() - start).count() / iterations;
+}
+
+void NBenchmark::Report(const char* name, double milliseconds, const char* format, ...)
+{
+	printf("  %-24s %10.3f ms", name, milliseconds);
+
+	if (format)
+	{
+		va_list args;
+		va_start(args, format);
+		printf("  ");
+		vprintf(format, args);
+		va_end(args);
+	}
+
+	printf("\n");
+}
+
+struct SSuite
+{
+	const char* m_Name;
+	bool (*m_Run)(NBenchmark::SContext& context);
+};
+
+static const SSuite s_Suites[] = {
+	{ "load", &NBenchmark::RunLoad },
+	{ "stream", &NBenchmark::RunStream },
+	{ "archive", &NBenchmark::RunArchive },
+	{ "quantize", &NBenchmark::RunQuantize },
+	{ "optimize", &NBenchmark::RunOptimize },
+	{ "lod", &NBenchmark::RunLod },
+	{ "transform", &NBenchmark::RunTransform },
+	{ "hierarchy", &NBenchmark::RunHierarchy },
+	{ "timestep", &NBenchmark::RunTimestep },
+	{ "cull", &NBenchmark::RunCull },
+	{ "occlusion", &NBenchmark::RunOcclusion },
+	{ "bvh", &NBenchmark::RunSceneBvh },
+	{ "raycast", &NBenchmark::RunRaycast },
+	{ "cluster", &NBenchmark::RunCluster },
+	{ "sort", &NBenchmark::RunSort },
+	{ "upload", &NBenchmark::RunUpload },
+	{ "raster", &NBenchmark::RunRaster },
+	{ "texture", &NBenchmark::RunTexture },
+	{ "decode", &NBenchmark::RunDecode },
+	{ "profile", &NBenchmark::RunProfile },
+};
+
+static bool LoadContextMesh(NBenchmark::SContext& context)
+{
+	// Without an asset we fall back to a generated mesh so every suite can run headless
+	if (context.m_MeshFilename.empty())
+	{
+		NUtils::GenerateSphere(context.m_Mesh, 128, 256, 8);
+		return true;
+	}
+
+	if (NUtils::LoadCookedMesh(context.m_MeshFilename.c_str(), context.m_Mesh))
+	{
+		return true;
+	}
+
+#ifdef ENGINE_ASSIMP
+	return NUtils::LoadMesh(context.m_MeshFilename.c_str(), "", context.m_Mesh);
+#else
+	return false;
+#endif
+}
+
+int main(int argc, char** argv)
+{
+	NBenchmark::SContext context;
+	std::vector<const SSuite*> suites;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--mesh") && i + 1 < argc)
+		{
+			context.m_MeshFilename = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--iterations") && i + 1 < argc)
+		{
+			context.m_Iterations = std::max(atoi(argv[++i]), 1);
+		}
+		else if (!strcmp(argv[i], "--instances") && i + 1 < argc)
+		{
+			context.m_Instances = std::max(atoi(argv[++i]), 1);
+		}
+		else if (!strcmp(argv[i], "--image") && i + 1 < argc)
+		{
+			context.m_ImageFilename = argv[++i];
+		}
+		else
+		{
+			const SSuite* found = nullptr;
+
+			for (const SSuite& suite : s_Suites)
+			{
+				found = strcmp(argv[i], suite.m_Name) ? found : &suite;
+			}
+
+			if (!found)
+			{
+				printf("Usage: %s [--mesh <file>] [--iterations <n>] [--instances <n>] [--image <file>] [suite...]\n", argv[0]);
+				printf("Suites:");
+
+				for (const SSuite& suite : s_Suites)
+				{
+					printf(" %s", suite.m_Name);
+				}
+
+				printf("\n");
+				return -1;
+			}
+
+			suites.push_back(found);
+		}
+	}
+
+	if (suites.empty())
+	{
+		for (const SSuite& suite : s_Suites)
+		{
+			suites.push_back(&suite);
+		}
+	}
+
+	if (!LoadContextMesh(context))
+	{
+		printf("Failed to load mesh: %s\n", context.m_MeshFilename.c_str());
+		return -1;
+	}
+
+	printf("%s: %zu vertices, %zu indices, %zu submeshes\n",
+		   context.m_MeshFilename.empty() ? "<generated>" : context.m_MeshFilename.c_str(),
+		   context.m_Mesh.m_Vertices.size(),
+		   context.m_Mesh.m_Indices.size(),
+		   context.m_Mesh.m_SubMeshes.size());
+
+	// Suites verify their own results, any failure fails the run
+	bool succeeded = true;
+
+	for (const SSuite* suite : suites)
+	{
+		printf("%s\n", suite->m_Name);
+
+		if (!suite->m_Run(context))
+		{
+			printf("  FAILED\n");
+			succeeded = false;
+		}
+	}
+
+	return succeeded ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+#include <string.h>
+#include <stdio.h>
+
+#include "Engine/Render/Mesh.h"
+
+#include "Utils/BvhBuilder.h"
+#include "Utils/CookedMesh.h"
+#include "Utils/MeshLoader.h"
+#include "Utils/MeshletBuilder.h"
+#include "Utils/MeshOptimizer.h"
+#include "Utils/MeshQuantizer.h"
+#include "Utils/MeshSimplifier.h"
+
+int main(int argc, char** argv)
+{
+	const char* input = nullptr;
+	const char* output = nullptr;
+	bool packed = false;
+	bool optimize = true;
+	bool lods = true;
+	bool meshlets = true;
+	bool bvh = true;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--packed"))
+		{
+			packed = true;
+		}
+		else if (!strcmp(argv[i], "--no-optimize"))
+		{
+			optimize = false;
+		}
+		else if (!strcmp(argv[i], "--no-lods"))
+		{
+			lods = false;
+		}
+		else if (!strcmp(argv[i], "--no-meshlets"))
+		{
+			meshlets = false;
+		}
+		else if (!strcmp(argv[i], "--no-bvh"))
+		{
+			bvh = false;
+		}
+		else if (!input)
+		{
+			input = argv[i];
+		}
+		else
+		{
+			output = argv[i];
+		}
+	}
+
+	if (!input || !output)
+	{
+		printf("Usage: %s [--packed] [--no-optimize] [--no-lods] [--no-meshlets] [--no-bvh] <input> <output>\n", argv[0]);
+		return -1;
+	}
+
+	// Textures are only referenced by path, the runtime decodes them
+	NRender::SMesh mesh;
+
+	if (!NUtils::LoadMesh(input, "", mesh))
+	{
+		printf("Failed to load mesh: %s\n", input);
+		return -1;
+	}
+
+	// Levels come first so the optimizer orders them along with the full detail ranges
+	if (lods)
+	{
+		NUtils::GenerateLods(mesh);
+
+		for (const NRender::SMesh::SSubMesh& sub_mesh : mesh.m_SubMeshes)
+		{
+			printf("Levels of detail for %s: %zu", sub_mesh.m_Name.c_str(), sub_mesh.m_IndexCount / 3);
+
+			for (const NRender::SMesh::SLod& lod : sub_mesh.m_Lods)
+			{
+				printf(" -> %zu (error %g)", lod.m_IndexCount / 3, lod.m_Error);
+			}
+
+			printf(" triangles\n");
+		}
+	}
+
+	if (optimize)
+	{
+		const NUtils::SVertexCacheStats before = NUtils::AnalyzeVertexCache(mesh);
+		NUtils::OptimizeMesh(mesh);
+		const NUtils::SVertexCacheStats after = NUtils::AnalyzeVertexCache(mesh);
+
+		printf("Vertex cache: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", before.ACMR(), after.ACMR(), before.ATVR(), after.ATVR());
+	}
+
+	size_t vertex_count = mesh.m_Vertices.size();
+	size_t vertex_size = sizeof(NRender::SMesh::SVertexData);
+
+	if (packed)
+	{
+		const std::vector<NRender::SMesh::SVertexData> reference = mesh.m_Vertices;
+		NUtils::QuantizeMesh(mesh);
+		vertex_size = sizeof(NRender::SMesh::SPackedVertexData);
+
+		const NUtils::SQuantizationError error = NUtils::MeasureQuantizationError(reference, mesh);
+		printf("Quantization error: position %g, normal %g deg, tangent %g deg, color %g, uv %g\n",
+			   error.m_Position, error.m_Normal, error.m_Tangent, error.m_Color, error.m_UV);
+	}
+
+	// Last, as it reorders triangles and its bounds should enclose the positions as they're stored
+	if (meshlets)
+	{
+		NUtils::BuildMeshlets(mesh);
+		printf("Meshlets: %zu\n", mesh.m_Meshlets.Size());
+	}
+
+	// The tree refers to triangles where they end up, so nothing may reorder them after this
+	if (bvh)
+	{
+		NUtils::BuildBvh(mesh);
+		printf("Bvh: %zu nodes, %zu triangle blocks\n", mesh.m_Bvh.m_Nodes.size(), mesh.m_Bvh.m_Blocks.size());
+	}
+
+	if (!NUtils::SaveCookedMesh(output, mesh))
+	{
+		return -1;
+	}
+
+	printf("Cooked %s -> %s (%zu vertices at %zu bytes, %zu indices, %zu submeshes, %zu materials)\n",
+		   input, output,
+		   vertex_count,
+		   vertex_size,
+		   mesh.m_Indices.size(),
+		   mesh.m_SubMeshes.size(),
+		   mesh.m_Materials.size());
+
+	return 0;
+}
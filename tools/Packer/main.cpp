@@ -0,0 +1,107 @@
+#include <string.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "Utils/AssetArchive.h"
+
+static bool ReadFile(const std::filesystem::path& path, std::vector<uint8_t>& data)
+{
+	std::ifstream file(path, std::ios::binary);
+
+	if (!file)
+	{
+		printf("Failed to open file: %s\n", path.string().c_str());
+		return false;
+	}
+
+	data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	const char* output = nullptr;
+	std::vector<const char*> inputs;
+	bool compress = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--compress"))
+		{
+			compress = true;
+		}
+		else if (!output)
+		{
+			output = argv[i];
+		}
+		else
+		{
+			inputs.push_back(argv[i]);
+		}
+	}
+
+	if (!output || inputs.empty())
+	{
+		printf("Usage: %s [--compress] <output.pak> <file or directory>...\n", argv[0]);
+		return -1;
+	}
+
+	// Files are archived under the paths they were found at, so pack from where the runtime loads them
+	std::vector<std::filesystem::path> paths;
+	std::error_code error;
+
+	for (const char* input : inputs)
+	{
+		if (!std::filesystem::is_directory(input, error))
+		{
+			paths.push_back(input);
+			continue;
+		}
+
+		for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator(input, error))
+		{
+			if (entry.is_regular_file(error))
+			{
+				paths.push_back(entry.path());
+			}
+		}
+
+		if (error)
+		{
+			printf("Failed to walk directory: %s (%s)\n", input, error.message().c_str());
+			return -1;
+		}
+	}
+
+	// Directory order isn't stable, sorting keeps the archive deterministic
+	std::sort(paths.begin(), paths.end());
+
+	std::vector<NUtils::SArchiveFile> files(paths.size());
+	size_t total_size = 0;
+
+	for (size_t i = 0; i < paths.size(); ++i)
+	{
+		files[i].m_Path = paths[i].generic_string();
+		files[i].m_Compress = compress;
+
+		if (!ReadFile(paths[i], files[i].m_Data))
+		{
+			return -1;
+		}
+
+		total_size += files[i].m_Data.size();
+	}
+
+	if (!NUtils::SaveArchive(output, files))
+	{
+		return -1;
+	}
+
+	printf("Packed %zu files -> %s (%zu bytes from %zu)\n", files.size(), output, size_t(std::filesystem::file_size(output, error)), total_size);
+	return 0;
+}
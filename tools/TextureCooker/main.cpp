@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+#include <string.h>
+#include <stdio.h>
+
+#include <png.h>
+
+#include "Engine/Render/Texture.h"
+
+#include "Utils/CookedTexture.h"
+#include "Utils/TextureCompressor.h"
+
+using CClock = std::chrono::steady_clock;
+
+static bool LoadPNG(const char* filename, NRender::STexture& texture)
+{
+	png_image image;
+	memset(&image, 0, sizeof(image));
+	image.version = PNG_IMAGE_VERSION;
+
+	if (!png_image_begin_read_from_file(&image, filename))
+	{
+		printf("Failed to read %s: %s\n", filename, image.message);
+		return false;
+	}
+
+	// Keep the channel count of the source, always decoded to 8-bits per channel
+	static const png_uint_32 png_formats[] = { PNG_FORMAT_GRAY, PNG_FORMAT_GA, PNG_FORMAT_RGB, PNG_FORMAT_RGBA };
+	static const NRender::ETextureFormat formats[] = {
+		NRender::ETextureFormat::R8,
+		NRender::ETextureFormat::RG8,
+		NRender::ETextureFormat::RGB8,
+		NRender::ETextureFormat::RGBA8,
+	};
+
+	const size_t channels = PNG_IMAGE_SAMPLE_CHANNELS(image.format);
+	image.format = png_formats[channels - 1];
+
+	texture.m_Name = filename;
+	texture.m_Width = image.width;
+	texture.m_Height = image.height;
+	texture.m_Format = formats[channels - 1];
+	texture.m_Buffer.resize(PNG_IMAGE_SIZE(image));
+	texture.m_Levels = { { texture.m_Width, texture.m_Height, 0, texture.m_Buffer.size() } };
+
+	if (!png_image_finish_read(&image, nullptr, texture.m_Buffer.data(), 0, nullptr))
+	{
+		printf("Failed to decode %s: %s\n", filename, image.message);
+		return false;
+	}
+
+	return true;
+}
+
+// Picks the block format holding the channels the texture actually uses
+static NRender::ETextureFormat GetAutoFormat(const NRender::STexture& texture)
+{
+	switch (texture.m_Format)
+	{
+	case NRender::ETextureFormat::R8: return NRender::ETextureFormat::EAC_R11;
+	case NRender::ETextureFormat::RG8: return NRender::ETextureFormat::EAC_RG11;
+	case NRender::ETextureFormat::RGB8: return NRender::ETextureFormat::ETC2_RGB8;
+	default: break;
+	}
+
+	for (size_t i = 3; i < texture.m_Levels[0].m_Size; i += 4)
+	{
+		if (texture.m_Buffer[i] != 255)
+		{
+			return NRender::ETextureFormat::ETC2_RGBA8;
+		}
+	}
+
+	return NRender::ETextureFormat::ETC2_RGB8;
+}
+
+int main(int argc, char** argv)
+{
+	const char* input = nullptr;
+	const char* output = nullptr;
+	const char* format_name = "auto";
+	bool mips = true;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--format") && i + 1 < argc)
+		{
+			format_name = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--no-mips"))
+		{
+			mips = false;
+		}
+		else if (!input)
+		{
+			input = argv[i];
+		}
+		else
+		{
+			output = argv[i];
+		}
+	}
+
+	struct SFormatName
+	{
+		const char* m_Name;
+		NRender::ETextureFormat m_Format;
+	};
+
+	static const SFormatName format_names[] = {
+		{ "etc2", NRender::ETextureFormat::ETC2_RGB8 },
+		{ "etc2a", NRender::ETextureFormat::ETC2_RGBA8 },
+		{ "r11", NRender::ETextureFormat::EAC_R11 },
+		{ "rg11", NRender::ETextureFormat::EAC_RG11 },
+	};
+
+	if (!input || !output)
+	{
+		printf("Usage: %s [--format auto|raw|etc2|etc2a|r11|rg11] [--no-mips] <input.png> <output.tex>\n", argv[0]);
+		return -1;
+	}
+
+	NRender::STexture texture;
+
+	if (!LoadPNG(input, texture))
+	{
+		return -1;
+	}
+
+	const size_t source_size = texture.m_Buffer.size();
+
+	if (mips && !NUtils::GenerateMips(texture))
+	{
+		return -1;
+	}
+
+	NRender::ETextureFormat format = texture.m_Format;
+
+	if (!strcmp(format_name, "auto"))
+	{
+		format = GetAutoFormat(texture);
+	}
+	else if (strcmp(format_name, "raw"))
+	{
+		const SFormatName* name = std::find_if(std::begin(format_names), std::end(format_names), [&](const SFormatName& entry) { return !strcmp(entry.m_Name, format_name); });
+
+		if (name == std::end(format_names))
+		{
+			printf("Unknown format: %s\n", format_name);
+			return -1;
+		}
+
+		format = name->m_Format;
+	}
+
+	NRender::STexture cooked = texture;
+
+	if (NRender::IsCompressed(format))
+	{
+		const CClock::time_point start = CClock::now();
+
+		if (!NUtils::CompressTexture(texture, format, cooked))
+		{
+			return -1;
+		}
+
+		const double milliseconds = std::chrono::duration<double, std::milli>(CClock::now() - start).count();
+		printf("Compressed in %.1f ms, PSNR %.2f dB\n", milliseconds, NUtils::MeasureTextureError(texture, cooked));
+	}
+
+	if (!NUtils::SaveCookedTexture(output, cooked))
+	{
+		return -1;
+	}
+
+	printf("Cooked %s -> %s (%ux%u, %zu levels, %zu bytes from %zu)\n",
+		   input, output,
+		   cooked.m_Width, cooked.m_Height,
+		   cooked.m_Levels.size(),
+		   cooked.m_Buffer.size(),
+		   source_size);
+
+	return 0;
+}